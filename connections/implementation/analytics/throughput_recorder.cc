@@ -16,6 +16,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <new>
 #include <ostream>
 #include <string>
@@ -159,6 +160,8 @@ void ThroughputRecorder::Throughput::Add(int frame_size, int64_t file_io_time,
                                          int64_t encryption_time,
                                          int64_t socket_io_time) {
   total_byte_size_ += frame_size;
+  ++frame_count_;
+  max_frame_size_ = std::max(max_frame_size_, frame_size);
   // reset the last timestamp
   last_timestamp_ = SystemClock::ElapsedRealtime();
   file_io_time_ += file_io_time;
@@ -177,13 +180,12 @@ bool ThroughputRecorder::Throughput::dump() {
   int64_t other =
       total_millis - file_io_time_ - encryption_time_ - socket_io_time_;
   std::string dump_content = absl::StrFormat(
-      "%s %s data(%ld bytes) via %s used %ld milliseconds, throughput is %d "
-      "MB/s (%d KB/s), File IO takes %ld ms, %s takes %ld ms, "
-      "Socket IO takes %ld ms, "
-      "Other takes %ld ms",
+      "%s %s data(%ld bytes in %ld frames, largest %d bytes) via %s used %ld "
+      "milliseconds, throughput is %d MB/s (%d KB/s), File IO takes %ld ms, "
+      "%s takes %ld ms, Socket IO takes %ld ms, Other takes %ld ms",
       (payload_direction_ == PayloadDirection::INCOMING_PAYLOAD) ? "Received"
                                                                  : "Sent",
-      ToString(payload_type_), total_byte_size_,
+      ToString(payload_type_), total_byte_size_, frame_count_, max_frame_size_,
       location::nearby::proto::connections::Medium_Name(medium_), total_millis,
       throughpu_mbps, throughput_kbps, file_io_time_,
       (payload_direction_ == PayloadDirection::INCOMING_PAYLOAD) ? "Decryption"
@@ -66,6 +66,9 @@ class ThroughputRecorder {
     }
 
     int64_t GetTotalByteSize() { return total_byte_size_; }
+    int64_t GetFrameCount() { return frame_count_; }
+    // The largest frame seen, which reflects the chunk size that was in use.
+    int GetMaxFrameSize() { return max_frame_size_; }
 
     bool dump();
 
@@ -74,6 +77,8 @@ class ThroughputRecorder {
     absl::Time start_timestamp_;
     PayloadType payload_type_;
     int64_t total_byte_size_ = 0;
+    int64_t frame_count_ = 0;
+    int max_frame_size_ = 0;
     absl::Time last_timestamp_;
     PayloadDirection payload_direction_ = PayloadDirection::INCOMING_PAYLOAD;
     int64_t file_io_time_ = 0;
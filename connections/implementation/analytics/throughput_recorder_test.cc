@@ -98,6 +98,25 @@ TEST_F(ThroughputRecorderTest, OnFrameSentSaveTransferredSize) {
   EXPECT_EQ(throughput.GetTotalByteSize(), kFrameSize * 3);
 }
 
+TEST_F(ThroughputRecorderTest, OnFrameSentTracksFrameSizes) {
+  auto TPRecorder = tp_recorder_container_.GetTPRecorder(
+      kPayloadIdA, PayloadDirection::OUTGOING_PAYLOAD);
+  TPRecorder->Start(PayloadType::kFile, PayloadDirection::OUTGOING_PAYLOAD);
+
+  PacketMetaData packet_meta_data;
+  packet_meta_data.SetPacketSize(kFrameSize);
+  TPRecorder->OnFrameSent(location::nearby::proto::connections::WIFI_LAN,
+                          packet_meta_data);
+  packet_meta_data.SetPacketSize(kFrameSize * 4);
+  TPRecorder->OnFrameSent(location::nearby::proto::connections::WIFI_LAN,
+                          packet_meta_data);
+
+  auto throughput = TPRecorder->GetThroughput(
+      location::nearby::proto::connections::WIFI_LAN, 0);
+  EXPECT_EQ(throughput.GetFrameCount(), 2);
+  EXPECT_EQ(throughput.GetMaxFrameSize(), kFrameSize * 4);
+}
+
 TEST_F(ThroughputRecorderTest, OnIgnoreUnkownPaylaodType) {
   auto TPRecorder = tp_recorder_container_.GetTPRecorder(
       kPayloadIdA, PayloadDirection::OUTGOING_PAYLOAD);
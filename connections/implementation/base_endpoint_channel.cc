@@ -14,13 +14,21 @@
 
 #include "connections/implementation/base_endpoint_channel.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/logging.h"
@@ -32,9 +40,15 @@ namespace connections {
 
 namespace {
 
-std::int32_t BytesToInt(const ByteArray& bytes) {
-  const char* int_bytes = bytes.data();
+// How many frames each pipeline stage may run ahead of its peer stage. One
+// frame in flight on the socket and one waiting is enough to keep the crypto
+// and I/O stages busy at the same time.
+constexpr size_t kPipelineDepth = 2;
+// How long Close() waits for queued frames, e.g. a DISCONNECTION frame, to be
+// written before the streams are closed under them.
+constexpr absl::Duration kPipelineDrainTimeout = absl::Seconds(1);
 
+std::int32_t BytesToInt(const char* int_bytes) {
   std::int32_t result = 0;
   result |= (static_cast<std::int32_t>(int_bytes[0]) & 0x0FF) << 24;
   result |= (static_cast<std::int32_t>(int_bytes[1]) & 0x0FF) << 16;
@@ -54,18 +68,6 @@ ByteArray IntToBytes(std::int32_t value) {
   return ByteArray(int_bytes, sizeof(int_bytes));
 }
 
-ExceptionOr<std::int32_t> ReadInt(InputStream* reader) {
-  ExceptionOr<ByteArray> read_bytes = reader->ReadExactly(sizeof(std::int32_t));
-  if (!read_bytes.ok()) {
-    return ExceptionOr<std::int32_t>(read_bytes.exception());
-  }
-  return ExceptionOr<std::int32_t>(BytesToInt(std::move(read_bytes.result())));
-}
-
-Exception WriteInt(OutputStream* writer, std::int32_t value) {
-  return writer->Write(IntToBytes(value));
-}
-
 }  // namespace
 
 BaseEndpointChannel::BaseEndpointChannel(const std::string& service_id,
@@ -99,39 +101,213 @@ BaseEndpointChannel::BaseEndpointChannel(
       technology_(technology),
       band_(band),
       frequency_(frequency),
-      try_count_(try_count) {}
+      try_count_(try_count),
+      enable_pipelining_(NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnablePipelinedEncryption)) {}
+
+BaseEndpointChannel::~BaseEndpointChannel() {
+  MutexLock lock(&pipeline_mutex_);
+  DCHECK(write_stage_ == nullptr && read_stage_ == nullptr);
+}
+
+void BaseEndpointChannel::ShutDownPipeline() {
+  {
+    MutexLock lock(&pipeline_mutex_);
+    if (write_stage_ == nullptr && read_stage_ == nullptr) return;
+  }
+  // The stages loop on |this| until stopped, and may be blocked in I/O.
+  StopPipeline();
+  CloseIo();
+  JoinPipeline();
+}
 
 ExceptionOr<ByteArray> BaseEndpointChannel::Read() {
   PacketMetaData packet_meta_data;
   return Read(packet_meta_data);
 }
 
-ExceptionOr<ByteArray> BaseEndpointChannel::Read(
+ExceptionOr<ByteArray> BaseEndpointChannel::ReadNextFrame(
     PacketMetaData& packet_meta_data) {
-  ByteArray result;
   {
+    // Choose the path under reader_mutex_, so that a direct read in progress
+    // finishes before the read stage starts reading the frames after it.
     MutexLock lock(&reader_mutex_);
-
-    packet_meta_data.StartSocketIo();
-    ExceptionOr<std::int32_t> read_int = ReadInt(reader_);
-    if (!read_int.ok()) {
-      return ExceptionOr<ByteArray>(read_int.exception());
+    if (!IsPipelined()) {
+      return ReadFrameLocked(packet_meta_data);
     }
+    StartReadStage();
+  }
+  return TakeReadAheadFrame(packet_meta_data);
+}
+
+ExceptionOr<ByteArray> BaseEndpointChannel::ReadFrame(
+    PacketMetaData& packet_meta_data) {
+  MutexLock lock(&reader_mutex_);
+  return ReadFrameLocked(packet_meta_data);
+}
 
-    if (read_int.result() < 0 || read_int.result() > kMaxAllowedReadBytes) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Read an invalid number of bytes: "
-                           << read_int.result();
+ExceptionOr<ByteArray> BaseEndpointChannel::ReadFrameLocked(
+    PacketMetaData& packet_meta_data) {
+  packet_meta_data.StartSocketIo();
+  if (read_error_.Raised()) {
+    return ExceptionOr<ByteArray>(read_error_);
+  }
+  // Pick up where ReadAvailable() left off, if it started on this frame.
+  if (next_prefix_size_ < sizeof(next_prefix_)) {
+    Exception exception = ReadBuffered(
+        absl::MakeSpan(next_prefix_).subspan(next_prefix_size_));
+    if (exception.Raised()) {
+      return ExceptionOr<ByteArray>(exception);
+    }
+    next_prefix_size_ = sizeof(next_prefix_);
+    if (!StartNextFrameLocked()) {
       return ExceptionOr<ByteArray>(Exception::kIo);
     }
+  }
+  Exception exception = ReadBuffered(
+      absl::MakeSpan(next_frame_.data(), next_frame_.size())
+          .subspan(next_frame_size_));
+  if (exception.Raised()) {
+    return ExceptionOr<ByteArray>(exception);
+  }
+
+  ByteArray frame = std::exchange(next_frame_, ByteArray());
+  next_prefix_size_ = 0;
+  next_frame_size_ = 0;
+  packet_meta_data.StopSocketIo();
+  packet_meta_data.SetPacketSize(frame.size() + sizeof(std::int32_t));
+  return ExceptionOr<ByteArray>(std::move(frame));
+}
+
+bool BaseEndpointChannel::StartNextFrameLocked() {
+  std::int32_t frame_size = BytesToInt(next_prefix_);
+  if (frame_size < 0 || frame_size > kMaxAllowedReadBytes) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Read an invalid number of bytes: "
+                         << frame_size;
+    return false;
+  }
+  next_frame_ = ByteArray(frame_size);
+  next_frame_size_ = 0;
+  return true;
+}
 
-    ExceptionOr<ByteArray> read_bytes = reader_->ReadExactly(read_int.result());
-    if (!read_bytes.ok()) {
-      return read_bytes;
+size_t BaseEndpointChannel::TakeReceived(absl::Span<char> buffer) {
+  size_t size = std::min(buffer.size(), receive_end_ - receive_begin_);
+  if (size > 0) {
+    std::memcpy(buffer.data(), receive_buffer_.get() + receive_begin_, size);
+    receive_begin_ += size;
+  }
+  return size;
+}
+
+Exception BaseEndpointChannel::ReadBuffered(absl::Span<char> buffer) {
+  // Serve the bytes read ahead by the previous call first.
+  buffer.remove_prefix(TakeReceived(buffer));
+
+  // Whoever polls |reader_| can't see bytes held here, so only read ahead
+  // from streams that can't be polled. A stream that waits for the whole
+  // buffer would never return a frame shorter than it, so those are read
+  // exactly as well.
+  bool read_ahead =
+      reader_->SupportsPartialReads() && reader_->GetReadinessFd() < 0;
+  while (!buffer.empty()) {
+    if (!read_ahead || buffer.size() >= kReceiveBufferSize) {
+      return reader_->ReadExactlyInto(buffer);
     }
-    packet_meta_data.StopSocketIo();
-    packet_meta_data.SetPacketSize(read_int.result() + sizeof(std::int32_t));
-    result = std::move(read_bytes.result());
+    if (receive_buffer_ == nullptr) {
+      receive_buffer_ = std::make_unique<char[]>(kReceiveBufferSize);
+    }
+    ExceptionOr<size_t> bytes_read = reader_->ReadInto(
+        absl::MakeSpan(receive_buffer_.get(), kReceiveBufferSize));
+    if (!bytes_read.ok()) {
+      return bytes_read.GetException();
+    }
+    if (bytes_read.result() == 0) {
+      return {Exception::kIo};
+    }
+    receive_begin_ = 0;
+    receive_end_ = bytes_read.result();
+    buffer.remove_prefix(TakeReceived(buffer));
+  }
+  return {Exception::kSuccess};
+}
+
+ExceptionOr<size_t> BaseEndpointChannel::AssembleNextFrame(bool may_read) {
+  bool has_read = false;
+  while (read_error_.Ok()) {
+    if (next_prefix_size_ < sizeof(next_prefix_)) {
+      next_prefix_size_ += TakeReceived(
+          absl::MakeSpan(next_prefix_).subspan(next_prefix_size_));
+      if (next_prefix_size_ == sizeof(next_prefix_) &&
+          !StartNextFrameLocked()) {
+        read_error_ = {Exception::kIo};
+        break;
+      }
+    }
+    absl::Span<char> body_left;
+    size_t missing = sizeof(next_prefix_) - next_prefix_size_;
+    if (missing == 0) {
+      body_left = absl::MakeSpan(next_frame_.data(), next_frame_.size())
+                      .subspan(next_frame_size_);
+      size_t size = TakeReceived(body_left);
+      next_frame_size_ += size;
+      body_left.remove_prefix(size);
+      missing = body_left.size();
+      if (missing == 0) return ExceptionOr<size_t>(0);
+    }
+    if (!may_read || has_read) return ExceptionOr<size_t>(missing);
+
+    // Only the first read is known not to block. A large body is read
+    // straight into the frame; anything else goes through |receive_buffer_|,
+    // so that the start of the next frame can come along.
+    has_read = true;
+    bool into_frame = body_left.size() >= kReceiveBufferSize;
+    if (!into_frame && receive_buffer_ == nullptr) {
+      receive_buffer_ = std::make_unique<char[]>(kReceiveBufferSize);
+    }
+    ExceptionOr<size_t> bytes_read = reader_->ReadInto(
+        into_frame ? body_left
+                   : absl::MakeSpan(receive_buffer_.get(), kReceiveBufferSize));
+    if (!bytes_read.ok()) {
+      read_error_ = bytes_read.GetException();
+    } else if (bytes_read.result() == 0) {
+      read_error_ = {Exception::kIo};
+    } else if (into_frame) {
+      next_frame_size_ += bytes_read.result();
+    } else {
+      receive_begin_ = 0;
+      receive_end_ = bytes_read.result();
+    }
+  }
+  return ExceptionOr<size_t>(read_error_);
+}
+
+ExceptionOr<size_t> BaseEndpointChannel::ReadAvailable() {
+  MutexLock lock(&reader_mutex_);
+  // Neither the read stage nor a stream that may wait for the whole buffer
+  // can be read from here; Read() has to.
+  if (IsPipelined() || !reader_->SupportsPartialReads()) {
+    return ExceptionOr<size_t>(0);
+  }
+  return AssembleNextFrame(/*may_read=*/true);
+}
+
+bool BaseEndpointChannel::HasBufferedFrame() {
+  MutexLock lock(&reader_mutex_);
+  if (IsPipelined()) return false;
+  // A failure is reported by the next Read(), without blocking.
+  ExceptionOr<size_t> missing = AssembleNextFrame(/*may_read=*/false);
+  return !missing.ok() || missing.result() == 0;
+}
+
+ExceptionOr<ByteArray> BaseEndpointChannel::Read(
+    PacketMetaData& packet_meta_data) {
+  ExceptionOr<ByteArray> read_frame = ReadNextFrame(packet_meta_data);
+  if (!read_frame.ok()) {
+    return read_frame;
   }
+  ByteArray result = std::move(read_frame.result());
 
   {
     MutexLock crypto_lock(&crypto_mutex_);
@@ -212,7 +388,7 @@ Exception BaseEndpointChannel::Write(const ByteArray& data,
         // If encryption is enabled, encode the message.
         packet_meta_data.StartEncryption();
         std::unique_ptr<std::string> encrypted =
-            crypto_context_->EncodeMessageToPeer(std::string(data));
+            crypto_context_->EncodeMessageToPeer(data.AsStringRef());
         packet_meta_data.StopEncryption();
         if (!encrypted) {
           NEARBY_LOGS(WARNING) << __func__ << ": Failed to encrypt data.";
@@ -230,26 +406,18 @@ Exception BaseEndpointChannel::Write(const ByteArray& data,
       return {Exception::kIo};
     }
 
+    // In pipelined mode this only waits for room in the write queue, which
+    // still tracks how fast the socket drains once the queue is full.
     packet_meta_data.StartSocketIo();
     Exception write_exception =
-        WriteInt(writer_, static_cast<std::int32_t>(data_size));
-    if (write_exception.Raised()) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Failed to write header: "
-                           << write_exception.value;
-      return write_exception;
-    }
-    write_exception = writer_->Write(*data_to_write);
+        IsPipelined()
+            ? QueueFrameForWrite(data_to_write == &encrypted_data
+                                     ? std::move(encrypted_data)
+                                     : data)
+            : WriteFrame(*data_to_write);
     if (write_exception.Raised()) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Failed to write data: "
-                           << write_exception.value;
       return write_exception;
     }
-    Exception flush_exception = writer_->Flush();
-    if (flush_exception.Raised()) {
-      NEARBY_LOGS(WARNING) << __func__ << ": Failed to flush writer: "
-                           << flush_exception.value;
-      return flush_exception;
-    }
     packet_meta_data.StopSocketIo();
     packet_meta_data.SetPacketSize(data_size + sizeof(std::uint32_t));
   }
@@ -261,6 +429,157 @@ Exception BaseEndpointChannel::Write(const ByteArray& data,
   return {Exception::kSuccess};
 }
 
+Exception BaseEndpointChannel::WriteFrame(const ByteArray& frame) {
+  // Hand the length prefix and the frame to the stream together, so that
+  // streams supporting gather writes send them with a single syscall rather
+  // than a tiny header packet followed by the body.
+  ByteArray header = IntToBytes(static_cast<std::int32_t>(frame.size()));
+  Exception write_exception = writer_->GatherWrite({&header, &frame});
+  if (write_exception.Raised()) {
+    NEARBY_LOGS(WARNING) << __func__
+                         << ": Failed to write data: " << write_exception.value;
+    return write_exception;
+  }
+  Exception flush_exception = writer_->Flush();
+  if (flush_exception.Raised()) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Failed to flush writer: "
+                         << flush_exception.value;
+    return flush_exception;
+  }
+  return {Exception::kSuccess};
+}
+
+bool BaseEndpointChannel::IsPipelined() const {
+  MutexLock lock(&pipeline_mutex_);
+  return is_pipelined_;
+}
+
+Exception BaseEndpointChannel::QueueFrameForWrite(ByteArray frame) {
+  MutexLock lock(&pipeline_mutex_);
+  while (write_queue_.size() >= kPipelineDepth && write_stage_error_.Ok() &&
+         !is_pipeline_stopped_) {
+    pipeline_cond_.Wait();
+  }
+  if (write_stage_error_.Raised()) {
+    return write_stage_error_;
+  }
+  if (is_pipeline_stopped_) {
+    return {Exception::kIo};
+  }
+  write_queue_.push_back(std::move(frame));
+  pipeline_cond_.Notify();
+  return {Exception::kSuccess};
+}
+
+ExceptionOr<ByteArray> BaseEndpointChannel::TakeReadAheadFrame(
+    PacketMetaData& packet_meta_data) {
+  MutexLock lock(&pipeline_mutex_);
+  while (read_queue_.empty() && !is_pipeline_stopped_) {
+    pipeline_cond_.Wait();
+  }
+  if (read_queue_.empty()) {
+    return ExceptionOr<ByteArray>(Exception::kIo);
+  }
+  ReadAheadFrame& next = read_queue_.front();
+  if (next.exception.Raised()) {
+    return ExceptionOr<ByteArray>(next.exception);
+  }
+  packet_meta_data = next.packet_meta_data;
+  ByteArray frame = std::move(next.frame);
+  read_queue_.pop_front();
+  pipeline_cond_.Notify();
+  return ExceptionOr<ByteArray>(std::move(frame));
+}
+
+void BaseEndpointChannel::StartReadStage() {
+  MutexLock lock(&pipeline_mutex_);
+  if (read_stage_ != nullptr || is_pipeline_stopped_) return;
+  read_stage_ = std::make_unique<SingleThreadExecutor>();
+  read_stage_->Execute("endpoint-channel-read", [this]() { RunReadStage(); });
+}
+
+void BaseEndpointChannel::RunWriteStage() {
+  while (true) {
+    ByteArray frame;
+    {
+      MutexLock lock(&pipeline_mutex_);
+      while (write_queue_.empty() && !is_pipeline_stopped_) {
+        pipeline_cond_.Wait();
+      }
+      if (write_queue_.empty()) return;
+      // The emptied slot keeps counting against kPipelineDepth until the
+      // frame is on the wire.
+      frame = std::move(write_queue_.front());
+    }
+
+    Exception write_exception = WriteFrame(frame);
+
+    MutexLock lock(&pipeline_mutex_);
+    write_queue_.pop_front();
+    pipeline_cond_.Notify();
+    if (write_exception.Raised()) {
+      write_stage_error_ = write_exception;
+      write_queue_.clear();
+      return;
+    }
+  }
+}
+
+void BaseEndpointChannel::RunReadStage() {
+  while (true) {
+    ReadAheadFrame read_ahead_frame;
+    ExceptionOr<ByteArray> read_frame =
+        ReadFrame(read_ahead_frame.packet_meta_data);
+    read_ahead_frame.exception = read_frame.GetException();
+    if (read_frame.ok()) {
+      read_ahead_frame.frame = std::move(read_frame.result());
+    }
+
+    MutexLock lock(&pipeline_mutex_);
+    while (read_queue_.size() >= kPipelineDepth && !is_pipeline_stopped_) {
+      pipeline_cond_.Wait();
+    }
+    if (is_pipeline_stopped_) return;
+    read_queue_.push_back(std::move(read_ahead_frame));
+    pipeline_cond_.Notify();
+    if (!read_frame.ok()) return;
+  }
+}
+
+void BaseEndpointChannel::StopPipeline() {
+  MutexLock lock(&pipeline_mutex_);
+  if (!is_pipelined_) {
+    // Keeps a late EnableEncryption() from starting stages on closed streams.
+    is_pipeline_stopped_ = true;
+    return;
+  }
+  absl::Time deadline = absl::Now() + kPipelineDrainTimeout;
+  while (!write_queue_.empty() && write_stage_error_.Ok()) {
+    absl::Duration remaining = deadline - absl::Now();
+    if (remaining <= absl::ZeroDuration()) {
+      NEARBY_LOGS(WARNING) << __func__ << ": Dropping " << write_queue_.size()
+                           << " queued frames on close.";
+      break;
+    }
+    pipeline_cond_.Wait(remaining);
+  }
+  is_pipeline_stopped_ = true;
+  pipeline_cond_.Notify();
+}
+
+void BaseEndpointChannel::JoinPipeline() {
+  std::unique_ptr<SingleThreadExecutor> write_stage;
+  std::unique_ptr<SingleThreadExecutor> read_stage;
+  {
+    MutexLock lock(&pipeline_mutex_);
+    write_stage = std::move(write_stage_);
+    read_stage = std::move(read_stage_);
+  }
+  // Destroying the executors waits for the stages to return.
+  write_stage.reset();
+  read_stage.reset();
+}
+
 void BaseEndpointChannel::Close() {
   {
     // In case channel is paused, resume it first thing.
@@ -272,7 +591,9 @@ void BaseEndpointChannel::Close() {
     is_closed_ = true;
     UnblockPausedWriter();
   }
+  StopPipeline();
   CloseIo();
+  JoinPipeline();
   CloseImpl();
 }
 
@@ -344,8 +665,26 @@ int BaseEndpointChannel::GetMaxTransmitPacketSize() const {
 
 void BaseEndpointChannel::EnableEncryption(
     std::shared_ptr<EncryptionContext> context) {
-  MutexLock crypto_lock(&crypto_mutex_);
-  crypto_context_ = context;
+  if (!enable_pipelining_ || context == nullptr) {
+    MutexLock crypto_lock(&crypto_mutex_);
+    crypto_context_ = context;
+    return;
+  }
+
+  // Switch to the pipeline while no direct write is in progress, so that
+  // frames written before and after the switch stay in order.
+  MutexLock lock(&writer_mutex_);
+  {
+    MutexLock crypto_lock(&crypto_mutex_);
+    crypto_context_ = context;
+  }
+  MutexLock pipeline_lock(&pipeline_mutex_);
+  if (is_pipelined_ || is_pipeline_stopped_) return;
+  is_pipelined_ = true;
+  write_stage_ = std::make_unique<SingleThreadExecutor>();
+  write_stage_->Execute("endpoint-channel-write",
+                        [this]() { RunWriteStage(); });
+  // The read stage is started by the next Read(), see ReadNextFrame().
 }
 
 void BaseEndpointChannel::DisableEncryption() {
@@ -364,7 +703,7 @@ ExceptionOr<ByteArray> BaseEndpointChannel::TryDecrypt(const ByteArray& data) {
     return Exception::kFailed;
   }
   std::unique_ptr<std::string> decrypted_data =
-      crypto_context_->DecodeMessageFromPeer(data.string_data());
+      crypto_context_->DecodeMessageFromPeer(data.AsStringRef());
   if (decrypted_data) {
     return ExceptionOr<ByteArray>(ByteArray(std::move(*decrypted_data)));
   }
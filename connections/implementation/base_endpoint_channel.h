@@ -15,19 +15,24 @@
 #ifndef CORE_INTERNAL_BASE_ENDPOINT_CHANNEL_H_
 #define CORE_INTERNAL_BASE_ENDPOINT_CHANNEL_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
 #include <string>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/types/span.h"
 #include "connections/implementation/analytics/analytics_recorder.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
 #include "connections/implementation/endpoint_channel.h"
 #include "internal/platform/byte_array.h"
+#include "internal/platform/condition_variable.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/input_stream.h"
 #include "internal/platform/mutex.h"
 #include "internal/platform/output_stream.h"
+#include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
 namespace connections {
@@ -45,16 +50,22 @@ class BaseEndpointChannel : public EndpointChannel {
       location::nearby::proto::connections::ConnectionTechnology,
       location::nearby::proto::connections::ConnectionBand band, int frequency,
       int try_count);
-  ~BaseEndpointChannel() override = default;
+  // A pipelined channel must be closed, or its pipeline shut down by the
+  // subclass, before it gets here: |reader| and |writer| may already be gone.
+  ~BaseEndpointChannel() override;
 
   // EndpointChannel:
   ExceptionOr<ByteArray> Read() override;
   ExceptionOr<ByteArray> Read(PacketMetaData& packet_meta_data)
-      ABSL_LOCKS_EXCLUDED(reader_mutex_, crypto_mutex_,
-                          last_read_mutex_) override;
+      ABSL_LOCKS_EXCLUDED(reader_mutex_, crypto_mutex_, last_read_mutex_,
+                          pipeline_mutex_) override;
   Exception Write(const ByteArray& data) override;
+  // In pipelined mode (see EnableEncryption()), returns once the frame is
+  // encrypted and queued. A failure to send it is reported by a later Write()
+  // instead.
   Exception Write(const ByteArray& data, PacketMetaData& packet_meta_data)
-      ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_) override;
+      ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_,
+                          pipeline_mutex_) override;
   void Close() ABSL_LOCKS_EXCLUDED(is_paused_mutex_) override;
   void Close(location::nearby::proto::connections::DisconnectionReason reason)
       override;
@@ -67,7 +78,14 @@ class BaseEndpointChannel : public EndpointChannel {
   int GetFrequency() const override;
   int GetTryCount() const override;
   int GetMaxTransmitPacketSize() const override;
-  void EnableEncryption(std::shared_ptr<EncryptionContext> context) override;
+  // With kEnablePipelinedEncryption set, this also starts the pipeline: frames
+  // are written by a dedicated I/O stage, and from the next Read() on, the
+  // next frame is read ahead while the caller decrypts the current one.
+  // Frames keep their order in both directions, so the UKEY2 sequence numbers
+  // stay in step with the peer.
+  void EnableEncryption(std::shared_ptr<EncryptionContext> context)
+      ABSL_LOCKS_EXCLUDED(writer_mutex_, crypto_mutex_,
+                          pipeline_mutex_) override;
   void DisableEncryption() override;
   bool IsEncrypted() override;
   ExceptionOr<ByteArray> TryDecrypt(const ByteArray& data) override;
@@ -80,18 +98,36 @@ class BaseEndpointChannel : public EndpointChannel {
       ABSL_LOCKS_EXCLUDED(last_write_mutex_) override;
   void SetAnalyticsRecorder(analytics::AnalyticsRecorder* analytics_recorder,
                             const std::string& endpoint_id) override;
+  // |reader_| is never reseated and its descriptor accessor does not touch
+  // stream state, so this is safe to call while a Read() holds the lock.
+  // Pipelined channels read ahead of their caller, so readiness of the
+  // underlying stream says nothing about whether Read() would block.
+  int GetReadinessFd() const ABSL_NO_THREAD_SAFETY_ANALYSIS override {
+    return enable_pipelining_ ? -1 : reader_->GetReadinessFd();
+  }
+  ExceptionOr<size_t> ReadAvailable()
+      ABSL_LOCKS_EXCLUDED(reader_mutex_) override;
+  bool HasBufferedFrame() ABSL_LOCKS_EXCLUDED(reader_mutex_) override;
+
+  // Used to sanity check that our frame sizes are reasonable. Frames larger
+  // than this are rejected by both the writer and the reader.
+  static constexpr std::int32_t kMaxAllowedReadBytes = 1048576;  // 1MB
 
  protected:
   virtual void CloseImpl() = 0;
+  // Stops and joins the pipeline if the channel was not closed. Subclasses
+  // that own |reader| and |writer| call this from their destructor, while the
+  // streams are still alive.
+  void ShutDownPipeline() ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
   // For tests only.
   std::unique_ptr<std::string> EncodeMessageForTests(absl::string_view data);
 
  private:
-  // Used to sanity check that our frame sizes are reasonable.
-  static constexpr std::int32_t kMaxAllowedReadBytes = 1048576;  // 1MB
-
   // The default maximum transmit unit/packet size.
   static constexpr int kDefaultMaxTransmitPacketSize = 65536;  // 64 KB
+  // Bytes read from |reader_| at once when reading ahead. Frame bodies at
+  // least this large are read straight into the frame instead.
+  static constexpr size_t kReceiveBufferSize = 16 * 1024;  // 16 KB
 
   bool IsEncryptionEnabledLocked() const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(crypto_mutex_);
@@ -99,6 +135,54 @@ class BaseEndpointChannel : public EndpointChannel {
   void BlockUntilUnpaused() ABSL_EXCLUSIVE_LOCKS_REQUIRED(is_paused_mutex_);
   void CloseIo() ABSL_NO_THREAD_SAFETY_ANALYSIS;
 
+  // Returns the next frame, read directly or taken from the read stage,
+  // without decrypting it.
+  ExceptionOr<ByteArray> ReadNextFrame(PacketMetaData& packet_meta_data)
+      ABSL_LOCKS_EXCLUDED(reader_mutex_, pipeline_mutex_);
+  // Reads one length-prefixed frame from |reader_|, without decrypting it.
+  ExceptionOr<ByteArray> ReadFrame(PacketMetaData& packet_meta_data)
+      ABSL_LOCKS_EXCLUDED(reader_mutex_);
+  ExceptionOr<ByteArray> ReadFrameLocked(PacketMetaData& packet_meta_data)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(reader_mutex_);
+  // Fills |buffer| from |reader_|, through |receive_buffer_|, so that a small
+  // frame and its length prefix can arrive in a single read.
+  Exception ReadBuffered(absl::Span<char> buffer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(reader_mutex_);
+  // Checks the length prefix in |next_prefix_| and sizes |next_frame_| for
+  // its body. Returns false if the length is invalid.
+  bool StartNextFrameLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(reader_mutex_);
+  // Moves bytes read ahead into |buffer|. Returns how many were moved.
+  size_t TakeReceived(absl::Span<char> buffer)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(reader_mutex_);
+  // Adds the bytes read ahead to |next_frame_|, then, if |may_read| and that
+  // did not complete it, reads |reader_| once. Returns how many bytes
+  // |next_frame_| still misses at least, and |read_error_| once set.
+  ExceptionOr<size_t> AssembleNextFrame(bool may_read)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(reader_mutex_);
+  // Writes one length-prefixed frame to |writer_|. Callers either hold
+  // |writer_mutex_| or are the write stage, which is then the only user of
+  // |writer_|.
+  Exception WriteFrame(const ByteArray& frame) ABSL_NO_THREAD_SAFETY_ANALYSIS;
+
+  // Pipelined mode.
+  struct ReadAheadFrame {
+    Exception exception;
+    ByteArray frame;
+    PacketMetaData packet_meta_data;
+  };
+  bool IsPipelined() const ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  Exception QueueFrameForWrite(ByteArray frame)
+      ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  ExceptionOr<ByteArray> TakeReadAheadFrame(PacketMetaData& packet_meta_data)
+      ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  void StartReadStage() ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  void RunWriteStage() ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  void RunReadStage() ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  // Gives queued writes a chance to reach the peer, then stops both stages.
+  // The stages may still be blocked in I/O until CloseIo().
+  void StopPipeline() ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+  void JoinPipeline() ABSL_LOCKS_EXCLUDED(pipeline_mutex_);
+
   // We need a separate mutex to protect read timestamp, because if a read
   // blocks on IO, we don't want timestamp read access to block too.
   mutable Mutex last_read_mutex_;
@@ -118,6 +202,20 @@ class BaseEndpointChannel : public EndpointChannel {
   // writes waiting on reads that might potentially block forever.
   Mutex reader_mutex_;
   InputStream* reader_ ABSL_PT_GUARDED_BY(reader_mutex_);
+  // Bytes read ahead of the current frame are at [receive_begin_,
+  // receive_end_). Allocated on the first read ahead.
+  std::unique_ptr<char[]> receive_buffer_ ABSL_GUARDED_BY(reader_mutex_);
+  size_t receive_begin_ ABSL_GUARDED_BY(reader_mutex_) = 0;
+  size_t receive_end_ ABSL_GUARDED_BY(reader_mutex_) = 0;
+  // The frame ReadAvailable() is assembling: the first |next_prefix_size_|
+  // bytes of its length prefix, then, once that is complete, the first
+  // |next_frame_size_| bytes of its body.
+  char next_prefix_[sizeof(std::int32_t)] ABSL_GUARDED_BY(reader_mutex_);
+  size_t next_prefix_size_ ABSL_GUARDED_BY(reader_mutex_) = 0;
+  ByteArray next_frame_ ABSL_GUARDED_BY(reader_mutex_);
+  size_t next_frame_size_ ABSL_GUARDED_BY(reader_mutex_) = 0;
+  // Set once ReadAvailable() fails; every later read fails with it.
+  Exception read_error_ ABSL_GUARDED_BY(reader_mutex_) = {Exception::kSuccess};
 
   Mutex writer_mutex_;
   OutputStream* writer_ ABSL_PT_GUARDED_BY(writer_mutex_);
@@ -141,6 +239,26 @@ class BaseEndpointChannel : public EndpointChannel {
 
   analytics::AnalyticsRecorder* analytics_recorder_ = nullptr;
   std::string endpoint_id_ = "";
+
+  // Whether this channel starts the pipeline once encryption is enabled.
+  const bool enable_pipelining_;
+  mutable Mutex pipeline_mutex_;
+  ConditionVariable pipeline_cond_{&pipeline_mutex_};
+  bool is_pipelined_ ABSL_GUARDED_BY(pipeline_mutex_) = false;
+  bool is_pipeline_stopped_ ABSL_GUARDED_BY(pipeline_mutex_) = false;
+  // Encrypted frames waiting for the write stage. The front frame stays
+  // queued while it is being written.
+  std::deque<ByteArray> write_queue_ ABSL_GUARDED_BY(pipeline_mutex_);
+  // The first write failure of the write stage; later writes fail with it.
+  Exception write_stage_error_ ABSL_GUARDED_BY(pipeline_mutex_) = {
+      Exception::kSuccess};
+  // Frames read ahead and not yet decrypted. A failed read is kept at the
+  // front, so that every later Read() reports it.
+  std::deque<ReadAheadFrame> read_queue_ ABSL_GUARDED_BY(pipeline_mutex_);
+  std::unique_ptr<SingleThreadExecutor> write_stage_
+      ABSL_GUARDED_BY(pipeline_mutex_);
+  std::unique_ptr<SingleThreadExecutor> read_stage_
+      ABSL_GUARDED_BY(pipeline_mutex_);
 };
 
 }  // namespace connections
@@ -15,15 +15,18 @@
 #include "connections/implementation/base_endpoint_channel.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "securegcm/ukey2_handshake.h"
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
@@ -31,7 +34,9 @@
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/encryption_runner.h"
 #include "connections/implementation/endpoint_channel.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
@@ -55,6 +60,7 @@ class TestEndpointChannel : public BaseEndpointChannel {
  public:
   explicit TestEndpointChannel(InputStream* input, OutputStream* output)
       : BaseEndpointChannel("service_id", "channel", input, output) {}
+  ~TestEndpointChannel() override { ShutDownPipeline(); }
 
   using BaseEndpointChannel::EncodeMessageForTests;
 
@@ -181,6 +187,96 @@ TEST(BaseEndpointChannelTest, ReadWrite) {
   EXPECT_EQ(rx_message, tx_message);
 }
 
+TEST(BaseEndpointChannelTest, ReadsBackToBackFramesOfMixedSizes) {
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  TestEndpointChannel channel_a(pipe_b.first.get(), pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  // Small frames share the reads of the receive buffer; the large one is read
+  // around it.
+  std::vector<ByteArray> tx_messages = {
+      ByteArray("a"), ByteArray(std::string(100, 'b')),
+      ByteArray(std::string(100 * 1024, 'c')), ByteArray("d")};
+  for (const ByteArray& tx_message : tx_messages) {
+    EXPECT_TRUE(channel_a.Write(tx_message).Ok());
+  }
+
+  for (const ByteArray& tx_message : tx_messages) {
+    ExceptionOr<ByteArray> rx_message = channel_b.Read();
+    ASSERT_TRUE(rx_message.ok());
+    EXPECT_EQ(rx_message.result(), tx_message);
+  }
+}
+
+// Like a stream read with InputStreamOptions::None on Windows: Read() only
+// returns once all `size` bytes have arrived.
+class FillingInputStream : public InputStream {
+ public:
+  explicit FillingInputStream(InputStream* input) : input_(input) {}
+
+  ExceptionOr<ByteArray> Read(std::int64_t size) override {
+    return input_->ReadExactly(size);
+  }
+  Exception Close() override { return input_->Close(); }
+
+ private:
+  InputStream* input_;
+};
+
+TEST(BaseEndpointChannelTest, ReadsSmallFramesFromStreamThatFillsReads) {
+  auto pipe = CreatePipe();
+  FillingInputStream input(pipe.first.get());
+  TestEndpointChannel channel_a(pipe.first.get(), pipe.second.get());
+  TestEndpointChannel channel_b(&input, pipe.second.get());
+  std::vector<ByteArray> tx_messages = {ByteArray("a"),
+                                        ByteArray(std::string(100, 'b'))};
+  for (const ByteArray& tx_message : tx_messages) {
+    EXPECT_TRUE(channel_a.Write(tx_message).Ok());
+  }
+
+  for (const ByteArray& tx_message : tx_messages) {
+    ExceptionOr<ByteArray> rx_message = channel_b.Read();
+    ASSERT_TRUE(rx_message.ok());
+    EXPECT_EQ(rx_message.result(), tx_message);
+  }
+}
+
+TEST(BaseEndpointChannelTest, ReadAvailableAssemblesFrameAcrossReads) {
+  auto [input, output] = CreatePipe();
+  TestEndpointChannel channel(input.get(), output.get());
+  // Half of the frame "hello", then the rest of it along with the frame "x".
+  EXPECT_TRUE(output->Write(ByteArray(std::string("\0\0\0\5he", 6))).Ok());
+  ExceptionOr<size_t> missing = channel.ReadAvailable();
+  ASSERT_TRUE(missing.ok());
+  EXPECT_EQ(missing.result(), 3);
+  EXPECT_FALSE(channel.HasBufferedFrame());
+
+  EXPECT_TRUE(
+      output->Write(ByteArray(std::string("llo\0\0\0\1x", 8))).Ok());
+  missing = channel.ReadAvailable();
+  ASSERT_TRUE(missing.ok());
+  EXPECT_EQ(missing.result(), 0);
+
+  ExceptionOr<ByteArray> rx_message = channel.Read();
+  ASSERT_TRUE(rx_message.ok());
+  EXPECT_EQ(rx_message.result(), ByteArray("hello"));
+  EXPECT_TRUE(channel.HasBufferedFrame());
+  rx_message = channel.Read();
+  ASSERT_TRUE(rx_message.ok());
+  EXPECT_EQ(rx_message.result(), ByteArray("x"));
+  EXPECT_FALSE(channel.HasBufferedFrame());
+}
+
+TEST(BaseEndpointChannelTest, ReadAvailableFailsOnInvalidFrameSize) {
+  auto [input, output] = CreatePipe();
+  TestEndpointChannel channel(input.get(), output.get());
+  EXPECT_TRUE(output->Write(ByteArray(std::string(4, '\xff'))).Ok());
+
+  EXPECT_FALSE(channel.ReadAvailable().ok());
+  EXPECT_TRUE(channel.HasBufferedFrame());
+  EXPECT_FALSE(channel.Read().ok());
+}
+
 TEST(BaseEndpointChannelTest, ChannelUnencryptedByDefault) {
   auto pipe = CreatePipe();
   TestEndpointChannel channel(pipe.first.get(), pipe.second.get());
@@ -346,6 +442,98 @@ TEST(BaseEndpointChannelTest, EncryptedReadWriteCanNotBeIntercepted) {
   channel_b.Close(DisconnectionReason::REMOTE_DISCONNECTION);
 }
 
+TEST(BaseEndpointChannelTest, PipelinedEncryptedReadWriteKeepsOrder) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePipelinedEncryption,
+      true);
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  TestEndpointChannel channel_a(pipe_b.first.get(), pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  auto [context_a, context_b] = DoDhKeyExchange(&channel_a, &channel_b);
+  ASSERT_NE(context_a, nullptr);
+  ASSERT_NE(context_b, nullptr);
+  channel_a.EnableEncryption(context_a);
+  channel_b.EnableEncryption(context_b);
+  // Pipelined channels read ahead, so they can not be polled.
+  EXPECT_EQ(channel_b.GetReadinessFd(), -1);
+
+  constexpr int kMessageCount = 20;
+  MultiThreadExecutor executor(1);
+  executor.Execute([&channel_a]() {
+    for (int i = 0; i < kMessageCount; ++i) {
+      EXPECT_TRUE(channel_a.Write(ByteArray(absl::StrCat("message ", i))).Ok());
+    }
+  });
+  for (int i = 0; i < kMessageCount; ++i) {
+    ExceptionOr<ByteArray> result = channel_b.Read();
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(std::string(result.result()), absl::StrCat("message ", i));
+  }
+
+  ByteArray reply{"reply"};
+  EXPECT_TRUE(channel_b.Write(reply).Ok());
+  ExceptionOr<ByteArray> result = channel_a.Read();
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result.result(), reply);
+
+  // A frame queued right before Close() still reaches the peer.
+  ByteArray last_message{"last message"};
+  EXPECT_TRUE(channel_a.Write(last_message).Ok());
+  channel_a.Close(DisconnectionReason::LOCAL_DISCONNECTION);
+  result = channel_b.Read();
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result.result(), last_message);
+
+  // Reads and writes after close fail instead of blocking.
+  EXPECT_FALSE(channel_a.Read().ok());
+  EXPECT_TRUE(channel_a.Write(last_message).Raised());
+  channel_b.Close(DisconnectionReason::REMOTE_DISCONNECTION);
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePipelinedEncryption,
+      false);
+}
+
+TEST(BaseEndpointChannelTest, PipelinedChannelCanBeDestroyedWithoutClose) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePipelinedEncryption,
+      true);
+  auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
+  auto pipe_b = CreatePipe();  // channel_b writes to pipe_b, reads from pipe_a.
+  auto channel_a = std::make_unique<TestEndpointChannel>(pipe_b.first.get(),
+                                                         pipe_a.second.get());
+  TestEndpointChannel channel_b(pipe_a.first.get(), pipe_b.second.get());
+  auto [context_a, context_b] = DoDhKeyExchange(channel_a.get(), &channel_b);
+  ASSERT_NE(context_a, nullptr);
+  ASSERT_NE(context_b, nullptr);
+  channel_a->EnableEncryption(context_a);
+  channel_b.EnableEncryption(context_b);
+
+  ByteArray reply{"reply"};
+  EXPECT_TRUE(channel_b.Write(reply).Ok());
+  ExceptionOr<ByteArray> result = channel_a->Read();
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result.result(), reply);
+  ByteArray message{"message"};
+  EXPECT_TRUE(channel_a->Write(message).Ok());
+
+  // The read stage is now blocked on pipe_b; the subclass destructor stops
+  // it while the streams are still alive.
+  channel_a.reset();
+  result = channel_b.Read();
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result.result(), message);
+
+  channel_b.Close(DisconnectionReason::REMOTE_DISCONNECTION);
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnablePipelinedEncryption,
+      false);
+}
+
 TEST(BaseEndpointChannelTest, CanBesuspendedAndResumed) {
   // Setup test communication environment.
   auto pipe_a = CreatePipe();  // channel_a writes to pipe_a, reads from pipe_b.
@@ -44,6 +44,10 @@ BleEndpointChannel::BleEndpointChannel(const std::string& service_id,
                           GetOutputStreamOrNull(socket)),
       ble_socket_(std::move(socket)) {}
 
+BleEndpointChannel::~BleEndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium BleEndpointChannel::GetMedium()
     const {
   return location::nearby::proto::connections::Medium::BLE;
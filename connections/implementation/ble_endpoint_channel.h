@@ -29,6 +29,8 @@ class BleEndpointChannel final : public BaseEndpointChannel {
   BleEndpointChannel(const std::string& service_id,
                      const std::string& channel_name, BleSocket socket);
 
+  ~BleEndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
   int GetMaxTransmitPacketSize() const override;
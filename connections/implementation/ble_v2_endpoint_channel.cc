@@ -49,6 +49,10 @@ BleV2EndpointChannel::BleV2EndpointChannel(const std::string& service_id,
                           GetOutputStreamOrNull(socket)),
       ble_socket_(std::move(socket)) {}
 
+BleV2EndpointChannel::~BleV2EndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium BleV2EndpointChannel::GetMedium()
     const {
   return location::nearby::proto::connections::Medium::BLE;
@@ -29,6 +29,8 @@ class BleV2EndpointChannel final : public BaseEndpointChannel {
   BleV2EndpointChannel(const std::string& service_id,
                        const std::string& channel_name, BleV2Socket socket);
 
+  ~BleV2EndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
   int GetMaxTransmitPacketSize() const override;
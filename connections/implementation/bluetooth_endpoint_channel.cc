@@ -44,6 +44,10 @@ BluetoothEndpointChannel::BluetoothEndpointChannel(
                           GetOutputStreamOrNull(socket)),
       bluetooth_socket_(std::move(socket)) {}
 
+BluetoothEndpointChannel::~BluetoothEndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium
 BluetoothEndpointChannel::GetMedium() const {
   return location::nearby::proto::connections::Medium::BLUETOOTH;
@@ -30,6 +30,8 @@ class BluetoothEndpointChannel final : public BaseEndpointChannel {
                            const std::string& channel_name,
                            BluetoothSocket bluetooth_socket);
 
+  ~BluetoothEndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
   int GetMaxTransmitPacketSize() const override;
@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/chunk_size_controller.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+
+namespace {
+// A larger chunk size must keep at least this fraction of the throughput
+// measured at the previous size, or the controller steps back. Slightly below
+// 1 so that measurement noise does not stop growth; bigger frames still save
+// per-frame CPU even when the link itself is the bottleneck.
+constexpr double kMinThroughputRatio = 0.9;
+}  // namespace
+
+// C++14 requires to declare this.
+constexpr absl::Duration ChunkSizeController::kMaxSendTime;
+
+ChunkSizeController::ChunkSizeController(int min_chunk_size,
+                                         int max_chunk_size)
+    : min_chunk_size_(min_chunk_size),
+      max_chunk_size_(std::max(min_chunk_size, max_chunk_size)),
+      chunk_size_(min_chunk_size) {}
+
+bool ChunkSizeController::RecordChunkSent(int chunk_size,
+                                          absl::Duration send_time) {
+  // Short chunks (the tail of a payload, small bytes payloads, or chunks cut
+  // before the last size change) say little about the current size.
+  if (chunk_size <= 0 || chunk_size < chunk_size_ / 2) return false;
+
+  ++samples_;
+  sampled_bytes_ += chunk_size;
+  sampled_time_ += std::max(send_time, absl::ZeroDuration());
+  if (samples_ < kSamplesPerDecision) return false;
+
+  absl::Duration average_send_time = sampled_time_ / samples_;
+  double throughput = sampled_time_ > absl::ZeroDuration()
+                          ? sampled_bytes_ / absl::ToDoubleSeconds(sampled_time_)
+                          : std::numeric_limits<double>::infinity();
+  ResetSamples();
+
+  if (average_send_time > kMaxSendTime) {
+    if (chunk_size_ == min_chunk_size_) return false;
+    chunk_size_ = std::max(min_chunk_size_, chunk_size_ / 2);
+    previous_chunk_size_ = 0;
+    previous_throughput_ = 0;
+    return true;
+  }
+
+  if (previous_chunk_size_ > 0 &&
+      throughput < previous_throughput_ * kMinThroughputRatio) {
+    // The last increase made things worse; stay at the smaller size.
+    max_chunk_size_ = previous_chunk_size_;
+    chunk_size_ = previous_chunk_size_;
+    previous_chunk_size_ = 0;
+    previous_throughput_ = 0;
+    return true;
+  }
+
+  if (chunk_size_ >= max_chunk_size_) return false;
+  previous_chunk_size_ = chunk_size_;
+  previous_throughput_ = throughput;
+  chunk_size_ = std::min(max_chunk_size_, chunk_size_ * 2);
+  return true;
+}
+
+void ChunkSizeController::ResetSamples() {
+  samples_ = 0;
+  sampled_bytes_ = 0;
+  sampled_time_ = absl::ZeroDuration();
+}
+
+}  // namespace connections
+}  // namespace nearby
@@ -0,0 +1,69 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_CHUNK_SIZE_CONTROLLER_H_
+#define CORE_INTERNAL_CHUNK_SIZE_CONTROLLER_H_
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+
+// Picks the payload chunk size for one endpoint channel from the observed cost
+// of sending chunks over it.
+//
+// Sizing starts at the medium's transmit packet size and doubles after every
+// window of chunks that went out quickly, up to |max_chunk_size|. If a larger
+// size turns out to deliver less throughput than the size before it, the
+// controller settles back on the smaller size. Chunks that take too long to
+// send halve the size again, but never below the starting size.
+//
+// Not thread-safe; callers serialize access.
+class ChunkSizeController {
+ public:
+  // Number of full-size chunks measured before the size is re-evaluated.
+  static constexpr int kSamplesPerDecision = 8;
+  // Average send time above which the chunk size is reduced.
+  static constexpr absl::Duration kMaxSendTime = absl::Milliseconds(200);
+
+  ChunkSizeController(int min_chunk_size, int max_chunk_size);
+
+  int GetChunkSize() const { return chunk_size_; }
+
+  // Records that a chunk of |chunk_size| bytes took |send_time| to encrypt
+  // and write to the channel. Returns true if GetChunkSize() changed.
+  bool RecordChunkSent(int chunk_size, absl::Duration send_time);
+
+ private:
+  void ResetSamples();
+
+  int min_chunk_size_;
+  int max_chunk_size_;
+  int chunk_size_;
+  // The size used before the last increase, and the throughput measured with
+  // it in bytes per second. Zero when the last change was not an increase.
+  int previous_chunk_size_ = 0;
+  double previous_throughput_ = 0;
+
+  int samples_ = 0;
+  std::int64_t sampled_bytes_ = 0;
+  absl::Duration sampled_time_ = absl::ZeroDuration();
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_CHUNK_SIZE_CONTROLLER_H_
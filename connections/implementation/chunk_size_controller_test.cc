@@ -0,0 +1,122 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/chunk_size_controller.h"
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr int kMinChunkSize = 64 * 1024;
+constexpr int kMaxChunkSize = 960 * 1024;
+
+// Sends one decision window of chunks at the current size, each taking
+// |send_time|. Returns whether the size changed at the end of the window.
+bool SendWindow(ChunkSizeController& controller, absl::Duration send_time) {
+  bool changed = false;
+  for (int i = 0; i < ChunkSizeController::kSamplesPerDecision; ++i) {
+    changed = controller.RecordChunkSent(controller.GetChunkSize(), send_time);
+  }
+  return changed;
+}
+
+// Send time for one chunk of |chunk_size| bytes over a link of |bytes_per_sec|.
+absl::Duration SendTime(int chunk_size, double bytes_per_sec) {
+  return absl::Seconds(chunk_size / bytes_per_sec);
+}
+
+TEST(ChunkSizeControllerTest, StartsAtMinimum) {
+  ChunkSizeController controller(kMinChunkSize, kMaxChunkSize);
+
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, GrowsToMaximumOnFastLink) {
+  ChunkSizeController controller(kMinChunkSize, kMaxChunkSize);
+
+  // Per-frame overhead dominates on a fast link, so throughput keeps
+  // improving as frames get bigger.
+  for (int i = 0; i < 10; ++i) {
+    int size = controller.GetChunkSize();
+    SendWindow(controller, absl::Microseconds(500) + SendTime(size, 100e6));
+  }
+
+  EXPECT_EQ(controller.GetChunkSize(), kMaxChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, DoesNotChangeBeforeWindowIsFull) {
+  ChunkSizeController controller(kMinChunkSize, kMaxChunkSize);
+
+  for (int i = 0; i < ChunkSizeController::kSamplesPerDecision - 1; ++i) {
+    EXPECT_FALSE(
+        controller.RecordChunkSent(kMinChunkSize, absl::Milliseconds(1)));
+  }
+
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, IgnoresShortChunks) {
+  ChunkSizeController controller(kMinChunkSize, kMaxChunkSize);
+
+  for (int i = 0; i < 2 * ChunkSizeController::kSamplesPerDecision; ++i) {
+    EXPECT_FALSE(controller.RecordChunkSent(100, absl::Milliseconds(1)));
+  }
+
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, StepsBackWhenLargerChunksAreSlower) {
+  ChunkSizeController controller(kMinChunkSize, kMaxChunkSize);
+
+  ASSERT_TRUE(SendWindow(controller, SendTime(kMinChunkSize, 10e6)));
+  ASSERT_EQ(controller.GetChunkSize(), 2 * kMinChunkSize);
+
+  // Doubling the size halves the throughput.
+  EXPECT_TRUE(SendWindow(controller, SendTime(2 * kMinChunkSize, 5e6)));
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+
+  // The smaller size is now the ceiling.
+  EXPECT_FALSE(SendWindow(controller, SendTime(kMinChunkSize, 10e6)));
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, ShrinksWhenSendsAreSlow) {
+  ChunkSizeController controller(kMinChunkSize, kMaxChunkSize);
+  SendWindow(controller, absl::Milliseconds(1));
+  SendWindow(controller, absl::Milliseconds(1));
+  ASSERT_EQ(controller.GetChunkSize(), 4 * kMinChunkSize);
+
+  EXPECT_TRUE(SendWindow(controller, absl::Seconds(1)));
+  EXPECT_EQ(controller.GetChunkSize(), 2 * kMinChunkSize);
+  EXPECT_TRUE(SendWindow(controller, absl::Seconds(1)));
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+
+  // Never below the starting size.
+  EXPECT_FALSE(SendWindow(controller, absl::Seconds(1)));
+  EXPECT_EQ(controller.GetChunkSize(), kMinChunkSize);
+}
+
+TEST(ChunkSizeControllerTest, FixedWhenMaximumIsMinimum) {
+  ChunkSizeController controller(512, 512);
+
+  EXPECT_FALSE(SendWindow(controller, absl::Microseconds(10)));
+  EXPECT_EQ(controller.GetChunkSize(), 512);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
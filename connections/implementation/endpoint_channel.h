@@ -121,6 +121,22 @@ class EndpointChannel {
   virtual void SetAnalyticsRecorder(
       analytics::AnalyticsRecorder* analytics_recorder,
       const std::string& endpoint_id) = 0;
+
+  // Returns a descriptor that polls readable when bytes of the next frame
+  // arrive, or -1 if this channel can only be read by blocking in Read().
+  virtual int GetReadinessFd() const { return -1; }
+
+  // Once GetReadinessFd() polled readable: reads what has arrived, with at
+  // most one read of the underlying stream, so it does not block. Returns how
+  // many more bytes the next frame needs at least; once that is 0, Read()
+  // returns the frame without blocking.
+  virtual ExceptionOr<size_t> ReadAvailable() {
+    return ExceptionOr<size_t>(0);
+  }
+
+  // Returns true if the bytes already read hold a complete frame, which the
+  // next Read() returns without blocking. Never reads the stream.
+  virtual bool HasBufferedFrame() { return false; }
 };
 
 inline bool operator==(const EndpointChannel& lhs, const EndpointChannel& rhs) {
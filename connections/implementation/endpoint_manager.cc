@@ -17,19 +17,25 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/time/time.h"
 #include "connections/implementation/analytics/throughput_recorder.h"
+#include "connections/implementation/base_endpoint_channel.h"
+#include "connections/implementation/chunk_size_controller.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
 #include "connections/implementation/endpoint_channel_manager.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames.h"
 #include "connections/implementation/payload_manager.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/implementation/service_id_constants.h"
+#include "internal/flags/nearby_flags.h"
+#include "internal/platform/cancelable.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/logging.h"
@@ -44,6 +50,7 @@ namespace connections {
 namespace {
 using ::location::nearby::analytics::proto::ConnectionsLog;
 using ::location::nearby::connections::OfflineFrame;
+using ::location::nearby::connections::PayloadTransferFrame;
 using ::location::nearby::connections::V1Frame;
 using ::nearby::analytics::PacketMetaData;
 
@@ -56,8 +63,148 @@ constexpr absl::Time kInvalidTimestamp = absl::InfinitePast();
 // The maximum time we will wait for the encryption setup during negotiating a
 // connection.
 constexpr absl::Duration kDecryptRetryTimeout = absl::Seconds(3);
+// Workers that read and process frames for all reactor-driven endpoints. A
+// worker only parses frames that have fully arrived, but a FrameProcessor
+// handling one may block, so this is more than one, but it does not grow
+// with the number of endpoints.
+constexpr int kReactorWorkerCount = 4;
+// Adaptive chunks stay this far below the frame size limit to leave room for
+// the payload header, the frame encoding and the encryption overhead.
+constexpr int kFrameOverheadAllowance = 64 * 1024;
+constexpr int kMaxAdaptiveChunkSize =
+    BaseEndpointChannel::kMaxAllowedReadBytes - kFrameOverheadAllowance;
+
+// Mediums with enough bandwidth that chunks larger than the default 64 KB
+// packet size pay off.
+bool IsAdaptiveChunkSizeMedium(Medium medium) {
+  switch (medium) {
+    case Medium::WIFI_LAN:
+    case Medium::WIFI_HOTSPOT:
+    case Medium::WIFI_DIRECT:
+    case Medium::WIFI_AWARE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The time spent getting a frame onto the wire after it was built.
+absl::Duration GetSendTime(const PacketMetaData& packet_meta_data) {
+  absl::Duration send_time = absl::ZeroDuration();
+  if (packet_meta_data.encryption_end_time >
+      packet_meta_data.encryption_start_time) {
+    send_time += packet_meta_data.encryption_end_time -
+                 packet_meta_data.encryption_start_time;
+  }
+  if (packet_meta_data.socket_io_end_time >
+      packet_meta_data.socket_io_start_time) {
+    send_time += packet_meta_data.socket_io_end_time -
+                 packet_meta_data.socket_io_start_time;
+  }
+  return send_time;
+}
 }  // namespace
 
+struct EndpointManager::ReactorEndpoint {
+  ReactorEndpoint(IoReactor* reactor, ClientProxy* client,
+                  const std::string& endpoint_id,
+                  absl::Duration keep_alive_interval,
+                  absl::Duration keep_alive_timeout)
+      : reactor(reactor),
+        client(client),
+        endpoint_id(endpoint_id),
+        keep_alive_interval(keep_alive_interval),
+        keep_alive_timeout(keep_alive_timeout) {}
+
+  // Counts a task about to run for this endpoint. Returns false once the
+  // endpoint has been stopped, in which case the task must not run.
+  bool BeginTask() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    if (stopped) return false;
+    ++tasks_in_flight;
+    return true;
+  }
+
+  void EndTask() {
+    MutexLock lock(&mutex);
+    if (--tasks_in_flight == 0) idle.Notify();
+  }
+
+  // Stops the KeepAlive timer and the channel watch, and waits for tasks in
+  // flight. Must not be called from one of those tasks.
+  void Stop();
+
+  IoReactor* const reactor;
+  ClientProxy* const client;
+  const std::string endpoint_id;
+  const absl::Duration keep_alive_interval;
+  const absl::Duration keep_alive_timeout;
+
+  Mutex mutex;
+  ConditionVariable idle{&mutex};
+  bool stopped ABSL_GUARDED_BY(mutex) = false;
+  int tasks_in_flight ABSL_GUARDED_BY(mutex) = 0;
+  IoReactor::WatchId watch_id ABSL_GUARDED_BY(mutex) =
+      IoReactor::kInvalidWatchId;
+  Cancelable keep_alive_task ABSL_GUARDED_BY(mutex);
+  // Reads channels that cannot be polled, the same way as without a reactor.
+  std::unique_ptr<SingleThreadExecutor> fallback_reader ABSL_GUARDED_BY(mutex);
+
+  // Watches are one-shot, so at most one task reads the endpoint at a time;
+  // the read state needs no lock. The same holds for the KeepAlive state,
+  // since the next check is only scheduled once the current one is done.
+  std::shared_ptr<EndpointChannel> read_channel;
+  Medium read_last_failed_medium = Medium::UNKNOWN_MEDIUM;
+  bool try_decrypting = false;
+  Medium keep_alive_last_failed_medium = Medium::UNKNOWN_MEDIUM;
+};
+
+void EndpointManager::ReactorEndpoint::Stop() {
+  Cancelable pending_keep_alive;
+  IoReactor::WatchId last_watch_id;
+  {
+    MutexLock lock(&mutex);
+    stopped = true;
+    pending_keep_alive = keep_alive_task;
+    last_watch_id = std::exchange(watch_id, IoReactor::kInvalidWatchId);
+  }
+  // Unwatching right away closes the reactor's copy of the socket, so that
+  // closing the channel is enough for the peer to see it go. Unwatch() waits
+  // for a running reactor callback, which takes |mutex|.
+  reactor->Unwatch(last_watch_id);
+  // This does not wait for a KeepAlive timer task that has already started.
+  // Such a task either sees |stopped| and does nothing, or has counted itself
+  // in |tasks_in_flight| and is waited for below.
+  pending_keep_alive.Cancel();
+
+  std::unique_ptr<SingleThreadExecutor> reader;
+  {
+    MutexLock lock(&mutex);
+    while (tasks_in_flight > 0) idle.Wait();
+    reader = std::move(fallback_reader);
+  }
+  // Joins the fallback reader thread, if one was started.
+  reader.reset();
+}
+
+void EndpointManager::FrameProcessor::OnIncomingPayloadData(
+    parser::PayloadDataFrame& data_frame, const std::string& from_endpoint_id,
+    ClientProxy* to_client,
+    location::nearby::proto::connections::Medium current_medium,
+    PacketMetaData& packet_meta_data) {
+  OfflineFrame frame;
+  frame.set_version(OfflineFrame::V1);
+  auto* v1_frame = frame.mutable_v1();
+  v1_frame->set_type(V1Frame::PAYLOAD_TRANSFER);
+  auto* payload_transfer = v1_frame->mutable_payload_transfer();
+  payload_transfer->set_packet_type(PayloadTransferFrame::DATA);
+  *payload_transfer->mutable_payload_header() = std::move(data_frame.header);
+  *payload_transfer->mutable_payload_chunk() = std::move(data_frame.chunk);
+  payload_transfer->mutable_payload_chunk()->set_body(
+      std::string(data_frame.body));
+  OnIncomingFrame(frame, from_endpoint_id, to_client, current_medium,
+                  packet_meta_data);
+}
+
 class EndpointManager::LockedFrameProcessor {
  public:
   explicit LockedFrameProcessor(FrameProcessorWithMutex* fp)
@@ -116,64 +263,14 @@ void EndpointManager::EndpointChannelLoopRunnable(
              runnable_name.c_str(), endpoint_id.c_str());
   Medium last_failed_medium = Medium::UNKNOWN_MEDIUM;
   while (true) {
-    // It's important to keep re-fetching the EndpointChannel for an endpoint
-    // because it can be changed out from under us (for example, when we
-    // upgrade from Bluetooth to Wifi).
     std::shared_ptr<EndpointChannel> channel =
-        channel_manager_->GetChannelForEndpoint(endpoint_id);
-    if (channel == nullptr) {
-      NEARBY_LOG(INFO, "Endpoint channel is nullptr, bail out.");
-      break;
-    }
-
-    // If we're looping back around after a failure, and there's not a new
-    // EndpointChannel for this endpoint, there's nothing more to do here.
-    if ((last_failed_medium != Medium::UNKNOWN_MEDIUM) &&
-        (channel->GetMedium() == last_failed_medium)) {
-      NEARBY_LOG(
-          INFO, "No new endpoint channel is found after a failure, exit loop.");
-      break;
-    }
+        GetChannelForLoop(endpoint_id, last_failed_medium);
+    if (channel == nullptr) break;
 
     ExceptionOr<bool> keep_using_channel = handler(channel.get());
 
-    if (!keep_using_channel.ok()) {
-      Exception exception = keep_using_channel.GetException();
-      // An "invalid proto" may be a final payload on a channel we're about to
-      // close, so we'll loop back around once. We set |last_failed_medium| to
-      // ensure we don't loop indefinitely. See crbug.com/1182031 for more
-      // detail.
-      if (exception.Raised(Exception::kInvalidProtocolBuffer)) {
-        last_failed_medium = channel->GetMedium();
-        NEARBY_LOGS(INFO)
-            << "Received invalid protobuf message, re-fetching endpoint "
-               "channel; last_failed_medium="
-            << location::nearby::proto::connections::Medium_Name(
-                   last_failed_medium);
-        continue;
-      }
-      if (exception.Raised(Exception::kIo)) {
-        last_failed_medium = channel->GetMedium();
-        NEARBY_LOGS(INFO)
-            << "Endpoint channel IO exception; last_failed_medium="
-            << location::nearby::proto::connections::Medium_Name(
-                   last_failed_medium);
-        continue;
-      }
-      if (exception.Raised(Exception::kInterrupted)) {
-        break;
-      }
-    }
-
-    if (!keep_using_channel.result()) {
-      NEARBY_LOGS(INFO) << "Dropping current channel: last medium="
-                        << location::nearby::proto::connections::Medium_Name(
-                               last_failed_medium);
-      if (client->IsSafeToDisconnectEnabled(endpoint_id)) {
-        channel_manager_->MarkEndpointStopWaitToDisconnect(
-            endpoint_id, /* is_safe_to_disconnect */ false,
-            /* notify_stop_waiting */ true);
-      }
+    if (!ShouldContinueChannelLoop(client, endpoint_id, *channel,
+                                   keep_using_channel, last_failed_medium)) {
       break;
     }
   }
@@ -188,6 +285,74 @@ void EndpointManager::EndpointChannelLoopRunnable(
                     << "; endpoint_id=" << endpoint_id;
 }
 
+std::shared_ptr<EndpointChannel> EndpointManager::GetChannelForLoop(
+    const std::string& endpoint_id, Medium last_failed_medium) {
+  // It's important to keep re-fetching the EndpointChannel for an endpoint
+  // because it can be changed out from under us (for example, when we
+  // upgrade from Bluetooth to Wifi).
+  std::shared_ptr<EndpointChannel> channel =
+      channel_manager_->GetChannelForEndpoint(endpoint_id);
+  if (channel == nullptr) {
+    NEARBY_LOG(INFO, "Endpoint channel is nullptr, bail out.");
+    return nullptr;
+  }
+
+  // If we're looping back around after a failure, and there's not a new
+  // EndpointChannel for this endpoint, there's nothing more to do here.
+  if ((last_failed_medium != Medium::UNKNOWN_MEDIUM) &&
+      (channel->GetMedium() == last_failed_medium)) {
+    NEARBY_LOG(INFO,
+               "No new endpoint channel is found after a failure, exit loop.");
+    return nullptr;
+  }
+  return channel;
+}
+
+bool EndpointManager::ShouldContinueChannelLoop(
+    ClientProxy* client, const std::string& endpoint_id,
+    const EndpointChannel& channel, const ExceptionOr<bool>& result,
+    Medium& last_failed_medium) {
+  if (!result.ok()) {
+    Exception exception = result.GetException();
+    // An "invalid proto" may be a final payload on a channel we're about to
+    // close, so we'll loop back around once. We set |last_failed_medium| to
+    // ensure we don't loop indefinitely. See crbug.com/1182031 for more
+    // detail.
+    if (exception.Raised(Exception::kInvalidProtocolBuffer)) {
+      last_failed_medium = channel.GetMedium();
+      NEARBY_LOGS(INFO)
+          << "Received invalid protobuf message, re-fetching endpoint "
+             "channel; last_failed_medium="
+          << location::nearby::proto::connections::Medium_Name(
+                 last_failed_medium);
+      return true;
+    }
+    if (exception.Raised(Exception::kIo)) {
+      last_failed_medium = channel.GetMedium();
+      NEARBY_LOGS(INFO) << "Endpoint channel IO exception; last_failed_medium="
+                        << location::nearby::proto::connections::Medium_Name(
+                               last_failed_medium);
+      return true;
+    }
+    if (exception.Raised(Exception::kInterrupted)) {
+      return false;
+    }
+  }
+
+  if (!result.result()) {
+    NEARBY_LOGS(INFO) << "Dropping current channel: last medium="
+                      << location::nearby::proto::connections::Medium_Name(
+                             last_failed_medium);
+    if (client->IsSafeToDisconnectEnabled(endpoint_id)) {
+      channel_manager_->MarkEndpointStopWaitToDisconnect(
+          endpoint_id, /* is_safe_to_disconnect */ false,
+          /* notify_stop_waiting */ true);
+    }
+    return false;
+  }
+  return true;
+}
+
 ExceptionOr<OfflineFrame> EndpointManager::TryDecryptFrame(
     const ByteArray& data, EndpointChannel* endpoint_channel) {
   auto start_time = SystemClock::ElapsedRealtime();
@@ -221,70 +386,97 @@ ExceptionOr<bool> EndpointManager::HandleData(
   // a replacement for this endpoint since we last checked with the
   // EndpointChannelManager.
   while (true) {
-    PacketMetaData packet_meta_data;
-    ExceptionOr<ByteArray> bytes = endpoint_channel->Read(packet_meta_data);
-    if (!bytes.ok()) {
-      NEARBY_LOG(INFO, "Stop reading on read-time exception: %d",
-                 bytes.exception());
-      return ExceptionOr<bool>(bytes.exception());
+    Exception exception = HandleNextFrame(endpoint_id, client,
+                                          endpoint_channel, try_decrypting);
+    if (!exception.Ok()) {
+      return ExceptionOr<bool>(exception);
     }
-    ExceptionOr<OfflineFrame> wrapped_frame = parser::FromBytes(bytes.result());
-    if (!wrapped_frame.ok() && try_decrypting) {
-      // Workaround for a race condition where the remote party has sent an
-      // encrypted message but our end was still configured as unencrypted when
-      // the message was received. The workaround is to wait until the
-      // encryption set-up has completed on another thread. We run this
-      // workaround if:
-      // - the connection was unencrypted when we started reading from the
-      // channel
-      // - the received frame looks wrong (corrupted)
-      // - it's the first invalid frame.
-      try_decrypting = false;
-      ExceptionOr<OfflineFrame> decrypted =
-          TryDecryptFrame(bytes.result(), endpoint_channel);
-      if (decrypted.ok()) {
-        wrapped_frame = std::move(decrypted);
-      }
+  }
+}
+
+Exception EndpointManager::HandleNextFrame(const std::string& endpoint_id,
+                                           ClientProxy* client,
+                                           EndpointChannel* endpoint_channel,
+                                           bool& try_decrypting) {
+  PacketMetaData packet_meta_data;
+  ExceptionOr<ByteArray> bytes = endpoint_channel->Read(packet_meta_data);
+  if (!bytes.ok()) {
+    NEARBY_LOG(INFO, "Stop reading on read-time exception: %d",
+               bytes.exception());
+    return bytes.GetException();
+  }
+  // DATA frames make up nearly all of the traffic. Hand them to the
+  // PAYLOAD_TRANSFER processor straight from |bytes|, without the copies and
+  // allocations of a full OfflineFrame.
+  std::optional<parser::PayloadDataFrame> data_frame =
+      parser::PayloadDataFrameFromBytes(bytes.result().AsStringView());
+  if (data_frame.has_value()) {
+    LockedFrameProcessor frame_processor =
+        GetFrameProcessor(V1Frame::PAYLOAD_TRANSFER);
+    if (frame_processor) {
+      frame_processor->OnIncomingPayloadData(*data_frame, endpoint_id, client,
+                                             endpoint_channel->GetMedium(),
+                                             packet_meta_data);
+      return {Exception::kSuccess};
     }
-    if (!wrapped_frame.ok()) {
-      if (wrapped_frame.GetException().Raised(
-              Exception::kInvalidProtocolBuffer)) {
-        NEARBY_LOG(INFO, "Failed to decode; endpoint=%s; channel=%s; skip",
-                   endpoint_id.c_str(), endpoint_channel->GetType().c_str());
-        continue;
-      } else {
-        NEARBY_LOG(INFO, "Stop reading on parse-time exception: %d",
-                   wrapped_frame.exception());
-        return ExceptionOr<bool>(wrapped_frame.exception());
-      }
+  }
+  ExceptionOr<OfflineFrame> wrapped_frame = parser::FromBytes(bytes.result());
+  if (!wrapped_frame.ok() && try_decrypting) {
+    // Workaround for a race condition where the remote party has sent an
+    // encrypted message but our end was still configured as unencrypted when
+    // the message was received. The workaround is to wait until the
+    // encryption set-up has completed on another thread. We run this
+    // workaround if:
+    // - the connection was unencrypted when we started reading from the
+    // channel
+    // - the received frame looks wrong (corrupted)
+    // - it's the first invalid frame.
+    try_decrypting = false;
+    ExceptionOr<OfflineFrame> decrypted =
+        TryDecryptFrame(bytes.result(), endpoint_channel);
+    if (decrypted.ok()) {
+      wrapped_frame = std::move(decrypted);
     }
-    OfflineFrame& frame = wrapped_frame.result();
-
-    // Route the incoming offlineFrame to its registered processor.
-    V1Frame::FrameType frame_type = parser::GetFrameType(frame);
-    LockedFrameProcessor frame_processor = GetFrameProcessor(frame_type);
-    if (!frame_processor) {
-      // report messages without handlers, except KEEP_ALIVE, which has
-      // no explicit handler.
-      if (frame_type == V1Frame::KEEP_ALIVE) {
-        NEARBY_LOG(INFO, "KeepAlive message for endpoint %s",
-                   endpoint_id.c_str());
-      } else if (frame_type == V1Frame::DISCONNECTION) {
-        NEARBY_LOG(INFO, "Disconnect message for endpoint %s",
-                   endpoint_id.c_str());
-        ProcessDisconnectionFrame(client, endpoint_id, endpoint_channel, frame);
-      } else {
-        NEARBY_LOGS(ERROR) << "Unhandled message: endpoint_id=" << endpoint_id
-                           << ", frame type="
-                           << V1Frame::FrameType_Name(frame_type);
-      }
-      continue;
+  }
+  if (!wrapped_frame.ok()) {
+    if (wrapped_frame.GetException().Raised(
+            Exception::kInvalidProtocolBuffer)) {
+      NEARBY_LOG(INFO, "Failed to decode; endpoint=%s; channel=%s; skip",
+                 endpoint_id.c_str(), endpoint_channel->GetType().c_str());
+      return {Exception::kSuccess};
+    } else {
+      NEARBY_LOG(INFO, "Stop reading on parse-time exception: %d",
+                 wrapped_frame.exception());
+      return wrapped_frame.GetException();
     }
-
-    frame_processor->OnIncomingFrame(frame, endpoint_id, client,
-                                     endpoint_channel->GetMedium(),
-                                     packet_meta_data);
   }
+  OfflineFrame& frame = wrapped_frame.result();
+
+  // Route the incoming offlineFrame to its registered processor.
+  V1Frame::FrameType frame_type = parser::GetFrameType(frame);
+  LockedFrameProcessor frame_processor = GetFrameProcessor(frame_type);
+  if (!frame_processor) {
+    // report messages without handlers, except KEEP_ALIVE, which has
+    // no explicit handler.
+    if (frame_type == V1Frame::KEEP_ALIVE) {
+      NEARBY_LOG(INFO, "KeepAlive message for endpoint %s",
+                 endpoint_id.c_str());
+    } else if (frame_type == V1Frame::DISCONNECTION) {
+      NEARBY_LOG(INFO, "Disconnect message for endpoint %s",
+                 endpoint_id.c_str());
+      ProcessDisconnectionFrame(client, endpoint_id, endpoint_channel, frame);
+    } else {
+      NEARBY_LOGS(ERROR) << "Unhandled message: endpoint_id=" << endpoint_id
+                         << ", frame type="
+                         << V1Frame::FrameType_Name(frame_type);
+    }
+    return {Exception::kSuccess};
+  }
+
+  frame_processor->OnIncomingFrame(frame, endpoint_id, client,
+                                   endpoint_channel->GetMedium(),
+                                   packet_meta_data);
+  return {Exception::kSuccess};
 }
 
 void EndpointManager::ProcessDisconnectionFrame(
@@ -347,6 +539,27 @@ ExceptionOr<bool> EndpointManager::HandleKeepAlive(
     EndpointChannel* endpoint_channel, absl::Duration keep_alive_interval,
     absl::Duration keep_alive_timeout, Mutex* keep_alive_waiter_mutex,
     ConditionVariable* keep_alive_waiter) {
+  absl::Duration wait_for;
+  ExceptionOr<bool> keep_alive = CheckKeepAlive(
+      endpoint_channel, keep_alive_interval, keep_alive_timeout, wait_for);
+  if (!keep_alive.ok()) {
+    return keep_alive;
+  }
+
+  {
+    MutexLock lock(keep_alive_waiter_mutex);
+    Exception wait_exception = keep_alive_waiter->Wait(wait_for);
+    if (!wait_exception.Ok()) {
+      return ExceptionOr<bool>(wait_exception);
+    }
+  }
+
+  return ExceptionOr<bool>(true);
+}
+
+ExceptionOr<bool> EndpointManager::CheckKeepAlive(
+    EndpointChannel* endpoint_channel, absl::Duration keep_alive_interval,
+    absl::Duration keep_alive_timeout, absl::Duration& next_check) {
   // Check if it has been too long since we received a frame from our endpoint.
   absl::Time last_read_time = endpoint_channel->GetLastReadTimestamp();
   absl::Duration duration_until_timeout =
@@ -376,16 +589,8 @@ ExceptionOr<bool> EndpointManager::HandleKeepAlive(
     duration_until_write_keep_alive = keep_alive_interval;
   }
 
-  absl::Duration wait_for =
+  next_check =
       std::min(duration_until_timeout, duration_until_write_keep_alive);
-  {
-    MutexLock lock(keep_alive_waiter_mutex);
-    Exception wait_exception = keep_alive_waiter->Wait(wait_for);
-    if (!wait_exception.Ok()) {
-      return ExceptionOr<bool>(wait_exception);
-    }
-  }
-
   return ExceptionOr<bool>(true);
 }
 
@@ -409,7 +614,35 @@ EndpointManager::EndpointManager(EndpointChannelManager* manager)
 EndpointManager::EndpointManager(
     EndpointChannelManager* manager,
     std::unique_ptr<SingleThreadExecutor> serial_executor)
-    : channel_manager_(manager), serial_executor_(std::move(serial_executor)) {}
+    : EndpointManager(
+          manager, std::move(serial_executor),
+          NearbyFlags::GetInstance().GetBoolFlag(
+              config_package_nearby::nearby_connections_feature::
+                  kEnableEndpointReactor)
+              ? std::make_unique<IoReactor>()
+              : nullptr) {}
+
+EndpointManager::EndpointManager(
+    EndpointChannelManager* manager,
+    std::unique_ptr<SingleThreadExecutor> serial_executor,
+    std::unique_ptr<IoReactor> reactor)
+    : channel_manager_(manager),
+      enable_adaptive_chunk_size_(NearbyFlags::GetInstance().GetBoolFlag(
+          config_package_nearby::nearby_connections_feature::
+              kEnableAdaptiveChunkSize)),
+      serial_executor_(std::move(serial_executor)) {
+  if (reactor == nullptr) return;
+  if (reactor->IsValid()) {
+    NEARBY_LOGS(INFO) << "EndpointManager reads endpoints from a reactor.";
+    reactor_ = std::move(reactor);
+    reactor_workers_ =
+        std::make_unique<MultiThreadExecutor>(kReactorWorkerCount);
+    keep_alive_timer_ = std::make_unique<ScheduledExecutor>();
+  } else {
+    NEARBY_LOGS(INFO) << "No I/O reactor on this platform; EndpointManager "
+                         "keeps a reader thread per endpoint.";
+  }
+}
 
 EndpointManager::~EndpointManager() {
   NEARBY_LOG(INFO, "Initiating shutdown of EndpointManager.");
@@ -500,6 +733,8 @@ void EndpointManager::RemoveEndpointState(const std::string& endpoint_id) {
   } else {
     NEARBY_LOGS(INFO) << "EndpointState not found for endpoint " << endpoint_id;
   }
+  MutexLock lock(&chunk_size_mutex_);
+  chunk_sizes_.erase(endpoint_id);
 }
 
 void EndpointManager::RegisterEndpoint(
@@ -552,6 +787,19 @@ void EndpointManager::RegisterEndpoint(
             .emplace(endpoint_id, EndpointState(endpoint_id, channel_manager_))
             .first->second;
 
+    if (reactor_) {
+      NEARBY_LOGS(INFO) << "Starting reactor workers: endpoint "
+                        << endpoint_id;
+      endpoint_state.SetReactorEndpoint(StartReactorEndpoint(
+          client, endpoint_id, keep_alive_interval, keep_alive_timeout));
+      NEARBY_LOGS(INFO) << "Registering endpoint " << endpoint_id
+                        << ", workers started and notifying client.";
+      client->OnConnectionInitiated(endpoint_id, info, connection_options,
+                                    listener, connection_token);
+      latch.CountDown();
+      return;
+    }
+
     NEARBY_LOGS(INFO) << "Starting workers: endpoint " << endpoint_id;
     // For every endpoint, there's normally only one Read handler instance
     // running on a dedicated thread. This instance reads data from the
@@ -632,6 +880,54 @@ int EndpointManager::GetMaxTransmitPacketSize(const std::string& endpoint_id) {
   return channel->GetMaxTransmitPacketSize();
 }
 
+int EndpointManager::GetPreferredChunkSize(const std::string& endpoint_id) {
+  std::shared_ptr<EndpointChannel> channel =
+      channel_manager_->GetChannelForEndpoint(endpoint_id);
+  if (channel == nullptr) {
+    return 0;
+  }
+
+  int max_transmit_packet_size = channel->GetMaxTransmitPacketSize();
+  if (!enable_adaptive_chunk_size_ ||
+      !IsAdaptiveChunkSizeMedium(channel->GetMedium())) {
+    return max_transmit_packet_size;
+  }
+
+  MutexLock lock(&chunk_size_mutex_);
+  auto it = chunk_sizes_.find(endpoint_id);
+  if (it == chunk_sizes_.end() || it->second.channel.lock() != channel) {
+    NEARBY_LOGS(INFO) << "Start adaptive chunk sizing for endpoint "
+                      << endpoint_id << " at " << max_transmit_packet_size
+                      << " bytes";
+    it = chunk_sizes_
+             .insert_or_assign(
+                 endpoint_id,
+                 ChunkSizeState{channel,
+                                ChunkSizeController(max_transmit_packet_size,
+                                                    kMaxAdaptiveChunkSize)})
+             .first;
+  }
+  return it->second.controller.GetChunkSize();
+}
+
+void EndpointManager::RecordFrameSent(
+    const std::string& endpoint_id,
+    const std::shared_ptr<EndpointChannel>& channel, int frame_size,
+    const PacketMetaData& packet_meta_data) {
+  MutexLock lock(&chunk_size_mutex_);
+  auto it = chunk_sizes_.find(endpoint_id);
+  if (it == chunk_sizes_.end() || it->second.channel.lock() != channel) {
+    return;
+  }
+  ChunkSizeController& controller = it->second.controller;
+  if (controller.RecordChunkSent(frame_size, GetSendTime(packet_meta_data))) {
+    NEARBY_LOGS(INFO) << "Chunk size for endpoint " << endpoint_id << " over "
+                      << location::nearby::proto::connections::Medium_Name(
+                             channel->GetMedium())
+                      << " is now " << controller.GetChunkSize() << " bytes";
+  }
+}
+
 std::vector<std::string> EndpointManager::SendPayloadChunk(
     const PayloadTransferFrame::PayloadHeader& payload_header,
     const PayloadTransferFrame::PayloadChunk& payload_chunk,
@@ -648,6 +944,19 @@ std::vector<std::string> EndpointManager::SendPayloadChunk(
       packet_meta_data);
 }
 
+bool EndpointManager::SendPayloadFrame(const std::string& endpoint_id,
+                                       const ByteArray& frame,
+                                       std::int64_t payload_id,
+                                       std::int64_t offset,
+                                       PacketMetaData& packet_meta_data) {
+  return SendTransferFrameBytes(
+             {endpoint_id}, frame, payload_id, offset,
+             /*packet_type=*/
+             PayloadTransferFrame::PacketType_Name(PayloadTransferFrame::DATA),
+             packet_meta_data)
+      .empty();
+}
+
 // Designed to run asynchronously. It is called from IO thread pools, and
 // jobs in these pools may be waited for from the EndpointManager thread. If
 // we allow synchronous behavior here it will cause a live lock.
@@ -916,6 +1225,9 @@ std::vector<std::string> EndpointManager::SendTransferFrameBytes(
     analytics::ThroughputRecorderContainer::GetInstance()
         .GetTPRecorder(payload_id, PayloadDirection::OUTGOING_PAYLOAD)
         ->OnFrameSent(channel->GetMedium(), packet_meta_data);
+    if (enable_adaptive_chunk_size_) {
+      RecordFrameSent(endpoint_id, channel, bytes.size(), packet_meta_data);
+    }
   }
 
   return failed_endpoint_ids;
@@ -939,6 +1251,12 @@ EndpointManager::EndpointState::~EndpointState() {
     MutexLock lock(keep_alive_waiter_mutex_.get());
     keep_alive_waiter_->Notify();
   }
+
+  // The channel is closed by now, so a reactor task blocked in a read will
+  // fail promptly rather than hold up the wait for tasks in flight.
+  if (reactor_endpoint_) {
+    reactor_endpoint_->Stop();
+  }
 }
 
 void EndpointManager::EndpointState::StartEndpointReader(Runnable&& runnable) {
@@ -955,6 +1273,173 @@ void EndpointManager::EndpointState::StartEndpointKeepAliveManager(
       });
 }
 
+std::shared_ptr<EndpointManager::ReactorEndpoint>
+EndpointManager::StartReactorEndpoint(ClientProxy* client,
+                                      const std::string& endpoint_id,
+                                      absl::Duration keep_alive_interval,
+                                      absl::Duration keep_alive_timeout) {
+  auto endpoint = std::make_shared<ReactorEndpoint>(
+      reactor_.get(), client, endpoint_id, keep_alive_interval,
+      keep_alive_timeout);
+  WatchReactorChannel(endpoint);
+  // The same ping/pong KeepAlive protocol as the dedicated KeepAlive thread,
+  // but each check is a timer event rather than a wait on a thread.
+  ScheduleReactorKeepAlive(endpoint, absl::ZeroDuration());
+  return endpoint;
+}
+
+void EndpointManager::WatchReactorChannel(
+    const std::shared_ptr<ReactorEndpoint>& endpoint) {
+  std::shared_ptr<EndpointChannel> channel = GetChannelForLoop(
+      endpoint->endpoint_id, endpoint->read_last_failed_medium);
+  if (channel == nullptr) {
+    StopReactorEndpoint(endpoint, "Read");
+    return;
+  }
+
+  endpoint->read_channel = channel;
+  endpoint->try_decrypting = !channel->IsEncrypted();
+
+  // Watch under the lock, so that a reactor callback (which takes the lock)
+  // can't run before |watch_id| is recorded for it to re-arm.
+  MutexLock lock(&endpoint->mutex);
+  if (endpoint->stopped) return;
+  endpoint->watch_id = reactor_->Watch(
+      channel->GetReadinessFd(), [this, endpoint]() {
+        MutexLock lock(&endpoint->mutex);
+        if (!endpoint->BeginTask()) return;
+        reactor_workers_->Execute("reactor-read", [this, endpoint]() {
+          OnReactorChannelReadable(endpoint);
+          endpoint->EndTask();
+        });
+      });
+  if (endpoint->watch_id != IoReactor::kInvalidWatchId) return;
+
+  // The channel can't be polled (or the reactor refused it), so read it the
+  // same way as without a reactor, on a thread of its own.
+  NEARBY_LOGS(INFO) << "Channel " << channel->GetType()
+                    << " can't be watched, starting reader thread: endpoint "
+                    << endpoint->endpoint_id;
+  endpoint->read_channel.reset();
+  endpoint->fallback_reader = std::make_unique<SingleThreadExecutor>();
+  endpoint->fallback_reader->Execute(
+      "reader", [this, client = endpoint->client,
+                 endpoint_id = endpoint->endpoint_id]() {
+        EndpointChannelLoopRunnable(
+            "Read", client, endpoint_id,
+            [this, client, endpoint_id](EndpointChannel* channel) {
+              return HandleData(endpoint_id, client, channel);
+            });
+      });
+}
+
+void EndpointManager::OnReactorChannelReadable(
+    const std::shared_ptr<ReactorEndpoint>& endpoint) {
+  std::shared_ptr<EndpointChannel> channel = endpoint->read_channel;
+  // Take in what has arrived, and only parse frames once they are complete,
+  // so that a slow sender can't hold up the workers in the middle of a frame.
+  ExceptionOr<size_t> missing = channel->ReadAvailable();
+  Exception exception = missing.GetException();
+  if (missing.ok() && missing.result() == 0) {
+    do {
+      exception =
+          HandleNextFrame(endpoint->endpoint_id, endpoint->client,
+                          channel.get(), endpoint->try_decrypting);
+    } while (exception.Ok() && channel->HasBufferedFrame());
+  }
+
+  IoReactor::WatchId watch_id;
+  {
+    MutexLock lock(&endpoint->mutex);
+    if (endpoint->stopped) return;
+    watch_id = endpoint->watch_id;
+  }
+  if (exception.Ok()) {
+    // Only now is the channel watched again, so the next frame of this
+    // endpoint can't be picked up by another worker before this one is done.
+    if (reactor_->Rearm(watch_id)) return;
+    exception = {Exception::kIo};
+  }
+
+  // Stop watching the failed channel before looking for its replacement.
+  {
+    MutexLock lock(&endpoint->mutex);
+    if (endpoint->stopped) return;
+    watch_id = std::exchange(endpoint->watch_id, IoReactor::kInvalidWatchId);
+  }
+  reactor_->Unwatch(watch_id);
+  endpoint->read_channel.reset();
+  if (ShouldContinueChannelLoop(endpoint->client, endpoint->endpoint_id,
+                                *channel, ExceptionOr<bool>(exception),
+                                endpoint->read_last_failed_medium)) {
+    WatchReactorChannel(endpoint);
+  } else {
+    StopReactorEndpoint(endpoint, "Read");
+  }
+}
+
+void EndpointManager::ScheduleReactorKeepAlive(
+    const std::shared_ptr<ReactorEndpoint>& endpoint, absl::Duration delay) {
+  Cancelable keep_alive_task = keep_alive_timer_->Schedule(
+      [this, endpoint]() {
+        MutexLock lock(&endpoint->mutex);
+        if (!endpoint->BeginTask()) return;
+        // KeepAlive writes can block on a congested channel, so they run on
+        // the workers rather than holding up the timer for other endpoints.
+        reactor_workers_->Execute("reactor-keep-alive", [this, endpoint]() {
+          OnReactorKeepAliveDue(endpoint);
+          endpoint->EndTask();
+        });
+      },
+      delay);
+
+  bool stopped;
+  {
+    MutexLock lock(&endpoint->mutex);
+    stopped = endpoint->stopped;
+    if (!stopped) endpoint->keep_alive_task = keep_alive_task;
+  }
+  if (stopped) keep_alive_task.Cancel();
+}
+
+void EndpointManager::OnReactorKeepAliveDue(
+    const std::shared_ptr<ReactorEndpoint>& endpoint) {
+  std::shared_ptr<EndpointChannel> channel = GetChannelForLoop(
+      endpoint->endpoint_id, endpoint->keep_alive_last_failed_medium);
+  if (channel == nullptr) {
+    StopReactorEndpoint(endpoint, "KeepAliveManager");
+    return;
+  }
+
+  absl::Duration next_check = absl::ZeroDuration();
+  ExceptionOr<bool> keep_alive =
+      CheckKeepAlive(channel.get(), endpoint->keep_alive_interval,
+                     endpoint->keep_alive_timeout, next_check);
+  if (!ShouldContinueChannelLoop(endpoint->client, endpoint->endpoint_id,
+                                 *channel, keep_alive,
+                                 endpoint->keep_alive_last_failed_medium)) {
+    StopReactorEndpoint(endpoint, "KeepAliveManager");
+    return;
+  }
+  // After a failure, retry on the replacement channel right away.
+  ScheduleReactorKeepAlive(endpoint, keep_alive.ok() ? next_check
+                                                     : absl::ZeroDuration());
+}
+
+void EndpointManager::StopReactorEndpoint(
+    const std::shared_ptr<ReactorEndpoint>& endpoint,
+    const std::string& worker_name) {
+  {
+    MutexLock lock(&endpoint->mutex);
+    // Already being removed; nothing left to discard.
+    if (endpoint->stopped) return;
+  }
+  NEARBY_LOGS(INFO) << "Worker going down; worker name=" << worker_name
+                    << "; endpoint_id=" << endpoint->endpoint_id;
+  DiscardEndpoint(endpoint->client, endpoint->endpoint_id,
+                  DisconnectionReason::IO_ERROR);
+}
+
 void EndpointManager::RunOnEndpointManagerThread(const std::string& name,
                                                  Runnable runnable) {
   serial_executor_->Execute(name, std::move(runnable));
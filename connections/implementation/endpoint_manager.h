@@ -28,15 +28,20 @@
 #include "absl/functional/any_invocable.h"
 #include "absl/time/time.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
+#include "connections/implementation/chunk_size_controller.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel.h"
 #include "connections/implementation/endpoint_channel_manager.h"
+#include "connections/implementation/offline_frames.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/listeners.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/condition_variable.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/io_reactor.h"
+#include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/runnable.h"
+#include "internal/platform/scheduled_executor.h"
 #include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
@@ -59,6 +64,14 @@ namespace connections {
 // chunks) originates on one of those threads before control is transferred over
 // to PayloadManager::ProcessFrame() (still running on that
 // same dedicated reader thread).
+//
+// With the kEnableEndpointReactor flag set, and on platforms that provide an
+// IoReactor, endpoints whose channel can be polled have no dedicated reader
+// thread. The reactor reports the channel as readable and one frame at a time
+// is read and processed on a small shared worker pool; the channel is only
+// watched again once that frame is done, so frames of one endpoint are still
+// handled in order and never concurrently. KeepAlives of all endpoints are
+// then driven by one shared timer instead of a thread per endpoint.
 
 class EndpointManager {
  public:
@@ -82,6 +95,17 @@ class EndpointManager {
         location::nearby::proto::connections::Medium current_medium,
         analytics::PacketMetaData& packet_meta_data) = 0;
 
+    // @EndpointManagerReaderThread
+    // Called instead of OnIncomingFrame() for PAYLOAD_TRANSFER DATA frames,
+    // which are decoded without an OfflineFrame. |data_frame.body| is only
+    // valid during the call. The default implementation builds the
+    // OfflineFrame and passes it to OnIncomingFrame().
+    virtual void OnIncomingPayloadData(
+        parser::PayloadDataFrame& data_frame,
+        const std::string& from_endpoint_id, ClientProxy* to_client,
+        location::nearby::proto::connections::Medium current_medium,
+        analytics::PacketMetaData& packet_meta_data);
+
     // Implementations must call barrier.CountDown() once
     // they're done. This parallelizes the disconnection event across all frame
     // processors.
@@ -125,6 +149,12 @@ class EndpointManager {
   // transport.
   int GetMaxTransmitPacketSize(const std::string& endpoint_id);
 
+  // Returns the payload chunk size to use for |endpoint_id|. This is
+  // GetMaxTransmitPacketSize() unless adaptive chunk sizing is enabled for the
+  // endpoint's medium, in which case it follows how fast recent chunks were
+  // sent over the current channel.
+  int GetPreferredChunkSize(const std::string& endpoint_id);
+
   // Returns the list of endpoints to which sending this chunk failed.
   //
   // Invoked from the PayloadManager's sendPayload() method.
@@ -135,6 +165,15 @@ class EndpointManager {
           payload_chunk,
       const std::vector<std::string>& endpoint_ids,
       analytics::PacketMetaData& packet_meta_data);
+  // Writes |frame|, an already serialized DATA frame carrying |offset| of
+  // payload |payload_id|, to a single endpoint. Returns false if the write
+  // failed.
+  //
+  // Invoked from the PayloadManager when a payload is fanned out to several
+  // endpoints, so that every endpoint sending the same piece shares one frame.
+  bool SendPayloadFrame(const std::string& endpoint_id, const ByteArray& frame,
+                        std::int64_t payload_id, std::int64_t offset,
+                        analytics::PacketMetaData& packet_meta_data);
   std::vector<std::string> SendControlMessage(
       const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
           payload_header,
@@ -162,8 +201,17 @@ class EndpointManager {
   // For unit tests only to control executing tasks on the executor.
   EndpointManager(EndpointChannelManager* manager,
                   std::unique_ptr<SingleThreadExecutor> serial_executor);
+  // For unit tests only to drive endpoints from a given reactor. A null
+  // |reactor| keeps a reader thread per endpoint.
+  EndpointManager(EndpointChannelManager* manager,
+                  std::unique_ptr<SingleThreadExecutor> serial_executor,
+                  std::unique_ptr<IoReactor> reactor);
 
  private:
+  // Per-endpoint state of the reactor-driven reader and KeepAlive timer.
+  // Shared with the tasks in flight for the endpoint.
+  struct ReactorEndpoint;
+
   class EndpointState {
    public:
     EndpointState(const std::string& endpoint_id,
@@ -185,7 +233,8 @@ class EndpointManager {
           keep_alive_waiter_mutex_{
               std::exchange(other.keep_alive_waiter_mutex_, nullptr)},
           keep_alive_waiter_{std::exchange(other.keep_alive_waiter_, nullptr)},
-          keep_alive_thread_{std::move(other.keep_alive_thread_)} {}
+          keep_alive_thread_{std::move(other.keep_alive_thread_)},
+          reactor_endpoint_{std::move(other.reactor_endpoint_)} {}
     EndpointState& operator=(const EndpointState&) = delete;
     EndpointState&& operator=(EndpointState&&) = delete;
     ~EndpointState();
@@ -193,6 +242,11 @@ class EndpointManager {
     void StartEndpointReader(Runnable&& runnable);
     void StartEndpointKeepAliveManager(
         absl::AnyInvocable<void(Mutex*, ConditionVariable*)> runnable);
+    // Hands the endpoint over to the reactor; the state is stopped (and its
+    // in-flight work waited for) when this EndpointState is destroyed.
+    void SetReactorEndpoint(std::shared_ptr<ReactorEndpoint> reactor_endpoint) {
+      reactor_endpoint_ = std::move(reactor_endpoint);
+    }
 
    private:
     const std::string endpoint_id_;
@@ -207,6 +261,10 @@ class EndpointManager {
     mutable std::unique_ptr<Mutex> keep_alive_waiter_mutex_;
     std::unique_ptr<ConditionVariable> keep_alive_waiter_;
     SingleThreadExecutor keep_alive_thread_;
+
+    // Set instead of running the reader and KeepAlive threads above when the
+    // endpoint is driven by the reactor.
+    std::shared_ptr<ReactorEndpoint> reactor_endpoint_;
   };
 
   // RAII accessor for FrameProcessor
@@ -232,12 +290,28 @@ class EndpointManager {
                                ClientProxy* client_proxy,
                                EndpointChannel* endpoint_channel);
 
+  // Reads one frame from |endpoint_channel| and routes it to its
+  // FrameProcessor. Frames that fail to parse are skipped. Returns the read or
+  // parse exception that should end use of the channel, if any.
+  Exception HandleNextFrame(const std::string& endpoint_id,
+                            ClientProxy* client_proxy,
+                            EndpointChannel* endpoint_channel,
+                            bool& try_decrypting);
+
   ExceptionOr<bool> HandleKeepAlive(EndpointChannel* endpoint_channel,
                                     absl::Duration keep_alive_interval,
                                     absl::Duration keep_alive_timeout,
                                     Mutex* keep_alive_waiter_mutex,
                                     ConditionVariable* keep_alive_waiter);
 
+  // Sends a KeepAlive frame if one is due. Returns false if nothing has been
+  // read from the endpoint within |keep_alive_timeout|; otherwise sets
+  // |next_check| to how long to wait before checking again.
+  ExceptionOr<bool> CheckKeepAlive(EndpointChannel* endpoint_channel,
+                                   absl::Duration keep_alive_interval,
+                                   absl::Duration keep_alive_timeout,
+                                   absl::Duration& next_check);
+
   // Waits for a given endpoint EndpointChannelLoopRunnable() workers to
   // terminate.
   // Is called from RegisterEndpoint to avoid races; also called from
@@ -250,6 +324,41 @@ class EndpointManager {
       const std::string& endpoint_id,
       absl::AnyInvocable<ExceptionOr<bool>(EndpointChannel*)> handler);
 
+  // The two halves of one EndpointChannelLoopRunnable() iteration, shared
+  // with the reactor so both apply the same channel failover rules.
+  //
+  // Returns the channel to run the handler on next, or nullptr if there is no
+  // channel left worth trying.
+  std::shared_ptr<EndpointChannel> GetChannelForLoop(
+      const std::string& endpoint_id,
+      location::nearby::proto::connections::Medium last_failed_medium);
+  // Returns false if the loop should stop after |result| from the handler.
+  bool ShouldContinueChannelLoop(
+      ClientProxy* client_proxy, const std::string& endpoint_id,
+      const EndpointChannel& channel, const ExceptionOr<bool>& result,
+      location::nearby::proto::connections::Medium& last_failed_medium);
+
+  // Starts the reactor-driven reader and KeepAlive timer for an endpoint.
+  // Readers of channels that cannot be polled fall back to a dedicated
+  // thread.
+  std::shared_ptr<ReactorEndpoint> StartReactorEndpoint(
+      ClientProxy* client_proxy, const std::string& endpoint_id,
+      absl::Duration keep_alive_interval, absl::Duration keep_alive_timeout);
+  // Watches the endpoint's current channel, or ends the reader if there is
+  // none left to read from.
+  void WatchReactorChannel(const std::shared_ptr<ReactorEndpoint>& endpoint);
+  // @ReactorWorker
+  void OnReactorChannelReadable(
+      const std::shared_ptr<ReactorEndpoint>& endpoint);
+  void ScheduleReactorKeepAlive(
+      const std::shared_ptr<ReactorEndpoint>& endpoint, absl::Duration delay);
+  // @ReactorWorker
+  void OnReactorKeepAliveDue(const std::shared_ptr<ReactorEndpoint>& endpoint);
+  // Ends the endpoint's reactor work and discards the endpoint.
+  // @ReactorWorker
+  void StopReactorEndpoint(const std::shared_ptr<ReactorEndpoint>& endpoint,
+                           const std::string& worker_name);
+
   static void WaitForLatch(const std::string& method_name,
                            CountDownLatch* latch);
   static void WaitForLatch(const std::string& method_name,
@@ -284,6 +393,20 @@ class EndpointManager {
       std::int64_t offset, const std::string& packet_type,
       analytics::PacketMetaData& packet_meta_data);
 
+  // Adaptive chunk sizing state for one endpoint. It is tied to the channel it
+  // was measured on and starts over when the endpoint changes channels.
+  struct ChunkSizeState {
+    std::weak_ptr<EndpointChannel> channel;
+    ChunkSizeController controller;
+  };
+  // Feeds the send timings of one frame written to |channel| to the
+  // endpoint's ChunkSizeController, if it has one.
+  void RecordFrameSent(const std::string& endpoint_id,
+                       const std::shared_ptr<EndpointChannel>& channel,
+                       int frame_size,
+                       const analytics::PacketMetaData& packet_meta_data)
+      ABSL_LOCKS_EXCLUDED(chunk_size_mutex_);
+
   // Executes all jobs sequentially, on a serial_executor_.
   void RunOnEndpointManagerThread(const std::string& name, Runnable runnable);
 
@@ -296,6 +419,18 @@ class EndpointManager {
                       FrameProcessorWithMutex>
       frame_processors_ ABSL_GUARDED_BY(frame_processors_lock_);
 
+  // Only set when the reactor mode is enabled and supported; see the class
+  // comment. They must outlive |endpoints_|, whose states stop any work they
+  // still have queued here.
+  std::unique_ptr<IoReactor> reactor_;
+  std::unique_ptr<MultiThreadExecutor> reactor_workers_;
+  std::unique_ptr<ScheduledExecutor> keep_alive_timer_;
+
+  bool enable_adaptive_chunk_size_ = false;
+  Mutex chunk_size_mutex_;
+  absl::flat_hash_map<std::string, ChunkSizeState> chunk_sizes_
+      ABSL_GUARDED_BY(chunk_size_mutex_);
+
   // We keep track of all registered channel endpoints here.
   absl::flat_hash_map<std::string, EndpointState> endpoints_;
 
@@ -15,6 +15,7 @@
 #include "connections/implementation/endpoint_manager.h"
 
 #include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -23,6 +24,7 @@
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -35,6 +37,8 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
+#include "internal/platform/implementation/io_reactor.h"
+#include "internal/platform/io_reactor.h"
 // #include "internal/platform/feature_flags.h"
 #include "internal/platform/logging.h"
 #include "internal/test/fake_single_thread_executor.h"
@@ -90,6 +94,7 @@ class MockEndpointChannel : public EndpointChannel {
   MOCK_METHOD(absl::Time, GetLastWriteTimestamp, (), (const override));
   MOCK_METHOD(void, SetAnalyticsRecorder,
               (analytics::AnalyticsRecorder*, const std::string&), (override));
+  MOCK_METHOD(int, GetReadinessFd, (), (const override));
 
   bool IsClosed() const {
     absl::MutexLock lock(&mutex_);
@@ -135,6 +140,90 @@ class TestEndpointManager : public EndpointManager {
   TestEndpointManager(EndpointChannelManager* manager,
                       std::unique_ptr<SingleThreadExecutor> serial_executor)
       : EndpointManager(manager, std::move(serial_executor)) {}
+  TestEndpointManager(EndpointChannelManager* manager,
+                      std::unique_ptr<IoReactor> reactor)
+      : EndpointManager(manager, std::make_unique<SingleThreadExecutor>(),
+                        std::move(reactor)) {}
+};
+
+// A reactor whose descriptors only become readable when the test says so.
+class FakeIoReactor : public api::IoReactor {
+ public:
+  WatchId Watch(int fd, absl::AnyInvocable<void()> on_readable) override {
+    absl::MutexLock lock(&mutex_);
+    WatchId watch_id = next_watch_id_++;
+    watches_.emplace(watch_id, FdWatch{fd, std::move(on_readable), true});
+    return watch_id;
+  }
+
+  bool Rearm(WatchId watch_id) override {
+    absl::MutexLock lock(&mutex_);
+    auto it = watches_.find(watch_id);
+    if (it == watches_.end()) return false;
+    it->second.armed = true;
+    return true;
+  }
+
+  void Unwatch(WatchId watch_id) override {
+    // Waits for a callback in progress.
+    absl::MutexLock callback_lock(&callback_mutex_);
+    absl::MutexLock lock(&mutex_);
+    watches_.erase(watch_id);
+  }
+
+  void Shutdown() override {
+    absl::MutexLock lock(&mutex_);
+    watches_.clear();
+  }
+
+  // Waits until `fd` is watched and armed, then reports it as readable.
+  bool MakeReadable(int fd, absl::Duration timeout) {
+    absl::MutexLock callback_lock(&callback_mutex_);
+    FdWatch* watch = nullptr;
+    {
+      absl::MutexLock lock(&mutex_);
+      auto armed = [this, fd, &watch]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        watch = FindWatch(fd);
+        return watch != nullptr && watch->armed;
+      };
+      if (!mutex_.AwaitWithTimeout(absl::Condition(&armed), timeout)) {
+        return false;
+      }
+      watch->armed = false;
+    }
+    // Unwatch() can't drop the watch while |callback_mutex_| is held, and the
+    // callback may take locks that are held around Watch().
+    watch->on_readable();
+    return true;
+  }
+
+  bool WaitUntilUnwatched(int fd, absl::Duration timeout) {
+    absl::MutexLock lock(&mutex_);
+    auto unwatched = [this, fd]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return FindWatch(fd) == nullptr;
+    };
+    return mutex_.AwaitWithTimeout(absl::Condition(&unwatched), timeout);
+  }
+
+ private:
+  struct FdWatch {
+    int fd;
+    absl::AnyInvocable<void()> on_readable;
+    bool armed;
+  };
+
+  FdWatch* FindWatch(int fd) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (auto& [watch_id, watch] : watches_) {
+      if (watch.fd == fd) return &watch;
+    }
+    return nullptr;
+  }
+
+  absl::Mutex callback_mutex_ ABSL_ACQUIRED_BEFORE(mutex_);
+  absl::Mutex mutex_;
+  WatchId next_watch_id_ ABSL_GUARDED_BY(mutex_) = 1;
+  // Keeps watches in place while new ones are added.
+  std::map<WatchId, FdWatch> watches_ ABSL_GUARDED_BY(mutex_);
 };
 
 class EndpointManagerTest : public ::testing::Test {
@@ -438,6 +527,185 @@ TEST_F(EndpointManagerTest, TryDecrypt) {
   RegisterEndpoint(std::move(endpoint_channel));
 }
 
+TEST_F(EndpointManagerTest, ReactorFlagWithoutPlatformReactorReadsFrames) {
+  // The test platform has no IoReactor, so with the reactor flag set the
+  // endpoint must still be read, by a dedicated reader thread.
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableEndpointReactor,
+      true);
+  EndpointChannelManager ecm;
+  auto endpoint_manager = std::make_unique<EndpointManager>(&ecm);
+  auto endpoint_channel = std::make_unique<MockEndpointChannel>();
+  auto connect_request = std::make_unique<MockFrameProcessor>();
+  ConnectionInfo connection_info{
+      "endpoint_id",
+      ByteArray{"endpoint_name"},
+      1234 /*nonce*/,
+      false /*supports_5_ghz*/,
+      "" /*bssid*/,
+      2412 /*ap_frequency*/,
+      "8xqT" /*ip_address in 4 bytes format*/,
+      std::vector<Medium>{Medium::BLE} /*supported_mediums*/,
+      0 /*keep_alive_interval_millis*/,
+      0 /*keep_alive_timeout_millis*/};
+  CountDownLatch closed(1);
+  EXPECT_CALL(*connect_request, OnIncomingFrame);
+  EXPECT_CALL(*connect_request, OnEndpointDisconnect);
+  EXPECT_CALL(*endpoint_channel, Read(_))
+      .WillOnce(Return(ExceptionOr<ByteArray>(
+          parser::ForConnectionRequestConnections({}, connection_info))))
+      .WillRepeatedly(Return(ExceptionOr<ByteArray>(Exception::kIo)));
+  EXPECT_CALL(*endpoint_channel, Write(_))
+      .WillRepeatedly(Return(Exception{Exception::kSuccess}));
+  EXPECT_CALL(*endpoint_channel, GetMedium())
+      .WillRepeatedly(Return(Medium::BLE));
+  EXPECT_CALL(*endpoint_channel, GetLastReadTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  EXPECT_CALL(*endpoint_channel, GetLastWriteTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  ON_CALL(*endpoint_channel, Close(_))
+      .WillByDefault(
+          [&closed](DisconnectionReason reason) { closed.CountDown(); });
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(1);
+
+  endpoint_manager->RegisterFrameProcessor(V1Frame::CONNECTION_REQUEST,
+                                           connect_request.get());
+  endpoint_manager->RegisterEndpoint(
+      client_.get(), endpoint_id_, info_, connection_options_,
+      std::move(endpoint_channel), listener_, connection_token);
+
+  EXPECT_TRUE(closed.Await(absl::Milliseconds(1000)).result());
+  endpoint_manager.reset();
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::
+          kEnableEndpointReactor,
+      false);
+}
+
+TEST_F(EndpointManagerTest, ReactorDispatchesFramesAndUnwatchesOnDisconnect) {
+  constexpr int kFd = 42;
+  auto reactor = std::make_unique<FakeIoReactor>();
+  FakeIoReactor* fake_reactor = reactor.get();
+  EndpointChannelManager ecm;
+  auto endpoint_manager = std::make_unique<TestEndpointManager>(
+      &ecm, std::make_unique<IoReactor>(std::move(reactor)));
+  auto endpoint_channel = std::make_unique<MockEndpointChannel>();
+  auto connect_request = std::make_unique<MockFrameProcessor>();
+  ConnectionInfo connection_info{
+      "endpoint_id",
+      ByteArray{"endpoint_name"},
+      1234 /*nonce*/,
+      false /*supports_5_ghz*/,
+      "" /*bssid*/,
+      2412 /*ap_frequency*/,
+      "8xqT" /*ip_address in 4 bytes format*/,
+      std::vector<Medium>{Medium::BLE} /*supported_mediums*/,
+      0 /*keep_alive_interval_millis*/,
+      0 /*keep_alive_timeout_millis*/};
+  CountDownLatch dispatched(2);
+  CountDownLatch closed(1);
+  EXPECT_CALL(*connect_request, OnIncomingFrame)
+      .Times(2)
+      .WillRepeatedly([&dispatched]() { dispatched.CountDown(); });
+  EXPECT_CALL(*connect_request, OnEndpointDisconnect);
+  // Nothing is read until the reactor reports the channel as readable.
+  EXPECT_CALL(*endpoint_channel, Read(_))
+      .WillOnce(Return(ExceptionOr<ByteArray>(
+          parser::ForConnectionRequestConnections({}, connection_info))))
+      .WillOnce(Return(ExceptionOr<ByteArray>(
+          parser::ForConnectionRequestConnections({}, connection_info))))
+      .WillOnce(Return(ExceptionOr<ByteArray>(Exception::kIo)));
+  EXPECT_CALL(*endpoint_channel, GetReadinessFd()).WillRepeatedly(Return(kFd));
+  EXPECT_CALL(*endpoint_channel, IsEncrypted()).WillRepeatedly(Return(false));
+  EXPECT_CALL(*endpoint_channel, Write(_))
+      .WillRepeatedly(Return(Exception{Exception::kSuccess}));
+  EXPECT_CALL(*endpoint_channel, GetMedium())
+      .WillRepeatedly(Return(Medium::BLE));
+  EXPECT_CALL(*endpoint_channel, GetLastReadTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  EXPECT_CALL(*endpoint_channel, GetLastWriteTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  ON_CALL(*endpoint_channel, Close(_))
+      .WillByDefault(
+          [&closed](DisconnectionReason reason) { closed.CountDown(); });
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(1);
+
+  endpoint_manager->RegisterFrameProcessor(V1Frame::CONNECTION_REQUEST,
+                                           connect_request.get());
+  endpoint_manager->RegisterEndpoint(
+      client_.get(), endpoint_id_, info_, connection_options_,
+      std::move(endpoint_channel), listener_, connection_token);
+
+  // Each readable event reads one frame; the channel is watched again once
+  // that frame has been dispatched.
+  EXPECT_TRUE(fake_reactor->MakeReadable(kFd, absl::Milliseconds(1000)));
+  EXPECT_TRUE(fake_reactor->MakeReadable(kFd, absl::Milliseconds(1000)));
+  EXPECT_TRUE(dispatched.Await(absl::Milliseconds(1000)).result());
+
+  // A failed read with no other channel left disconnects the endpoint.
+  EXPECT_TRUE(fake_reactor->MakeReadable(kFd, absl::Milliseconds(1000)));
+  EXPECT_TRUE(closed.Await(absl::Milliseconds(1000)).result());
+  EXPECT_TRUE(
+      fake_reactor->WaitUntilUnwatched(kFd, absl::Milliseconds(1000)));
+  endpoint_manager.reset();
+}
+
+TEST_F(EndpointManagerTest, ReactorKeepAliveSendsAndTimesOut) {
+  constexpr int kFd = 42;
+  auto reactor = std::make_unique<FakeIoReactor>();
+  FakeIoReactor* fake_reactor = reactor.get();
+  EndpointChannelManager ecm;
+  auto endpoint_manager = std::make_unique<TestEndpointManager>(
+      &ecm, std::make_unique<IoReactor>(std::move(reactor)));
+  auto endpoint_channel = std::make_unique<MockEndpointChannel>();
+  auto processor = std::make_unique<MockFrameProcessor>();
+  ConnectionOptions connection_options{
+      .keep_alive_interval_millis = 10,
+      .keep_alive_timeout_millis = 200,
+  };
+  CountDownLatch keep_alive_sent(1);
+  CountDownLatch closed(1);
+  EXPECT_CALL(*processor, OnEndpointDisconnect);
+  // The peer never sends anything, so the channel is never read.
+  EXPECT_CALL(*endpoint_channel, Read(_)).Times(0);
+  EXPECT_CALL(*endpoint_channel, GetReadinessFd()).WillRepeatedly(Return(kFd));
+  EXPECT_CALL(*endpoint_channel, IsEncrypted()).WillRepeatedly(Return(false));
+  EXPECT_CALL(*endpoint_channel, Write(_))
+      .WillRepeatedly([&keep_alive_sent](const ByteArray& data) {
+        auto frame = parser::FromBytes(data);
+        if (frame.ok() && parser::GetFrameType(frame.result()) ==
+                              V1Frame::KEEP_ALIVE) {
+          keep_alive_sent.CountDown();
+        }
+        return Exception{Exception::kSuccess};
+      });
+  EXPECT_CALL(*endpoint_channel, GetMedium())
+      .WillRepeatedly(Return(Medium::BLE));
+  EXPECT_CALL(*endpoint_channel, GetLastReadTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  EXPECT_CALL(*endpoint_channel, GetLastWriteTimestamp())
+      .WillRepeatedly(Return(start_time_));
+  ON_CALL(*endpoint_channel, Close(_))
+      .WillByDefault(
+          [&closed](DisconnectionReason reason) { closed.CountDown(); });
+  EXPECT_CALL(mock_listener_.initiated_cb, Call).Times(1);
+
+  endpoint_manager->RegisterFrameProcessor(V1Frame::KEEP_ALIVE,
+                                           processor.get());
+  endpoint_manager->RegisterEndpoint(
+      client_.get(), endpoint_id_, info_, connection_options,
+      std::move(endpoint_channel), listener_, connection_token);
+
+  // Nothing was written for longer than the interval, so a KeepAlive goes
+  // out; nothing is read within the timeout, so the endpoint is dropped.
+  EXPECT_TRUE(keep_alive_sent.Await(absl::Milliseconds(1000)).result());
+  EXPECT_TRUE(closed.Await(absl::Milliseconds(1000)).result());
+  EXPECT_TRUE(
+      fake_reactor->WaitUntilUnwatched(kFd, absl::Milliseconds(1000)));
+  endpoint_manager.reset();
+}
+
 // Regression test for b/278729669.
 //
 // During the destruction of NearbyConnections, Core (which owns ClientProxy)
@@ -58,6 +58,30 @@ constexpr auto kEnablePayloadReceivedAck =
 constexpr auto kSafeToDisconnectVersion =
     flags::Flag<int64_t>(kConfigPackage, "45425841", 0);
 
+// When true, endpoints whose channels can be polled are read from a shared
+// I/O reactor instead of a dedicated reader thread each, and keep-alives for
+// all endpoints run on one timer. Ignored on platforms without a reactor.
+constexpr auto kEnableEndpointReactor =
+    flags::Flag<bool>(kConfigPackage, "45428901", false);
+
+// When true, payload chunks sent over Wi-Fi mediums grow beyond the medium's
+// default packet size, up to the 1 MB frame limit, while measured send times
+// show that larger chunks keep improving throughput.
+constexpr auto kEnableAdaptiveChunkSize =
+    flags::Flag<bool>(kConfigPackage, "45429012", false);
+
+// When true, encrypted endpoint channels write frames from a dedicated I/O
+// stage and read the next frame ahead, so that encrypting or decrypting a frame
+// overlaps with the socket I/O of its neighbours.
+constexpr auto kEnablePipelinedEncryption =
+    flags::Flag<bool>(kConfigPackage, "45429013", false);
+
+// When true, a payload sent to several endpoints is read once and every
+// endpoint is fed from a shared window by its own sender, at its own chunk size
+// and pace, instead of all endpoints moving in lockstep with the slowest one.
+constexpr auto kEnablePayloadFanOut =
+    flags::Flag<bool>(kConfigPackage, "45429014", false);
+
 }  // namespace nearby_connections_feature
 }  // namespace config_package_nearby
 }  // namespace connections
@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "connections/implementation/internal_payload.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/payload.h"
@@ -268,7 +269,15 @@ class IncomingFileInternalPayload : public InternalPayload {
                               std::int64_t total_size)
       : InternalPayload(std::move(payload)),
         output_file_(std::move(output_file)),
-        total_size_(total_size) {}
+        total_size_(total_size) {
+    if (total_size_ > 0) {
+      Exception exception = output_file_.Preallocate(total_size_);
+      if (exception.Raised()) {
+        NEARBY_LOGS(WARNING) << "Failed to preallocate " << total_size_
+                             << " bytes for incoming file Payload " << this;
+      }
+    }
+  }
 
   location::nearby::connections::PayloadTransferFrame::PayloadHeader::
       PayloadType
@@ -358,11 +367,21 @@ std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
     return {};
   }
 
-  const Payload::Id payload_id = frame.payload_header().id();
-  switch (frame.payload_header().type()) {
+  return CreateIncomingInternalPayload(frame.payload_header(),
+                                       frame.payload_chunk().body(),
+                                       custom_save_path);
+}
+
+std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
+    const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
+        header,
+    absl::string_view first_chunk_body, const std::string& custom_save_path) {
+  const Payload::Id payload_id = header.id();
+  switch (header.type()) {
     case PayloadTransferFrame::PayloadHeader::BYTES: {
-      return std::make_unique<BytesInternalPayload>(
-          Payload(payload_id, ByteArray(frame.payload_chunk().body())));
+      return std::make_unique<BytesInternalPayload>(Payload(
+          payload_id,
+          ByteArray(first_chunk_body.data(), first_chunk_body.size())));
     }
 
     case PayloadTransferFrame::PayloadHeader::STREAM: {
@@ -379,17 +398,17 @@ std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
 
       int64_t total_size = 0;
 
-      if (frame.payload_header().has_parent_folder()) {
-        parent_folder = frame.payload_header().parent_folder();
+      if (header.has_parent_folder()) {
+        parent_folder = header.parent_folder();
       }
 
-      if (frame.payload_header().has_file_name()) {
-        file_name = frame.payload_header().file_name();
+      if (header.has_file_name()) {
+        file_name = header.file_name();
         // if custom_save_path is empty, default download path is used
         file_path = make_path(custom_save_path, parent_folder, file_name);
       } else {
-        if (frame.payload_header().has_id()) {
-          file_name = std::to_string(frame.payload_header().id());
+        if (header.has_id()) {
+          file_name = std::to_string(header.id());
           // if custom_save_path is empty, default download path is used
           file_path = make_path(custom_save_path, parent_folder, file_name);
         } else {
@@ -401,8 +420,8 @@ std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
         }
       }
 
-      if (frame.payload_header().has_total_size()) {
-        total_size = frame.payload_header().total_size();
+      if (header.has_total_size()) {
+        total_size = header.total_size();
       }
 
       // These are ordered, the output file must be created first otherwise
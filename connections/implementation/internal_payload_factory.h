@@ -19,6 +19,7 @@
 
 #include <memory>
 
+#include "absl/strings/string_view.h"
 #include "connections/implementation/internal_payload.h"
 #include "connections/payload.h"
 
@@ -34,6 +35,13 @@ std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
     const location::nearby::connections::PayloadTransferFrame& frame,
     const std::string& custom_save_path);
 
+// Same as above, for a DATA frame whose header and first chunk body were
+// decoded separately.
+std::unique_ptr<InternalPayload> CreateIncomingInternalPayload(
+    const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
+        header,
+    absl::string_view first_chunk_body, const std::string& custom_save_path);
+
 }  // namespace connections
 }  // namespace nearby
 
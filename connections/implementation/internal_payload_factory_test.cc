@@ -95,6 +95,20 @@ TEST(InternalPayloadFactoryTest, CanCreateInternalPayloadFromByteMessage) {
   EXPECT_EQ(payload.AsBytes(), ByteArray(kText));
 }
 
+TEST(InternalPayloadFactoryTest, CanCreateInternalPayloadFromByteHeader) {
+  PayloadTransferFrame::PayloadHeader header;
+  header.set_type(PayloadTransferFrame::PayloadHeader::BYTES);
+  header.set_id(12345);
+  header.set_total_size(512);
+  std::string body(kText);
+  std::unique_ptr<InternalPayload> internal_payload =
+      CreateIncomingInternalPayload(header, body, "C:\\Downloads");
+  EXPECT_NE(internal_payload, nullptr);
+  Payload payload = internal_payload->ReleasePayload();
+  EXPECT_EQ(payload.GetId(), 12345);
+  EXPECT_EQ(payload.AsBytes(), ByteArray(kText));
+}
+
 TEST(InternalPayloadFactoryTest, CanCreateInternalPayloadFromStreamMessage) {
   PayloadTransferFrame frame;
   std::string path = "C:\\Downloads";
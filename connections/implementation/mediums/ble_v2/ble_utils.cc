@@ -14,9 +14,15 @@
 
 #include "connections/implementation/mediums/ble_v2/ble_utils.h"
 
+#include <cstddef>
+#include <optional>
 #include <string>
+#include <utility>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/types/optional.h"
+#include "internal/base/lru_cache.h"
 
 namespace nearby {
 namespace connections {
@@ -40,6 +46,11 @@ constexpr std::int64_t kAdvertisementUuidLsb = 0x8000000000000000;
 const std::uint64_t kCopresenceServiceUuidMsb = 0x0000FEF300001000;
 const std::uint64_t kCopresenceServiceUuidLsb = 0x800000805F9B34FB;
 
+// Service ID hashes are memoized since discovery hashes the same few service
+// IDs for every advertisement it sees. Bounded in case a client cycles through
+// many service IDs.
+constexpr size_t kMaxMemoizedServiceIdHashes = 64;
+
 // Creates a string as a space separated listing of hex bytes with [] at the
 // beginning and the end.
 //
@@ -54,17 +65,8 @@ std::string StringToPrintableHexString(const std::string& source) {
   return out;
 }
 
-}  // namespace
-
-ABSL_CONST_INIT const Uuid kCopresenceServiceUuid(kCopresenceServiceUuidMsb,
-                                  kCopresenceServiceUuidLsb);
-
-ByteArray GenerateHash(const std::string& source, size_t size) {
-  return Utils::Sha256Hash(source, size);
-}
-
-ByteArray GenerateServiceIdHash(const std::string& service_id,
-                                BleAdvertisement::Version version) {
+ByteArray ComputeServiceIdHash(const std::string& service_id,
+                               BleAdvertisement::Version version) {
   switch (version) {
       // legacy hash for testing only.
     case BleAdvertisement::Version::kV1:
@@ -80,6 +82,39 @@ ByteArray GenerateServiceIdHash(const std::string& service_id,
   }
 }
 
+// Returns the memo table for the hashing scheme used by `version`. Versions
+// that hash alike share a table.
+LruCache<ByteArray>& GetServiceIdHashCache(BleAdvertisement::Version version) {
+  if (version == BleAdvertisement::Version::kV1) {
+    static auto* legacy_cache =
+        new LruCache<ByteArray>(kMaxMemoizedServiceIdHashes);
+    return *legacy_cache;
+  }
+  static auto* cache = new LruCache<ByteArray>(kMaxMemoizedServiceIdHashes);
+  return *cache;
+}
+
+}  // namespace
+
+ABSL_CONST_INIT const Uuid kCopresenceServiceUuid(kCopresenceServiceUuidMsb,
+                                  kCopresenceServiceUuidLsb);
+
+ByteArray GenerateHash(const std::string& source, size_t size) {
+  return Utils::Sha256Hash(source, size);
+}
+
+ByteArray GenerateServiceIdHash(const std::string& service_id,
+                                BleAdvertisement::Version version) {
+  LruCache<ByteArray>& cache = GetServiceIdHashCache(version);
+  std::optional<ByteArray> service_id_hash = cache.Get(service_id);
+  if (service_id_hash.has_value()) {
+    return *std::move(service_id_hash);
+  }
+  ByteArray computed_hash = ComputeServiceIdHash(service_id, version);
+  cache.Put(service_id, computed_hash);
+  return computed_hash;
+}
+
 ByteArray GenerateDeviceToken() {
   return Utils::Sha256Hash(std::to_string(Prng().NextUint32()),
                            mediums::BleAdvertisement::kDeviceTokenLength);
@@ -41,6 +41,9 @@ ByteArray GenerateHash(const std::string& source, size_t size);
 
 // Return SHA256 hash of service ID.
 //
+// The hashes are memoized per hashing scheme, so hashing the same service ID
+// again does not recompute it. Thread-safe.
+//
 // source  - service id.
 // version - BleAdvertisement::Version. kV1 has been deprecated and just used
 //           for testing.
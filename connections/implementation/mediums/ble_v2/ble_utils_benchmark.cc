@@ -0,0 +1,86 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "connections/implementation/mediums/ble_v2/ble_advertisement_header.h"
+#include "connections/implementation/mediums/ble_v2/ble_packet.h"
+#include "connections/implementation/mediums/ble_v2/ble_utils.h"
+#include "connections/implementation/mediums/utils.h"
+#include "internal/platform/byte_array.h"
+
+namespace nearby {
+namespace connections {
+namespace mediums {
+namespace {
+
+// A GATT advertisement is about this long.
+constexpr int kAdvertisementLength = 60;
+
+std::vector<std::string> CreateServiceIds(int count) {
+  std::vector<std::string> service_ids;
+  service_ids.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    service_ids.push_back("com.google.location.nearby.apps.service" +
+                          std::to_string(i));
+  }
+  return service_ids;
+}
+
+// Hashes an advertisement and the tracked service IDs the way discovery did
+// before the service ID hashes were memoized and the advertisement bytes were
+// hashed in place.
+void BM_HashAdvertisementUncached(benchmark::State& state) {
+  std::vector<std::string> service_ids = CreateServiceIds(state.range(0));
+  ByteArray advertisement_bytes(std::string(kAdvertisementLength, 'a'));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Utils::Sha256Hash(
+        std::string(advertisement_bytes),
+        BleAdvertisementHeader::kAdvertisementHashByteLength));
+    for (const auto& service_id : service_ids) {
+      benchmark::DoNotOptimize(
+          Utils::Sha256Hash(service_id, BlePacket::kServiceIdHashLength));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_HashAdvertisementUncached)->Arg(1)->Arg(8);
+
+// Hashes an advertisement and the tracked service IDs through bleutils.
+void BM_HashAdvertisement(benchmark::State& state) {
+  std::vector<std::string> service_ids = CreateServiceIds(state.range(0));
+  ByteArray advertisement_bytes(std::string(kAdvertisementLength, 'a'));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        bleutils::GenerateAdvertisementHash(advertisement_bytes));
+    for (const auto& service_id : service_ids) {
+      benchmark::DoNotOptimize(bleutils::GenerateServiceIdHash(service_id));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_HashAdvertisement)->Arg(1)->Arg(8);
+
+}  // namespace
+}  // namespace mediums
+}  // namespace connections
+}  // namespace nearby
+
+BENCHMARK_MAIN();
@@ -52,6 +52,30 @@ TEST(BleUtilsTest, CanGenerateServiceIdHash) {
   EXPECT_FALSE(generated_bytes.Empty());
 }
 
+TEST(BleUtilsTest, MemoizedServiceIdHashMatchesHash) {
+  std::string service_id = {"service_id"};
+
+  ByteArray first_hash = GenerateServiceIdHash(service_id);
+  ByteArray second_hash = GenerateServiceIdHash(service_id);
+
+  EXPECT_EQ(first_hash, second_hash);
+  EXPECT_EQ(first_hash,
+            GenerateHash(service_id, BlePacket::kServiceIdHashLength));
+}
+
+TEST(BleUtilsTest, ServiceIdHashIsMemoizedPerVersion) {
+  std::string service_id = {"service_id"};
+
+  ByteArray v2_hash =
+      GenerateServiceIdHash(service_id, BleAdvertisement::Version::kV2);
+  ByteArray v1_hash =
+      GenerateServiceIdHash(service_id, BleAdvertisement::Version::kV1);
+
+  EXPECT_NE(v1_hash, v2_hash);
+  EXPECT_EQ(GenerateServiceIdHash(service_id, BleAdvertisement::Version::kV2),
+            v2_hash);
+}
+
 TEST(BleUtilsTest, CanGenerateDeviceToken) {
   ByteArray generated_bytes = GenerateDeviceToken();
 
@@ -15,9 +15,15 @@
 #ifndef CORE_INTERNAL_MEDIUMS_BLE_V2_BLOOM_FILTER_H_
 #define CORE_INTERNAL_MEDIUMS_BLE_V2_BLOOM_FILTER_H_
 
-#include <bitset>
-#include <vector>
-
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 
 namespace nearby {
@@ -40,6 +46,12 @@ class BitSet {
   virtual void Set(size_t pos, bool value) = 0;
   virtual bool Test(size_t pos) const = 0;
   virtual size_t Size() const = 0;
+
+  // Replaces the bits with `bytes`, where position i is bit (i % 8) of byte
+  // (i / 8). `bytes` must be Size() / 8 bytes long.
+  virtual void SetBytes(absl::string_view bytes);
+  // Returns the bits in the layout SetBytes() takes.
+  virtual std::string GetBytes() const;
 };
 
 // A bloom filter that gives access to the underlying BitSet. The implementation
@@ -66,16 +78,20 @@ class BloomFilter {
   explicit operator ByteArray() const;
 
   void Add(const std::string& s);
-  bool PossiblyContains(const std::string& s);
+  bool PossiblyContains(const std::string& s) const;
+  // Returns true if any of `strings` is possibly in the filter.
+  bool PossiblyContainsAny(absl::Span<const std::string> strings) const;
 
  private:
-  std::vector<std::int32_t> GetHashes(const std::string& s);
-  int GetMinBytesForBits() const { return (bit_set_->Size() + 7) >> 3; }
+  static constexpr int kHasherNumberOfRepetitions = 5;
+
+  static std::array<std::int32_t, kHasherNumberOfRepetitions> GetHashes(
+      absl::string_view s);
 
   std::unique_ptr<BitSet> bit_set_;
 };
 
-// A default bit set implementation.
+// A default bit set implementation, stored in 64-bit words.
 //
 // It is templatized on the size of the byte array and not the size of
 // the bit set to ensure the bit set's length is a multiple of 8 (and can
@@ -83,13 +99,43 @@ class BloomFilter {
 template <size_t CapacityInBytes>
 class BitSetImpl final : public BitSet {
  public:
-  std::string ToString() const override { return bits_.to_string(); }
-  void Set(size_t pos, bool value) override { bits_.set(pos, value); }
-  bool Test(size_t pos) const override { return bits_.test(pos); }
-  size_t Size() const override { return bits_.size(); }
+  std::string ToString() const override {
+    std::string result(Size(), '0');
+    for (size_t pos = 0; pos < Size(); ++pos) {
+      if (Test(pos)) result[Size() - 1 - pos] = '1';
+    }
+    return result;
+  }
+  void Set(size_t pos, bool value) override {
+    std::uint64_t mask = std::uint64_t{1} << (pos % 64);
+    if (value) {
+      words_[pos / 64] |= mask;
+    } else {
+      words_[pos / 64] &= ~mask;
+    }
+  }
+  bool Test(size_t pos) const override {
+    return (words_[pos / 64] >> (pos % 64)) & 1;
+  }
+  size_t Size() const override { return CapacityInBytes * 8; }
+
+  void SetBytes(absl::string_view bytes) override {
+    words_.fill(0);
+    for (size_t i = 0; i < CapacityInBytes && i < bytes.size(); ++i) {
+      words_[i / 8] |= std::uint64_t{static_cast<std::uint8_t>(bytes[i])}
+                       << (i % 8 * 8);
+    }
+  }
+  std::string GetBytes() const override {
+    std::string bytes(CapacityInBytes, '\0');
+    for (size_t i = 0; i < CapacityInBytes; ++i) {
+      bytes[i] = static_cast<char>(words_[i / 8] >> (i % 8 * 8));
+    }
+    return bytes;
+  }
 
  private:
-  std::bitset<CapacityInBytes * 8> bits_;
+  std::array<std::uint64_t, (CapacityInBytes + 7) / 8> words_ = {};
 };
 
 }  // namespace mediums
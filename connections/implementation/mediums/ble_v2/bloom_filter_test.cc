@@ -15,6 +15,8 @@
 #include "connections/implementation/mediums/ble_v2/bloom_filter.h"
 
 #include <algorithm>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -212,6 +214,42 @@ TEST(BloomFilterTest, ConstructLongByteArrayFails) {
   EXPECT_FALSE(bloom_filter_inherited.PossiblyContains("ELEMENT_1"));
 }
 
+TEST(BloomFilterTest, PossiblyContainsAny) {
+  BloomFilter bloom_filter(std::make_unique<BitSetImpl<kByteArrayLength>>());
+
+  bloom_filter.Add("ELEMENT_2");
+
+  EXPECT_TRUE(bloom_filter.PossiblyContainsAny(
+      std::vector<std::string>{"ELEMENT_1", "ELEMENT_2"}));
+  EXPECT_FALSE(bloom_filter.PossiblyContainsAny(
+      std::vector<std::string>{"ELEMENT_1", "ELEMENT_3"}));
+  EXPECT_FALSE(bloom_filter.PossiblyContainsAny({}));
+}
+
+TEST(BitSetImplTest, BytesAreLeastSignificantBitFirst) {
+  BitSetImpl<10> bit_set;
+
+  bit_set.Set(0, true);
+  bit_set.Set(9, true);
+  bit_set.Set(79, true);
+
+  EXPECT_EQ(bit_set.GetBytes(),
+            std::string("\x01\x02\0\0\0\0\0\0\0\x80", 10));
+  EXPECT_EQ(bit_set.ToString().substr(0, 1), "1");
+  EXPECT_EQ(bit_set.ToString().substr(70), "1000000001");
+}
+
+TEST(BitSetImplTest, SetBytesRoundTrips) {
+  std::string bytes = "\x12\x34\x56\x78\x9a\xbc\xde\xf0\x0f\xff";
+  BitSetImpl<10> bit_set;
+
+  bit_set.SetBytes(bytes);
+
+  EXPECT_EQ(bit_set.GetBytes(), bytes);
+  EXPECT_TRUE(bit_set.Test(1));
+  EXPECT_FALSE(bit_set.Test(0));
+}
+
 }  // namespace
 }  // namespace mediums
 }  // namespace connections
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -28,6 +29,7 @@
 #include "connections/implementation/mediums/ble_v2/ble_advertisement_header.h"
 #include "connections/implementation/mediums/ble_v2/ble_utils.h"
 #include "connections/implementation/mediums/ble_v2/bloom_filter.h"
+#include "internal/base/lru_cache.h"
 #include "internal/flags/nearby_flags.h"
 #include "internal/platform/ble_v2.h"
 #include "internal/platform/byte_array.h"
@@ -42,6 +44,9 @@ namespace {
 constexpr int kGattThreadCount = 1;
 }
 
+// C++14 requires to declare this.
+constexpr int DiscoveredPeripheralTracker::kMaxCachedAdvertisements;
+
 DiscoveredPeripheralTracker::DiscoveredPeripheralTracker(
     bool is_extended_advertisement_available)
     : is_extended_advertisement_available_(
@@ -79,6 +84,7 @@ void DiscoveredPeripheralTracker::StartTracking(
 
   // Replace if key exists.
   service_id_infos_.insert_or_assign(service_id, std::move(service_id_info));
+  UpdateTrackedServiceIds();
 
   // Clear all of the GATT read results. With this cleared, we will now attempt
   // to reconnect to every peripheral we see, giving us a chance to search for
@@ -94,6 +100,7 @@ void DiscoveredPeripheralTracker::StopTracking(const std::string& service_id) {
   MutexLock lock(&mutex_);
 
   service_id_infos_.erase(service_id);
+  UpdateTrackedServiceIds();
 }
 
 void DiscoveredPeripheralTracker::ProcessFoundBleAdvertisement(
@@ -156,6 +163,19 @@ void DiscoveredPeripheralTracker::ProcessLostGattAdvertisements() {
   }
 }
 
+LruCacheStats DiscoveredPeripheralTracker::GetParseCacheStats() const {
+  LruCacheStats stats = parsed_advertisements_.GetStats();
+  stats += parsed_advertisement_headers_.GetStats();
+  return stats;
+}
+
+void DiscoveredPeripheralTracker::UpdateTrackedServiceIds() {
+  tracked_service_ids_.clear();
+  for (const auto& item : service_id_infos_) {
+    tracked_service_ids_.push_back(item.first);
+  }
+}
+
 void DiscoveredPeripheralTracker::ClearDataForServiceId(
     const std::string& service_id) {
   std::vector<BleAdvertisement> advertisement_list;
@@ -178,7 +198,7 @@ bool DiscoveredPeripheralTracker::IsSkippableGattAdvertisement(
     return false;
   }
 
-  BleAdvertisementHeader advertisement_header(
+  BleAdvertisementHeader advertisement_header = ParseAdvertisementHeader(
       ExtractAdvertisementHeaderBytes(advertisement_data));
 
   return advertisement_header.IsValid() &&
@@ -249,7 +269,7 @@ void DiscoveredPeripheralTracker::HandleAdvertisement(
   // Create a header tied to this fast advertisement. This helps us track the
   // advertisement when reporting it as lost or connecting.
   BleAdvertisementHeader advertisement_header =
-      CreateAdvertisementHeader(advertisement_bytes);
+      ParseAdvertisement(advertisement_bytes).advertisement_header;
 
   // Process the fast advertisement like we would a GATT advertisement and
   // insert a placeholder AdvertisementReadResult.
@@ -294,6 +314,35 @@ BleAdvertisementHeader DiscoveredPeripheralTracker::CreateAdvertisementHeader(
       /*psm=*/BleAdvertisementHeader::kDefaultPsmValue);
 }
 
+DiscoveredPeripheralTracker::ParsedAdvertisement
+DiscoveredPeripheralTracker::ParseAdvertisement(
+    const ByteArray& advertisement_bytes) {
+  std::optional<ParsedAdvertisement> cached =
+      parsed_advertisements_.Get(advertisement_bytes.AsStringView());
+  if (cached.has_value()) {
+    return *std::move(cached);
+  }
+  ParsedAdvertisement parsed = {
+      .advertisement = BleAdvertisement(advertisement_bytes),
+      .advertisement_header = CreateAdvertisementHeader(advertisement_bytes)};
+  parsed_advertisements_.Put(advertisement_bytes.AsStringView(), parsed);
+  return parsed;
+}
+
+BleAdvertisementHeader DiscoveredPeripheralTracker::ParseAdvertisementHeader(
+    const ByteArray& advertisement_header_bytes) {
+  std::optional<BleAdvertisementHeader> cached =
+      parsed_advertisement_headers_.Get(
+          advertisement_header_bytes.AsStringView());
+  if (cached.has_value()) {
+    return *std::move(cached);
+  }
+  BleAdvertisementHeader parsed(advertisement_header_bytes);
+  parsed_advertisement_headers_.Put(advertisement_header_bytes.AsStringView(),
+                                    parsed);
+  return parsed;
+}
+
 BleAdvertisementHeader DiscoveredPeripheralTracker::HandleRawGattAdvertisements(
     BleV2Peripheral peripheral,
     const BleAdvertisementHeader& advertisement_header,
@@ -391,7 +440,8 @@ DiscoveredPeripheralTracker::ParseRawGattAdvertisements(
   // TODO(edwinwu): Refactor this big loop as subroutines.
   for (const auto gatt_advertisement_bytes : gatt_advertisement_bytes_list) {
     // First, parse the raw bytes into a BleAdvertisement.
-    BleAdvertisement gatt_advertisement(*gatt_advertisement_bytes);
+    BleAdvertisement gatt_advertisement =
+        ParseAdvertisement(*gatt_advertisement_bytes).advertisement;
     if (!gatt_advertisement.IsValid()) {
       NEARBY_LOGS(INFO) << "Unable to parse raw GATT advertisement:"
                         << absl::BytesToHexString(
@@ -494,7 +544,7 @@ void DiscoveredPeripheralTracker::HandleAdvertisementHeader(
     const nearby::api::ble_v2::BleAdvertisementData& advertisement_data,
     AdvertisementFetcher advertisement_fetcher) {
   // Attempt to parse the advertisement header.
-  BleAdvertisementHeader advertisement_header(
+  BleAdvertisementHeader advertisement_header = ParseAdvertisementHeader(
       ExtractAdvertisementHeaderBytes(advertisement_data));
   if (!advertisement_header.IsValid()) {
     NEARBY_LOGS(INFO)
@@ -606,13 +656,7 @@ bool DiscoveredPeripheralTracker::IsInterestingAdvertisementHeader(
           BleAdvertisementHeader::kServiceIdBloomFilterByteLength>>(),
       advertisement_header.GetServiceIdBloomFilter());
 
-  for (const auto& item : service_id_infos_) {
-    const std::string& service_id = item.first;
-    if (bloom_filter.PossiblyContains(service_id)) {
-      return true;
-    }
-  }
-  return false;
+  return bloom_filter.PossiblyContainsAny(tracked_service_ids_);
 }
 
 bool DiscoveredPeripheralTracker::ShouldReadRawAdvertisementFromServer(
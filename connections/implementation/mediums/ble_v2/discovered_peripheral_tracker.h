@@ -29,6 +29,7 @@
 #include "connections/implementation/mediums/ble_v2/ble_advertisement_header.h"
 #include "connections/implementation/mediums/ble_v2/discovered_peripheral_callback.h"
 #include "connections/implementation/mediums/lost_entity_tracker.h"
+#include "internal/base/lru_cache.h"
 #include "internal/platform/bluetooth_adapter.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/multi_thread_executor.h"
@@ -46,6 +47,10 @@ namespace mediums {
 // compute found and lost peripherals.
 class DiscoveredPeripheralTracker {
  public:
+  // Maximum number of parsed advertisements and advertisement headers kept, so
+  // that the copies a peripheral keeps sending are not parsed and hashed again.
+  static constexpr int kMaxCachedAdvertisements = 256;
+
   // GATT advertisement fetcher.
   struct AdvertisementFetcher {
     // Fetches relevant GATT advertisements for the peripheral found in {@link
@@ -102,6 +107,9 @@ class DiscoveredPeripheralTracker {
   // any lost peripherals.
   void ProcessLostGattAdvertisements() ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // Returns the lookup counts of the parsed advertisement caches.
+  LruCacheStats GetParseCacheStats() const;
+
  private:
   using BleAdvertisementSet = absl::flat_hash_set<BleAdvertisement>;
 
@@ -136,6 +144,18 @@ class DiscoveredPeripheralTracker {
     BleV2Peripheral peripheral;
   };
 
+  // The parsed form of raw advertisement bytes.
+  struct ParsedAdvertisement {
+    // Invalid if the bytes are not an advertisement.
+    BleAdvertisement advertisement;
+    // A header tied to the advertisement, for advertisements that come with
+    // no header. See CreateAdvertisementHeader().
+    BleAdvertisementHeader advertisement_header;
+  };
+
+  // Rebuilds tracked_service_ids_ from service_id_infos_.
+  void UpdateTrackedServiceIds() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Clears stale data from any previous sessions.
   void ClearDataForServiceId(const std::string& service_id)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
@@ -176,6 +196,15 @@ class DiscoveredPeripheralTracker {
   BleAdvertisementHeader CreateAdvertisementHeader(
       const ByteArray& advertisement_bytes);
 
+  // Returns `advertisement_bytes` parsed, from the cache if it was parsed
+  // before.
+  ParsedAdvertisement ParseAdvertisement(const ByteArray& advertisement_bytes);
+
+  // Returns `advertisement_header_bytes` parsed, from the cache if it was
+  // parsed before. The header is invalid if the bytes are not a header.
+  BleAdvertisementHeader ParseAdvertisementHeader(
+      const ByteArray& advertisement_header_bytes);
+
   // Returns BleAdvertisementHeader, it may be replaced if the header is mock
   // and there's a psm value in advertisement.
   BleAdvertisementHeader HandleRawGattAdvertisements(
@@ -258,6 +287,9 @@ class DiscoveredPeripheralTracker {
   // StartTracking, and removed in StopTracking.
   absl::flat_hash_map<std::string, ServiceIdInfo> service_id_infos_
       ABSL_GUARDED_BY(mutex_);
+  // The keys of service_id_infos_, to check them against a header's bloom
+  // filter in one call.
+  std::vector<std::string> tracked_service_ids_ ABSL_GUARDED_BY(mutex_);
 
   // ------------ ADVERTISEMENT HEADER MAPS ------------
   // Maps advertisement headers to AdvertisementReadResult. Tells us when to
@@ -298,6 +330,15 @@ class DiscoveredPeripheralTracker {
 
   std::unique_ptr<MultiThreadExecutor> executor_ ABSL_GUARDED_BY(mutex_) =
       nullptr;
+
+  // ------------ PARSE CACHES ------------
+  // Keyed by raw bytes. Parsing does not depend on the tracked service IDs,
+  // so entries stay valid across StartTracking and StopTracking, and invalid
+  // bytes are cached as well.
+  LruCache<ParsedAdvertisement> parsed_advertisements_{
+      kMaxCachedAdvertisements};
+  LruCache<BleAdvertisementHeader> parsed_advertisement_headers_{
+      kMaxCachedAdvertisements};
 };
 
 }  // namespace mediums
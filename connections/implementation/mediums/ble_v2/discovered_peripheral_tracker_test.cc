@@ -20,6 +20,7 @@
 #include "gtest/gtest.h"
 #include "connections/implementation/mediums/ble_v2/ble_utils.h"
 #include "connections/implementation/mediums/ble_v2/bloom_filter.h"
+#include "internal/base/lru_cache.h"
 #include "internal/platform/ble_v2.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/medium_environment.h"
@@ -218,6 +219,40 @@ TEST_F(DiscoveredPeripheralTrackerTest,
   EXPECT_EQ(GetFetchAdvertisementCallbackCount(), 0);
 }
 
+TEST_F(DiscoveredPeripheralTrackerTest,
+       RepeatedFastAdvertisementIsParsedOnce) {
+  ByteArray fast_advertisement_bytes = CreateFastBleAdvertisement(
+      ByteArray(std::string(kData)), ByteArray(std::string(kDeviceToken)));
+  CountDownLatch fetch_latch(1);
+  int found_count = 0;
+
+  discovered_peripheral_tracker_.StartTracking(
+      std::string(kServiceIdA),
+      {
+          .peripheral_discovered_cb =
+              [&found_count](BleV2Peripheral peripheral,
+                             const std::string& service_id,
+                             const ByteArray& advertisement_bytes,
+                             bool fast_advertisement) { found_count++; },
+      },
+      Uuid(kFastAdvertisementServiceUuid));
+
+  api::ble_v2::BleAdvertisementData advertisement_data;
+  advertisement_data.service_data.insert(
+      {Uuid(kFastAdvertisementServiceUuid), fast_advertisement_bytes});
+
+  FindFastAdvertisement(advertisement_data, {}, fetch_latch);
+  LruCacheStats first_stats =
+      discovered_peripheral_tracker_.GetParseCacheStats();
+  FindFastAdvertisement(advertisement_data, {}, fetch_latch);
+  FindFastAdvertisement(advertisement_data, {}, fetch_latch);
+  LruCacheStats stats = discovered_peripheral_tracker_.GetParseCacheStats();
+
+  EXPECT_EQ(found_count, 1);
+  EXPECT_EQ(stats.misses, first_stats.misses);
+  EXPECT_GT(stats.hits, first_stats.hits);
+}
+
 TEST_F(DiscoveredPeripheralTrackerTest,
        CanStartMultipleTrackingWithSameServiceId) {
   ByteArray fast_advertisement_bytes = CreateFastBleAdvertisement(
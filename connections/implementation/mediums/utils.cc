@@ -17,8 +17,9 @@
 #include <memory>
 #include <string>
 
-#include "internal/platform/prng.h"
+#include "absl/strings/string_view.h"
 #include "internal/platform/crypto.h"
+#include "internal/platform/prng.h"
 
 namespace nearby {
 namespace connections {
@@ -46,13 +47,17 @@ ByteArray Utils::GenerateRandomBytes(size_t length) {
 }
 
 ByteArray Utils::Sha256Hash(const ByteArray& source, size_t length) {
-  return Utils::Sha256Hash(std::string(source), length);
+  return Utils::Sha256Hash(source.AsStringView(), length);
 }
 
-ByteArray Utils::Sha256Hash(const std::string& source, size_t length) {
-  ByteArray full_hash(length);
-  full_hash.CopyAt(0, Crypto::Sha256(source));
-  return full_hash;
+ByteArray Utils::Sha256Hash(absl::string_view source, size_t length) {
+  ByteArray full_hash = Crypto::Sha256(source);
+  if (length <= full_hash.size()) {
+    return ByteArray(full_hash.data(), length);
+  }
+  ByteArray padded_hash(length);
+  padded_hash.CopyAt(0, full_hash);
+  return padded_hash;
 }
 
 LocationHint Utils::BuildLocationHint(const std::string& location) {
@@ -18,6 +18,7 @@
 #include <memory>
 #include <string>
 
+#include "absl/strings/string_view.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "internal/platform/byte_array.h"
 
@@ -27,8 +28,10 @@ namespace connections {
 class Utils {
  public:
   static ByteArray GenerateRandomBytes(size_t length);
+  // Returns the first `length` bytes of the SHA256 hash of `source`, padded
+  // with zeros if `length` is longer than the hash.
   static ByteArray Sha256Hash(const ByteArray& source, size_t length);
-  static ByteArray Sha256Hash(const std::string& source, size_t length);
+  static ByteArray Sha256Hash(absl::string_view source, size_t length);
   static location::nearby::connections::LocationHint BuildLocationHint(
       const std::string& location);
 };
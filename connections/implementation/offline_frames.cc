@@ -14,12 +14,15 @@
 
 #include "connections/implementation/offline_frames.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/offline_frames_validator.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
@@ -51,12 +54,158 @@ ByteArray ToBytes(OfflineFrame&& frame) {
   return bytes;
 }
 
+// Protobuf wire types.
+constexpr int kWireTypeVarint = 0;
+constexpr int kWireTypeFixed64 = 1;
+constexpr int kWireTypeLengthDelimited = 2;
+constexpr int kWireTypeFixed32 = 5;
+
+// PayloadDataFrameFromBytes() only needs fields numbered up to this one from
+// any message it decodes.
+constexpr std::uint64_t kMaxWireFieldNumber = 4;
+
+// The fields of an encoded message, indexed by field number. Length delimited
+// values point into the encoded message.
+struct WireFields {
+  std::optional<std::uint64_t> varints[kMaxWireFieldNumber + 1];
+  std::optional<absl::string_view> length_delimited[kMaxWireFieldNumber + 1];
+};
+
+bool ReadVarint(absl::string_view& data, std::uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (data.empty()) return false;
+    std::uint8_t byte = data.front();
+    data.remove_prefix(1);
+    value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+bool ReadFixed(absl::string_view& data, std::size_t size) {
+  if (data.size() < size) return false;
+  data.remove_prefix(size);
+  return true;
+}
+
+bool ReadLengthDelimited(absl::string_view& data, absl::string_view& value) {
+  std::uint64_t size;
+  if (!ReadVarint(data, size) || size > data.size()) return false;
+  value = data.substr(0, size);
+  data.remove_prefix(size);
+  return true;
+}
+
+// Splits `message` into `fields`, skipping all other fields. Like a protobuf
+// parser, keeps the last value of a repeated varint. Fails on a malformed
+// message, on groups, and on a repeated length delimited field, which
+// protobuf would merge if it is a message; the full parser handles those.
+bool ReadWireFields(absl::string_view message, WireFields& fields) {
+  while (!message.empty()) {
+    std::uint64_t key;
+    if (!ReadVarint(message, key)) return false;
+    std::uint64_t number = key >> 3;
+    int wire_type = key & 7;
+    // Protobuf tags are 32 bits and field numbers start at 1.
+    if (key > 0xffffffff || number == 0) return false;
+    bool kept = number <= kMaxWireFieldNumber;
+    switch (wire_type) {
+      case kWireTypeVarint: {
+        std::uint64_t value;
+        if (!ReadVarint(message, value)) return false;
+        if (kept) fields.varints[number] = value;
+        break;
+      }
+      case kWireTypeFixed64:
+        if (!ReadFixed(message, 8)) return false;
+        break;
+      case kWireTypeLengthDelimited: {
+        absl::string_view value;
+        if (!ReadLengthDelimited(message, value)) return false;
+        if (kept) {
+          if (fields.length_delimited[number].has_value()) return false;
+          fields.length_delimited[number] = value;
+        }
+        break;
+      }
+      case kWireTypeFixed32:
+        if (!ReadFixed(message, 4)) return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+bool VarintEquals(const std::optional<std::uint64_t>& varint, int value) {
+  return varint.has_value() && *varint == static_cast<std::uint64_t>(value);
+}
+
 }  // namespace
 
+std::optional<PayloadDataFrame> PayloadDataFrameFromBytes(
+    absl::string_view offline_frame_bytes) {
+  // OfflineFrame: version = 1, v1 = 2.
+  WireFields offline_frame;
+  if (!ReadWireFields(offline_frame_bytes, offline_frame) ||
+      !VarintEquals(offline_frame.varints[1], OfflineFrame::V1) ||
+      !offline_frame.length_delimited[2].has_value()) {
+    return std::nullopt;
+  }
+  // V1Frame: type = 1, payload_transfer = 4.
+  WireFields v1_frame;
+  if (!ReadWireFields(*offline_frame.length_delimited[2], v1_frame) ||
+      !VarintEquals(v1_frame.varints[1], V1Frame::PAYLOAD_TRANSFER) ||
+      !v1_frame.length_delimited[4].has_value()) {
+    return std::nullopt;
+  }
+  // PayloadTransferFrame: packet_type = 1, payload_header = 2,
+  // payload_chunk = 3.
+  WireFields payload_transfer;
+  if (!ReadWireFields(*v1_frame.length_delimited[4], payload_transfer) ||
+      !VarintEquals(payload_transfer.varints[1], PayloadTransferFrame::DATA) ||
+      !payload_transfer.length_delimited[2].has_value() ||
+      !payload_transfer.length_delimited[3].has_value()) {
+    return std::nullopt;
+  }
+  // PayloadChunk: flags = 1, offset = 2, body = 3, index = 4.
+  WireFields chunk;
+  if (!ReadWireFields(*payload_transfer.length_delimited[3], chunk)) {
+    return std::nullopt;
+  }
+
+  PayloadDataFrame frame;
+  // The header is small, so it goes through the regular parser.
+  absl::string_view header = *payload_transfer.length_delimited[2];
+  if (!frame.header.ParseFromArray(header.data(),
+                                   static_cast<int>(header.size()))) {
+    return std::nullopt;
+  }
+  if (chunk.varints[1].has_value()) {
+    frame.chunk.set_flags(static_cast<std::int32_t>(*chunk.varints[1]));
+  }
+  if (chunk.varints[2].has_value()) {
+    frame.chunk.set_offset(static_cast<std::int64_t>(*chunk.varints[2]));
+  }
+  if (chunk.varints[4].has_value()) {
+    frame.chunk.set_index(static_cast<std::int32_t>(*chunk.varints[4]));
+  }
+  bool has_body = chunk.length_delimited[3].has_value();
+  if (has_body) frame.body = *chunk.length_delimited[3];
+
+  if (EnsureValidPayloadDataFrame(frame.header, frame.chunk, has_body)
+          .Raised()) {
+    return std::nullopt;
+  }
+  return frame;
+}
+
 ExceptionOrOfflineFrame FromBytes(const ByteArray& bytes) {
   OfflineFrame frame;
 
-  if (frame.ParseFromString(std::string(bytes))) {
+  if (frame.ParseFromArray(bytes.data(), static_cast<int>(bytes.size()))) {
     Exception validation_exception = EnsureValidOfflineFrame(frame);
     if (validation_exception.Raised()) {
       return ExceptionOrOfflineFrame(validation_exception);
@@ -203,10 +352,20 @@ ByteArray ForDataPayloadTransfer(
   v1_frame->set_type(V1Frame::PAYLOAD_TRANSFER);
   auto* sub_frame = v1_frame->mutable_payload_transfer();
   sub_frame->set_packet_type(PayloadTransferFrame::DATA);
-  *sub_frame->mutable_payload_header() = header;
-  *sub_frame->mutable_payload_chunk() = chunk;
-
-  return ToBytes(std::move(frame));
+  // Borrow the header and chunk instead of copying them into the frame; the
+  // chunk body is the bulk of the frame and would otherwise be copied once
+  // here and again by the serializer. Ownership is given back before |frame|
+  // goes out of scope, so the borrowed messages are never freed by it.
+  sub_frame->unsafe_arena_set_allocated_payload_header(
+      const_cast<PayloadTransferFrame::PayloadHeader*>(&header));
+  sub_frame->unsafe_arena_set_allocated_payload_chunk(
+      const_cast<PayloadTransferFrame::PayloadChunk*>(&chunk));
+
+  ByteArray bytes = ToBytes(std::move(frame));
+
+  sub_frame->unsafe_arena_release_payload_header();
+  sub_frame->unsafe_arena_release_payload_chunk();
+  return bytes;
 }
 
 ByteArray ForControlPayloadTransfer(
@@ -16,9 +16,11 @@
 #define CORE_INTERNAL_OFFLINE_FRAMES_H_
 
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
 #include "connections/implementation/proto/offline_wire_formats.pb.h"
 #include "connections/connection_options.h"
 #include "internal/platform/byte_array.h"
@@ -39,6 +41,22 @@ using UpgradePathInfo = ::location::nearby::connections::
 ExceptionOr<location::nearby::connections::OfflineFrame> FromBytes(
     const ByteArray& offline_frame_bytes);
 
+// A PAYLOAD_TRANSFER DATA frame, decoded without building an OfflineFrame.
+struct PayloadDataFrame {
+  location::nearby::connections::PayloadTransferFrame::PayloadHeader header;
+  // The chunk's flags, offset and index. Its body is left out; see `body`.
+  location::nearby::connections::PayloadTransferFrame::PayloadChunk chunk;
+  // The chunk body. Points into the bytes the frame was decoded from.
+  absl::string_view body;
+};
+
+// Decodes `offline_frame_bytes` if it holds a valid PAYLOAD_TRANSFER DATA
+// frame. This is the data path's alternative to FromBytes(): the chunk body is
+// not copied and no OfflineFrame is allocated. Returns std::nullopt for any
+// other message, valid or not, which FromBytes() then has to parse.
+std::optional<PayloadDataFrame> PayloadDataFrameFromBytes(
+    absl::string_view offline_frame_bytes);
+
 // Returns FrameType of a parsed message, or
 // V1Frame::UNKNOWN_FRAME_TYPE, if frame contents is not recognized.
 location::nearby::connections::V1Frame::FrameType GetFrameType(
@@ -16,6 +16,7 @@
 
 #include <array>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -337,6 +338,117 @@ TEST(OfflineFramesTest, CanGenerateDataPayloadTransfer) {
   EXPECT_THAT(message, EqualsProto(kExpected));
 }
 
+TEST(OfflineFramesTest, DataPayloadTransferLeavesHeaderAndChunkIntact) {
+  PayloadTransferFrame::PayloadHeader header;
+  PayloadTransferFrame::PayloadChunk chunk;
+  header.set_id(12345);
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_total_size(1024);
+  chunk.set_body("payload data");
+  chunk.set_offset(150);
+
+  ByteArray first = ForDataPayloadTransfer(header, chunk);
+  ByteArray second = ForDataPayloadTransfer(header, chunk);
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(header.id(), 12345);
+  EXPECT_EQ(header.total_size(), 1024);
+  EXPECT_EQ(chunk.body(), "payload data");
+  EXPECT_EQ(chunk.offset(), 150);
+}
+
+TEST(OfflineFramesTest, DecodesDataPayloadTransferInPlace) {
+  PayloadTransferFrame::PayloadHeader header;
+  PayloadTransferFrame::PayloadChunk chunk;
+  header.set_id(12345);
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_total_size(1024);
+  header.set_file_name("file.txt");
+  chunk.set_body("payload data");
+  chunk.set_offset(150);
+  chunk.set_flags(0);
+  chunk.set_index(3);
+  ByteArray bytes = ForDataPayloadTransfer(header, chunk);
+
+  std::optional<PayloadDataFrame> frame =
+      PayloadDataFrameFromBytes(bytes.AsStringView());
+
+  ASSERT_TRUE(frame.has_value());
+  EXPECT_THAT(frame->header, EqualsProto(header));
+  EXPECT_EQ(frame->chunk.flags(), 0);
+  EXPECT_EQ(frame->chunk.offset(), 150);
+  EXPECT_EQ(frame->chunk.index(), 3);
+  EXPECT_FALSE(frame->chunk.has_body());
+  EXPECT_EQ(frame->body, "payload data");
+  // The body is a view into the frame, not a copy.
+  EXPECT_GE(frame->body.data(), bytes.data());
+  EXPECT_LE(frame->body.data() + frame->body.size(),
+            bytes.data() + bytes.size());
+}
+
+TEST(OfflineFramesTest, DecodesLastChunkWithoutBody) {
+  PayloadTransferFrame::PayloadHeader header;
+  PayloadTransferFrame::PayloadChunk chunk;
+  header.set_id(12345);
+  header.set_type(PayloadTransferFrame::PayloadHeader::STREAM);
+  header.set_total_size(-1);
+  chunk.set_offset(1024);
+  chunk.set_flags(PayloadTransferFrame::PayloadChunk::LAST_CHUNK);
+
+  std::optional<PayloadDataFrame> frame = PayloadDataFrameFromBytes(
+      ForDataPayloadTransfer(header, chunk).AsStringView());
+
+  ASSERT_TRUE(frame.has_value());
+  EXPECT_EQ(frame->chunk.flags(),
+            PayloadTransferFrame::PayloadChunk::LAST_CHUNK);
+  EXPECT_TRUE(frame->body.empty());
+}
+
+TEST(OfflineFramesTest, DataFrameDecoderLeavesOtherFramesToFromBytes) {
+  PayloadTransferFrame::PayloadHeader header;
+  PayloadTransferFrame::ControlMessage control;
+  header.set_id(12345);
+  header.set_type(PayloadTransferFrame::PayloadHeader::BYTES);
+  header.set_total_size(1024);
+  control.set_event(PayloadTransferFrame::ControlMessage::PAYLOAD_CANCELED);
+  control.set_offset(150);
+
+  EXPECT_FALSE(PayloadDataFrameFromBytes(
+                   ForControlPayloadTransfer(header, control).AsStringView())
+                   .has_value());
+  EXPECT_FALSE(
+      PayloadDataFrameFromBytes(ForKeepAlive().AsStringView()).has_value());
+}
+
+TEST(OfflineFramesTest, DataFrameDecoderRejectsInvalidFrames) {
+  PayloadTransferFrame::PayloadHeader header;
+  PayloadTransferFrame::PayloadChunk chunk;
+  header.set_id(12345);
+  header.set_type(PayloadTransferFrame::PayloadHeader::FILE);
+  header.set_total_size(1024);
+  chunk.set_body("payload data");
+  chunk.set_offset(150);
+  chunk.set_flags(0);
+  ByteArray bytes = ForDataPayloadTransfer(header, chunk);
+  ASSERT_TRUE(PayloadDataFrameFromBytes(bytes.AsStringView()).has_value());
+
+  // Truncated.
+  EXPECT_FALSE(PayloadDataFrameFromBytes(
+                   bytes.AsStringView().substr(0, bytes.size() - 1))
+                   .has_value());
+  // Offset past the end of the payload.
+  chunk.set_offset(2048);
+  EXPECT_FALSE(PayloadDataFrameFromBytes(
+                   ForDataPayloadTransfer(header, chunk).AsStringView())
+                   .has_value());
+  // Illegal file name.
+  chunk.set_offset(150);
+  header.set_file_name("../file.txt");
+  EXPECT_FALSE(PayloadDataFrameFromBytes(
+                   ForDataPayloadTransfer(header, chunk).AsStringView())
+                   .has_value());
+}
+
 TEST(OfflineFramesTest, CanGenerateBwuWifiHotspotPathAvailable) {
   constexpr absl::string_view kExpected =
       R"pb(
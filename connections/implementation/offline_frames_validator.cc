@@ -89,6 +89,7 @@ Exception EnsureValidConnectionResponseFrame(
 }
 
 Exception EnsureValidPayloadTransferDataFrame(const PayloadChunk& payload_chunk,
+                                              bool has_body,
                                               std::int64_t totalSize) {
   if (!payload_chunk.has_flags()) return {Exception::kInvalidProtocolBuffer};
 
@@ -96,7 +97,7 @@ Exception EnsureValidPayloadTransferDataFrame(const PayloadChunk& payload_chunk,
   // chunk.
   bool is_last_chunk = (payload_chunk.flags() &
                         PayloadTransferFrame::PayloadChunk::LAST_CHUNK) != 0;
-  if (!payload_chunk.has_body() && !is_last_chunk)
+  if (!has_body && !is_last_chunk)
     return {Exception::kInvalidProtocolBuffer};
   if (!payload_chunk.has_offset() || payload_chunk.offset() < 0)
     return {Exception::kInvalidProtocolBuffer};
@@ -124,20 +125,27 @@ Exception EnsureValidPayloadTransferControlFrame(
   return {Exception::kSuccess};
 }
 
+Exception EnsureValidPayloadHeader(
+    const PayloadTransferFrame::PayloadHeader& payload_header) {
+  if (!payload_header.has_total_size() ||
+      (payload_header.total_size() < 0 &&
+       payload_header.total_size() != InternalPayload::kIndeterminateSize))
+    return {Exception::kInvalidProtocolBuffer};
+  return {Exception::kSuccess};
+}
+
 Exception EnsureValidPayloadTransferFrame(const PayloadTransferFrame& frame) {
   if (!frame.has_payload_header()) return {Exception::kInvalidProtocolBuffer};
-  if (!frame.payload_header().has_total_size() ||
-      (frame.payload_header().total_size() < 0 &&
-       frame.payload_header().total_size() !=
-           InternalPayload::kIndeterminateSize))
-    return {Exception::kInvalidProtocolBuffer};
+  Exception header_exception = EnsureValidPayloadHeader(frame.payload_header());
+  if (header_exception.Raised()) return header_exception;
   if (!frame.has_packet_type()) return {Exception::kInvalidProtocolBuffer};
 
   switch (frame.packet_type()) {
     case PayloadTransferFrame::DATA:
       if (frame.has_payload_chunk()) {
         return EnsureValidPayloadTransferDataFrame(
-            frame.payload_chunk(), frame.payload_header().total_size());
+            frame.payload_chunk(), frame.payload_chunk().has_body(),
+            frame.payload_header().total_size());
       }
       return {Exception::kInvalidProtocolBuffer};
 
@@ -367,6 +375,27 @@ bool CheckForIllegalCharacters(std::string toBeValidated,
   return false;
 }
 
+Exception EnsureLegalPayloadFileNames(
+    const PayloadTransferFrame::PayloadHeader& payload_header) {
+  if (!payload_header.has_type() ||
+      payload_header.type() != PayloadTransferFrame::PayloadHeader::FILE) {
+    return {Exception::kSuccess};
+  }
+  if (payload_header.has_file_name() &&
+      CheckForIllegalCharacters(payload_header.file_name(),
+                                kIllegalFileNamePatterns,
+                                kIllegalFileNamePatternsSize)) {
+    return {Exception::kIllegalCharacters};
+  }
+  if (payload_header.has_parent_folder() &&
+      CheckForIllegalCharacters(payload_header.parent_folder(),
+                                kIllegalParentFolderPatterns,
+                                kIllegalParentFolderPatternsSize)) {
+    return {Exception::kIllegalCharacters};
+  }
+  return {Exception::kSuccess};
+}
+
 }  // namespace
 
 Exception EnsureValidOfflineFrame(
@@ -389,45 +418,16 @@ Exception EnsureValidOfflineFrame(
       }
       return {Exception::kInvalidProtocolBuffer};
 
-    case V1Frame::PAYLOAD_TRANSFER:
-      if (offline_frame.has_v1() &&
-          (offline_frame.v1().payload_transfer().payload_header().has_type() &&
-           offline_frame.v1().payload_transfer().payload_header().type() ==
-               location::nearby::connections::
-                   PayloadTransferFrame_PayloadHeader_PayloadType::
-                       PayloadTransferFrame_PayloadHeader_PayloadType_FILE)) {
-        if (offline_frame.v1()
-                .payload_transfer()
-                .payload_header()
-                .has_file_name()) {
-          if (CheckForIllegalCharacters(offline_frame.v1()
-                                            .payload_transfer()
-                                            .payload_header()
-                                            .file_name(),
-                                        kIllegalFileNamePatterns,
-                                        kIllegalFileNamePatternsSize)) {
-            return {Exception::kIllegalCharacters};
-          }
-        }
-        if (offline_frame.v1()
-                .payload_transfer()
-                .payload_header()
-                .has_parent_folder()) {
-          if (CheckForIllegalCharacters(offline_frame.v1()
-                                            .payload_transfer()
-                                            .payload_header()
-                                            .parent_folder(),
-                                        kIllegalParentFolderPatterns,
-                                        kIllegalParentFolderPatternsSize)) {
-            return {Exception::kIllegalCharacters};
-          }
-        }
-      }
+    case V1Frame::PAYLOAD_TRANSFER: {
+      Exception names_exception = EnsureLegalPayloadFileNames(
+          offline_frame.v1().payload_transfer().payload_header());
+      if (names_exception.Raised()) return names_exception;
       if (offline_frame.has_v1() && offline_frame.v1().has_payload_transfer()) {
         return EnsureValidPayloadTransferFrame(
             offline_frame.v1().payload_transfer());
       }
       return {Exception::kInvalidProtocolBuffer};
+    }
 
     case V1Frame::BANDWIDTH_UPGRADE_NEGOTIATION:
       if (offline_frame.has_v1() &&
@@ -446,6 +446,17 @@ Exception EnsureValidOfflineFrame(
   return {Exception::kSuccess};
 }
 
+Exception EnsureValidPayloadDataFrame(
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    const PayloadChunk& payload_chunk, bool has_body) {
+  Exception names_exception = EnsureLegalPayloadFileNames(payload_header);
+  if (names_exception.Raised()) return names_exception;
+  Exception header_exception = EnsureValidPayloadHeader(payload_header);
+  if (header_exception.Raised()) return header_exception;
+  return EnsureValidPayloadTransferDataFrame(payload_chunk, has_body,
+                                             payload_header.total_size());
+}
+
 }  // namespace parser
 }  // namespace connections
 }  // namespace nearby
@@ -39,6 +39,16 @@ const size_t kIllegalParentFolderPatternsSize =
 Exception EnsureValidOfflineFrame(
     const location::nearby::connections::OfflineFrame& offline_frame);
 
+// Runs the checks EnsureValidOfflineFrame() does for a PAYLOAD_TRANSFER DATA
+// frame on a header and chunk that were decoded without an OfflineFrame.
+// `payload_chunk` carries no body; `has_body` says whether the frame had one.
+Exception EnsureValidPayloadDataFrame(
+    const location::nearby::connections::PayloadTransferFrame::PayloadHeader&
+        payload_header,
+    const location::nearby::connections::PayloadTransferFrame::PayloadChunk&
+        payload_chunk,
+    bool has_body);
+
 }  // namespace parser
 }  // namespace connections
 }  // namespace nearby
@@ -20,6 +20,7 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/system_clock.h"
+#include "proto/connections_enums.pb.h"
 
 namespace nearby {
 namespace connections {
@@ -57,6 +58,15 @@ void OfflineSimulationUser::OnEndpointDisconnect(
   if (disconnect_latch_) disconnect_latch_->CountDown();
 }
 
+void OfflineSimulationUser::OnBandwidthChanged(const std::string& endpoint_id,
+                                               Medium medium) {
+  NEARBY_LOGS(INFO) << "OnBandwidthChanged: self=" << this
+                    << "; id=" << endpoint_id << "; medium="
+                    << location::nearby::proto::connections::Medium_Name(
+                           medium);
+  if (bandwidth_changed_latch_) bandwidth_changed_latch_->CountDown();
+}
+
 void OfflineSimulationUser::OnEndpointFound(const std::string& endpoint_id,
                                             const ByteArray& endpoint_info,
                                             const std::string& service_id) {
@@ -119,6 +129,8 @@ Status OfflineSimulationUser::StartAdvertising(const std::string& service_id,
           absl::bind_front(&OfflineSimulationUser::OnConnectionRejected, this),
       .disconnected_cb =
           absl::bind_front(&OfflineSimulationUser::OnEndpointDisconnect, this),
+      .bandwidth_changed_cb =
+          absl::bind_front(&OfflineSimulationUser::OnBandwidthChanged, this),
   };
   return ctrl_.StartAdvertising(&client_, service_id_, advertising_options_,
                                 {
@@ -176,6 +188,8 @@ Status OfflineSimulationUser::RequestConnection(CountDownLatch* latch) {
           absl::bind_front(&OfflineSimulationUser::OnConnectionRejected, this),
       .disconnected_cb =
           absl::bind_front(&OfflineSimulationUser::OnEndpointDisconnect, this),
+      .bandwidth_changed_cb =
+          absl::bind_front(&OfflineSimulationUser::OnBandwidthChanged, this),
   };
   client_.AddCancellationFlag(discovered_.endpoint_id);
   return ctrl_.RequestConnection(&client_, discovered_.endpoint_id,
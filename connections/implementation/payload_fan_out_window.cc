@@ -0,0 +1,230 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/payload_fan_out_window.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/platform/submittable_executor.h"
+
+namespace nearby {
+namespace connections {
+
+std::shared_ptr<const ByteArray> PayloadFanOutWindow::Chunk::GetFrame(
+    std::size_t begin, std::size_t size,
+    absl::FunctionRef<ByteArray()> build) const {
+  // Building under the lock makes endpoints asking for the same piece wait for
+  // one build instead of each doing their own.
+  MutexLock lock(&mutex_);
+  std::shared_ptr<const ByteArray>& frame = frames_[{begin, size}];
+  if (!frame) {
+    frame = std::make_shared<const ByteArray>(build());
+  }
+  return frame;
+}
+
+PayloadFanOutWindow::PayloadFanOutWindow(
+    const std::vector<std::string>& endpoint_ids,
+    std::int64_t max_buffered_bytes)
+    : max_buffered_bytes_(max_buffered_bytes) {
+  for (const auto& endpoint_id : endpoint_ids) {
+    cursors_.emplace(endpoint_id, 0);
+  }
+}
+
+bool PayloadFanOutWindow::Push(std::shared_ptr<const Chunk> chunk) {
+  std::vector<absl::AnyInvocable<void()>> waiters;
+  {
+    MutexLock lock(&mutex_);
+    std::int64_t size = chunk->GetBody().size();
+    // An empty window always takes the next chunk, however large it is.
+    while (!aborted_ && !cursors_.empty() && !chunks_.empty() &&
+           buffered_bytes_ + size > max_buffered_bytes_) {
+      cond_.Wait();
+    }
+    if (aborted_ || cursors_.empty()) return false;
+
+    chunks_.push_back(std::move(chunk));
+    buffered_bytes_ += size;
+    cond_.Notify();
+    waiters = TakeWaitersLocked();
+  }
+  for (auto& on_pushed : waiters) {
+    on_pushed();
+  }
+  return true;
+}
+
+std::vector<std::string> PayloadFanOutWindow::Abort() {
+  std::vector<std::string> remaining;
+  std::vector<absl::AnyInvocable<void()>> waiters;
+  {
+    MutexLock lock(&mutex_);
+    remaining.reserve(cursors_.size());
+    for (const auto& item : cursors_) {
+      remaining.push_back(item.first);
+    }
+    aborted_ = true;
+    cursors_.clear();
+    TrimLocked();
+    cond_.Notify();
+    waiters = TakeWaitersLocked();
+  }
+  for (auto& on_pushed : waiters) {
+    on_pushed();
+  }
+  return remaining;
+}
+
+std::shared_ptr<const PayloadFanOutWindow::Chunk> PayloadFanOutWindow::Next(
+    const std::string& endpoint_id) {
+  MutexLock lock(&mutex_);
+  while (true) {
+    if (aborted_) return nullptr;
+    auto item = cursors_.find(endpoint_id);
+    if (item == cursors_.end()) return nullptr;
+
+    std::int64_t index = item->second;
+    if (index < first_index_ + static_cast<std::int64_t>(chunks_.size())) {
+      std::shared_ptr<const Chunk> chunk = chunks_[index - first_index_];
+      ++item->second;
+      TrimLocked();
+      return chunk;
+    }
+    cond_.Wait();
+  }
+}
+
+bool PayloadFanOutWindow::TryNext(const std::string& endpoint_id,
+                                  std::shared_ptr<const Chunk>* chunk,
+                                  absl::AnyInvocable<void()> on_pushed) {
+  MutexLock lock(&mutex_);
+  *chunk = nullptr;
+  if (aborted_) return false;
+  auto item = cursors_.find(endpoint_id);
+  if (item == cursors_.end()) return false;
+
+  std::int64_t index = item->second;
+  if (index < first_index_ + static_cast<std::int64_t>(chunks_.size())) {
+    *chunk = chunks_[index - first_index_];
+    ++item->second;
+    TrimLocked();
+  } else {
+    waiters_[endpoint_id] = std::move(on_pushed);
+  }
+  return true;
+}
+
+void PayloadFanOutWindow::Leave(const std::string& endpoint_id) {
+  MutexLock lock(&mutex_);
+  waiters_.erase(endpoint_id);
+  if (cursors_.erase(endpoint_id) == 0) return;
+  TrimLocked();
+  // The producer may be waiting for this endpoint to make room, or for any
+  // endpoint to remain at all.
+  cond_.Notify();
+}
+
+std::int64_t PayloadFanOutWindow::GetBufferedBytes() const {
+  MutexLock lock(&mutex_);
+  return buffered_bytes_;
+}
+
+void PayloadFanOutWindow::TrimLocked() {
+  std::int64_t slowest = first_index_ + chunks_.size();
+  for (const auto& item : cursors_) {
+    slowest = std::min(slowest, item.second);
+  }
+  bool trimmed = false;
+  while (first_index_ < slowest) {
+    buffered_bytes_ -= chunks_.front()->GetBody().size();
+    chunks_.pop_front();
+    ++first_index_;
+    trimmed = true;
+  }
+  if (trimmed) cond_.Notify();
+}
+
+std::vector<absl::AnyInvocable<void()>>
+PayloadFanOutWindow::TakeWaitersLocked() {
+  std::vector<absl::AnyInvocable<void()>> waiters;
+  waiters.reserve(waiters_.size());
+  for (auto& item : waiters_) {
+    waiters.push_back(std::move(item.second));
+  }
+  waiters_.clear();
+  return waiters;
+}
+
+PayloadFanOutSenders::PayloadFanOutSenders(
+    PayloadFanOutWindow& window, const std::vector<std::string>& endpoint_ids,
+    SubmittableExecutor& executor, SendChunk send_chunk)
+    : window_(window),
+      executor_(executor),
+      send_chunk_(std::move(send_chunk)),
+      done_(endpoint_ids.size()) {
+  for (const auto& endpoint_id : endpoint_ids) {
+    Post(endpoint_id);
+  }
+}
+
+bool PayloadFanOutSenders::Wait() {
+  done_.Await();
+  return delivered_.Get();
+}
+
+void PayloadFanOutSenders::Post(std::string endpoint_id) {
+  executor_.Execute("fan-out-payload",
+                    [this, endpoint_id = std::move(endpoint_id)]() mutable {
+                      Send(std::move(endpoint_id));
+                    });
+}
+
+void PayloadFanOutSenders::Send(std::string endpoint_id) {
+  std::shared_ptr<const PayloadFanOutWindow::Chunk> chunk;
+  bool keep_sending = false;
+  if (window_.TryNext(endpoint_id, &chunk,
+                      [this, endpoint_id]() { Post(endpoint_id); })) {
+    // Posted again once the chunk is pushed.
+    if (chunk == nullptr) return;
+    if (send_chunk_(*chunk, endpoint_id)) {
+      if (chunk->IsLast()) {
+        delivered_.Set(true);
+      } else {
+        keep_sending = true;
+      }
+    }
+  }
+  if (keep_sending) {
+    // Go to the back of the executor's queue, so that endpoints take turns
+    // on its threads.
+    Post(std::move(endpoint_id));
+    return;
+  }
+  window_.Leave(endpoint_id);
+  done_.CountDown();
+}
+
+}  // namespace connections
+}  // namespace nearby
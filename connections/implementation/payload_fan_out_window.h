@@ -0,0 +1,175 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef CORE_INTERNAL_PAYLOAD_FAN_OUT_WINDOW_H_
+#define CORE_INTERNAL_PAYLOAD_FAN_OUT_WINDOW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
+#include "internal/platform/atomic_boolean.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/condition_variable.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/submittable_executor.h"
+
+namespace nearby {
+namespace connections {
+
+// Shares the chunks of one outgoing payload between the endpoints it is sent
+// to.
+//
+// The payload is read once, by a single producer that appends chunks with
+// Push(). Every endpoint walks the chunks with its own cursor through Next(),
+// so a fast endpoint is not held back by a slow one. A chunk is dropped once
+// every endpoint still receiving the payload has moved past it; Push() blocks
+// while the chunks held back this way exceed |max_buffered_bytes|. That bounds
+// how far the fastest endpoint can run ahead of the slowest one.
+//
+// Thread-safe.
+class PayloadFanOutWindow {
+ public:
+  // A chunk of the payload at |offset|. An empty body marks the end of the
+  // payload.
+  class Chunk {
+   public:
+    Chunk(std::int64_t offset, ByteArray body)
+        : offset_(offset), body_(std::move(body)) {}
+
+    std::int64_t GetOffset() const { return offset_; }
+    const ByteArray& GetBody() const { return body_; }
+    bool IsLast() const { return body_.Empty(); }
+
+    // Returns the frame that carries |size| bytes of the body starting at
+    // |begin|. The frame is built with |build| by the first endpoint that asks
+    // for it, and shared with every other endpoint sending the same piece.
+    std::shared_ptr<const ByteArray> GetFrame(
+        std::size_t begin, std::size_t size,
+        absl::FunctionRef<ByteArray()> build) const;
+
+   private:
+    const std::int64_t offset_;
+    const ByteArray body_;
+    mutable Mutex mutex_;
+    mutable absl::flat_hash_map<std::pair<std::size_t, std::size_t>,
+                                std::shared_ptr<const ByteArray>>
+        frames_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  PayloadFanOutWindow(const std::vector<std::string>& endpoint_ids,
+                      std::int64_t max_buffered_bytes);
+
+  // Appends |chunk|, blocking while the window is full. Returns false, without
+  // appending, once every endpoint has left or the window was aborted.
+  bool Push(std::shared_ptr<const Chunk> chunk);
+
+  // Wakes up all waiters; Push() and Next() fail from now on. Returns the
+  // endpoints that had not left the window yet.
+  std::vector<std::string> Abort();
+
+  // Returns the chunk after the one last returned to |endpoint_id|, blocking
+  // until the producer has pushed it. Returns nullptr if the window was aborted
+  // or the endpoint has left.
+  std::shared_ptr<const Chunk> Next(const std::string& endpoint_id);
+
+  // Like Next(), but does not block. Returns false if the window was aborted
+  // or the endpoint has left. Otherwise sets |chunk| to the next chunk, or,
+  // if it has not been pushed yet, to nullptr; |on_pushed| is then called,
+  // without the window's lock, once it is pushed or the window is aborted.
+  bool TryNext(const std::string& endpoint_id,
+               std::shared_ptr<const Chunk>* chunk,
+               absl::AnyInvocable<void()> on_pushed);
+
+  // Stops holding chunks back for |endpoint_id|.
+  void Leave(const std::string& endpoint_id);
+
+  // Returns the number of body bytes held in the window.
+  std::int64_t GetBufferedBytes() const;
+
+ private:
+  // Drops the chunks that every remaining endpoint has moved past.
+  void TrimLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Removes and returns the callbacks of every TryNext() waiting for a chunk.
+  std::vector<absl::AnyInvocable<void()>> TakeWaitersLocked()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const std::int64_t max_buffered_bytes_;
+  mutable Mutex mutex_;
+  ConditionVariable cond_{&mutex_};
+  std::deque<std::shared_ptr<const Chunk>> chunks_ ABSL_GUARDED_BY(mutex_);
+  // Index of chunks_.front() among all chunks pushed so far.
+  std::int64_t first_index_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::int64_t buffered_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  // Index of the next chunk to return, for each endpoint still in the window.
+  absl::flat_hash_map<std::string, std::int64_t> cursors_
+      ABSL_GUARDED_BY(mutex_);
+  // TryNext() callbacks waiting for the next chunk, by endpoint.
+  absl::flat_hash_map<std::string, absl::AnyInvocable<void()>> waiters_
+      ABSL_GUARDED_BY(mutex_);
+  bool aborted_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+// Sends the chunks of a PayloadFanOutWindow to each of its endpoints.
+//
+// Every endpoint gets a sender task of its own on a shared executor. The task
+// sends one chunk and reposts itself, and it holds no thread while it waits
+// for the next chunk to be pushed. Endpoints therefore only share the
+// executor's threads: one that is slow to take its chunks ties up a single
+// thread and leaves the others to keep their own pace.
+class PayloadFanOutSenders {
+ public:
+  // Sends |chunk| to |endpoint_id|. Returns false if the endpoint should not
+  // be sent any more chunks. Called concurrently for different endpoints.
+  using SendChunk = absl::AnyInvocable<bool(
+      const PayloadFanOutWindow::Chunk& chunk,
+      const std::string& endpoint_id) const>;
+
+  // Starts a sender on |executor| for each of |endpoint_ids|, which must all
+  // be in |window|.
+  PayloadFanOutSenders(PayloadFanOutWindow& window,
+                       const std::vector<std::string>& endpoint_ids,
+                       SubmittableExecutor& executor, SendChunk send_chunk);
+  ~PayloadFanOutSenders() { Wait(); }
+
+  // Blocks until every endpoint has left the window. Returns true if the last
+  // chunk was delivered to any of them.
+  bool Wait();
+
+ private:
+  void Post(std::string endpoint_id);
+  // Sends the next chunk to |endpoint_id|, or leaves the window once there is
+  // nothing more to send it.
+  void Send(std::string endpoint_id);
+
+  PayloadFanOutWindow& window_;
+  SubmittableExecutor& executor_;
+  const SendChunk send_chunk_;
+  CountDownLatch done_;
+  AtomicBoolean delivered_{false};
+};
+
+}  // namespace connections
+}  // namespace nearby
+
+#endif  // CORE_INTERNAL_PAYLOAD_FAN_OUT_WINDOW_H_
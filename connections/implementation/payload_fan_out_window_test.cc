@@ -0,0 +1,237 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "connections/implementation/payload_fan_out_window.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "internal/platform/atomic_boolean.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/multi_thread_executor.h"
+#include "internal/platform/single_thread_executor.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr char kFast[] = "fast";
+constexpr char kSlow[] = "slow";
+constexpr std::int64_t kChunkSize = 100;
+constexpr absl::Duration kWaitTimeout = absl::Seconds(1);
+constexpr absl::Duration kQuietPeriod = absl::Milliseconds(100);
+
+std::shared_ptr<const PayloadFanOutWindow::Chunk> MakeChunk(
+    std::int64_t offset, std::int64_t size = kChunkSize) {
+  return std::make_shared<const PayloadFanOutWindow::Chunk>(
+      offset, ByteArray(static_cast<size_t>(size)));
+}
+
+TEST(PayloadFanOutWindowTest, EveryEndpointGetsEveryChunkInOrder) {
+  PayloadFanOutWindow window({kFast, kSlow}, 10 * kChunkSize);
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(window.Push(MakeChunk(i * kChunkSize)));
+  }
+
+  for (const char* endpoint_id : {kFast, kSlow}) {
+    for (int i = 0; i < 3; ++i) {
+      auto chunk = window.Next(endpoint_id);
+      ASSERT_NE(chunk, nullptr);
+      EXPECT_EQ(chunk->GetOffset(), i * kChunkSize);
+    }
+  }
+}
+
+TEST(PayloadFanOutWindowTest, KeepsChunksUntilSlowestEndpointIsPast) {
+  PayloadFanOutWindow window({kFast, kSlow}, 10 * kChunkSize);
+  ASSERT_TRUE(window.Push(MakeChunk(0)));
+  ASSERT_TRUE(window.Push(MakeChunk(kChunkSize)));
+
+  window.Next(kFast);
+  window.Next(kFast);
+  EXPECT_EQ(window.GetBufferedBytes(), 2 * kChunkSize);
+
+  window.Next(kSlow);
+  EXPECT_EQ(window.GetBufferedBytes(), kChunkSize);
+
+  // An endpoint that leaves no longer holds chunks back.
+  window.Leave(kSlow);
+  EXPECT_EQ(window.GetBufferedBytes(), 0);
+}
+
+TEST(PayloadFanOutWindowTest, PushBlocksWhileSlowestEndpointIsWindowBehind) {
+  PayloadFanOutWindow window({kFast, kSlow}, 2 * kChunkSize);
+  ASSERT_TRUE(window.Push(MakeChunk(0)));
+  ASSERT_TRUE(window.Push(MakeChunk(kChunkSize)));
+  window.Next(kFast);
+  window.Next(kFast);
+
+  SingleThreadExecutor producer;
+  CountDownLatch pushed(1);
+  producer.Execute([&window, &pushed]() {
+    if (window.Push(MakeChunk(2 * kChunkSize))) pushed.CountDown();
+  });
+
+  // The fast endpoint alone does not make room.
+  EXPECT_FALSE(pushed.Await(kQuietPeriod).result());
+
+  window.Next(kSlow);
+  EXPECT_TRUE(pushed.Await(kWaitTimeout).result());
+  auto chunk = window.Next(kFast);
+  ASSERT_NE(chunk, nullptr);
+  EXPECT_EQ(chunk->GetOffset(), 2 * kChunkSize);
+}
+
+TEST(PayloadFanOutWindowTest, EmptyWindowTakesOversizedChunk) {
+  PayloadFanOutWindow window({kFast}, kChunkSize);
+
+  EXPECT_TRUE(window.Push(MakeChunk(0, 4 * kChunkSize)));
+  EXPECT_EQ(window.GetBufferedBytes(), 4 * kChunkSize);
+}
+
+TEST(PayloadFanOutWindowTest, NextBlocksUntilChunkIsPushed) {
+  PayloadFanOutWindow window({kFast}, kChunkSize);
+
+  SingleThreadExecutor consumer;
+  CountDownLatch received(1);
+  consumer.Execute([&window, &received]() {
+    if (window.Next(kFast) != nullptr) received.CountDown();
+  });
+
+  EXPECT_FALSE(received.Await(kQuietPeriod).result());
+  ASSERT_TRUE(window.Push(MakeChunk(0)));
+  EXPECT_TRUE(received.Await(kWaitTimeout).result());
+}
+
+TEST(PayloadFanOutWindowTest, TryNextCallsBackOnceChunkIsPushed) {
+  PayloadFanOutWindow window({kFast}, kChunkSize);
+  std::shared_ptr<const PayloadFanOutWindow::Chunk> chunk;
+  int calls = 0;
+
+  ASSERT_TRUE(window.TryNext(kFast, &chunk, [&calls]() { ++calls; }));
+  EXPECT_EQ(chunk, nullptr);
+  EXPECT_EQ(calls, 0);
+
+  ASSERT_TRUE(window.Push(MakeChunk(0)));
+  EXPECT_EQ(calls, 1);
+  ASSERT_TRUE(window.TryNext(kFast, &chunk, [&calls]() { ++calls; }));
+  ASSERT_NE(chunk, nullptr);
+  EXPECT_EQ(chunk->GetOffset(), 0);
+
+  window.Leave(kFast);
+  EXPECT_FALSE(window.TryNext(kFast, &chunk, [&calls]() { ++calls; }));
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(PayloadFanOutWindowTest, PushFailsOnceAllEndpointsLeft) {
+  PayloadFanOutWindow window({kFast, kSlow}, kChunkSize);
+  ASSERT_TRUE(window.Push(MakeChunk(0)));
+
+  SingleThreadExecutor producer;
+  AtomicBoolean push_result{true};
+  CountDownLatch push_done(1);
+  producer.Execute([&]() {
+    push_result.Set(window.Push(MakeChunk(kChunkSize)));
+    push_done.CountDown();
+  });
+
+  window.Leave(kFast);
+  window.Leave(kSlow);
+
+  EXPECT_TRUE(push_done.Await(kWaitTimeout).result());
+  EXPECT_FALSE(push_result.Get());
+}
+
+TEST(PayloadFanOutWindowTest, AbortWakesEndpointsAndReturnsThem) {
+  PayloadFanOutWindow window({kFast, kSlow}, kChunkSize);
+  window.Leave(kSlow);
+
+  SingleThreadExecutor consumer;
+  CountDownLatch woken(1);
+  consumer.Execute([&window, &woken]() {
+    if (window.Next(kFast) == nullptr) woken.CountDown();
+  });
+
+  std::vector<std::string> remaining = window.Abort();
+  EXPECT_TRUE(woken.Await(kWaitTimeout).result());
+  EXPECT_EQ(remaining, std::vector<std::string>{kFast});
+  EXPECT_FALSE(window.Push(MakeChunk(0)));
+}
+
+TEST(PayloadFanOutWindowTest, FrameIsBuiltOncePerPiece) {
+  PayloadFanOutWindow::Chunk chunk(0, ByteArray(std::string("abcdef")));
+  int builds = 0;
+  auto build = [&builds]() {
+    ++builds;
+    return ByteArray(std::string("frame"));
+  };
+
+  auto first = chunk.GetFrame(0, 3, build);
+  auto second = chunk.GetFrame(0, 3, build);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(builds, 1);
+
+  chunk.GetFrame(0, 6, build);
+  EXPECT_EQ(builds, 2);
+}
+
+TEST(PayloadFanOutSendersTest, StalledEndpointDoesNotHoldBackOthers) {
+  constexpr int kEndpointCount = 6;
+  constexpr int kChunkCount = 8;
+  std::vector<std::string> endpoint_ids;
+  for (int i = 0; i < kEndpointCount; ++i) {
+    endpoint_ids.push_back(absl::StrCat("endpoint-", i));
+  }
+  const std::string stalled = endpoint_ids[0];
+  // Room for the whole payload, so the stalled endpoint does not hold back
+  // the producer either.
+  PayloadFanOutWindow window(endpoint_ids, kChunkCount * kChunkSize);
+  MultiThreadExecutor executor(4);
+  CountDownLatch release(1);
+  CountDownLatch others_done(kEndpointCount - 1);
+
+  PayloadFanOutSenders senders(
+      window, endpoint_ids, executor,
+      [&](const PayloadFanOutWindow::Chunk& chunk,
+          const std::string& endpoint_id) {
+        if (endpoint_id == stalled) {
+          release.Await();
+        } else if (chunk.IsLast()) {
+          others_done.CountDown();
+        }
+        return true;
+      });
+  for (int i = 0; i < kChunkCount; ++i) {
+    EXPECT_TRUE(window.Push(MakeChunk(i * kChunkSize)));
+  }
+  EXPECT_TRUE(window.Push(MakeChunk(kChunkCount * kChunkSize, 0)));
+
+  // Every other endpoint gets the whole payload while one is stuck on its
+  // first chunk.
+  EXPECT_TRUE(others_done.Await(kWaitTimeout).result());
+  release.CountDown();
+  EXPECT_TRUE(senders.Wait());
+  EXPECT_EQ(window.GetBufferedBytes(), 0);
+}
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
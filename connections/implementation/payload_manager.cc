@@ -26,18 +26,22 @@
 #include "absl/functional/bind_front.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "connections/implementation/analytics/throughput_recorder.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_channel_manager.h"
 #include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/internal_payload_factory.h"
+#include "connections/implementation/offline_frames.h"
+#include "connections/implementation/payload_fan_out_window.h"
 #include "connections/payload_type.h"
 #include "internal/flags/nearby_flags.h"
 #include "internal/platform/count_down_latch.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/feature_flags.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/mutex_lock.h"
 #include "internal/platform/single_thread_executor.h"
 #include "proto/connections_enums.pb.h"
@@ -52,6 +56,12 @@ using ::nearby::analytics::PacketMetaData;
 using ::nearby::analytics::ThroughputRecorderContainer;
 using ::nearby::connections::PayloadDirection;
 
+namespace {
+// Payload bytes read ahead for the slowest endpoint of a fanned out payload;
+// the fastest endpoint runs at most this far ahead of it.
+constexpr std::int64_t kFanOutWindowBytes = 16 * 1024 * 1024;
+}  // namespace
+
 // C++14 requires to declare this.
 // TODO(apolyudov): remove when migration to c++17 is possible.
 constexpr absl::Duration PayloadManager::kWaitCloseTimeout;
@@ -204,6 +214,179 @@ bool PayloadManager::SendPayloadLoop(
   return true;
 }
 
+void PayloadManager::SendPayloadFanOut(
+    ClientProxy* client, PendingPayload& pending_payload,
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    size_t resume_offset) {
+  InternalPayload* internal_payload = pending_payload.GetInternalPayload();
+  auto pair = GetAvailableAndUnavailableEndpoints(pending_payload);
+  const EndpointIds endpoint_ids = EndpointsToEndpointIds(pair.first);
+  std::int64_t next_chunk_offset = 0;
+
+  for (const auto& endpoint : pair.second) {
+    HandleFinishedOutgoingPayload(
+        client, {endpoint->id}, payload_header, next_chunk_offset,
+        EndpointInfoStatusToPayloadStatus(endpoint->status.Get()));
+  }
+  if (endpoint_ids.empty()) return;
+  if (pending_payload.IsLocallyCanceled()) {
+    HandleFinishedOutgoingPayload(client, endpoint_ids, payload_header,
+                                  next_chunk_offset,
+                                  location::nearby::proto::connections::
+                                      PayloadStatus::LOCAL_CANCELLATION);
+    return;
+  }
+  if (resume_offset > 0) {
+    ExceptionOr<size_t> real_offset =
+        internal_payload->SkipToOffset(resume_offset);
+    if (!real_offset.ok()) {
+      NEARBY_LOGS(WARNING) << "PayloadManager failed to skip offset "
+                           << resume_offset << " on payload_id "
+                           << internal_payload->GetId();
+      HandleFinishedOutgoingPayload(
+          client, endpoint_ids, payload_header, next_chunk_offset,
+          location::nearby::proto::connections::PayloadStatus::LOCAL_ERROR);
+      return;
+    }
+    next_chunk_offset = real_offset.GetResult();
+  }
+
+  NEARBY_LOGS(INFO) << "PayloadManager fanning out payload_id="
+                    << internal_payload->GetId() << " to endpoint_ids={"
+                    << ToString(endpoint_ids) << "}";
+  PayloadFanOutWindow window(endpoint_ids, kFanOutWindowBytes);
+  PayloadFanOutSenders senders(
+      window, endpoint_ids, fan_out_executor_,
+      [&](const PayloadFanOutWindow::Chunk& chunk,
+          const std::string& endpoint_id) {
+        return !shutdown_.Get() &&
+               SendPayloadFanOutChunk(client, pending_payload, payload_header,
+                                      chunk, endpoint_id, resume_offset);
+      });
+
+  // Read each chunk once, at the largest size any endpoint wants; senders
+  // split it further for endpoints that prefer smaller chunks.
+  while (!shutdown_.Get()) {
+    int chunk_size = 0;
+    for (const auto& endpoint_id : endpoint_ids) {
+      chunk_size = std::max(
+          chunk_size, endpoint_manager_->GetPreferredChunkSize(endpoint_id));
+    }
+    if (chunk_size <= 0) {
+      // None of the endpoints has a channel left.
+      HandleFinishedOutgoingPayload(
+          client, window.Abort(), payload_header, next_chunk_offset,
+          location::nearby::proto::connections::PayloadStatus::
+              ENDPOINT_IO_ERROR);
+      break;
+    }
+
+    // This will block if there is no data to transfer.
+    // It will resume when new data arrives, or if Close() is called.
+    ByteArray next_chunk = internal_payload->DetachNextChunk(chunk_size);
+    if (shutdown_.Get()) break;
+    auto next_chunk_size = next_chunk.size();
+    if (!next_chunk_size && internal_payload->GetTotalSize() > 0 &&
+        internal_payload->GetTotalSize() < next_chunk_offset) {
+      NEARBY_LOGS(INFO) << "Payload xfer failed: payload_id="
+                        << internal_payload->GetId();
+      HandleFinishedOutgoingPayload(
+          client, window.Abort(), payload_header, next_chunk_offset,
+          location::nearby::proto::connections::PayloadStatus::LOCAL_ERROR);
+      break;
+    }
+
+    // Fails once every endpoint is done with the payload, successfully or
+    // not.
+    if (!window.Push(std::make_shared<const PayloadFanOutWindow::Chunk>(
+            next_chunk_offset, std::move(next_chunk)))) {
+      break;
+    }
+    next_chunk_offset += next_chunk_size;
+    if (!next_chunk_size) break;
+  }
+  if (shutdown_.Get()) window.Abort();
+
+  if (senders.Wait()) {
+    NEARBY_LOGS(INFO) << "Payload xfer done: payload_id="
+                      << internal_payload->GetId()
+                      << "; size=" << next_chunk_offset;
+    ThroughputRecorderContainer::GetInstance()
+        .GetTPRecorder(internal_payload->GetId(),
+                       PayloadDirection::OUTGOING_PAYLOAD)
+        ->MarkAsSuccess();
+  }
+}
+
+bool PayloadManager::SendPayloadFanOutChunk(
+    ClientProxy* client, PendingPayload& pending_payload,
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    const PayloadFanOutWindow::Chunk& chunk, const std::string& endpoint_id,
+    size_t resume_offset) {
+  const ByteArray& body = chunk.GetBody();
+  size_t begin = 0;
+  do {
+    std::int64_t offset = chunk.GetOffset() + begin;
+    EndpointInfo* endpoint = pending_payload.GetEndpoint(endpoint_id);
+    if (endpoint == nullptr) return false;
+    if (pending_payload.IsLocallyCanceled()) {
+      HandleFinishedOutgoingPayload(client, {endpoint_id}, payload_header,
+                                    offset,
+                                    location::nearby::proto::connections::
+                                        PayloadStatus::LOCAL_CANCELLATION);
+      return false;
+    }
+    if (!endpoint->IsEndpointAvailable(client, endpoint->status.Get())) {
+      HandleFinishedOutgoingPayload(
+          client, {endpoint_id}, payload_header, offset,
+          EndpointInfoStatusToPayloadStatus(endpoint->status.Get()));
+      return false;
+    }
+    pending_payload.SetOffsetForEndpoint(endpoint_id, offset);
+
+    int preferred_size = endpoint_manager_->GetPreferredChunkSize(endpoint_id);
+    size_t size = std::min(body.size() - begin,
+                           static_cast<size_t>(std::max(preferred_size, 0)));
+    PacketMetaData packet_meta_data;
+    // An empty piece of a non-empty chunk would read as the last chunk, so an
+    // endpoint without a channel fails here rather than at the write.
+    bool sent = (size > 0 || chunk.IsLast());
+    if (sent) {
+      std::shared_ptr<const ByteArray> frame =
+          chunk.GetFrame(begin, size, [&]() {
+            return parser::ForDataPayloadTransfer(
+                payload_header,
+                CreatePayloadChunk(offset - resume_offset,
+                                   ByteArray(body.data() + begin, size)));
+          });
+      sent = endpoint_manager_->SendPayloadFrame(
+          endpoint_id, *frame, payload_header.id(), offset - resume_offset,
+          packet_meta_data);
+    }
+    if (!sent) {
+      NEARBY_LOGS(INFO) << "Payload xfer: endpoint failed: payload_id="
+                        << payload_header.id()
+                        << "; endpoint_id=" << endpoint_id;
+      HandleFinishedOutgoingPayload(client, {endpoint_id}, payload_header,
+                                    offset,
+                                    location::nearby::proto::connections::
+                                        PayloadStatus::ENDPOINT_IO_ERROR);
+      return false;
+    }
+
+    if (!WaitForReceivedAck(client, endpoint_id, pending_payload,
+                            payload_header, offset, chunk.IsLast())) {
+      return false;
+    }
+    HandleSuccessfulOutgoingChunk(
+        client, endpoint_id, payload_header,
+        chunk.IsLast() ? PayloadTransferFrame::PayloadChunk::LAST_CHUNK : 0,
+        offset - resume_offset, size);
+    begin += size;
+  } while (begin < body.size());
+  return true;
+}
+
 std::pair<PayloadManager::Endpoints, PayloadManager::Endpoints>
 PayloadManager::GetAvailableAndUnavailableEndpoints(
     const PendingPayload& pending_payload) {
@@ -349,6 +532,7 @@ PayloadManager::~PayloadManager() {
   bytes_payload_executor_.Shutdown();
   stream_payload_executor_.Shutdown();
   file_payload_executor_.Shutdown();
+  fan_out_executor_.Shutdown();
 
   CountDownLatch stop_latch(1);
   // Clear our tracked pending payloads.
@@ -463,6 +647,14 @@ void PayloadManager::SendPayload(ClientProxy* client,
         ThroughputRecorderContainer::GetInstance()
             .GetTPRecorder(payload_id, PayloadDirection::OUTGOING_PAYLOAD)
             ->Start(payload_type, PayloadDirection::OUTGOING_PAYLOAD);
+        if (endpoint_ids.size() > 1 &&
+            NearbyFlags::GetInstance().GetBoolFlag(
+                config_package_nearby::nearby_connections_feature::
+                    kEnablePayloadFanOut)) {
+          SendPayloadFanOut(client, *pending_payload, payload_header,
+                            resume_offset);
+          should_continue = false;
+        }
         while (should_continue && !shutdown_.Get()) {
           should_continue =
               SendPayloadLoop(client, *pending_payload, payload_header,
@@ -521,10 +713,21 @@ void PayloadManager::OnIncomingFrame(
                         << this << "; endpoint_id=" << from_endpoint_id;
       ProcessControlPacket(to_client, from_endpoint_id, frame);
       break;
-    case PayloadTransferFrame::DATA:
-      ProcessDataPacket(to_client, from_endpoint_id, frame, current_medium,
-                        packet_meta_data);
+    case PayloadTransferFrame::DATA: {
+      const PayloadTransferFrame::PayloadChunk& payload_chunk =
+          frame.payload_chunk();
+      parser::PayloadDataFrame data_frame;
+      data_frame.header = std::move(*frame.mutable_payload_header());
+      data_frame.chunk.set_flags(payload_chunk.flags());
+      data_frame.chunk.set_offset(payload_chunk.offset());
+      if (payload_chunk.has_index()) {
+        data_frame.chunk.set_index(payload_chunk.index());
+      }
+      data_frame.body = payload_chunk.body();
+      ProcessDataPacket(to_client, from_endpoint_id, data_frame,
+                        current_medium, packet_meta_data);
       break;
+    }
     default:
       NEARBY_LOGS(WARNING)
           << "PayloadManager: invalid frame; remote endpoint: self=" << this
@@ -533,6 +736,16 @@ void PayloadManager::OnIncomingFrame(
   }
 }
 
+// @EndpointManagerDataPool
+void PayloadManager::OnIncomingPayloadData(
+    parser::PayloadDataFrame& data_frame, const std::string& from_endpoint_id,
+    ClientProxy* to_client,
+    location::nearby::proto::connections::Medium current_medium,
+    PacketMetaData& packet_meta_data) {
+  ProcessDataPacket(to_client, from_endpoint_id, data_frame, current_medium,
+                    packet_meta_data);
+}
+
 void PayloadManager::OnEndpointDisconnect(ClientProxy* client,
                                           const std::string& service_id,
                                           const std::string& endpoint_id,
@@ -666,7 +879,7 @@ int PayloadManager::GetOptimalChunkSize(EndpointIds endpoint_ids) {
   int minChunkSize = std::numeric_limits<int>::max();
   for (const auto& endpoint_id : endpoint_ids) {
     minChunkSize = std::min(
-        minChunkSize, endpoint_manager_->GetMaxTransmitPacketSize(endpoint_id));
+        minChunkSize, endpoint_manager_->GetPreferredChunkSize(endpoint_id));
   }
   return minChunkSize;
 }
@@ -710,9 +923,10 @@ PayloadTransferFrame::PayloadChunk PayloadManager::CreatePayloadChunk(
 }
 
 PayloadManager::PendingPayloadHandle PayloadManager::CreateIncomingPayload(
-    const PayloadTransferFrame& frame, const std::string& endpoint_id) {
-  auto internal_payload =
-      CreateIncomingInternalPayload(frame, custom_save_path_);
+    const PayloadTransferFrame::PayloadHeader& payload_header,
+    absl::string_view first_chunk_body, const std::string& endpoint_id) {
+  auto internal_payload = CreateIncomingInternalPayload(
+      payload_header, first_chunk_body, custom_save_path_);
   if (!internal_payload) {
     return PendingPayloadHandle();
   }
@@ -1153,12 +1367,10 @@ void PayloadManager::HandleSuccessfulIncomingChunk(
 // @EndpointManagerDataPool
 void PayloadManager::ProcessDataPacket(
     ClientProxy* to_client, const std::string& from_endpoint_id,
-    PayloadTransferFrame& payload_transfer_frame, Medium medium,
+    parser::PayloadDataFrame& data_frame, Medium medium,
     PacketMetaData& packet_meta_data) {
-  PayloadTransferFrame::PayloadHeader& payload_header =
-      *payload_transfer_frame.mutable_payload_header();
-  PayloadTransferFrame::PayloadChunk& payload_chunk =
-      *payload_transfer_frame.mutable_payload_chunk();
+  const PayloadTransferFrame::PayloadHeader& payload_header = data_frame.header;
+  const PayloadTransferFrame::PayloadChunk& payload_chunk = data_frame.chunk;
   NEARBY_LOGS(VERBOSE) << "PayloadManager got data OfflineFrame for payload_id="
                        << payload_header.id()
                        << " from endpoint_id=" << from_endpoint_id
@@ -1182,8 +1394,8 @@ void PayloadManager::ProcessDataPacket(
               payload_header.total_size());
         });
 
-    pending_payload =
-        CreateIncomingPayload(payload_transfer_frame, from_endpoint_id);
+    pending_payload = CreateIncomingPayload(payload_header, data_frame.body,
+                                            from_endpoint_id);
     if (!pending_payload) {
       NEARBY_LOGS(WARNING)
           << "PayloadManager failed to create InternalPayload from "
@@ -1242,12 +1454,12 @@ void PayloadManager::ProcessDataPacket(
   pending_payload->SetOffsetForEndpoint(from_endpoint_id,
                                         payload_chunk.offset());
 
-  // Save size of packet before we move it.
-  std::int64_t payload_body_size = payload_chunk.body().size();
+  std::int64_t payload_body_size = data_frame.body.size();
 
   packet_meta_data.StartFileIo();
   if (pending_payload->GetInternalPayload()
-          ->AttachNextChunk(ByteArray(std::move(*payload_chunk.mutable_body())))
+          ->AttachNextChunk(ByteArray(data_frame.body.data(),
+                                      data_frame.body.size()))
           .Raised()) {
     NEARBY_LOGS(ERROR) << "ProcessDataPacket: [data: error] endpoint_id="
                        << from_endpoint_id
@@ -25,10 +25,13 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/strings/string_view.h"
 #include "connections/implementation/analytics/packet_meta_data.h"
 #include "connections/implementation/client_proxy.h"
 #include "connections/implementation/endpoint_manager.h"
 #include "connections/implementation/internal_payload.h"
+#include "connections/implementation/offline_frames.h"
+#include "connections/implementation/payload_fan_out_window.h"
 #include "connections/listeners.h"
 #include "connections/payload.h"
 #include "connections/status.h"
@@ -37,6 +40,7 @@
 #include "internal/platform/byte_array.h"
 #include "internal/platform/condition_variable.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/multi_thread_executor.h"
 #include "internal/platform/mutex.h"
 
 namespace nearby {
@@ -68,6 +72,13 @@ class PayloadManager : public EndpointManager::FrameProcessor {
       location::nearby::proto::connections::Medium current_medium,
       analytics::PacketMetaData& packet_meta_data) override;
 
+  // @EndpointManagerReaderThread
+  void OnIncomingPayloadData(
+      parser::PayloadDataFrame& data_frame,
+      const std::string& from_endpoint_id, ClientProxy* to_client,
+      location::nearby::proto::connections::Medium current_medium,
+      analytics::PacketMetaData& packet_meta_data) override;
+
   // @EndpointManagerThread
   void OnEndpointDisconnect(ClientProxy* client, const std::string& service_id,
                             const std::string& endpoint_id,
@@ -271,6 +282,22 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   bool SendPayloadLoop(ClientProxy* client, PendingPayload& pending_payload,
                        PayloadTransferFrame::PayloadHeader& payload_header,
                        std::int64_t& next_chunk_offset, size_t resume_offset);
+  // Sends the payload to all of its endpoints, reading it once and feeding
+  // every endpoint from a PayloadFanOutWindow at its own chunk size. Each
+  // endpoint is sent to by PayloadFanOutSenders on |fan_out_executor_|, so it
+  // keeps its own pace. Blocks until every endpoint is done with the payload.
+  void SendPayloadFanOut(
+      ClientProxy* client, PendingPayload& pending_payload,
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      size_t resume_offset);
+  // Sends one chunk of the window to |endpoint_id|, split into pieces of the
+  // endpoint's preferred chunk size. Returns false, after handling the
+  // endpoint's end of transfer, if it should not be sent any more.
+  bool SendPayloadFanOutChunk(
+      ClientProxy* client, PendingPayload& pending_payload,
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      const PayloadFanOutWindow::Chunk& chunk, const std::string& endpoint_id,
+      size_t resume_offset);
   void SendClientCallbacksForFinishedIncomingPayloadRunnable(
       ClientProxy* client, const std::string& endpoint_id,
       const PayloadTransferFrame::PayloadHeader& payload_header,
@@ -304,8 +331,9 @@ class PayloadManager : public EndpointManager::FrameProcessor {
              PayloadTransferFrame::PayloadChunk::LAST_CHUNK) != 0);
   }
 
-  PendingPayloadHandle CreateIncomingPayload(const PayloadTransferFrame& frame,
-                                             const std::string& endpoint_id)
+  PendingPayloadHandle CreateIncomingPayload(
+      const PayloadTransferFrame::PayloadHeader& payload_header,
+      absl::string_view first_chunk_body, const std::string& endpoint_id)
       ABSL_LOCKS_EXCLUDED(mutex_);
 
   Payload::Id CreateOutgoingPayload(Payload payload,
@@ -371,8 +399,7 @@ class PayloadManager : public EndpointManager::FrameProcessor {
 
   void ProcessDataPacket(ClientProxy* to_client,
                          const std::string& from_endpoint_id,
-                         PayloadTransferFrame& payload_transfer_frame,
-                         Medium medium,
+                         parser::PayloadDataFrame& data_frame, Medium medium,
                          analytics::PacketMetaData& packet_meta_data);
   void ProcessControlPacket(ClientProxy* to_client,
                             const std::string& from_endpoint_id,
@@ -420,6 +447,11 @@ class PayloadManager : public EndpointManager::FrameProcessor {
   SingleThreadExecutor file_payload_executor_;
   SingleThreadExecutor stream_payload_executor_;
   SingleThreadExecutor payload_status_update_executor_;
+  // Sends the chunks of fanned out payloads, one chunk per task. A sender only
+  // holds a thread while it writes, so the threads are shared by every
+  // endpoint of every payload.
+  static constexpr int kFanOutThreadCount = 12;
+  MultiThreadExecutor fan_out_executor_{kFanOutThreadCount};
   PendingPayloads pending_payloads_;
   EndpointManager* endpoint_manager_;
 
@@ -15,19 +15,25 @@
 #include "connections/implementation/payload_manager.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <utility>
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
 #include "connections/implementation/simulation_user.h"
 #include "connections/listeners.h"
 #include "connections/medium_selector.h"
 #include "connections/payload.h"
 #include "connections/status.h"
+#include "internal/flags/nearby_flags.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/count_down_latch.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/medium_environment.h"
 #include "internal/platform/pipe.h"
@@ -40,6 +46,7 @@ constexpr size_t kChunkSize = 64 * 1024;
 constexpr absl::string_view kServiceId = "service-id";
 constexpr absl::string_view kDeviceA = "device-a";
 constexpr absl::string_view kDeviceB = "device-b";
+constexpr absl::string_view kDeviceC = "device-c";
 constexpr absl::string_view kMessage = "message";
 constexpr absl::Duration kProgressTimeout = absl::Milliseconds(1000);
 constexpr absl::Duration kDefaultTimeout = absl::Milliseconds(1000);
@@ -86,10 +93,16 @@ class PayloadSimulationUser : public SimulationUser {
 
   Payload& GetPayload() { return payload_; }
   void SendPayload(Payload payload) {
+    SendPayload(std::move(payload), {discovered_.endpoint_id});
+  }
+  void SendPayload(Payload payload,
+                   const PayloadManager::EndpointIds& endpoint_ids) {
     sender_payload_id_ = payload.GetId();
-    pm_.SendPayload(&client_, {discovered_.endpoint_id}, std::move(payload));
+    pm_.SendPayload(&client_, endpoint_ids, std::move(payload));
   }
 
+  void StopAdvertising() { mgr_.StopAdvertising(&client_); }
+
   Status CancelPayload() {
     if (sender_payload_id_) {
       return pm_.CancelPayload(&client_, sender_payload_id_);
@@ -369,6 +382,76 @@ TEST_P(PayloadManagerTest, SendPayloadWithSkip_StreamPayload) {
   env_.Stop();
 }
 
+TEST_P(PayloadManagerTest, FansOutStreamPayloadToEveryEndpoint) {
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::kEnablePayloadFanOut,
+      true);
+  env_.Start();
+  PayloadSimulationUser user_a(kDeviceA, GetParam());
+  PayloadSimulationUser user_b(kDeviceB, GetParam());
+  PayloadSimulationUser user_c(kDeviceC, GetParam());
+  ASSERT_TRUE(SetupConnection(user_a, user_b));
+  std::string endpoint_a = user_b.GetDiscovered().endpoint_id;
+  // user_b connects to one advertiser at a time, so that it discovers only
+  // user_c the second time around.
+  user_a.StopAdvertising();
+  user_b.StopDiscovery();
+  CountDownLatch discovery_latch(1);
+  CountDownLatch connection_latch(2);
+  CountDownLatch accept_latch(2);
+  user_c.StartAdvertising(std::string(kServiceId), &connection_latch);
+  user_b.StartDiscovery(std::string(kServiceId), &discovery_latch);
+  ASSERT_TRUE(discovery_latch.Await(kDefaultTimeout).result());
+  EXPECT_EQ(user_b.GetDiscovered().endpoint_info, user_c.GetInfo());
+  user_b.RequestConnection(&connection_latch);
+  ASSERT_TRUE(connection_latch.Await(kDefaultTimeout).result());
+  user_c.AcceptConnection(&accept_latch);
+  user_b.AcceptConnection(&accept_latch);
+  ASSERT_TRUE(accept_latch.Await(kDefaultTimeout).result());
+  std::string endpoint_c = user_b.GetDiscovered().endpoint_id;
+  ASSERT_NE(endpoint_a, endpoint_c);
+
+  auto [input, tx] = CreatePipe();
+  CountDownLatch payload_latch(2);
+  user_a.ExpectPayload(payload_latch);
+  user_c.ExpectPayload(payload_latch);
+  const ByteArray message{std::string(kMessage)};
+  tx->Write(message);
+  user_b.SendPayload(Payload(std::move(input)), {endpoint_a, endpoint_c});
+  ASSERT_TRUE(payload_latch.Await(kDefaultTimeout).result());
+
+  // Every chunk reaches both endpoints, and so does the end of the stream.
+  constexpr int kChunkCount = 3;
+  constexpr std::int64_t kStreamSize = kChunkCount * kMessage.size();
+  for (int i = 1; i < kChunkCount; ++i) {
+    tx->Write(message);
+  }
+  tx->Close();
+  for (PayloadSimulationUser* user : {&user_a, &user_c}) {
+    EXPECT_TRUE(user->WaitForProgress(
+        [](const PayloadProgressInfo& info) {
+          return info.status == PayloadProgressInfo::Status::kSuccess &&
+                 info.bytes_transferred == kStreamSize;
+        },
+        kProgressTimeout));
+    ASSERT_NE(user->GetPayload().AsStream(), nullptr);
+    InputStream& rx = *user->GetPayload().AsStream();
+    ExceptionOr<ByteArray> result = rx.ReadExactly(kStreamSize);
+    ASSERT_TRUE(result.ok());
+    EXPECT_EQ(std::string(result.result()),
+              absl::StrCat(kMessage, kMessage, kMessage));
+    rx.Close();
+  }
+
+  user_a.Stop();
+  user_b.Stop();
+  user_c.Stop();
+  env_.Stop();
+  NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      config_package_nearby::nearby_connections_feature::kEnablePayloadFanOut,
+      false);
+}
+
 INSTANTIATE_TEST_SUITE_P(ParametrisedPayloadManagerTest, PayloadManagerTest,
                          ::testing::ValuesIn(kTestCases));
 
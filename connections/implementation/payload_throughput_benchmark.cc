@@ -0,0 +1,323 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// End-to-end payload throughput between two OfflineSimulationUsers over the
+// simulated mediums. Each benchmark connects a pair of users once and then
+// sends one payload per iteration, reporting:
+//   bytes_per_second       payload bytes delivered to the receiver.
+//   time_to_first_byte_ms  from SendPayload() to the receiver's first
+//                          progress update.
+//   cpu_seconds_per_gb     process CPU time, over all threads, per GB sent.
+//
+// Run with --benchmark_format=json (or --benchmark_out=<file>) to get results
+// in machine-readable form.
+
+#include <time.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "connections/implementation/flags/nearby_connections_feature_flags.h"
+#include "connections/implementation/offline_simulation_user.h"
+#include "connections/listeners.h"
+#include "connections/medium_selector.h"
+#include "connections/payload.h"
+#include "internal/flags/nearby_flags.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/count_down_latch.h"
+#include "internal/platform/file.h"
+#include "internal/platform/input_stream.h"
+#include "internal/platform/medium_environment.h"
+#include "internal/platform/output_stream.h"
+#include "internal/platform/pipe.h"
+
+namespace nearby {
+namespace connections {
+namespace {
+
+constexpr absl::string_view kServiceId = "benchmark-service-id";
+constexpr absl::Duration kTimeout = absl::Seconds(30);
+constexpr size_t kChunkSize = 64 * 1024;
+
+enum Link : int64_t {
+  kBluetooth,
+  kBle,
+  kWifiLan,
+  // Connects over Bluetooth and sends after upgrading to WifiLan.
+  kBluetoothUpgradedToWifiLan,
+};
+
+enum Kind : int64_t {
+  kBytes,
+  kStream,
+  kFile,
+};
+
+absl::string_view LinkName(Link link) {
+  switch (link) {
+    case kBluetooth:
+      return "Bluetooth";
+    case kBle:
+      return "BLE";
+    case kWifiLan:
+      return "WifiLan";
+    case kBluetoothUpgradedToWifiLan:
+      return "BluetoothToWifiLan";
+  }
+  return "";
+}
+
+absl::string_view KindName(Kind kind) {
+  switch (kind) {
+    case kBytes:
+      return "BYTES";
+    case kStream:
+      return "STREAM";
+    case kFile:
+      return "FILE";
+  }
+  return "";
+}
+
+BooleanMediumSelector GetAllowedMediums(Link link) {
+  switch (link) {
+    case kBluetooth:
+      return {.bluetooth = true};
+    case kBle:
+      return {.ble = true};
+    case kWifiLan:
+      return {.wifi_lan = true};
+    case kBluetoothUpgradedToWifiLan:
+      return {.bluetooth = true, .wifi_lan = true};
+  }
+  return {};
+}
+
+double ProcessCpuSeconds() {
+  timespec time;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+class BenchmarkUser : public OfflineSimulationUser {
+ public:
+  BenchmarkUser(absl::string_view device_name, Link link)
+      : OfflineSimulationUser(device_name, GetAllowedMediums(link)) {
+    if (link == kBluetoothUpgradedToWifiLan) {
+      // Only Bluetooth can find the advertiser, so the connection starts
+      // there; WifiLan stays allowed as an upgrade medium.
+      discovery_options_.allowed = BooleanMediumSelector{.bluetooth = true};
+    }
+  }
+};
+
+// Two users connected over one link for the lifetime of a benchmark run.
+class ConnectedPair {
+ public:
+  explicit ConnectedPair(Link link) : link_(link) {
+    NearbyFlags::GetInstance().OverrideBoolFlagValue(
+        config_package_nearby::nearby_connections_feature::kEnableBleV2, true);
+    NearbyFlags::GetInstance().OverrideBoolFlagValue(
+        config_package_nearby::nearby_connections_feature::
+            kEnableSafeToDisconnect,
+        false);
+    env_.Start();
+    sender_ = std::make_unique<BenchmarkUser>("device-a", link);
+    receiver_ = std::make_unique<BenchmarkUser>("device-b", link);
+  }
+
+  ~ConnectedPair() {
+    sender_->Stop();
+    receiver_->Stop();
+    sender_.reset();
+    receiver_.reset();
+    env_.Stop();
+  }
+
+  // The receiver advertises and the sender discovers and connects, so the
+  // receiver is the side that initiates the bandwidth upgrade.
+  bool Connect() {
+    CountDownLatch discover_latch(1);
+    CountDownLatch connect_latch(2);
+    CountDownLatch accept_latch(2);
+    CountDownLatch upgrade_latch(1);
+    receiver_->ExpectBandwidthUpgrade(upgrade_latch);
+    receiver_->StartAdvertising(std::string(kServiceId), &connect_latch);
+    sender_->StartDiscovery(std::string(kServiceId), &discover_latch);
+    if (!discover_latch.Await(kTimeout).result()) return false;
+    sender_->RequestConnection(&connect_latch);
+    if (!connect_latch.Await(kTimeout).result()) return false;
+    sender_->AcceptConnection(&accept_latch);
+    receiver_->AcceptConnection(&accept_latch);
+    if (!accept_latch.Await(kTimeout).result()) return false;
+    if (link_ == kBluetoothUpgradedToWifiLan &&
+        !upgrade_latch.Await(kTimeout).result()) {
+      return false;
+    }
+    return sender_->IsConnected() && receiver_->IsConnected();
+  }
+
+  OfflineSimulationUser& sender() { return *sender_; }
+  OfflineSimulationUser& receiver() { return *receiver_; }
+
+ private:
+  const Link link_;
+  MediumEnvironment& env_ = MediumEnvironment::Instance();
+  std::unique_ptr<BenchmarkUser> sender_;
+  std::unique_ptr<BenchmarkUser> receiver_;
+};
+
+// Reads a STREAM payload on the receiving side until `size` bytes arrived.
+bool DrainStream(OfflineSimulationUser& receiver, size_t size) {
+  InputStream* stream = receiver.GetPayload().AsStream();
+  if (stream == nullptr) return false;
+  size_t received = 0;
+  while (received < size) {
+    ExceptionOr<ByteArray> chunk = stream->Read(kChunkSize);
+    if (!chunk.ok() || chunk.result().Empty()) return false;
+    received += chunk.result().size();
+  }
+  return true;
+}
+
+// Sends `data` as one payload of `kind` and waits for the receiver to complete
+// it. Returns the time to the first received byte, or an infinite duration if
+// the transfer failed.
+absl::Duration TransferPayload(ConnectedPair& pair, Kind kind,
+                               const ByteArray& data,
+                               const std::string& file_path) {
+  const size_t size = data.size();
+  CountDownLatch payload_latch(1);
+  pair.receiver().ExpectPayload(payload_latch);
+
+  std::thread writer;
+  Payload payload;
+  switch (kind) {
+    case kBytes:
+      payload = Payload(data);
+      break;
+    case kStream: {
+      auto [input, output] = CreatePipe();
+      payload = Payload(std::move(input));
+      writer = std::thread([output = std::move(output), &data]() {
+        for (size_t offset = 0; offset < data.size(); offset += kChunkSize) {
+          size_t length = std::min(kChunkSize, data.size() - offset);
+          if (!output->Write(ByteArray(data.data() + offset, length)).Ok()) {
+            break;
+          }
+        }
+        output->Close();
+      });
+      break;
+    }
+    case kFile:
+      payload = Payload(InputFile(file_path, size));
+      break;
+  }
+  const Payload::Id id = payload.GetId();
+
+  absl::Time start = absl::Now();
+  pair.sender().SendPayload(std::move(payload));
+  bool ok = pair.receiver().WaitForProgress(
+      [id](const PayloadProgressInfo& info) {
+        return info.payload_id == id && info.bytes_transferred > 0;
+      },
+      kTimeout);
+  absl::Duration first_byte = absl::Now() - start;
+  if (ok && kind == kStream) {
+    ok = payload_latch.Await(kTimeout).result() &&
+         DrainStream(pair.receiver(), size);
+  }
+  ok = ok && pair.receiver().WaitForProgress(
+                 [id](const PayloadProgressInfo& info) {
+                   return info.payload_id == id &&
+                          info.status == PayloadProgressInfo::Status::kSuccess;
+                 },
+                 kTimeout);
+  if (writer.joinable()) writer.join();
+  return ok ? first_byte : absl::InfiniteDuration();
+}
+
+// Arguments: Link, Kind, payload size in bytes.
+void BM_PayloadThroughput(benchmark::State& state) {
+  const Link link = static_cast<Link>(state.range(0));
+  const Kind kind = static_cast<Kind>(state.range(1));
+  const size_t size = state.range(2);
+  state.SetLabel(absl::StrCat(LinkName(link), "/", KindName(kind)));
+
+  ByteArray data(std::string(size, 'x'));
+  std::string file_path;
+  if (kind == kFile) {
+    std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / "payload_throughput_benchmark";
+    std::filesystem::create_directories(directory);
+    file_path = (directory / "payload.bin").string();
+    std::ofstream(file_path, std::ios::binary)
+        .write(data.data(), static_cast<std::streamsize>(size));
+  }
+
+  ConnectedPair pair(link);
+  if (!pair.Connect()) {
+    state.SkipWithError("failed to connect");
+    return;
+  }
+
+  absl::Duration first_byte_total;
+  double cpu_start = ProcessCpuSeconds();
+  for (auto _ : state) {
+    absl::Duration first_byte = TransferPayload(pair, kind, data, file_path);
+    if (first_byte == absl::InfiniteDuration()) {
+      state.SkipWithError("payload transfer failed");
+      break;
+    }
+    first_byte_total += first_byte;
+  }
+  double cpu_seconds = ProcessCpuSeconds() - cpu_start;
+
+  int64_t total_bytes = state.iterations() * static_cast<int64_t>(size);
+  state.SetBytesProcessed(total_bytes);
+  state.counters["time_to_first_byte_ms"] = benchmark::Counter(
+      absl::ToDoubleMilliseconds(first_byte_total),
+      benchmark::Counter::kAvgIterations);
+  if (total_bytes > 0) {
+    state.counters["cpu_seconds_per_gb"] = cpu_seconds / (total_bytes / 1e9);
+  }
+  if (!file_path.empty()) std::filesystem::remove(file_path);
+}
+
+BENCHMARK(BM_PayloadThroughput)
+    ->ArgNames({"link", "kind", "size"})
+    ->ArgsProduct({{kBluetooth, kBle, kWifiLan, kBluetoothUpgradedToWifiLan},
+                   {kBytes, kStream, kFile},
+                   {64 * 1024, 1024 * 1024}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace connections
+}  // namespace nearby
+
+BENCHMARK_MAIN();
@@ -26,6 +26,10 @@ WebRtcEndpointChannel::WebRtcEndpointChannel(
                           &socket.GetOutputStream()),
       webrtc_socket_(std::move(socket)) {}
 
+WebRtcEndpointChannel::~WebRtcEndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium WebRtcEndpointChannel::GetMedium()
     const {
   return location::nearby::proto::connections::Medium::WEB_RTC;
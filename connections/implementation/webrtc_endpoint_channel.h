@@ -33,6 +33,8 @@ class WebRtcEndpointChannel final : public BaseEndpointChannel {
                         const std::string& channel_name,
                         mediums::WebRtcSocketWrapper webrtc_socket);
 
+  ~WebRtcEndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
  private:
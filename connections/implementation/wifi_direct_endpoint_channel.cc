@@ -30,6 +30,10 @@ WifiDirectEndpointChannel::WifiDirectEndpointChannel(
                           &socket.GetOutputStream()),
       socket_(std::move(socket)) {}
 
+WifiDirectEndpointChannel::~WifiDirectEndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium
 WifiDirectEndpointChannel::GetMedium() const {
   return location::nearby::proto::connections::Medium::WIFI_DIRECT;
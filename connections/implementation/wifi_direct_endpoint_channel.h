@@ -37,6 +37,8 @@ class WifiDirectEndpointChannel final : public BaseEndpointChannel {
   WifiDirectEndpointChannel(WifiDirectEndpointChannel&&) = delete;
   WifiDirectEndpointChannel& operator=(WifiDirectEndpointChannel&&) = delete;
 
+  ~WifiDirectEndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
  private:
@@ -30,6 +30,10 @@ WifiHotspotEndpointChannel::WifiHotspotEndpointChannel(
                           &socket.GetOutputStream()),
       socket_(std::move(socket)) {}
 
+WifiHotspotEndpointChannel::~WifiHotspotEndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium
 WifiHotspotEndpointChannel::GetMedium() const {
   return location::nearby::proto::connections::Medium::WIFI_HOTSPOT;
@@ -37,6 +37,8 @@ class WifiHotspotEndpointChannel final : public BaseEndpointChannel {
   WifiHotspotEndpointChannel(WifiHotspotEndpointChannel&&) = delete;
   WifiHotspotEndpointChannel& operator=(WifiHotspotEndpointChannel&&) = delete;
 
+  ~WifiHotspotEndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
  private:
@@ -28,6 +28,10 @@ WifiLanEndpointChannel::WifiLanEndpointChannel(const std::string& service_id,
                           &socket.GetOutputStream()),
       socket_(std::move(socket)) {}
 
+WifiLanEndpointChannel::~WifiLanEndpointChannel() {
+  ShutDownPipeline();
+}
+
 location::nearby::proto::connections::Medium WifiLanEndpointChannel::GetMedium()
     const {
   return location::nearby::proto::connections::Medium::WIFI_LAN;
@@ -29,6 +29,8 @@ class WifiLanEndpointChannel final : public BaseEndpointChannel {
   WifiLanEndpointChannel(const std::string& service_id,
                          const std::string& channel_name, WifiLanSocket socket);
 
+  ~WifiLanEndpointChannel() override;
+
   location::nearby::proto::connections::Medium GetMedium() const override;
 
  private:
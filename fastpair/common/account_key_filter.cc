@@ -16,11 +16,17 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "fastpair/common/account_key.h"
 #include "fastpair/common/battery_notification.h"
+#include "fastpair/common/constant.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 #include "internal/crypto_cros/sha2.h"
 #include "internal/platform/logging.h"
@@ -40,11 +46,16 @@ constexpr uint8_t kInUseByte = 0x06;
 constexpr uint8_t kShowUi = 0b00110011;
 constexpr uint8_t kHideUi = 0b00110100;
 
-// Helper to AccountKeyFilter::IsAccountKeyInFilter().
+// Account keys are hashed with the salt and battery bytes appended. Inputs up
+// to this size stay on the stack.
+constexpr size_t kInlineHashInputSize = 32;
+
+// Helper to AccountKeyFilter::FindFirstPossiblyInSet().
 // Performs the test to see if |data| is in |bit_sets|, a Bloom filter.
-bool AccountKeyFilterChecker(const std::vector<uint8_t>& data,
+bool AccountKeyFilterChecker(absl::Span<const uint8_t> data,
                              const std::vector<uint8_t>& bit_sets) {
   std::array<uint8_t, 32> hashed = crypto::SHA256Hash(data);
+  const size_t num_bits = bit_sets.size() * kBitsInByte;
 
   // Iterate over the hashed input in 4 byte increments, combine those 4
   // bytes into an unsigned int and use it as the index into our
@@ -53,15 +64,11 @@ bool AccountKeyFilterChecker(const std::vector<uint8_t>& data,
     uint32_t hash = uint32_t{hashed[i]} << 24 | uint32_t{hashed[i + 1]} << 16 |
                     uint32_t{hashed[i + 2]} << 8 | hashed[i + 3];
 
-    size_t num_bits = bit_sets.size() * kBitsInByte;
     size_t n = hash % num_bits;
-    size_t byte_index = floor(n / kBitsInByte);
-    size_t bit_index = n % kBitsInByte;
-    bool is_set = (bit_sets[byte_index] >> bit_index) & 0x01;
+    bool is_set = (bit_sets[n / kBitsInByte] >> (n % kBitsInByte)) & 0x01;
 
     if (!is_set) return false;
   }
-  NEARBY_LOGS(INFO) << __func__ << " The accountkey is possibly in set.";
   return true;
 }
 
@@ -95,30 +102,42 @@ AccountKeyFilter::AccountKeyFilter(
     const std::vector<uint8_t>& salt_values)
     : bit_sets_(account_key_filter_bytes), salt_values_(salt_values) {}
 
-bool AccountKeyFilter::IsPossiblyInSet(const AccountKey& account_key) {
-  if (!account_key.Ok()) {
-    NEARBY_LOGS(INFO) << __func__ << " Invalid account key.";
-    return false;
-  }
-  if (bit_sets_.empty()) return false;
+bool AccountKeyFilter::IsPossiblyInSet(const AccountKey& account_key) const {
+  return FindFirstPossiblyInSet(absl::MakeConstSpan(&account_key, 1))
+      .has_value();
+}
+
+std::optional<size_t> AccountKeyFilter::FindFirstPossiblyInSet(
+    absl::Span<const AccountKey> account_keys) const {
+  if (bit_sets_.empty()) return std::nullopt;
   // We first need to append the salt value to the input (see
   // https://developers.google.com/nearby/fast-pair/spec#AccountKeyFilter).
-  std::vector<uint8_t> data(account_key.GetAsBytes().begin(),
-                            account_key.GetAsBytes().end());
-  for (auto& byte : salt_values_) data.push_back(byte);
-
-  // We need to try account keys with different first bytes in case
-  // the peripheral is SASS per
-  // https://developers.google.com/nearby/fast-pair/early-access/specifications/extensions/sass#SassAdvertisingPayload
-  if (AccountKeyFilterChecker(data, bit_sets_)) {
-    return true;
-  }
-  data[0] = kRecentlyUsedByte;
-  if (AccountKeyFilterChecker(data, bit_sets_)) {
-    return true;
+  // The salt is the same for every key, so only the key bytes in front of it
+  // are replaced per key.
+  absl::InlinedVector<uint8_t, kInlineHashInputSize> data(kAccountKeySize);
+  data.insert(data.end(), salt_values_.begin(), salt_values_.end());
+
+  for (size_t i = 0; i < account_keys.size(); ++i) {
+    const AccountKey& account_key = account_keys[i];
+    if (!account_key.Ok()) {
+      NEARBY_LOGS(INFO) << __func__ << " Invalid account key.";
+      continue;
+    }
+    absl::string_view bytes = account_key.GetAsBytes();
+    std::copy(bytes.begin(), bytes.end(), data.begin());
+
+    // We need to try account keys with different first bytes in case
+    // the peripheral is SASS per
+    // https://developers.google.com/nearby/fast-pair/early-access/specifications/extensions/sass#SassAdvertisingPayload
+    for (uint8_t first_byte : {data[0], kRecentlyUsedByte, kInUseByte}) {
+      data[0] = first_byte;
+      if (AccountKeyFilterChecker(data, bit_sets_)) {
+        NEARBY_LOGS(INFO) << __func__ << " The accountkey is possibly in set.";
+        return i;
+      }
+    }
   }
-  data[0] = kInUseByte;
-  return AccountKeyFilterChecker(data, bit_sets_);
+  return std::nullopt;
 }
 
 }  // namespace fastpair
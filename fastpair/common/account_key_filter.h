@@ -15,9 +15,13 @@
 #ifndef THIRD_PARTY_NEARBY_FASTPAIR_COMMON_ACCOUNT_KEY_FILTER_H_
 #define THIRD_PARTY_NEARBY_FASTPAIR_COMMON_ACCOUNT_KEY_FILTER_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "fastpair/common/account_key.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 
@@ -36,7 +40,25 @@ class AccountKeyFilter {
   // Returns true if the `account_key` is possibly in the account key set
   // defined by the filter.
   // Return false if `account_key` is definitely not in set.
-  bool IsPossiblyInSet(const AccountKey& account_key);
+  bool IsPossiblyInSet(const AccountKey& account_key) const;
+
+  // Returns the index of the first of `account_keys` that is possibly in the
+  // account key set, or std::nullopt if none of them is. Cheaper than calling
+  // IsPossiblyInSet() for each key.
+  std::optional<size_t> FindFirstPossiblyInSet(
+      absl::Span<const AccountKey> account_keys) const;
+
+  // Filters with the same bits and salt match the same account keys, so the
+  // result of a check can be reused for repeated advertisements.
+  friend bool operator==(const AccountKeyFilter& a,
+                         const AccountKeyFilter& b) {
+    return a.bit_sets_ == b.bit_sets_ && a.salt_values_ == b.salt_values_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const AccountKeyFilter& filter) {
+    return H::combine(std::move(h), filter.bit_sets_, filter.salt_values_);
+  }
 
  private:
   std::vector<uint8_t> bit_sets_;
@@ -0,0 +1,84 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "fastpair/common/account_key.h"
+#include "fastpair/common/account_key_filter.h"
+
+namespace nearby {
+namespace fastpair {
+namespace {
+
+// Filter and salt from the Fast Pair test cases, with battery data appended
+// to the salt like a non-discoverable advertisement that shows battery levels.
+// The account keys are chosen not to be in it, so every key and every SASS
+// variant is checked.
+const std::vector<uint8_t> kFilter{0x46, 0x15, 0x24, 0xD0, 0x08};
+const std::vector<uint8_t> kSalt{0xC7, 0xC8, 0b00110011, 0b01000000,
+                                 0b01000000, 0b01000000};
+
+std::vector<AccountKey> CreateAccountKeys(const AccountKeyFilter& filter,
+                                          int count) {
+  std::vector<AccountKey> account_keys;
+  account_keys.reserve(count);
+  while (static_cast<int>(account_keys.size()) < count) {
+    AccountKey account_key = AccountKey::CreateRandomKey();
+    if (!filter.IsPossiblyInSet(account_key)) {
+      account_keys.push_back(account_key);
+    }
+  }
+  return account_keys;
+}
+
+void BM_IsPossiblyInSetPerKey(benchmark::State& state) {
+  AccountKeyFilter filter(kFilter, kSalt);
+  std::vector<AccountKey> account_keys =
+      CreateAccountKeys(filter, state.range(0));
+
+  for (auto _ : state) {
+    bool found = false;
+    for (const auto& account_key : account_keys) {
+      if (filter.IsPossiblyInSet(account_key)) {
+        found = true;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations() * account_keys.size());
+}
+
+BENCHMARK(BM_IsPossiblyInSetPerKey)->Arg(1)->Arg(1000);
+
+void BM_FindFirstPossiblyInSet(benchmark::State& state) {
+  AccountKeyFilter filter(kFilter, kSalt);
+  std::vector<AccountKey> account_keys =
+      CreateAccountKeys(filter, state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter.FindFirstPossiblyInSet(account_keys));
+  }
+  state.SetItemsProcessed(state.iterations() * account_keys.size());
+}
+
+BENCHMARK(BM_FindFirstPossiblyInSet)->Arg(1)->Arg(1000);
+
+}  // namespace
+}  // namespace fastpair
+}  // namespace nearby
+
+BENCHMARK_MAIN();
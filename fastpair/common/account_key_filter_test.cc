@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/types/span.h"
 #include "fastpair/common/battery_notification.h"
 #include "fastpair/common/non_discoverable_advertisement.h"
 
@@ -130,6 +131,28 @@ TEST_F(AccountKeyFilterTest, SassEnabledPeripheral) {
       AccountKeyFilter(filter4, salt_values).IsPossiblyInSet(account_key_3));
 }
 
+TEST_F(AccountKeyFilterTest, FindFirstPossiblyInSet) {
+  const std::vector<uint8_t> bytes{0x12, 0x22, 0x33, 0x44, 0x55, 0x66,
+                                   0x77, 0x88, 0x99, 0x00, 0xAA, 0xBB,
+                                   0xCC, 0xDD, 0xEE, 0xFF};
+  std::vector<AccountKey> account_keys{AccountKey(bytes), AccountKey(""),
+                                       AccountKey(account_key_2_),
+                                       AccountKey(account_key_1_)};
+
+  EXPECT_EQ(AccountKeyFilter(filter_1_, salt_)
+                .FindFirstPossiblyInSet(account_keys),
+            3);
+  EXPECT_EQ(AccountKeyFilter(filter_1_and_2_, salt_)
+                .FindFirstPossiblyInSet(account_keys),
+            2);
+  EXPECT_EQ(AccountKeyFilter(filter_1_, salt_)
+                .FindFirstPossiblyInSet(absl::MakeConstSpan(account_keys)
+                                            .subspan(0, 3)),
+            std::nullopt);
+  EXPECT_EQ(AccountKeyFilter({}, {}).FindFirstPossiblyInSet(account_keys),
+            std::nullopt);
+}
+
 }  // namespace
 }  // namespace fastpair
 }  // namespace nearby
@@ -14,6 +14,7 @@
 
 #include "fastpair/repository/fast_pair_repository_impl.h"
 
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
@@ -22,11 +23,16 @@
 
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "fastpair/common/account_key.h"
+#include "fastpair/common/account_key_filter.h"
 #include "fastpair/common/device_metadata.h"
 #include "fastpair/proto/data.proto.h"
 #include "fastpair/proto/enum.proto.h"
 #include "fastpair/proto/proto_builder.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
 #include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
@@ -72,8 +78,13 @@ bool IsDeviceSha256Matched(const proto::FastPairDevice& device,
 }
 }  // namespace
 
-FastPairRepositoryImpl::FastPairRepositoryImpl(FastPairClient* fast_pair_client)
-    : fast_pair_client_(fast_pair_client) {}
+// C++14 requires to declare this.
+constexpr absl::Duration FastPairRepositoryImpl::kSavedAccountKeysTtl;
+constexpr size_t FastPairRepositoryImpl::kMaxCachedFilterResults;
+
+FastPairRepositoryImpl::FastPairRepositoryImpl(
+    FastPairClient* fast_pair_client, AccountManager* account_manager)
+    : fast_pair_client_(fast_pair_client), account_manager_(account_manager) {}
 
 void FastPairRepositoryImpl::AddObserver(Observer* observer) {
   observers_.AddObserver(observer);
@@ -122,11 +133,13 @@ void FastPairRepositoryImpl::WriteAccountAssociationToFootprints(
         NEARBY_LOGS(INFO)
             << __func__
             << ": Start to write account associated device to footprints.";
+        std::optional<std::string> account_id = GetCurrentAccountId();
         absl::StatusOr<proto::UserWriteDeviceResponse> response =
             fast_pair_client_->UserWriteDevice(request);
         if (response.ok()) {
           NEARBY_LOGS(INFO)
               << __func__ << "Got GetWriteDeviceResponse from backend.";
+          AddSavedAccountKey(request.fast_pair_info().device(), account_id);
           std::move(callback)(absl::OkStatus());
         } else {
           NEARBY_LOGS(WARNING)
@@ -144,10 +157,12 @@ void FastPairRepositoryImpl::DeleteAssociatedDeviceByAccountKey(
   executor_.Execute(
       "Delete associated device",
       [this, hex_account_key = std::move(hex_string),
+       account_key = std::string(account_key.GetAsBytes()),
        callback = std::move(callback)]() mutable {
         NEARBY_LOGS(INFO)
             << __func__
             << ": Start to delete account associated device from footprints";
+        std::optional<std::string> account_id = GetCurrentAccountId();
         proto::UserDeleteDeviceRequest request;
         request.set_hex_account_key(hex_account_key);
         absl::StatusOr<proto::UserDeleteDeviceResponse> response =
@@ -156,6 +171,7 @@ void FastPairRepositoryImpl::DeleteAssociatedDeviceByAccountKey(
           if (response->success()) {
             NEARBY_LOGS(INFO)
                 << __func__ << "Successfully deleted associated device.";
+            RemoveSavedAccountKey(account_key, account_id);
             std::move(callback)(absl::OkStatus());
           } else {
             NEARBY_LOGS(WARNING) << __func__ << "Failed to delete device.";
@@ -175,6 +191,7 @@ void FastPairRepositoryImpl::GetUserSavedDevices() {
   executor_.Execute("Get associated devices", [this]() mutable {
     NEARBY_LOGS(INFO) << __func__
                       << ": Start to get all account associated devices.";
+    std::optional<std::string> account_id = GetCurrentAccountId();
     proto::UserReadDevicesRequest request;
     absl::StatusOr<proto::UserReadDevicesResponse> response =
         fast_pair_client_->UserReadDevices(request);
@@ -185,6 +202,7 @@ void FastPairRepositoryImpl::GetUserSavedDevices() {
     }
     NEARBY_LOGS(INFO) << __func__
                       << "Got UserReadDevicesResponse from backend.";
+    UpdateSavedAccountKeys(*response, account_id);
     proto::OptInStatus opt_in_status =
         proto::OptInStatus::OPT_IN_STATUS_UNKNOWN;
     std::vector<proto::FastPairDevice> saved_devices;
@@ -211,37 +229,57 @@ void FastPairRepositoryImpl::GetUserSavedDevices() {
 
 void FastPairRepositoryImpl::CheckIfAssociatedWithCurrentAccount(
     AccountKeyFilter& account_key_filter, CheckAccountKeysCallback callback) {
-  executor_.Execute("Check if associated.", [this,
-                                             account_key_filter =
-                                                 std::move(account_key_filter),
-                                             callback = std::move(
-                                                 callback)]() mutable {
-    NEARBY_LOGS(INFO) << __func__
-                      << ": Start to check if associated with current account.";
-    proto::UserReadDevicesRequest request;
-    absl::StatusOr<proto::UserReadDevicesResponse> response =
-        fast_pair_client_->UserReadDevices(request);
-    if (response.ok()) {
-      for (const auto& info : response->fast_pair_info()) {
-        if (!info.has_device()) {
-          continue;
-        }
-        AccountKey account_key(info.device().account_key());
-        if (!account_key_filter.IsPossiblyInSet(account_key)) {
-          continue;
-        }
-        proto::StoredDiscoveryItem device;
-        if (device.ParseFromString(info.device().discovery_item_bytes())) {
-          NEARBY_LOGS(INFO)
-              << "Account key matched with a paired device: " << device.title();
-          std::move(callback)(account_key, device.id());
-          return;
-        }
+  std::optional<std::string> account_id = GetCurrentAccountId();
+  std::optional<SavedAccountKey> saved_account_key;
+  {
+    MutexLock lock(&mutex_);
+    // Without a signed-in account nothing matches, and whatever was cached for
+    // the last one is dropped.
+    if (UseSavedAccountKeysOfLocked(account_id)) {
+      // Answer from the cache right away, and refresh it in the background if
+      // it is getting old.
+      if (!saved_account_keys_refresh_pending_ &&
+          absl::Now() - *saved_account_keys_update_time_ >=
+              kSavedAccountKeysTtl) {
+        saved_account_keys_refresh_pending_ = true;
+        executor_.Execute("Refresh saved account keys",
+                          [this, account_id = *account_id]() {
+                            RefreshSavedAccountKeys(account_id);
+                          });
       }
+      saved_account_key = FindSavedAccountKeyLocked(account_key_filter);
+    } else if (account_id.has_value()) {
+      // Nothing to answer from yet; load the account keys first.
+      executor_.Execute(
+          "Check if associated.",
+          [this, account_id = *account_id,
+           account_key_filter = std::move(account_key_filter),
+           callback = std::move(callback)]() mutable {
+            NEARBY_LOGS(INFO)
+                << __func__
+                << ": Start to check if associated with current account.";
+            bool loaded;
+            {
+              MutexLock lock(&mutex_);
+              loaded = HasSavedAccountKeysOfLocked(account_id);
+            }
+            if (!loaded) {
+              RefreshSavedAccountKeys(account_id);
+            }
+            std::optional<SavedAccountKey> saved_account_key;
+            {
+              MutexLock lock(&mutex_);
+              if (HasSavedAccountKeysOfLocked(account_id)) {
+                saved_account_key =
+                    FindSavedAccountKeyLocked(account_key_filter);
+              }
+            }
+            RunCheckAccountKeysCallback(saved_account_key, std::move(callback));
+          });
+      return;
     }
-    NEARBY_LOGS(INFO) << "Account key does not match any paired devices.";
-    std::move(callback)(std::nullopt, std::nullopt);
-  });
+  }
+  RunCheckAccountKeysCallback(saved_account_key, std::move(callback));
 }
 
 void FastPairRepositoryImpl::IsDeviceSavedToAccount(
@@ -252,6 +290,7 @@ void FastPairRepositoryImpl::IsDeviceSavedToAccount(
        callback = std::move(callback)]() mutable {
         NEARBY_LOGS(INFO) << __func__
                           << ": Start to check is device saved to account.";
+        std::optional<std::string> account_id = GetCurrentAccountId();
         proto::UserReadDevicesRequest request;
         absl::StatusOr<proto::UserReadDevicesResponse> response =
             fast_pair_client_->UserReadDevices(request);
@@ -262,6 +301,7 @@ void FastPairRepositoryImpl::IsDeviceSavedToAccount(
           std::move(callback)(response.status());
           return;
         }
+        UpdateSavedAccountKeys(*response, account_id);
         for (const auto& info : response->fast_pair_info()) {
           if (info.has_device() &&
               IsDeviceSha256Matched(info.device(), mac_address)) {
@@ -277,5 +317,170 @@ void FastPairRepositoryImpl::IsDeviceSavedToAccount(
       });
 }
 
+void FastPairRepositoryImpl::RunCheckAccountKeysCallback(
+    const std::optional<SavedAccountKey>& saved_account_key,
+    CheckAccountKeysCallback callback) {
+  if (!saved_account_key.has_value()) {
+    NEARBY_LOGS(INFO) << "Account key does not match any paired devices.";
+    std::move(callback)(std::nullopt, std::nullopt);
+    return;
+  }
+  NEARBY_LOGS(INFO) << "Account key matched with a paired device: "
+                    << saved_account_key->model_id;
+  std::move(callback)(saved_account_key->account_key,
+                      saved_account_key->model_id);
+}
+
+std::optional<std::string> FastPairRepositoryImpl::GetCurrentAccountId()
+    const {
+  std::optional<AccountManager::Account> account =
+      account_manager_->GetCurrentAccount();
+  if (!account.has_value()) return std::nullopt;
+  return account->id;
+}
+
+void FastPairRepositoryImpl::RefreshSavedAccountKeys(
+    const std::string& account_id) {
+  NEARBY_LOGS(INFO) << __func__ << ": Start to refresh saved account keys.";
+  proto::UserReadDevicesRequest request;
+  absl::StatusOr<proto::UserReadDevicesResponse> response =
+      fast_pair_client_->UserReadDevices(request);
+  if (!response.ok()) {
+    NEARBY_LOGS(WARNING)
+        << __func__ << "Failed to get UserReadDevicesResponse from backend.";
+    MutexLock lock(&mutex_);
+    saved_account_keys_refresh_pending_ = false;
+    return;
+  }
+  UpdateSavedAccountKeys(*response, account_id);
+}
+
+void FastPairRepositoryImpl::UpdateSavedAccountKeys(
+    const proto::UserReadDevicesResponse& response,
+    const std::optional<std::string>& account_id) {
+  if (!account_id.has_value() || GetCurrentAccountId() != account_id) {
+    NEARBY_LOGS(INFO) << __func__
+                      << ": Signed-in account changed, ignoring its devices.";
+    return;
+  }
+  std::vector<AccountKey> saved_account_keys;
+  std::vector<std::string> saved_model_ids;
+  for (const auto& info : response.fast_pair_info()) {
+    if (!info.has_device()) {
+      continue;
+    }
+    AccountKey account_key(info.device().account_key());
+    proto::StoredDiscoveryItem item;
+    if (!account_key.Ok() ||
+        !item.ParseFromString(info.device().discovery_item_bytes())) {
+      continue;
+    }
+    saved_account_keys.push_back(std::move(account_key));
+    saved_model_ids.push_back(item.id());
+  }
+
+  MutexLock lock(&mutex_);
+  NEARBY_LOGS(INFO) << __func__ << ": Cached " << saved_account_keys.size()
+                    << " saved account keys.";
+  UseSavedAccountKeysOfLocked(account_id);
+  saved_account_keys_ = std::move(saved_account_keys);
+  saved_model_ids_ = std::move(saved_model_ids);
+  saved_account_keys_update_time_ = absl::Now();
+  saved_account_keys_refresh_pending_ = false;
+  OnSavedAccountKeysChangedLocked();
+}
+
+void FastPairRepositoryImpl::AddSavedAccountKey(
+    const proto::FastPairDevice& device,
+    const std::optional<std::string>& account_id) {
+  AccountKey account_key(device.account_key());
+  proto::StoredDiscoveryItem item;
+  if (!account_key.Ok() ||
+      !item.ParseFromString(device.discovery_item_bytes())) {
+    return;
+  }
+
+  MutexLock lock(&mutex_);
+  // Until the first read from the server, there is no cache to add to.
+  if (!HasSavedAccountKeysOfLocked(account_id)) return;
+  auto it = std::find(saved_account_keys_.begin(), saved_account_keys_.end(),
+                      account_key);
+  if (it != saved_account_keys_.end()) {
+    saved_model_ids_[it - saved_account_keys_.begin()] = item.id();
+  } else {
+    saved_account_keys_.push_back(std::move(account_key));
+    saved_model_ids_.push_back(item.id());
+  }
+  OnSavedAccountKeysChangedLocked();
+}
+
+void FastPairRepositoryImpl::RemoveSavedAccountKey(
+    absl::string_view account_key,
+    const std::optional<std::string>& account_id) {
+  MutexLock lock(&mutex_);
+  if (!HasSavedAccountKeysOfLocked(account_id)) return;
+  auto it = std::find(saved_account_keys_.begin(), saved_account_keys_.end(),
+                      AccountKey(account_key));
+  if (it == saved_account_keys_.end()) return;
+  saved_model_ids_.erase(saved_model_ids_.begin() +
+                         (it - saved_account_keys_.begin()));
+  saved_account_keys_.erase(it);
+  OnSavedAccountKeysChangedLocked();
+}
+
+bool FastPairRepositoryImpl::HasSavedAccountKeysOfLocked(
+    const std::optional<std::string>& account_id) const {
+  return account_id.has_value() &&
+         saved_account_keys_account_id_ == account_id &&
+         saved_account_keys_update_time_.has_value();
+}
+
+bool FastPairRepositoryImpl::UseSavedAccountKeysOfLocked(
+    const std::optional<std::string>& account_id) {
+  if (saved_account_keys_account_id_ != account_id) {
+    if (saved_account_keys_update_time_.has_value()) {
+      NEARBY_LOGS(INFO) << __func__
+                        << ": Signed-in account changed, dropping "
+                        << saved_account_keys_.size()
+                        << " cached account keys.";
+    }
+    saved_account_keys_account_id_ = account_id;
+    saved_account_keys_.clear();
+    saved_model_ids_.clear();
+    saved_account_keys_update_time_.reset();
+    saved_account_keys_refresh_pending_ = false;
+    OnSavedAccountKeysChangedLocked();
+  }
+  return HasSavedAccountKeysOfLocked(account_id);
+}
+
+std::optional<FastPairRepositoryImpl::SavedAccountKey>
+FastPairRepositoryImpl::FindSavedAccountKeyLocked(
+    const AccountKeyFilter& account_key_filter) {
+  auto it = filter_results_.find(account_key_filter);
+  if (it != filter_results_.end()) {
+    return it->second;
+  }
+
+  std::optional<SavedAccountKey> result;
+  std::optional<size_t> index =
+      account_key_filter.FindFirstPossiblyInSet(saved_account_keys_);
+  if (index.has_value()) {
+    result = SavedAccountKey{saved_account_keys_[*index],
+                             saved_model_ids_[*index]};
+  }
+  // Salts rotate with the advertisements, so old filters are never seen
+  // again; start over rather than tracking which ones are stale.
+  if (filter_results_.size() >= kMaxCachedFilterResults) {
+    filter_results_.clear();
+  }
+  filter_results_.emplace(account_key_filter, result);
+  return result;
+}
+
+void FastPairRepositoryImpl::OnSavedAccountKeysChangedLocked() {
+  filter_results_.clear();
+}
+
 }  // namespace fastpair
 }  // namespace nearby
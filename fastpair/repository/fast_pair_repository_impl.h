@@ -15,22 +15,46 @@
 #ifndef THIRD_PARTY_NEARBY_FASTPAIR_REPOSITORY_FAST_PAIR_REPOSITORY_IMPL_H_
 #define THIRD_PARTY_NEARBY_FASTPAIR_REPOSITORY_FAST_PAIR_REPOSITORY_IMPL_H_
 
+#include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "fastpair/common/account_key.h"
+#include "fastpair/common/account_key_filter.h"
 #include "fastpair/common/device_metadata.h"
+#include "fastpair/proto/data.proto.h"
 #include "fastpair/repository/fast_pair_repository.h"
 #include "fastpair/server_access/fast_pair_client.h"
+#include "internal/account/account_manager.h"
 #include "internal/base/observer_list.h"
+#include "internal/platform/mutex.h"
 #include "internal/platform/single_thread_executor.h"
 
 namespace nearby {
 namespace fastpair {
 
+// The account keys saved to the user's account are cached locally, so
+// checking a non-discoverable advertisement against them needs no server
+// round-trip. The cache is loaded by the first check, updated by every read
+// of the saved devices and by writes and deletes, and refreshed in the
+// background once it is older than kSavedAccountKeysTtl. It belongs to the
+// account it was read for: once another account, or none, is signed in, it is
+// dropped, and server responses read for the previous account are ignored.
 class FastPairRepositoryImpl : public FastPairRepository {
  public:
-  explicit FastPairRepositoryImpl(FastPairClient* fast_pair_client);
+  // How long the cached account keys are used before they are refreshed.
+  static constexpr absl::Duration kSavedAccountKeysTtl = absl::Minutes(30);
+  // Maximum number of filter check results kept for repeated advertisements.
+  static constexpr size_t kMaxCachedFilterResults = 128;
+
+  FastPairRepositoryImpl(FastPairClient* fast_pair_client,
+                         AccountManager* account_manager);
 
   FastPairRepositoryImpl(const FastPairRepositoryImpl&) = delete;
   FastPairRepositoryImpl& operator=(const FastPairRepositoryImpl&) = delete;
@@ -58,9 +82,74 @@ class FastPairRepositoryImpl : public FastPairRepository {
                               OperationCallback callback) override;
 
  private:
+  // An account key saved to the user's account and the model id of its
+  // device.
+  struct SavedAccountKey {
+    AccountKey account_key;
+    std::string model_id;
+  };
+
+  static void RunCheckAccountKeysCallback(
+      const std::optional<SavedAccountKey>& saved_account_key,
+      CheckAccountKeysCallback callback);
+  // Returns the id of the signed-in account, if any.
+  std::optional<std::string> GetCurrentAccountId() const;
+  // Replaces the cached account keys with the devices in |response|, which
+  // was read for |account_id|, unless another account is signed in by now.
+  void UpdateSavedAccountKeys(const proto::UserReadDevicesResponse& response,
+                              const std::optional<std::string>& account_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Adds or replaces the cached account key of |device|, written to the
+  // account |account_id|.
+  void AddSavedAccountKey(const proto::FastPairDevice& device,
+                          const std::optional<std::string>& account_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  void RemoveSavedAccountKey(absl::string_view account_key,
+                             const std::optional<std::string>& account_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Reads the saved devices of |account_id| from the server into the cache.
+  // Runs on |executor_|. On failure the cache is left as it is.
+  void RefreshSavedAccountKeys(const std::string& account_id)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Returns true if the cache holds the account keys of |account_id|.
+  bool HasSavedAccountKeysOfLocked(
+      const std::optional<std::string>& account_id) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Like HasSavedAccountKeysOfLocked(), but first drops the cache if it
+  // belongs to another account.
+  bool UseSavedAccountKeysOfLocked(const std::optional<std::string>& account_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the first cached account key matching |account_key_filter|.
+  std::optional<SavedAccountKey> FindSavedAccountKeyLocked(
+      const AccountKeyFilter& account_key_filter)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Drops the filter check results of the previous account keys.
+  void OnSavedAccountKeysChangedLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Declared before |executor_|, so they outlive the tasks still running on
+  // it during destruction.
+  Mutex mutex_;
+  // The account |saved_account_keys_| belong to.
+  std::optional<std::string> saved_account_keys_account_id_
+      ABSL_GUARDED_BY(mutex_);
+  // Kept apart from the model ids so they can be checked against a filter in
+  // one call.
+  std::vector<AccountKey> saved_account_keys_ ABSL_GUARDED_BY(mutex_);
+  // Model ids of the devices in |saved_account_keys_|, in the same order.
+  std::vector<std::string> saved_model_ids_ ABSL_GUARDED_BY(mutex_);
+  // Unset until the account keys of |saved_account_keys_account_id_| are read
+  // from the server.
+  std::optional<absl::Time> saved_account_keys_update_time_
+      ABSL_GUARDED_BY(mutex_);
+  bool saved_account_keys_refresh_pending_ ABSL_GUARDED_BY(mutex_) = false;
+  // Results of earlier checks against the current |saved_account_keys_|.
+  absl::flat_hash_map<AccountKeyFilter, std::optional<SavedAccountKey>>
+      filter_results_ ABSL_GUARDED_BY(mutex_);
+
   // A thread for running blocking tasks.
   SingleThreadExecutor executor_;
   FastPairClient* fast_pair_client_;
+  AccountManager* account_manager_;
   absl::flat_hash_map<std::string, std::unique_ptr<DeviceMetadata>>
       metadata_cache_;
   ObserverList<FastPairRepository::Observer> observers_;
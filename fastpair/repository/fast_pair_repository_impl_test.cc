@@ -24,10 +24,12 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "fastpair/common/device_metadata.h"
+#include "fastpair/common/fast_pair_prefs.h"
 #include "fastpair/proto/data.proto.h"
 #include "fastpair/proto/fast_pair_string.proto.h"
 #include "fastpair/proto/proto_builder.h"
 #include "fastpair/server_access/fake_fast_pair_client.h"
+#include "internal/account/fake_account_manager.h"
 #include "internal/platform/count_down_latch.h"
 
 namespace nearby {
@@ -43,6 +45,8 @@ constexpr absl::string_view kInitialPairingdescription =
 constexpr absl::string_view kExpectedSha256Hash =
     "6353c0075a35b7d81bb30a6190ab246da4b8c55a6111d387400579133c090ed8";
 constexpr absl::Duration kWaitTimeout = absl::Milliseconds(200);
+constexpr absl::string_view kTestAccountId = "test_account_id";
+constexpr absl::string_view kOtherAccountId = "other_account_id";
 
 // A gMock matcher to match proto values. Use this matcher like:
 // request/response proto, expected_proto;
@@ -54,6 +58,17 @@ MATCHER_P(
   return arg.SerializeAsString() == expected_proto.SerializeAsString();
 }
 
+std::unique_ptr<FakeAccountManager> CreateSignedInAccountManager(
+    absl::string_view account_id) {
+  auto account_manager = std::make_unique<FakeAccountManager>(
+      /*preferences_manager=*/nullptr, prefs::kNearbyFastPairUsersName,
+      /*authentication_manager=*/nullptr, /*task_runner=*/nullptr);
+  AccountManager::Account account;
+  account.id = std::string(account_id);
+  account_manager->SetAccount(account);
+  return account_manager;
+}
+
 class FastPairRepositoryObserver : public FastPairRepository::Observer {
  public:
   explicit FastPairRepositoryObserver(CountDownLatch* latch) {
@@ -79,8 +94,10 @@ class FastPairRepositoryObserver : public FastPairRepository::Observer {
 
 TEST(FastPairRepositoryImplTest, MetadataDownloadSuccess) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up proto::GetObservedDeviceResponse
   proto::GetObservedDeviceResponse response_proto;
@@ -118,8 +135,10 @@ TEST(FastPairRepositoryImplTest, MetadataDownloadSuccess) {
 
 TEST(FastPairRepositoryImplTest, FailedToDownloadMetadata) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   fake_fast_pair_client.SetGetObservedDeviceResponse(
       absl::InternalError("No response"));
@@ -135,8 +154,10 @@ TEST(FastPairRepositoryImplTest, FailedToDownloadMetadata) {
 
 TEST(FastPairRepositoryImplTest, GetUserSavedDevicesSuccess) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up two devices to proto::UserReadDevicesResponse.
   // Adds device 1.
@@ -195,8 +216,10 @@ TEST(FastPairRepositoryImplTest, GetUserSavedDevicesSuccess) {
 
 TEST(FastPairRepositoryImplTest, FailedToGetUserSavedDevices) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   fake_fast_pair_client.SetUserReadDevicesResponse(
       absl::InternalError("No response"));
@@ -213,8 +236,10 @@ TEST(FastPairRepositoryImplTest, FailedToGetUserSavedDevices) {
 
 TEST(FastPairRepositoryImplTest, WriteAccountAssociationToFootprintsSuccess) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up proto::UserWriteDeviceResponse.
   proto::UserWriteDeviceResponse response_proto;
@@ -266,8 +291,10 @@ TEST(FastPairRepositoryImplTest, WriteAccountAssociationToFootprintsSuccess) {
 
 TEST(FastPairRepositoryImplTest, FailedToWriteAccountAssociationToFootprints) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   fake_fast_pair_client.SetUserWriteDeviceResponse(
       absl::InternalError("No response"));
@@ -300,8 +327,10 @@ TEST(FastPairRepositoryImplTest, FailedToWriteAccountAssociationToFootprints) {
 
 TEST(FastPairRepositoryImplTest, DeleteAssociatedDeviceByAccountKeySuccess) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up proto::UserDeleteDeviceResponse
   proto::UserDeleteDeviceResponse response_proto;
@@ -330,8 +359,10 @@ TEST(FastPairRepositoryImplTest, DeleteAssociatedDeviceByAccountKeySuccess) {
 
 TEST(FastPairRepositoryImplTest, FailedToDeleteAssociatedDeviceWithNoResponse) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   fake_fast_pair_client.SetUserDeleteDeviceResponse(
       absl::InternalError("No response"));
@@ -352,8 +383,10 @@ TEST(FastPairRepositoryImplTest, FailedToDeleteAssociatedDeviceWithNoResponse) {
 
 TEST(FastPairRepositoryImplTest, FailedToDeleteAssociatedDeviceWithError) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up proto::UserDeleteDeviceResponse
   proto::UserDeleteDeviceResponse response_proto;
@@ -383,8 +416,10 @@ TEST(FastPairRepositoryImplTest, DeviceAssociatedWithCurrentAccountSuccess) {
                                              0x77, 0x88, 0x99, 0x00, 0xAA, 0xBB,
                                              0xCC, 0xDD, 0xEE, 0xFF};
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up two devices to proto::UserReadDevicesResponse.
   proto::UserReadDevicesResponse response_proto;
@@ -436,8 +471,10 @@ TEST(FastPairRepositoryImplTest, DeviceNotAssociatedWithCurrentAccount) {
                                              0x77, 0x77, 0x88, 0x88};
 
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up two devices to proto::UserReadDevicesResponse.
   // Adds device 1.
@@ -469,10 +506,202 @@ TEST(FastPairRepositoryImplTest, DeviceNotAssociatedWithCurrentAccount) {
   latch.Await();
 }
 
+TEST(FastPairRepositoryImplTest, AssociatedAccountKeysAreCached) {
+  const std::vector<uint8_t> filter{0x02, 0x0C, 0x80, 0x2A};
+  const std::vector<uint8_t> salt{0xC7, 0xC8};
+  const std::vector<uint8_t> account_key_vec{0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+                                             0x77, 0x88, 0x99, 0x00, 0xAA, 0xBB,
+                                             0xCC, 0xDD, 0xEE, 0xFF};
+  FakeFastPairClient fake_fast_pair_client;
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
+
+  proto::UserReadDevicesResponse response_proto;
+  FastPairDevice device(kHexModelId, kBleAddress,
+                        Protocol::kFastPairInitialPairing);
+  AccountKey account_key(account_key_vec);
+  device.SetAccountKey(account_key);
+  device.SetPublicAddress(kPublicAddress);
+  proto::GetObservedDeviceResponse get_observed_device_response;
+  DeviceMetadata device_metadata(get_observed_device_response);
+  device.SetMetadata(device_metadata);
+  BuildFastPairInfo(response_proto.add_fast_pair_info(), device);
+  fake_fast_pair_client.SetUserReadDevicesResponse(response_proto);
+
+  // The first check reads the account keys from the server.
+  AccountKeyFilter account_key_filter(filter, salt);
+  CountDownLatch latch(1);
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      account_key_filter, [&](std::optional<AccountKey> cb_account_key,
+                              std::optional<absl::string_view> cb_model_id) {
+        EXPECT_TRUE(cb_account_key.has_value());
+        latch.CountDown();
+      });
+  latch.Await();
+
+  // Later checks are answered without the server.
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      absl::InternalError("No response"));
+  for (int i = 0; i < 2; ++i) {
+    AccountKeyFilter same_filter(filter, salt);
+    bool called = false;
+    fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+        same_filter, [&](std::optional<AccountKey> cb_account_key,
+                         std::optional<absl::string_view> cb_model_id) {
+          ASSERT_TRUE(cb_account_key.has_value());
+          ASSERT_TRUE(cb_model_id.has_value());
+          EXPECT_EQ(cb_account_key.value(), account_key);
+          EXPECT_EQ(cb_model_id.value(), kHexModelId);
+          called = true;
+        });
+    EXPECT_TRUE(called);
+  }
+}
+
+TEST(FastPairRepositoryImplTest, CachedAccountKeysFollowWritesAndDeletes) {
+  const std::vector<uint8_t> filter{0x02, 0x0C, 0x80, 0x2A};
+  const std::vector<uint8_t> salt{0xC7, 0xC8};
+  const std::vector<uint8_t> account_key_vec{0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+                                             0x77, 0x88, 0x99, 0x00, 0xAA, 0xBB,
+                                             0xCC, 0xDD, 0xEE, 0xFF};
+  FakeFastPairClient fake_fast_pair_client;
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
+
+  // Loads an empty set of account keys.
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      proto::UserReadDevicesResponse());
+  AccountKeyFilter account_key_filter(filter, salt);
+  CountDownLatch read_latch(1);
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      account_key_filter, [&](std::optional<AccountKey> cb_account_key,
+                              std::optional<absl::string_view> cb_model_id) {
+        EXPECT_FALSE(cb_account_key.has_value());
+        read_latch.CountDown();
+      });
+  read_latch.Await();
+
+  // Saves a device that matches the filter.
+  fake_fast_pair_client.SetUserWriteDeviceResponse(
+      proto::UserWriteDeviceResponse());
+  FastPairDevice device(kHexModelId, kBleAddress,
+                        Protocol::kFastPairInitialPairing);
+  AccountKey account_key(account_key_vec);
+  device.SetAccountKey(account_key);
+  device.SetPublicAddress(kPublicAddress);
+  proto::GetObservedDeviceResponse get_observed_device_response;
+  DeviceMetadata device_metadata(get_observed_device_response);
+  device.SetMetadata(device_metadata);
+  CountDownLatch write_latch(1);
+  fast_pair_repository->WriteAccountAssociationToFootprints(
+      device, [&](absl::Status status) {
+        EXPECT_OK(status);
+        write_latch.CountDown();
+      });
+  write_latch.Await();
+
+  AccountKeyFilter filter_after_write(filter, salt);
+  std::optional<AccountKey> matched_account_key;
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      filter_after_write, [&](std::optional<AccountKey> cb_account_key,
+                              std::optional<absl::string_view> cb_model_id) {
+        matched_account_key = cb_account_key;
+      });
+  EXPECT_EQ(matched_account_key, account_key);
+
+  // Deletes it again.
+  proto::UserDeleteDeviceResponse delete_response;
+  delete_response.set_success(true);
+  fake_fast_pair_client.SetUserDeleteDeviceResponse(delete_response);
+  CountDownLatch delete_latch(1);
+  fast_pair_repository->DeleteAssociatedDeviceByAccountKey(
+      account_key, [&](absl::Status status) {
+        EXPECT_OK(status);
+        delete_latch.CountDown();
+      });
+  delete_latch.Await();
+
+  AccountKeyFilter filter_after_delete(filter, salt);
+  bool matched = true;
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      filter_after_delete, [&](std::optional<AccountKey> cb_account_key,
+                               std::optional<absl::string_view> cb_model_id) {
+        matched = cb_account_key.has_value();
+      });
+  EXPECT_FALSE(matched);
+}
+
+TEST(FastPairRepositoryImplTest, CachedAccountKeysAreDroppedOnAccountChange) {
+  const std::vector<uint8_t> filter{0x02, 0x0C, 0x80, 0x2A};
+  const std::vector<uint8_t> salt{0xC7, 0xC8};
+  const std::vector<uint8_t> account_key_vec{0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+                                             0x77, 0x88, 0x99, 0x00, 0xAA, 0xBB,
+                                             0xCC, 0xDD, 0xEE, 0xFF};
+  FakeFastPairClient fake_fast_pair_client;
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
+
+  proto::UserReadDevicesResponse response_proto;
+  FastPairDevice device(kHexModelId, kBleAddress,
+                        Protocol::kFastPairInitialPairing);
+  device.SetAccountKey(AccountKey(account_key_vec));
+  device.SetPublicAddress(kPublicAddress);
+  proto::GetObservedDeviceResponse get_observed_device_response;
+  DeviceMetadata device_metadata(get_observed_device_response);
+  device.SetMetadata(device_metadata);
+  BuildFastPairInfo(response_proto.add_fast_pair_info(), device);
+  fake_fast_pair_client.SetUserReadDevicesResponse(response_proto);
+
+  AccountKeyFilter account_key_filter(filter, salt);
+  CountDownLatch latch(1);
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      account_key_filter, [&](std::optional<AccountKey> cb_account_key,
+                              std::optional<absl::string_view> cb_model_id) {
+        EXPECT_TRUE(cb_account_key.has_value());
+        latch.CountDown();
+      });
+  latch.Await();
+
+  // Once signed out, nothing matches, and the server is not asked.
+  account_manager->SetAccount(std::nullopt);
+  AccountKeyFilter filter_signed_out(filter, salt);
+  bool matched = true;
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      filter_signed_out, [&](std::optional<AccountKey> cb_account_key,
+                             std::optional<absl::string_view> cb_model_id) {
+        matched = cb_account_key.has_value();
+      });
+  EXPECT_FALSE(matched);
+
+  // Another account does not see the account keys of the first one.
+  AccountManager::Account other_account;
+  other_account.id = std::string(kOtherAccountId);
+  account_manager->SetAccount(other_account);
+  fake_fast_pair_client.SetUserReadDevicesResponse(
+      proto::UserReadDevicesResponse());
+  AccountKeyFilter filter_other_account(filter, salt);
+  CountDownLatch other_latch(1);
+  fast_pair_repository->CheckIfAssociatedWithCurrentAccount(
+      filter_other_account, [&](std::optional<AccountKey> cb_account_key,
+                                std::optional<absl::string_view> cb_model_id) {
+        EXPECT_FALSE(cb_account_key.has_value());
+        other_latch.CountDown();
+      });
+  other_latch.Await();
+}
+
 TEST(FastPairRepositoryImplTest, DeviceIsSavedToCurrentAccount) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up two devices to proto::UserReadDevicesResponse.
   proto::UserReadDevicesResponse response_proto;
@@ -504,8 +733,10 @@ TEST(FastPairRepositoryImplTest, DeviceIsSavedToCurrentAccount) {
 
 TEST(FastPairRepositoryImplTest, DeviceIsNotSavedToCurrentAccount) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   // Sets up two devices to proto::UserReadDevicesResponse.
   proto::UserReadDevicesResponse response_proto;
@@ -532,8 +763,10 @@ TEST(FastPairRepositoryImplTest, DeviceIsNotSavedToCurrentAccount) {
 
 TEST(FastPairRepositoryImplTest, FailedToCheckDeviceIsSavedToCurrentAccount) {
   FakeFastPairClient fake_fast_pair_client;
-  auto fast_pair_repository =
-      std::make_unique<FastPairRepositoryImpl>(&fake_fast_pair_client);
+  std::unique_ptr<FakeAccountManager> account_manager =
+      CreateSignedInAccountManager(kTestAccountId);
+  auto fast_pair_repository = std::make_unique<FastPairRepositoryImpl>(
+      &fake_fast_pair_client, account_manager.get());
 
   CountDownLatch latch(1);
   fast_pair_repository->IsDeviceSavedToAccount(kPublicAddress,
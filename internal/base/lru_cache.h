@@ -0,0 +1,162 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_INTERNAL_BASE_LRU_CACHE_H_
+#define THIRD_PARTY_NEARBY_INTERNAL_BASE_LRU_CACHE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
+
+namespace nearby {
+
+// Lookup counts of an LruCache.
+struct LruCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+  int64_t evictions = 0;
+
+  // Fraction of lookups that found a value, or 0 if there were none.
+  double HitRate() const {
+    int64_t lookups = hits + misses;
+    return lookups == 0 ? 0 : static_cast<double>(hits) / lookups;
+  }
+
+  LruCacheStats& operator+=(const LruCacheStats& other) {
+    hits += other.hits;
+    misses += other.misses;
+    evictions += other.evictions;
+    return *this;
+  }
+};
+
+// A bounded, thread-safe cache from byte strings to values, evicting the least
+// recently used entry when full.
+//
+// Keys are spread over `num_shards` independently locked shards, so threads
+// looking up different keys rarely wait for each other. Each shard holds at
+// most `capacity / num_shards` entries (rounded up). Values are returned by
+// copy; use a `std::shared_ptr` for values that are expensive to copy.
+template <typename Value>
+class LruCache {
+ public:
+  // `num_shards` must be positive.
+  explicit LruCache(size_t capacity, size_t num_shards = 8)
+      : shard_capacity_(
+            std::max<size_t>((capacity + num_shards - 1) / num_shards, 1)) {
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+      shards_.push_back(std::make_unique<Shard>());
+    }
+  }
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  // Returns the value stored for `key` and marks it as recently used.
+  std::optional<Value> Get(absl::string_view key) {
+    Shard& shard = GetShard(key);
+    MutexLock lock(&shard.mutex);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->second;
+  }
+
+  // Stores `value` for `key`, replacing any value stored before.
+  void Put(absl::string_view key, Value value) {
+    Shard& shard = GetShard(key);
+    MutexLock lock(&shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      it->second->second = std::move(value);
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      return;
+    }
+    if (shard.entries.size() >= shard_capacity_) {
+      shard.index.erase(shard.entries.back().first);
+      shard.entries.pop_back();
+      evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard.entries.emplace_front(std::string(key), std::move(value));
+    // The index refers to the key stored in the list node, which never moves.
+    shard.index.emplace(shard.entries.front().first, shard.entries.begin());
+  }
+
+  // Removes every entry. The statistics are kept.
+  void Clear() {
+    for (auto& shard : shards_) {
+      MutexLock lock(&shard->mutex);
+      shard->index.clear();
+      shard->entries.clear();
+    }
+  }
+
+  size_t Size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+      MutexLock lock(&shard->mutex);
+      size += shard->entries.size();
+    }
+    return size;
+  }
+
+  LruCacheStats GetStats() const {
+    return {.hits = hits_.load(std::memory_order_relaxed),
+            .misses = misses_.load(std::memory_order_relaxed),
+            .evictions = evictions_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  using Entries = std::list<std::pair<std::string, Value>>;
+
+  struct Shard {
+    mutable Mutex mutex;
+    // Most recently used first.
+    Entries entries ABSL_GUARDED_BY(mutex);
+    absl::flat_hash_map<absl::string_view, typename Entries::iterator> index
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  Shard& GetShard(absl::string_view key) {
+    return *shards_[absl::Hash<absl::string_view>{}(key) % shards_.size()];
+  }
+
+  const size_t shard_capacity_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+  std::atomic<int64_t> evictions_{0};
+};
+
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_INTERNAL_BASE_LRU_CACHE_H_
@@ -0,0 +1,110 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/base/lru_cache.h"
+
+#include <optional>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace nearby {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+TEST(LruCacheTest, GetReturnsStoredValue) {
+  LruCache<int> cache(/*capacity=*/4, /*num_shards=*/1);
+
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+
+  EXPECT_THAT(cache.Get("a"), Optional(Eq(1)));
+  EXPECT_THAT(cache.Get("b"), Optional(Eq(2)));
+  EXPECT_EQ(cache.Get("c"), std::nullopt);
+}
+
+TEST(LruCacheTest, PutReplacesValue) {
+  LruCache<int> cache(/*capacity=*/4, /*num_shards=*/1);
+
+  cache.Put("a", 1);
+  cache.Put("a", 2);
+
+  EXPECT_THAT(cache.Get("a"), Optional(Eq(2)));
+  EXPECT_EQ(cache.Size(), 1);
+}
+
+TEST(LruCacheTest, EvictsLeastRecentlyUsed) {
+  LruCache<int> cache(/*capacity=*/2, /*num_shards=*/1);
+
+  cache.Put("a", 1);
+  cache.Put("b", 2);
+  // "a" is now used more recently than "b".
+  ASSERT_THAT(cache.Get("a"), Optional(Eq(1)));
+  cache.Put("c", 3);
+
+  EXPECT_THAT(cache.Get("a"), Optional(Eq(1)));
+  EXPECT_EQ(cache.Get("b"), std::nullopt);
+  EXPECT_THAT(cache.Get("c"), Optional(Eq(3)));
+  EXPECT_EQ(cache.GetStats().evictions, 1);
+}
+
+TEST(LruCacheTest, SizeIsBounded) {
+  LruCache<int> cache(/*capacity=*/16, /*num_shards=*/4);
+
+  for (int i = 0; i < 100; ++i) {
+    cache.Put(std::to_string(i), i);
+  }
+
+  EXPECT_LE(cache.Size(), 16);
+}
+
+TEST(LruCacheTest, KeysAreBytes) {
+  LruCache<int> cache(/*capacity=*/4, /*num_shards=*/1);
+
+  cache.Put(std::string("a\0b", 3), 1);
+
+  EXPECT_EQ(cache.Get("a"), std::nullopt);
+  EXPECT_THAT(cache.Get(std::string("a\0b", 3)), Optional(Eq(1)));
+}
+
+TEST(LruCacheTest, CountsHitsAndMisses) {
+  LruCache<int> cache(/*capacity=*/4, /*num_shards=*/1);
+  cache.Put("a", 1);
+
+  cache.Get("a");
+  cache.Get("a");
+  cache.Get("a");
+  cache.Get("b");
+
+  LruCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.hits, 3);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_DOUBLE_EQ(stats.HitRate(), 0.75);
+}
+
+TEST(LruCacheTest, ClearRemovesEntries) {
+  LruCache<int> cache(/*capacity=*/4, /*num_shards=*/1);
+  cache.Put("a", 1);
+
+  cache.Clear();
+
+  EXPECT_EQ(cache.Size(), 0);
+  EXPECT_EQ(cache.Get("a"), std::nullopt);
+}
+
+}  // namespace
+}  // namespace nearby
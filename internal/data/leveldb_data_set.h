@@ -15,6 +15,7 @@
 #ifndef THIRD_PARTY_NEARBY_INTERNAL_DATA_LEVELDB_DATA_SET_H_
 #define THIRD_PARTY_NEARBY_INTERNAL_DATA_LEVELDB_DATA_SET_H_
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <ostream>
@@ -24,19 +25,27 @@
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "third_party/leveldb/include/cache.h"
 #include "third_party/leveldb/include/db.h"
+#include "third_party/leveldb/include/filter_policy.h"
 #include "third_party/leveldb/include/iterator.h"
 #include "third_party/leveldb/include/options.h"
 #include "third_party/leveldb/include/slice.h"
 #include "third_party/leveldb/include/status.h"
+#include "third_party/leveldb/include/write_batch.h"
 #include "internal/data/data_set.h"
 #include "internal/platform/logging.h"
+#include "internal/platform/single_thread_executor.h"
 #include "third_party/protobuf/message_lite.h"
 
 namespace nearby {
 namespace data {
 // DataSet implementation using leveldb as its persistent storage. Values are
 // serialized and stored in leveldb databases.
+//
+// Database operations run in order on a dedicated I/O thread, and callbacks
+// are invoked on that thread. Pending operations finish before the data set is
+// destroyed.
 template <typename T,
           std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value,
                            bool> = true>
@@ -44,7 +53,38 @@ class LeveldbDataSet : public DataSet<T> {
  public:
   using KeyEntryVector = std::vector<std::pair<std::string, T>>;
 
-  explicit LeveldbDataSet(absl::string_view path) : path_(path) {}
+  struct Options {
+    // Size of the cache of uncompressed blocks, in bytes. 0 uses the leveldb
+    // default of 8 MB.
+    size_t block_cache_size = 0;
+    // Bits per key of the bloom filter that lets reads of missing keys skip
+    // table files. 0 disables the filter.
+    int bloom_filter_bits_per_key = 10;
+  };
+
+  // An entry read by VisitEntries(). It only refers to the database, so it is
+  // valid during the visitor call only.
+  class Entry {
+   public:
+    explicit Entry(const leveldb::Iterator& it) : it_(it) {}
+
+    absl::string_view key() const {
+      return absl::string_view(it_.key().data(), it_.key().size());
+    }
+
+    // Deserializes the value into `value`. Returns false if it is malformed.
+    bool GetValue(T& value) const {
+      return value.ParseFromArray(it_.value().data(), it_.value().size());
+    }
+
+   private:
+    const leveldb::Iterator& it_;
+  };
+
+  explicit LeveldbDataSet(absl::string_view path)
+      : LeveldbDataSet(path, Options()) {}
+  LeveldbDataSet(absl::string_view path, Options options)
+      : path_(path), options_(options) {}
   ~LeveldbDataSet() override = default;
 
   void Initialize(std::function<void(InitStatus)> callback) override;
@@ -54,6 +94,12 @@ class LeveldbDataSet : public DataSet<T> {
       std::function<
           void(bool, std::unique_ptr<std::vector<std::pair<std::string, T>>>)>
           callback);
+  // Calls `visitor` with the entries in key order, without copying or
+  // deserializing them up front, until it returns false. `callback` is then
+  // invoked with false if the entries couldn't be read.
+  void VisitEntries(std::function<bool(const Entry&)> visitor,
+                    std::function<void(bool)> callback);
+  // Saves and removes the entries in one atomic write.
   void UpdateEntries(std::unique_ptr<KeyEntryVector> entries_to_save,
                      std::unique_ptr<std::vector<std::string>> keys_to_remove,
                      std::function<void(bool)> callback) override;
@@ -61,12 +107,23 @@ class LeveldbDataSet : public DataSet<T> {
 
  private:
   void Serialize(T const& value, std::string& str);
-  void Deserialize(absl::string_view str, T& value);
+
+  // Reads every entry with `visitor` on the I/O thread. Returns false if the
+  // database couldn't be read.
+  bool ReadEntries(const std::function<bool(const Entry&)>& visitor);
 
  private:
   std::string path_;
+  const Options options_;
+  // Owned by the data set since leveldb doesn't take ownership of them; they
+  // must outlive `db_`.
+  std::unique_ptr<leveldb::Cache> block_cache_;
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
   std::unique_ptr<leveldb::DB> db_ = nullptr;
   InitStatus status_ = InitStatus::kNotInitialized;
+  // Runs every database operation. Declared last so that it stops before the
+  // database is closed.
+  SingleThreadExecutor executor_;
 };
 
 template <typename T,
@@ -74,25 +131,37 @@ template <typename T,
               isMessageLite>
 void LeveldbDataSet<T, isMessageLite>::Initialize(
     std::function<void(InitStatus)> callback) {
-  leveldb::Options options;
-  options.create_if_missing = true;
-
-  leveldb::DB* db;
-  leveldb::Status status = leveldb::DB::Open(options, path_, &db);
-  db_ = std::unique_ptr<leveldb::DB>(db);
-
-  if (status.ok()) {
-    status_ = InitStatus::kOK;
-    NEARBY_LOGS(INFO) << "Database is initialized successfully..";
-  } else if (status.IsCorruption() || status.IsIOError()) {
-    status_ = InitStatus::kCorrupt;
-    NEARBY_LOGS(INFO) << "Database is corrupt.";
-
-  } else {
-    status_ = InitStatus::kError;
-    NEARBY_LOGS(INFO) << "Failed to initialize database due to unknown error.";
-  }
-  std::move(callback)(status_);
+  executor_.Execute([this, callback = std::move(callback)]() mutable {
+    leveldb::Options options;
+    options.create_if_missing = true;
+    if (options_.block_cache_size > 0) {
+      block_cache_.reset(leveldb::NewLRUCache(options_.block_cache_size));
+      options.block_cache = block_cache_.get();
+    }
+    if (options_.bloom_filter_bits_per_key > 0) {
+      filter_policy_.reset(
+          leveldb::NewBloomFilterPolicy(options_.bloom_filter_bits_per_key));
+      options.filter_policy = filter_policy_.get();
+    }
+
+    leveldb::DB* db;
+    leveldb::Status status = leveldb::DB::Open(options, path_, &db);
+    db_ = std::unique_ptr<leveldb::DB>(db);
+
+    if (status.ok()) {
+      status_ = InitStatus::kOK;
+      NEARBY_LOGS(INFO) << "Database is initialized successfully..";
+    } else if (status.IsCorruption() || status.IsIOError()) {
+      status_ = InitStatus::kCorrupt;
+      NEARBY_LOGS(INFO) << "Database is corrupt.";
+
+    } else {
+      status_ = InitStatus::kError;
+      NEARBY_LOGS(INFO)
+          << "Failed to initialize database due to unknown error.";
+    }
+    std::move(callback)(status_);
+  });
 }
 
 template <typename T,
@@ -100,30 +169,23 @@ template <typename T,
               isMessageLite>
 void LeveldbDataSet<T, isMessageLite>::LoadEntries(
     std::function<void(bool, std::unique_ptr<std::vector<T>>)> callback) {
-  auto result = std::make_unique<std::vector<T>>();
-  if (status_ != InitStatus::kOK) {
-    std::move(callback)(false, std::move(result));
-    return;
-  }
-
-  std::unique_ptr<leveldb::Iterator> it(
-      db_->NewIterator(leveldb::ReadOptions()));
-
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    T value;
-    Deserialize(it->value().ToString(), value);
-    result->push_back(value);
-  }
+  executor_.Execute([this, callback = std::move(callback)]() mutable {
+    auto result = std::make_unique<std::vector<T>>();
+    bool success = ReadEntries([&result](const Entry& entry) {
+      T value;
+      entry.GetValue(value);
+      result->push_back(std::move(value));
+      return true;
+    });
 
-  if (it->status().ok()) {
-    NEARBY_LOGS(INFO) << "Loaded " << result->size()
-                      << " entries from database.";
-    std::move(callback)(true, std::move(result));
-  } else {
-    NEARBY_LOGS(INFO) << "Failed to load entries from database.";
-    result->clear();
-    std::move(callback)(false, std::move(result));
-  }
+    if (success) {
+      NEARBY_LOGS(INFO) << "Loaded " << result->size()
+                        << " entries from database.";
+    } else {
+      result->clear();
+    }
+    std::move(callback)(success, std::move(result));
+  });
 }
 
 template <typename T,
@@ -133,30 +195,35 @@ void LeveldbDataSet<T, isMessageLite>::LoadEntriesWithKeys(
     std::function<void(bool,
                        std::unique_ptr<std::vector<std::pair<std::string, T>>>)>
         callback) {
-  auto result = std::make_unique<std::vector<std::pair<std::string, T>>>();
-  if (status_ != InitStatus::kOK) {
-    std::move(callback)(false, std::move(result));
-    return;
-  }
-
-  std::unique_ptr<leveldb::Iterator> it(
-      db_->NewIterator(leveldb::ReadOptions()));
+  executor_.Execute([this, callback = std::move(callback)]() mutable {
+    auto result = std::make_unique<std::vector<std::pair<std::string, T>>>();
+    bool success = ReadEntries([&result](const Entry& entry) {
+      T value;
+      entry.GetValue(value);
+      result->emplace_back(std::string(entry.key()), std::move(value));
+      return true;
+    });
 
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    T value;
-    Deserialize(it->value().ToString(), value);
-    result->push_back({it->key().ToString(), value});
-  }
+    if (success) {
+      NEARBY_LOGS(INFO) << "Loaded " << result->size()
+                        << " entries from database.";
+    } else {
+      result->clear();
+    }
+    std::move(callback)(success, std::move(result));
+  });
+}
 
-  if (it->status().ok()) {
-    NEARBY_LOGS(INFO) << "Loaded " << result->size()
-                      << " entries from database.";
-    std::move(callback)(true, std::move(result));
-  } else {
-    NEARBY_LOGS(INFO) << "Failed to load entries from database.";
-    result->clear();
-    std::move(callback)(false, std::move(result));
-  }
+template <typename T,
+          std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
+              isMessageLite>
+void LeveldbDataSet<T, isMessageLite>::VisitEntries(
+    std::function<bool(const Entry&)> visitor,
+    std::function<void(bool)> callback) {
+  executor_.Execute([this, visitor = std::move(visitor),
+                     callback = std::move(callback)]() mutable {
+    std::move(callback)(ReadEntries(visitor));
+  });
 }
 
 template <typename T,
@@ -167,26 +234,36 @@ void LeveldbDataSet<T, isMessageLite>::UpdateEntries(
     std::unique_ptr<std::vector<std::string>> keys_to_remove,
     std::function<void(bool)> callback) {
   NEARBY_LOGS(INFO) << "UpdateEntries is called.";
-  if (status_ != InitStatus::kOK) {
-    std::move(callback)(false);
-    return;
-  }
+  executor_.Execute([this, entries_to_save = std::move(entries_to_save),
+                     keys_to_remove = std::move(keys_to_remove),
+                     callback = std::move(callback)]() mutable {
+    if (status_ != InitStatus::kOK) {
+      std::move(callback)(false);
+      return;
+    }
 
-  if (entries_to_save != nullptr) {
-    for (const auto& [key, value] : *entries_to_save) {
+    leveldb::WriteBatch batch;
+    if (entries_to_save != nullptr) {
       std::string str;
-      Serialize(value, str);
-      db_->Put(leveldb::WriteOptions(), key, leveldb::Slice(str));
+      for (const auto& [key, value] : *entries_to_save) {
+        Serialize(value, str);
+        // The batch copies the key and value.
+        batch.Put(key, leveldb::Slice(str));
+      }
     }
-  }
 
-  if (keys_to_remove != nullptr) {
-    for (const auto& it : *keys_to_remove) {
-      db_->Delete(leveldb::WriteOptions(), it);
+    if (keys_to_remove != nullptr) {
+      for (const auto& it : *keys_to_remove) {
+        batch.Delete(it);
+      }
     }
-  }
 
-  std::move(callback)(true);
+    leveldb::Status status = db_->Write(leveldb::WriteOptions(), &batch);
+    if (!status.ok()) {
+      NEARBY_LOGS(INFO) << "Failed to update entries in database.";
+    }
+    std::move(callback)(status.ok());
+  });
 }
 
 template <typename T,
@@ -195,29 +272,51 @@ template <typename T,
 void LeveldbDataSet<T, isMessageLite>::Destroy(
     std::function<void(bool)> callback) {
   NEARBY_LOGS(INFO) << "Destroy is called.";
-  db_.reset();
-  leveldb::DestroyDB(path_, leveldb::Options());
-  std::move(callback)(true);
+  executor_.Execute([this, callback = std::move(callback)]() mutable {
+    db_.reset();
+    status_ = InitStatus::kNotInitialized;
+    leveldb::DestroyDB(path_, leveldb::Options());
+    std::move(callback)(true);
+  });
 }
 
-// Functions for serializing/deserializing data values to/from strings. Strings
-// are used as a convenient container that manages its memory. They don't need
-// to be human-readable.
-
 template <typename T,
           std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
               isMessageLite>
-void LeveldbDataSet<T, isMessageLite>::Serialize(T const& value,
-                                                 std::string& str) {
-  value.SerializeToString(&str);
+bool LeveldbDataSet<T, isMessageLite>::ReadEntries(
+    const std::function<bool(const Entry&)>& visitor) {
+  if (status_ != InitStatus::kOK) {
+    return false;
+  }
+
+  // A full scan would evict the blocks that point reads use from the cache.
+  leveldb::ReadOptions read_options;
+  read_options.fill_cache = false;
+  std::unique_ptr<leveldb::Iterator> it(db_->NewIterator(read_options));
+
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    if (!visitor(Entry(*it))) {
+      break;
+    }
+  }
+
+  if (!it->status().ok()) {
+    NEARBY_LOGS(INFO) << "Failed to load entries from database.";
+    return false;
+  }
+  return true;
 }
 
+// Function for serializing data values to strings. Strings are used as a
+// convenient container that manages its memory. They don't need to be
+// human-readable. Values are deserialized in place by Entry::GetValue().
+
 template <typename T,
           std::enable_if_t<std::is_base_of<proto2::MessageLite, T>::value, bool>
               isMessageLite>
-void LeveldbDataSet<T, isMessageLite>::Deserialize(absl::string_view str,
-                                                   T& value) {
-  value.ParseFromString(str);
+void LeveldbDataSet<T, isMessageLite>::Serialize(T const& value,
+                                                 std::string& str) {
+  value.SerializeToString(&str);
 }
 
 }  // namespace data
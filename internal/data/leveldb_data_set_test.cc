@@ -38,6 +38,7 @@ namespace nearby {
 namespace data {
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::SizeIs;
 
 // Generate a unique directory under temp directory for leveldb storage
@@ -90,6 +91,21 @@ bool UpdateEntriesAndWait(
   return result;
 }
 
+template <typename T>
+std::vector<std::string> VisitKeysAndWait(
+    std::unique_ptr<LeveldbDataSet<T>>& dataset, int max_keys) {
+  std::vector<std::string> keys;
+  absl::Notification notification;
+  dataset->VisitEntries(
+      [&keys, max_keys](const typename LeveldbDataSet<T>::Entry& entry) {
+        keys.push_back(std::string(entry.key()));
+        return static_cast<int>(keys.size()) < max_keys;
+      },
+      [&notification](bool) { notification.Notify(); });
+  notification.WaitForNotificationWithTimeout(absl::Seconds(5));
+  return keys;
+}
+
 template <typename T>
 std::unique_ptr<std::vector<T>> LoadEntriesAndWait(
     std::unique_ptr<LeveldbDataSet<T>>& dataset) {
@@ -254,6 +270,53 @@ TEST(LeveldbDataSet, RemoveEntriesDiceRoll) {
   EXPECT_EQ(result["id4"].nickname(), diceroll4.nickname());
 }
 
+TEST(LeveldbDataSet, VisitEntriesStopsWhenVisitorReturnsFalse) {
+  std::filesystem::path path = GenerateLeveldbPath();
+  std::unique_ptr<LeveldbDataSet<DiceRoll>> diceroll_set =
+      CreateDataSet<DiceRoll>(path);
+
+  InitializeAndWait(diceroll_set);
+
+  auto entries = LeveldbDataSet<DiceRoll>::KeyEntryVector(
+      {{"id3", GenerateDiceRoll(5)},
+       {"id1", GenerateDiceRoll(2)},
+       {"id2", GenerateDiceRoll(12)}});
+  UpdateEntriesAndWait(
+      diceroll_set,
+      std::make_unique<LeveldbDataSet<DiceRoll>::KeyEntryVector>(entries),
+      nullptr);
+
+  std::vector<std::string> keys = VisitKeysAndWait(diceroll_set, 2);
+  WipeCleanAndWait(diceroll_set, path);
+
+  EXPECT_THAT(keys, ElementsAre("id1", "id2"));
+}
+
+TEST(LeveldbDataSet, LoadEntriesWithOptions) {
+  std::filesystem::path path = GenerateLeveldbPath();
+  auto diceroll_set = std::make_unique<LeveldbDataSet<DiceRoll>>(
+      path.string(),
+      LeveldbDataSet<DiceRoll>::Options{.block_cache_size = 1 << 20,
+                                        .bloom_filter_bits_per_key = 10});
+
+  ASSERT_EQ(InitializeAndWait(diceroll_set), InitStatus::kOK);
+
+  auto entries = LeveldbDataSet<DiceRoll>::KeyEntryVector(
+      {{"id1", GenerateDiceRoll(2)}, {"id2", GenerateDiceRoll(12)}});
+  EXPECT_TRUE(UpdateEntriesAndWait(
+      diceroll_set,
+      std::make_unique<LeveldbDataSet<DiceRoll>::KeyEntryVector>(entries),
+      std::make_unique<std::vector<std::string>>(
+          std::vector<std::string>({"id1"}))));
+
+  auto result = LoadEntriesWithKeysAndWait(diceroll_set);
+  WipeCleanAndWait(diceroll_set, path);
+
+  // Removals in the same update apply after the saves.
+  EXPECT_THAT(result, SizeIs(1));
+  EXPECT_EQ(result["id2"].nickname(), "boxcars");
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace nearby
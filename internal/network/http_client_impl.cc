@@ -24,11 +24,14 @@
 #include "internal/network/debug.h"
 #include "internal/platform/logging.h"
 #include "internal/platform/mutex_lock.h"
-#include "internal/platform/single_thread_executor.h"
+#include "internal/platform/multi_thread_executor.h"
 
 namespace nearby {
 namespace network {
 
+// C++14 requires to declare this.
+constexpr int NearbyHttpClient::kDefaultMaxConcurrentRequests;
+
 void NearbyHttpClient::StartRequest(
     const HttpRequest& request,
     std::function<void(const absl::StatusOr<HttpResponse>&)> callback) {
@@ -79,8 +82,10 @@ void NearbyHttpClient::StartCancellableRequest(
                   << " is cancelled.";
               return;
             }
-            absl::StatusOr<HttpResponse> response =
-                InternalGetResponse(cancellable_request->http_request());
+            CancellableRequest* request = cancellable_request.get();
+            absl::StatusOr<HttpResponse> response = InternalGetResponse(
+                request->http_request(),
+                [request]() { return request->is_cancelled(); });
             if (response.ok()) {
               NEARBY_LOGS(INFO)
                   << __func__ << ": Got response from url="
@@ -128,7 +133,7 @@ absl::StatusOr<HttpResponse> NearbyHttpClient::GetResponse(
 }
 
 absl::StatusOr<HttpResponse> NearbyHttpClient::InternalGetResponse(
-    const HttpRequest& request) {
+    const HttpRequest& request, std::function<bool()> is_cancelled) {
   api::WebRequest web_request;
   web_request.url = request.GetUrl().GetUrlPath();
   web_request.method = absl::StrCat(request.GetMethodString());
@@ -138,6 +143,8 @@ absl::StatusOr<HttpResponse> NearbyHttpClient::InternalGetResponse(
     }
   }
   web_request.body = absl::StrCat(request.GetBody().GetRawData());
+  web_request.timeout = request.GetTimeout();
+  web_request.is_cancelled = std::move(is_cancelled);
 
   if (debug::kRequestEnabled) {
     std::stringstream request_stream;
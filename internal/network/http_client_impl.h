@@ -22,14 +22,20 @@
 #include "internal/network/http_client.h"
 #include "internal/network/http_request.h"
 #include "internal/platform/mutex.h"
-#include "internal/platform/single_thread_executor.h"
+#include "internal/platform/multi_thread_executor.h"
 
 namespace nearby {
 namespace network {
 
+// Asynchronous requests run on a pool of up to `max_concurrent_requests`
+// threads, so a slow request does not hold up the ones started after it.
 class NearbyHttpClient : public HttpClient {
  public:
-  NearbyHttpClient() = default;
+  static constexpr int kDefaultMaxConcurrentRequests = 4;
+
+  explicit NearbyHttpClient(
+      int max_concurrent_requests = kDefaultMaxConcurrentRequests)
+      : executor_(max_concurrent_requests) {}
   ~NearbyHttpClient() override = default;
 
   NearbyHttpClient(const NearbyHttpClient&) = default;
@@ -50,11 +56,13 @@ class NearbyHttpClient : public HttpClient {
   absl::StatusOr<HttpResponse> GetResponse(const HttpRequest& request) override;
 
  private:
+  // `is_cancelled` is polled while the request is in flight; it may be empty.
   static absl::StatusOr<HttpResponse> InternalGetResponse(
-      const HttpRequest& request);
+      const HttpRequest& request,
+      std::function<bool()> is_cancelled = nullptr);
 
   Mutex mutex_;
-  SingleThreadExecutor executor_;
+  MultiThreadExecutor executor_;
 };
 
 }  // namespace network
@@ -14,6 +14,7 @@
 
 #include "internal/network/http_client_impl.h"
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -27,6 +28,8 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "internal/network/http_client.h"
@@ -39,10 +42,13 @@ namespace api {
 namespace {
 
 struct HttpTestContext {
-  WebRequest web_request;
+  absl::Mutex mutex;
+  WebRequest web_request ABSL_GUARDED_BY(mutex);
   WebResponse web_response;
   absl::Status status;
   absl::Duration api_time;
+  std::atomic<int> requests_in_flight{0};
+  std::atomic<int> max_requests_in_flight{0};
 };
 
 HttpTestContext* GetContext() {
@@ -55,10 +61,20 @@ HttpTestContext* GetContext() {
 // Mock web implementation of the platform
 absl::StatusOr<WebResponse> ImplementationPlatform::SendRequest(
     const WebRequest& request) {
-  GetContext()->web_request = request;
+  {
+    absl::MutexLock lock(&GetContext()->mutex);
+    GetContext()->web_request = request;
+  }
+  int in_flight = ++GetContext()->requests_in_flight;
+  int max_in_flight = GetContext()->max_requests_in_flight;
+  while (in_flight > max_in_flight &&
+         !GetContext()->max_requests_in_flight.compare_exchange_weak(
+             max_in_flight, in_flight)) {
+  }
   if (GetContext()->api_time != absl::ZeroDuration()) {
     absl::SleepFor(GetContext()->api_time);
   }
+  --GetContext()->requests_in_flight;
   if (GetContext()->status.ok()) {
     return GetContext()->web_response;
   }
@@ -74,10 +90,14 @@ using ::testing::SizeIs;
 class NearbyHttpClientTest : public ::testing::Test {
  public:
   void SetUp() override {
-    api::GetContext()->web_request = api::WebRequest();
+    {
+      absl::MutexLock lock(&api::GetContext()->mutex);
+      api::GetContext()->web_request = api::WebRequest();
+    }
     api::GetContext()->web_response = api::WebResponse();
     api::GetContext()->status = absl::Status();
     api::GetContext()->api_time = absl::ZeroDuration();
+    api::GetContext()->max_requests_in_flight = 0;
   }
 
   void MockFailedResponse(absl::Status status) {
@@ -96,7 +116,10 @@ class NearbyHttpClientTest : public ::testing::Test {
     api::GetContext()->web_response = web_response;
   }
 
-  api::WebRequest GetWebRequest() { return api::GetContext()->web_request; }
+  api::WebRequest GetWebRequest() {
+    absl::MutexLock lock(&api::GetContext()->mutex);
+    return api::GetContext()->web_request;
+  }
 
   absl::StatusOr<HttpRequest> MakeHttpRequest(
       absl::string_view url, HttpRequestMethod method,
@@ -324,6 +347,36 @@ TEST_F(NearbyHttpClientTest, TestRequestWithCleanThreadsAsync) {
   ASSERT_TRUE(result.ok());
 }
 
+TEST_F(NearbyHttpClientTest, TestTimeoutIsPassedToPlatform) {
+  absl::StatusOr<HttpRequest> request =
+      MakeHttpRequest("http://www.google.com", HttpRequestMethod::kGet, {}, "");
+  ASSERT_TRUE(request.ok());
+  request->SetTimeout(absl::Seconds(5));
+  MockResponse(HttpStatusCode::kHttpOk, "OK", {}, "web content");
+
+  ASSERT_TRUE(client().GetResponse(*request).ok());
+
+  EXPECT_EQ(GetWebRequest().timeout, absl::Seconds(5));
+}
+
+TEST_F(NearbyHttpClientTest, TestRequestsRunConcurrentlyAsync) {
+  absl::StatusOr<HttpRequest> request =
+      MakeHttpRequest("http://www.google.com", HttpRequestMethod::kGet, {}, "");
+  ASSERT_TRUE(request.ok());
+  MockResponse(HttpStatusCode::kHttpOk, "OK", {}, "web content");
+  api::GetContext()->api_time = absl::Milliseconds(200);
+  absl::BlockingCounter done(NearbyHttpClient::kDefaultMaxConcurrentRequests);
+
+  for (int i = 0; i < NearbyHttpClient::kDefaultMaxConcurrentRequests; ++i) {
+    client().StartRequest(
+        *request,
+        [&done](const absl::StatusOr<HttpResponse>&) { done.DecrementCount(); });
+  }
+  done.Wait();
+
+  EXPECT_GT(api::GetContext()->max_requests_in_flight, 1);
+}
+
 TEST_F(NearbyHttpClientTest, TestCancellableRequestAsync) {
   absl::StatusOr<HttpRequest> request =
       MakeHttpRequest("http://www.google.com", HttpRequestMethod::kGet, {}, "");
@@ -345,6 +398,7 @@ TEST_F(NearbyHttpClientTest, TestCancellableRequestAsync) {
   api::WebRequest web_request = GetWebRequest();
   EXPECT_EQ(web_request.url, "http://www.google.com");
   EXPECT_EQ(web_request.method, "GET");
+  EXPECT_TRUE(web_request.is_cancelled != nullptr);
 
   // Checks response.
   ASSERT_TRUE(result.ok());
@@ -19,6 +19,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace nearby {
 namespace network {
@@ -98,5 +99,9 @@ void HttpRequest::SetBody(absl::string_view body) {
 
 const HttpRequestBody& HttpRequest::GetBody() const { return body_; }
 
+void HttpRequest::SetTimeout(absl::Duration timeout) { timeout_ = timeout; }
+
+absl::Duration HttpRequest::GetTimeout() const { return timeout_; }
+
 }  // namespace network
 }  // namespace nearby
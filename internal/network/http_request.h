@@ -21,6 +21,7 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "internal/network/http_body.h"
 #include "internal/network/url.h"
 
@@ -70,6 +71,10 @@ class HttpRequest {
   void SetBody(absl::string_view body);
   const HttpRequestBody& GetBody() const;
 
+  // The request fails with a deadline exceeded error when it takes longer.
+  void SetTimeout(absl::Duration timeout);
+  absl::Duration GetTimeout() const;
+
  private:
   // The url of the request
   Url url_;
@@ -82,6 +87,9 @@ class HttpRequest {
 
   // The request body, it may be empty.
   HttpRequestBody body_;
+
+  // Time allowed for the whole request, including the response body.
+  absl::Duration timeout_ = absl::InfiniteDuration();
 };
 
 }  // namespace network
@@ -99,6 +99,11 @@ class ByteArray {
     return absl::string_view(data(), size());
   }
 
+  // Returns a reference to the internal representation as std::string.
+  // Unlike string_data(), no copy is made; the reference is valid for as long
+  // as this ByteArray is alive and unmodified.
+  const std::string& AsStringRef() const { return data_; }
+
   // Hashable
   template <typename H>
   friend H AbslHashValue(H h, const ByteArray& m) {
@@ -97,6 +97,15 @@ TEST(ByteArrayTest, CreateFromAbslStringReturnsTheSame) {
   EXPECT_EQ(bytes.AsStringView(), kTestString);
 }
 
+TEST(ByteArrayTest, AsStringRefAliasesInternalData) {
+  const absl::string_view kTestString = "Test String";
+  ByteArray bytes{std::string(kTestString)};
+
+  const std::string& ref = bytes.AsStringRef();
+  EXPECT_EQ(ref, kTestString);
+  EXPECT_EQ(ref.data(), bytes.data());
+}
+
 TEST(ByteArrayTest, Hash) {
   EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly({
       ByteArray(),
@@ -75,6 +75,11 @@ Exception OutputFile::Flush() { return impl_->Flush(); }
 // associated with it.
 Exception OutputFile::Close() { return impl_->Close(); }
 
+// Reserves space for |size| bytes of data, if the platform supports it.
+Exception OutputFile::Preallocate(std::int64_t size) {
+  return impl_->Preallocate(size);
+}
+
 // Returns a handle to the underlying  output stream.
 //
 // Returned handle will remain valid even if OutputFile is moved, for as long
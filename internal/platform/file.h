@@ -89,6 +89,10 @@ class OutputFile final {
   // associated with it.
   Exception Close();
 
+  // Reserves space for |size| bytes of data, if the platform supports it.
+  // Returns Exception::kIo on error, Exception::kSuccess otherwise.
+  Exception Preallocate(std::int64_t size);
+
   // Returns a handle to the underlying  output stream.
   //
   // Returned handle will remain valid even if OutputFile is moved, for as long
@@ -65,6 +65,12 @@ constexpr auto kWifiHotspotConnectionIntervalMillis =
 constexpr auto kWifiHotspotConnectionTimeoutMillis =
     flags::Flag<int64_t>(kConfigPackage, "45415888", 10000);
 
+// When true, files received on Linux start writeback of every batch as soon as
+// it is written and drop it from the page cache once it is on disk, instead of
+// leaving the whole file dirty in memory until it is closed.
+constexpr auto kEnableFileWriteBehindSync =
+    flags::Flag<bool>(kConfigPackage, "45415889", false);
+
 }  // namespace nearby_platform_feature
 }  // namespace config_package_nearby
 }  // namespace platform
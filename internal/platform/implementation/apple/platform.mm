@@ -154,6 +154,8 @@ std::unique_ptr<ScheduledExecutor> ImplementationPlatform::CreateScheduledExecut
   return std::make_unique<apple::ScheduledExecutor>();
 }
 
+std::unique_ptr<IoReactor> ImplementationPlatform::CreateIoReactor() { return nullptr; }
+
 // Mediums
 std::unique_ptr<BluetoothAdapter> ImplementationPlatform::CreateBluetoothAdapter() {
   return std::make_unique<apple::BluetoothAdapter>();
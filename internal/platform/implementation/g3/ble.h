@@ -38,8 +38,10 @@ class BleMedium;
 
 class BleSocket : public api::BleSocket, public SocketBase {
  public:
-  BleSocket() = default;
-  explicit BleSocket(BlePeripheral* peripheral) : peripheral_(peripheral) {}
+  BleSocket() : SocketBase(location::nearby::proto::connections::BLE) {}
+  explicit BleSocket(BlePeripheral* peripheral)
+      : SocketBase(location::nearby::proto::connections::BLE),
+        peripheral_(peripheral) {}
 
   // Returns the InputStream of this connected BleSocket.
   InputStream& GetInputStream() override {
@@ -52,7 +52,9 @@ class BleV2Peripheral : public api::ble_v2::BlePeripheral {
 
 class BleV2Socket : public api::ble_v2::BleSocket, public SocketBase {
  public:
-  explicit BleV2Socket(BluetoothAdapter* adapter) : adapter_(adapter) {}
+  explicit BleV2Socket(BluetoothAdapter* adapter)
+      : SocketBase(location::nearby::proto::connections::BLE),
+        adapter_(adapter) {}
 
   // Returns the InputStream of this connected BleSocket.
   InputStream& GetInputStream() override {
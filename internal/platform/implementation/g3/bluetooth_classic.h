@@ -37,8 +37,11 @@ namespace g3 {
 // https://developer.android.com/reference/android/bluetooth/BluetoothSocket.html.
 class BluetoothSocket : public api::BluetoothSocket, public SocketBase {
  public:
-  BluetoothSocket() = default;
-  explicit BluetoothSocket(BluetoothAdapter* adapter) : adapter_(adapter) {}
+  BluetoothSocket()
+      : SocketBase(location::nearby::proto::connections::BLUETOOTH) {}
+  explicit BluetoothSocket(BluetoothAdapter* adapter)
+      : SocketBase(location::nearby::proto::connections::BLUETOOTH),
+        adapter_(adapter) {}
 
   // Returns the InputStream of this connected BluetoothSocket.
   InputStream& GetInputStream() override {
@@ -102,6 +102,10 @@ ImplementationPlatform::CreateScheduledExecutor() {
   return std::make_unique<g3::ScheduledExecutor>();
 }
 
+std::unique_ptr<IoReactor> ImplementationPlatform::CreateIoReactor() {
+  return nullptr;
+}
+
 std::unique_ptr<AtomicUint32> ImplementationPlatform::CreateAtomicUint32(
     std::uint32_t value) {
   return std::make_unique<g3::AtomicUint32>(value);
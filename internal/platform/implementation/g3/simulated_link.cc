@@ -0,0 +1,212 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/g3/simulated_link.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
+#include "internal/platform/medium_environment.h"
+#include "internal/platform/output_stream.h"
+
+namespace nearby {
+namespace g3 {
+
+namespace {
+
+class LinkInputStream : public InputStream {
+ public:
+  explicit LinkInputStream(std::shared_ptr<SimulatedLink> link)
+      : link_(std::move(link)) {}
+  ~LinkInputStream() override { link_->CloseInput(); }
+
+  ExceptionOr<ByteArray> Read(std::int64_t size) override {
+    return link_->Read(size);
+  }
+  Exception Close() override {
+    link_->CloseInput();
+    return {Exception::kSuccess};
+  }
+
+ private:
+  std::shared_ptr<SimulatedLink> link_;
+};
+
+class LinkOutputStream : public OutputStream {
+ public:
+  explicit LinkOutputStream(std::shared_ptr<SimulatedLink> link)
+      : link_(std::move(link)) {}
+  ~LinkOutputStream() override { link_->CloseOutput(); }
+
+  Exception Write(const ByteArray& data) override { return link_->Write(data); }
+  Exception Flush() override { return {Exception::kSuccess}; }
+  Exception Close() override {
+    link_->CloseOutput();
+    return {Exception::kSuccess};
+  }
+
+ private:
+  std::shared_ptr<SimulatedLink> link_;
+};
+
+}  // namespace
+
+std::unique_ptr<InputStream> SimulatedLink::CreateInputStream(
+    std::shared_ptr<SimulatedLink> link) {
+  return std::make_unique<LinkInputStream>(std::move(link));
+}
+
+std::unique_ptr<OutputStream> SimulatedLink::CreateOutputStream(
+    std::shared_ptr<SimulatedLink> link) {
+  return std::make_unique<LinkOutputStream>(std::move(link));
+}
+
+void SimulatedLink::SetModel(const LinkModel& model, std::uint64_t seed) {
+  absl::MutexLock lock(&mutex_);
+  SetModelLocked(model, seed);
+}
+
+void SimulatedLink::SetModelIfUnset(const LinkModel& model,
+                                    std::uint64_t seed) {
+  absl::MutexLock lock(&mutex_);
+  if (!model_.has_value()) SetModelLocked(model, seed);
+}
+
+void SimulatedLink::SetModelLocked(const LinkModel& model,
+                                   std::uint64_t seed) {
+  model_ = model;
+  random_.seed(seed);
+  // The link starts idle, with a full bucket.
+  tokens_ = model.burst_bytes;
+  refilled_at_ = absl::Now();
+}
+
+ExceptionOr<ByteArray> SimulatedLink::Read(std::int64_t size) {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    if (input_closed_) return ExceptionOr<ByteArray>{ByteArray{}};
+    if (!packets_.empty()) {
+      absl::Time deliver_at = packets_.front().deliver_at;
+      if (deliver_at <= absl::Now()) break;
+      cond_.WaitWithDeadline(&mutex_, deliver_at);
+    } else if (output_closed_) {
+      // Everything written before the output was closed has been read.
+      return ExceptionOr<ByteArray>{ByteArray{}};
+    } else {
+      cond_.Wait(&mutex_);
+    }
+  }
+
+  Packet& packet = packets_.front();
+  std::size_t remaining = packet.data.size() - front_offset_;
+  if (front_offset_ == 0 && remaining <= static_cast<std::size_t>(size)) {
+    ByteArray data = std::move(packet.data);
+    packets_.pop_front();
+    return ExceptionOr<ByteArray>{std::move(data)};
+  }
+  // Serve the rest of the packet on the next Read(), without moving it.
+  std::size_t length = std::min(remaining, static_cast<std::size_t>(size));
+  ByteArray data(packet.data.data() + front_offset_, length);
+  front_offset_ += length;
+  if (front_offset_ == packet.data.size()) {
+    packets_.pop_front();
+    front_offset_ = 0;
+  }
+  return ExceptionOr<ByteArray>{std::move(data)};
+}
+
+Exception SimulatedLink::Write(const ByteArray& data) {
+  absl::Time sent = absl::InfinitePast();
+  {
+    absl::MutexLock lock(&mutex_);
+    if (input_closed_ || output_closed_) return {Exception::kIo};
+    if (data.Empty()) return {Exception::kSuccess};
+    if (!model_.has_value()) {
+      packets_.push_back({.deliver_at = absl::InfinitePast(), .data = data});
+      cond_.SignalAll();
+      return {Exception::kSuccess};
+    }
+
+    absl::Time now = absl::Now();
+    std::size_t packet_size = model_->mtu > 0 ? model_->mtu : data.size();
+    for (std::size_t offset = 0; offset < data.size(); offset += packet_size) {
+      std::size_t length = std::min(packet_size, data.size() - offset);
+      sent = TransmitLocked(length, now);
+      // A packet never overtakes the one sent before it.
+      last_delivery_ =
+          std::max(sent + PropagationDelayLocked(), last_delivery_);
+      packets_.push_back({.deliver_at = last_delivery_,
+                          .data = ByteArray(data.data() + offset, length)});
+    }
+    cond_.SignalAll();
+  }
+  // The writer is busy until the last packet is on the wire.
+  absl::SleepFor(sent - absl::Now());
+  return {Exception::kSuccess};
+}
+
+void SimulatedLink::CloseInput() {
+  absl::MutexLock lock(&mutex_);
+  input_closed_ = true;
+  cond_.SignalAll();
+}
+
+void SimulatedLink::CloseOutput() {
+  absl::MutexLock lock(&mutex_);
+  output_closed_ = true;
+  cond_.SignalAll();
+}
+
+absl::Time SimulatedLink::TransmitLocked(std::size_t size, absl::Time now) {
+  if (model_->bandwidth_bytes_per_second <= 0) return now;
+  double rate = model_->bandwidth_bytes_per_second;
+  tokens_ = std::min(static_cast<double>(model_->burst_bytes),
+                     tokens_ + absl::ToDoubleSeconds(now - refilled_at_) * rate);
+  refilled_at_ = now;
+  // The bucket goes into debt for packets sent before it refilled; they leave
+  // once the debt is paid back.
+  tokens_ -= size;
+  if (tokens_ >= 0) return now;
+  return now + absl::Seconds(-tokens_ / rate);
+}
+
+absl::Duration SimulatedLink::PropagationDelayLocked() {
+  absl::Duration delay = model_->latency;
+  if (model_->jitter > absl::ZeroDuration()) {
+    delay += model_->jitter * NextRandomLocked();
+  }
+  if (model_->loss_probability > 0 &&
+      NextRandomLocked() < model_->loss_probability) {
+    delay += model_->loss_stall;
+  }
+  return delay;
+}
+
+double SimulatedLink::NextRandomLocked() {
+  // Not std::uniform_real_distribution, whose output differs between standard
+  // libraries; the top 53 bits give the same double everywhere.
+  return (random_() >> 11) * 0x1.0p-53;
+}
+
+}  // namespace g3
+}  // namespace nearby
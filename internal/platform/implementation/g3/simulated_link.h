@@ -0,0 +1,101 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_INTERNAL_PLATFORM_IMPLEMENTATION_G3_SIMULATED_LINK_H_
+#define THIRD_PARTY_NEARBY_INTERNAL_PLATFORM_IMPLEMENTATION_G3_SIMULATED_LINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <random>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
+#include "internal/platform/medium_environment.h"
+#include "internal/platform/output_stream.h"
+
+namespace nearby {
+namespace g3 {
+
+// One direction of a simulated socket connection. Bytes written to the output
+// stream come out of the input stream, shaped by a LinkModel.
+//
+// Without a model the link behaves like CreatePipe(). With a model, Write()
+// blocks while the data is on the wire at the modelled bandwidth, and Read()
+// blocks until the packet at the head of the link has crossed the modelled
+// delay. Packets are delivered in the order they were written. Timing follows
+// the real clock, not the simulated one.
+class SimulatedLink {
+ public:
+  // Returns the two ends of `link`. Each of them keeps the link alive.
+  static std::unique_ptr<InputStream> CreateInputStream(
+      std::shared_ptr<SimulatedLink> link);
+  static std::unique_ptr<OutputStream> CreateOutputStream(
+      std::shared_ptr<SimulatedLink> link);
+
+  // Shapes data written from now on. Jitter and loss draw from a generator
+  // seeded with `seed`, so the same writes see the same delays on every run.
+  void SetModel(const LinkModel& model, std::uint64_t seed)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Same as SetModel(), unless the link already has a model.
+  void SetModelIfUnset(const LinkModel& model, std::uint64_t seed)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  ExceptionOr<ByteArray> Read(std::int64_t size) ABSL_LOCKS_EXCLUDED(mutex_);
+  Exception Write(const ByteArray& data) ABSL_LOCKS_EXCLUDED(mutex_);
+  void CloseInput() ABSL_LOCKS_EXCLUDED(mutex_);
+  void CloseOutput() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Packet {
+    absl::Time deliver_at;
+    ByteArray data;
+  };
+
+  void SetModelLocked(const LinkModel& model, std::uint64_t seed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Takes `size` bytes from the token bucket and returns when the last of
+  // them leaves the sender.
+  absl::Time TransmitLocked(std::size_t size, absl::Time now)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the delay from sending a packet to delivering it.
+  absl::Duration PropagationDelayLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns a uniformly distributed number in [0, 1).
+  double NextRandomLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  absl::Mutex mutex_;
+  absl::CondVar cond_;
+  std::optional<LinkModel> model_ ABSL_GUARDED_BY(mutex_);
+  std::mt19937_64 random_ ABSL_GUARDED_BY(mutex_);
+  double tokens_ ABSL_GUARDED_BY(mutex_) = 0;
+  absl::Time refilled_at_ ABSL_GUARDED_BY(mutex_);
+  absl::Time last_delivery_ ABSL_GUARDED_BY(mutex_) = absl::InfinitePast();
+  std::deque<Packet> packets_ ABSL_GUARDED_BY(mutex_);
+  // How much of the front packet has already been read.
+  std::size_t front_offset_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool input_closed_ ABSL_GUARDED_BY(mutex_) = false;
+  bool output_closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace g3
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_INTERNAL_PLATFORM_IMPLEMENTATION_G3_SIMULATED_LINK_H_
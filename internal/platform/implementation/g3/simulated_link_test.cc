@@ -0,0 +1,148 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/g3/simulated_link.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/input_stream.h"
+#include "internal/platform/medium_environment.h"
+#include "internal/platform/output_stream.h"
+
+namespace nearby {
+namespace g3 {
+namespace {
+
+class SimulatedLinkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    input_ = SimulatedLink::CreateInputStream(link_);
+    output_ = SimulatedLink::CreateOutputStream(link_);
+  }
+
+  // Writes `data` and returns how long it takes to read it back.
+  absl::Duration TimeTransfer(const std::string& data) {
+    absl::Time start = absl::Now();
+    EXPECT_TRUE(output_->Write(ByteArray(data)).Ok());
+    std::string received;
+    while (received.size() < data.size()) {
+      ExceptionOr<ByteArray> chunk = input_->Read(data.size());
+      if (!chunk.ok() || chunk.result().Empty()) break;
+      received += std::string(chunk.result());
+    }
+    EXPECT_EQ(received, data);
+    return absl::Now() - start;
+  }
+
+  std::shared_ptr<SimulatedLink> link_ = std::make_shared<SimulatedLink>();
+  std::unique_ptr<InputStream> input_;
+  std::unique_ptr<OutputStream> output_;
+};
+
+TEST_F(SimulatedLinkTest, PassesDataWithoutModel) {
+  EXPECT_TRUE(output_->Write(ByteArray("abc")).Ok());
+  EXPECT_TRUE(output_->Write(ByteArray("def")).Ok());
+
+  EXPECT_EQ(std::string(input_->Read(10).result()), "abc");
+  EXPECT_EQ(std::string(input_->Read(10).result()), "def");
+}
+
+TEST_F(SimulatedLinkTest, ReadSplitsPacket) {
+  EXPECT_TRUE(output_->Write(ByteArray("abcdef")).Ok());
+
+  EXPECT_EQ(std::string(input_->Read(4).result()), "abcd");
+  EXPECT_EQ(std::string(input_->Read(4).result()), "ef");
+}
+
+TEST_F(SimulatedLinkTest, SmallReadsDrainPacketInOrder) {
+  EXPECT_TRUE(output_->Write(ByteArray("abcdefg")).Ok());
+  EXPECT_TRUE(output_->Write(ByteArray("hij")).Ok());
+
+  EXPECT_EQ(std::string(input_->Read(3).result()), "abc");
+  EXPECT_EQ(std::string(input_->Read(3).result()), "def");
+  EXPECT_EQ(std::string(input_->Read(3).result()), "g");
+  EXPECT_EQ(std::string(input_->Read(3).result()), "hij");
+}
+
+TEST_F(SimulatedLinkTest, ClosedOutputEndsStreamAfterQueuedData) {
+  EXPECT_TRUE(output_->Write(ByteArray("abc")).Ok());
+  output_->Close();
+
+  EXPECT_EQ(std::string(input_->Read(10).result()), "abc");
+  ExceptionOr<ByteArray> end = input_->Read(10);
+  ASSERT_TRUE(end.ok());
+  EXPECT_TRUE(end.result().Empty());
+}
+
+TEST_F(SimulatedLinkTest, WriteFailsAfterInputClosed) {
+  input_->Close();
+
+  EXPECT_EQ(output_->Write(ByteArray("abc")).value, Exception::kIo);
+}
+
+TEST_F(SimulatedLinkTest, MtuSplitsWrites) {
+  link_->SetModel({.mtu = 4}, /*seed=*/0);
+  EXPECT_TRUE(output_->Write(ByteArray("abcdefghij")).Ok());
+
+  EXPECT_EQ(std::string(input_->Read(10).result()), "abcd");
+  EXPECT_EQ(std::string(input_->Read(10).result()), "efgh");
+  EXPECT_EQ(std::string(input_->Read(10).result()), "ij");
+}
+
+TEST_F(SimulatedLinkTest, LatencyDelaysDelivery) {
+  link_->SetModel({.latency = absl::Milliseconds(100)}, /*seed=*/0);
+
+  EXPECT_GE(TimeTransfer("abc"), absl::Milliseconds(100));
+}
+
+TEST_F(SimulatedLinkTest, BandwidthLimitsThroughput) {
+  // 20 KB at 100 KB/s, of which 10 KB go out as a burst.
+  link_->SetModel(
+      {.bandwidth_bytes_per_second = 100 * 1024, .burst_bytes = 10 * 1024},
+      /*seed=*/0);
+
+  EXPECT_GE(TimeTransfer(std::string(20 * 1024, 'a')),
+            absl::Milliseconds(100));
+}
+
+TEST_F(SimulatedLinkTest, LossStallsDelivery) {
+  link_->SetModel(
+      {.loss_probability = 1, .loss_stall = absl::Milliseconds(100)},
+      /*seed=*/0);
+
+  EXPECT_GE(TimeTransfer("abc"), absl::Milliseconds(100));
+}
+
+TEST_F(SimulatedLinkTest, JitterKeepsPacketsInOrder) {
+  link_->SetModel({.jitter = absl::Milliseconds(50), .mtu = 1}, /*seed=*/42);
+
+  TimeTransfer("abcdefghijklmnopqrstuvwxyz");
+}
+
+TEST_F(SimulatedLinkTest, ModelIfUnsetKeepsExistingModel) {
+  link_->SetModel({.latency = absl::ZeroDuration()}, /*seed=*/0);
+  link_->SetModelIfUnset({.latency = absl::Seconds(10)}, /*seed=*/0);
+
+  EXPECT_LT(TimeTransfer("abc"), absl::Seconds(10));
+}
+
+}  // namespace
+}  // namespace g3
+}  // namespace nearby
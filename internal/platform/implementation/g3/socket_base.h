@@ -18,24 +18,33 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <tuple>
+#include <optional>
 #include <utility>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
+#include "internal/platform/implementation/g3/simulated_link.h"
 #include "internal/platform/input_stream.h"
+#include "internal/platform/medium_environment.h"
 #include "internal/platform/output_stream.h"
-#include "internal/platform/pipe.h"
+#include "proto/connections_enums.pb.h"
 
 namespace nearby {
 namespace g3 {
 
 // Common base for BT, BLE and Wifi socket implementations.
+//
+// Data sent to the peer goes over a SimulatedLink, which is shaped by the
+// LinkModel that MediumEnvironment holds for the socket's medium.
 class SocketBase {
  public:
-  SocketBase() { std::tie(input_for_remote_, output_) = CreatePipe(); }
+  explicit SocketBase(location::nearby::proto::connections::Medium medium)
+      : medium_(medium), outgoing_link_(std::make_shared<SimulatedLink>()) {
+    output_ = SimulatedLink::CreateOutputStream(outgoing_link_);
+    input_for_remote_ = SimulatedLink::CreateInputStream(outgoing_link_);
+  }
   virtual ~SocketBase() {
     absl::MutexLock lock(&mutex_);
     DoClose();
@@ -47,6 +56,33 @@ class SocketBase {
     absl::MutexLock lock(&mutex_);
     remote_socket_ = &other;
     input_ = std::move(other.input_for_remote_);
+    incoming_link_ = other.outgoing_link_;
+    // Each side shapes the link it reads from, so our outgoing link is shaped
+    // when the remote side connects to us.
+    MediumEnvironment& environment = MediumEnvironment::Instance();
+    if (pending_incoming_model_.has_value()) {
+      incoming_link_->SetModel(*pending_incoming_model_,
+                               environment.NextLinkSeed());
+      pending_incoming_model_.reset();
+    } else if (std::optional<LinkModel> model =
+                   environment.GetLinkModel(medium_);
+               model.has_value()) {
+      incoming_link_->SetModelIfUnset(*model, environment.NextLinkSeed());
+    }
+  }
+
+  // Shapes both directions of this connection with `model`, instead of the
+  // model set for the medium. Applies to data written from now on; call it
+  // before Connect() to shape the whole connection.
+  void SetLinkModel(const LinkModel& model) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    MediumEnvironment& environment = MediumEnvironment::Instance();
+    outgoing_link_->SetModel(model, environment.NextLinkSeed());
+    if (incoming_link_) {
+      incoming_link_->SetModel(model, environment.NextLinkSeed());
+    } else {
+      pending_incoming_model_ = model;
+    }
   }
 
   // Returns the InputStream of this connected socket.
@@ -146,6 +182,12 @@ class SocketBase {
   // give this stream to the remote socket when they connect to us, and it
   // becomes their `input_` stream.
   std::unique_ptr<InputStream> input_for_remote_;
+  const location::nearby::proto::connections::Medium medium_;
+  // The link behind `output_` and the one behind `input_`, once connected.
+  std::shared_ptr<SimulatedLink> outgoing_link_;
+  std::shared_ptr<SimulatedLink> incoming_link_ ABSL_GUARDED_BY(mutex_);
+  // Set by SetLinkModel() before Connect().
+  std::optional<LinkModel> pending_incoming_model_ ABSL_GUARDED_BY(mutex_);
   SocketBase* remote_socket_ ABSL_GUARDED_BY(mutex_) = nullptr;
   bool closed_ ABSL_GUARDED_BY(mutex_) = false;
 };
@@ -37,6 +37,9 @@ class WifiLanMedium;
 
 class WifiLanSocket : public api::WifiLanSocket, public SocketBase {
  public:
+  WifiLanSocket()
+      : SocketBase(location::nearby::proto::connections::WIFI_LAN) {}
+
   // Returns the InputStream of this connected WifiLanSocket.
   InputStream& GetInputStream() override {
     return SocketBase::GetInputStream();
@@ -15,9 +15,12 @@
 #ifndef THIRD_PARTY_NEARBY_INTERNAL_PLATFORM_IMPLEMENTATION_HTTP_LOADER_H_
 #define THIRD_PARTY_NEARBY_INTERNAL_PLATFORM_IMPLEMENTATION_HTTP_LOADER_H_
 
+#include <functional>
 #include <map>
 #include <string>
 
+#include "absl/time/time.h"
+
 namespace nearby {
 namespace api {
 
@@ -26,6 +29,12 @@ struct WebRequest {
   std::string method;
   std::multimap<std::string, std::string> headers;
   std::string body;
+  // The request fails with a deadline exceeded error when it takes longer.
+  // Platforms that cannot bound a request ignore it.
+  absl::Duration timeout = absl::InfiniteDuration();
+  // Polled while the request is in flight; the request is abandoned with a
+  // cancelled error once it returns true. May be empty.
+  std::function<bool()> is_cancelled;
 };
 
 struct WebResponse {
@@ -0,0 +1,64 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_API_IO_REACTOR_H_
+#define PLATFORM_API_IO_REACTOR_H_
+
+#include <cstdint>
+
+#include "absl/functional/any_invocable.h"
+
+namespace nearby {
+namespace api {
+
+// Multiplexes read readiness of many file descriptors onto a single thread, so
+// that idle connections do not each need a thread blocked in Read().
+//
+// Watches are one-shot: once `on_readable` has been invoked for a watch, it
+// is not invoked again until Rearm() is called. This lets callers hand the
+// actual read off to another thread while still guaranteeing that a single
+// descriptor is never processed by two threads at once.
+class IoReactor {
+ public:
+  using WatchId = std::uint64_t;
+  static constexpr WatchId kInvalidWatchId = 0;
+
+  virtual ~IoReactor() = default;
+
+  // Starts watching `fd` for readability (including end of stream and errors).
+  // `on_readable` runs on the reactor thread and must not block.
+  // The reactor keeps its own reference to `fd`, so the watch stays valid even
+  // if the caller closes its copy; it then reports the descriptor as readable
+  // once the peer or a local shutdown ends the stream.
+  //
+  // Returns kInvalidWatchId if `fd` could not be watched.
+  virtual WatchId Watch(int fd, absl::AnyInvocable<void()> on_readable) = 0;
+
+  // Re-enables a watch after its callback has fired.
+  // Returns false if `watch_id` is unknown or could not be re-armed.
+  virtual bool Rearm(WatchId watch_id) = 0;
+
+  // Stops a watch. Once this returns, the callback for `watch_id` is not
+  // running (unless Unwatch() is called from that callback) and will not be
+  // invoked again.
+  virtual void Unwatch(WatchId watch_id) = 0;
+
+  // Stops the reactor thread and drops all watches.
+  virtual void Shutdown() = 0;
+};
+
+}  // namespace api
+}  // namespace nearby
+
+#endif  // PLATFORM_API_IO_REACTOR_H_
@@ -14,6 +14,7 @@
 
 #include <sys/poll.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <array>
 #include <cerrno>
@@ -73,6 +74,11 @@ ExceptionOr<ByteArray> BluetoothInputStream::Read(std::int64_t size) {
                          << std::strerror(errno);
       return {Exception::kIo};
     }
+    if (bytes_read == 0) {
+      NEARBY_LOGS(ERROR) << __func__
+                         << ": bluetooth socket reached end of stream";
+      return {Exception::kIo};
+    }
     total_read += bytes_read;
   }
 
@@ -81,6 +87,7 @@ ExceptionOr<ByteArray> BluetoothInputStream::Read(std::int64_t size) {
 
 Exception BluetoothInputStream::Close() {
   if (!fd_.isValid()) return {Exception::kIo};
+  shutdown(fd_.get(), SHUT_RD);
   fd_.reset();
   return {Exception::kSuccess};
 }
@@ -113,8 +120,57 @@ Exception BluetoothOutputStream::Write(const ByteArray &data) {
   return {Exception::kSuccess};
 }
 
+Exception BluetoothOutputStream::GatherWrite(
+    absl::Span<const ByteArray *const> buffers) {
+  constexpr size_t kMaxGatherBuffers = 8;
+  if (buffers.size() > kMaxGatherBuffers) {
+    return nearby::OutputStream::GatherWrite(buffers);
+  }
+  if (!fd_.isValid()) return Exception{Exception::kIo};
+
+  std::array<iovec, kMaxGatherBuffers> iov;
+  size_t iov_count = 0;
+  for (const ByteArray *buffer : buffers) {
+    if (buffer->Empty()) continue;
+    iov[iov_count].iov_base = const_cast<char *>(buffer->data());
+    iov[iov_count].iov_len = buffer->size();
+    ++iov_count;
+  }
+
+  auto poller = Poller::CreateOutputPoller(fd_);
+
+  iovec *pending = iov.data();
+  while (iov_count > 0) {
+    auto result = poller.Ready();
+    if (result.Raised()) return result;
+
+    auto wrote = writev(fd_.get(), pending, iov_count);
+    if (wrote < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) continue;
+      NEARBY_LOGS(ERROR) << __func__
+                         << ": error writing data on bluetooth socket: "
+                         << std::strerror(errno);
+      return {Exception::kIo};
+    }
+
+    size_t remaining = wrote;
+    while (iov_count > 0 && remaining >= pending->iov_len) {
+      remaining -= pending->iov_len;
+      ++pending;
+      --iov_count;
+    }
+    if (iov_count > 0) {
+      pending->iov_base = static_cast<char *>(pending->iov_base) + remaining;
+      pending->iov_len -= remaining;
+    }
+  }
+
+  return {Exception::kSuccess};
+}
+
 Exception BluetoothOutputStream::Close() {
   if (!fd_.isValid()) return {Exception::kIo};
+  shutdown(fd_.get(), SHUT_WR);
   fd_.reset();
   return {Exception::kSuccess};
 }
@@ -22,6 +22,7 @@
 #include <sys/poll.h>
 #include <systemd/sd-bus.h>
 
+#include "absl/types/span.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/bluetooth_classic.h"
 #include "internal/platform/input_stream.h"
@@ -63,6 +64,9 @@ class BluetoothInputStream final : public nearby::InputStream {
 
   ExceptionOr<ByteArray> Read(std::int64_t size) override;
   Exception Close() override;
+  int GetReadinessFd() const override {
+    return fd_.isValid() ? fd_.get() : -1;
+  }
 
  private:
   sdbus::UnixFd fd_;
@@ -73,6 +77,7 @@ class BluetoothOutputStream : public nearby::OutputStream {
   explicit BluetoothOutputStream(sdbus::UnixFd fd) : fd_(std::move(fd)){};
 
   Exception Write(const ByteArray &data) override;
+  Exception GatherWrite(absl::Span<const ByteArray *const> buffers) override;
   Exception Flush() override {return {Exception::kSuccess};}
   Exception Close() override;
 
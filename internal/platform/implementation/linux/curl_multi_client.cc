@@ -0,0 +1,374 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/curl_multi_client.h"
+
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "internal/platform/implementation/http_loader.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+constexpr size_t kMaxRequestBodySize = 8 * 1024 * 1024;
+
+// How often running transfers are checked for cancellation when no socket is
+// active.
+constexpr int kPollIntervalMillis = 100;
+
+absl::Status HttpCodeToStatus(int status_code,
+                              absl::string_view status_message) {
+  switch (status_code) {
+    case 400:
+      return absl::InvalidArgumentError(status_message);
+    case 401:
+      return absl::UnauthenticatedError(status_message);
+    case 403:
+      return absl::PermissionDeniedError(status_message);
+    case 404:
+      return absl::NotFoundError(status_message);
+    case 409:
+      return absl::AbortedError(status_message);
+    case 416:
+      return absl::OutOfRangeError(status_message);
+    case 429:
+      return absl::ResourceExhaustedError(status_message);
+    case 499:
+      return absl::CancelledError(status_message);
+    case 504:
+      return absl::DeadlineExceededError(status_message);
+    case 501:
+      return absl::UnimplementedError(status_message);
+    case 503:
+      return absl::UnavailableError(status_message);
+    default:
+      break;
+  }
+  if (status_code >= 200 && status_code < 300) {
+    return absl::OkStatus();
+  } else if (status_code >= 400 && status_code < 500) {
+    return absl::FailedPreconditionError(status_message);
+  } else if (status_code >= 500 && status_code < 600) {
+    return absl::InternalError(status_message);
+  }
+  return absl::UnknownError(status_message);
+}
+
+absl::Status CurlCodeToStatus(CURLcode code, const char* error) {
+  std::string message =
+      absl::StrCat(curl_easy_strerror(code), error[0] == '\0' ? "" : ": ",
+                   error);
+  switch (code) {
+    case CURLE_OPERATION_TIMEDOUT:
+      return absl::DeadlineExceededError(message);
+    case CURLE_ABORTED_BY_CALLBACK:
+      return absl::CancelledError(message);
+    case CURLE_UNSUPPORTED_PROTOCOL:
+    case CURLE_URL_MALFORMAT:
+      return absl::InvalidArgumentError(message);
+    default:
+      return absl::UnavailableError(message);
+  }
+}
+
+size_t WriteBody(char* data, size_t size, size_t count, void* user_data) {
+  static_cast<api::WebResponse*>(user_data)->body.append(data, size * count);
+  return size * count;
+}
+
+// Called once per header line, including the status line of every response
+// when redirects are followed; only the last response is kept.
+size_t WriteHeader(char* data, size_t size, size_t count, void* user_data) {
+  auto* response = static_cast<api::WebResponse*>(user_data);
+  absl::string_view line =
+      absl::StripAsciiWhitespace(absl::string_view(data, size * count));
+  if (absl::StartsWith(line, "HTTP/")) {
+    response->headers.clear();
+    response->status_text.clear();
+    // "HTTP/1.1 200 OK"; HTTP/2 responses have no reason phrase.
+    size_t code_start = line.find(' ');
+    if (code_start != absl::string_view::npos) {
+      absl::string_view status = line.substr(code_start + 1);
+      size_t text_start = status.find(' ');
+      if (text_start != absl::string_view::npos) {
+        response->status_text = std::string(status.substr(text_start + 1));
+      }
+    }
+    return size * count;
+  }
+  size_t colon = line.find(':');
+  if (colon != absl::string_view::npos) {
+    response->headers.emplace(
+        std::string(absl::StripAsciiWhitespace(line.substr(0, colon))),
+        std::string(absl::StripAsciiWhitespace(line.substr(colon + 1))));
+  }
+  return size * count;
+}
+
+// Must run before the first curl handle is created; curl counts the calls.
+CURLM* CreateMultiHandle() {
+  curl_global_init(CURL_GLOBAL_DEFAULT);
+  return curl_multi_init();
+}
+
+}  // namespace
+
+struct CurlMultiClient::Transfer {
+  ~Transfer() {
+    if (handle != nullptr) curl_easy_cleanup(handle);
+    if (headers != nullptr) curl_slist_free_all(headers);
+  }
+
+  api::WebRequest request;
+  Callback callback;
+  CURL* handle = nullptr;
+  curl_slist* headers = nullptr;
+  api::WebResponse response{};
+  char error[CURL_ERROR_SIZE] = {};
+};
+
+CurlMultiClient::CurlMultiClient(const Options& options)
+    : multi_(CreateMultiHandle()),
+      share_(curl_share_init()) {
+  curl_multi_setopt(multi_, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                    static_cast<long>(options.max_concurrent_requests));
+  curl_multi_setopt(multi_, CURLMOPT_MAXCONNECTS,
+                    static_cast<long>(options.max_cached_connections));
+  // Handles of one multi handle already share connections and DNS entries;
+  // TLS sessions have to be shared explicitly so that new connections to a
+  // known host can resume them. All handles are used on the event loop
+  // thread only, so the share needs no locking.
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  thread_ = std::thread([this]() { Run(); });
+}
+
+CurlMultiClient::~CurlMultiClient() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutting_down_ = true;
+  }
+  curl_multi_wakeup(multi_);
+  thread_.join();
+  curl_multi_cleanup(multi_);
+  curl_share_cleanup(share_);
+  curl_global_cleanup();
+}
+
+CurlMultiClient& CurlMultiClient::GetInstance() {
+  static auto* client = new CurlMultiClient();
+  return *client;
+}
+
+void CurlMultiClient::StartRequest(api::WebRequest request,
+                                   Callback callback) {
+  if (request.body.size() >= kMaxRequestBodySize) {
+    std::move(callback)(absl::ResourceExhaustedError("request body too large"));
+    return;
+  }
+  auto transfer = std::make_unique<Transfer>();
+  transfer->request = std::move(request);
+  transfer->callback = std::move(callback);
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!shutting_down_) {
+      pending_.push_back(std::move(transfer));
+    }
+  }
+  if (transfer != nullptr) {
+    std::move(transfer->callback)(
+        absl::CancelledError("HTTP client is shutting down"));
+    return;
+  }
+  curl_multi_wakeup(multi_);
+}
+
+absl::StatusOr<api::WebResponse> CurlMultiClient::SendRequest(
+    api::WebRequest request) {
+  absl::StatusOr<api::WebResponse> result;
+  absl::Notification done;
+  StartRequest(std::move(request),
+               [&result, &done](absl::StatusOr<api::WebResponse> response) {
+                 result = std::move(response);
+                 done.Notify();
+               });
+  done.WaitForNotification();
+  return result;
+}
+
+void CurlMultiClient::Run() {
+  while (true) {
+    std::deque<std::unique_ptr<Transfer>> added;
+    bool shutting_down;
+    {
+      absl::MutexLock lock(&mutex_);
+      added.swap(pending_);
+      shutting_down = shutting_down_;
+    }
+    for (auto& transfer : added) {
+      AddTransfer(std::move(transfer));
+    }
+    if (shutting_down) break;
+
+    int running_handles = 0;
+    curl_multi_perform(multi_, &running_handles);
+    CompleteTransfers();
+    CancelTransfers();
+    curl_multi_poll(multi_, nullptr, 0, kPollIntervalMillis, nullptr);
+  }
+
+  while (!running_.empty()) {
+    FinishTransfer(running_.begin()->first,
+                   absl::CancelledError("HTTP client is shutting down"));
+  }
+}
+
+void CurlMultiClient::AddTransfer(std::unique_ptr<Transfer> transfer) {
+  CURL* handle = curl_easy_init();
+  if (handle == nullptr) {
+    std::move(transfer->callback)(
+        absl::ResourceExhaustedError("failed to create curl handle"));
+    return;
+  }
+  transfer->handle = handle;
+  const api::WebRequest& request = transfer->request;
+
+  for (const auto& [key, value] : request.headers) {
+    curl_slist* headers = curl_slist_append(
+        transfer->headers, absl::StrCat(key, ": ", value).c_str());
+    if (headers == nullptr) {
+      std::move(transfer->callback)(
+          absl::ResourceExhaustedError("failed to append header to slist"));
+      return;
+    }
+    transfer->headers = headers;
+  }
+
+  curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
+  curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, transfer->error);
+  curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer.get());
+  curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+  // Required when the handle is used off the thread that installed the
+  // process signal handlers.
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+  curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->headers);
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, WriteBody);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer->response);
+  curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, WriteHeader);
+  curl_easy_setopt(handle, CURLOPT_HEADERDATA, &transfer->response);
+
+  if (request.method.empty() || request.method == "GET") {
+    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
+  } else if (request.method == "HEAD") {
+    curl_easy_setopt(handle, CURLOPT_NOBODY, 1L);
+  } else {
+    if (request.method != "POST") {
+      curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+    }
+    if (request.method == "POST" || !request.body.empty()) {
+      // The body is owned by the transfer, so curl need not copy it.
+      curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE,
+                       static_cast<long>(request.body.size()));
+      curl_easy_setopt(handle, CURLOPT_POSTFIELDS, request.body.data());
+    }
+  }
+
+  if (request.timeout > absl::ZeroDuration() &&
+      request.timeout != absl::InfiniteDuration()) {
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS,
+                     static_cast<long>(absl::ToInt64Milliseconds(
+                         std::max(request.timeout, absl::Milliseconds(1)))));
+  }
+
+  CURLMcode result = curl_multi_add_handle(multi_, handle);
+  if (result != CURLM_OK) {
+    std::move(transfer->callback)(absl::ResourceExhaustedError(
+        absl::StrCat("failed to start request: ", curl_multi_strerror(result))));
+    return;
+  }
+  running_.emplace(handle, std::move(transfer));
+}
+
+void CurlMultiClient::CompleteTransfers() {
+  int remaining = 0;
+  while (CURLMsg* message = curl_multi_info_read(multi_, &remaining)) {
+    if (message->msg != CURLMSG_DONE) continue;
+    CURL* handle = message->easy_handle;
+    CURLcode code = message->data.result;
+    auto it = running_.find(handle);
+    if (it == running_.end()) continue;
+    Transfer& transfer = *it->second;
+
+    if (code != CURLE_OK) {
+      NEARBY_LOGS(ERROR) << __func__ << ": Error performing HTTP request to "
+                         << transfer.request.url << ": "
+                         << curl_easy_strerror(code);
+      FinishTransfer(handle, CurlCodeToStatus(code, transfer.error));
+      continue;
+    }
+    long status_code = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status_code);
+    transfer.response.status_code = static_cast<int>(status_code);
+    absl::Status status = HttpCodeToStatus(transfer.response.status_code,
+                                           transfer.response.status_text);
+    if (!status.ok()) {
+      FinishTransfer(handle, status);
+      continue;
+    }
+    FinishTransfer(handle, std::move(transfer.response));
+  }
+}
+
+void CurlMultiClient::CancelTransfers() {
+  std::vector<CURL*> cancelled;
+  for (const auto& [handle, transfer] : running_) {
+    if (transfer->request.is_cancelled && transfer->request.is_cancelled()) {
+      cancelled.push_back(handle);
+    }
+  }
+  for (CURL* handle : cancelled) {
+    FinishTransfer(handle, absl::CancelledError("request is cancelled"));
+  }
+}
+
+void CurlMultiClient::FinishTransfer(
+    CURL* handle, absl::StatusOr<api::WebResponse> response) {
+  auto node = running_.extract(handle);
+  std::unique_ptr<Transfer> transfer = std::move(node.mapped());
+  curl_multi_remove_handle(multi_, handle);
+  std::move(transfer->callback)(std::move(response));
+}
+
+}  // namespace linux
+}  // namespace nearby
@@ -0,0 +1,97 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_IMPL_LINUX_CURL_MULTI_CLIENT_H_
+#define PLATFORM_IMPL_LINUX_CURL_MULTI_CLIENT_H_
+
+#include <curl/curl.h>
+
+#include <deque>
+#include <memory>
+#include <thread>  // NOLINT
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/implementation/http_loader.h"
+
+namespace nearby {
+namespace linux {
+
+// Sends HTTP requests concurrently over one curl multi handle.
+//
+// All transfers are driven by a single event loop thread, so connections, DNS
+// lookups and TLS sessions are reused across requests instead of being set up
+// again for each one. Requests over the concurrency limit wait inside curl
+// until a connection becomes free.
+class CurlMultiClient {
+ public:
+  struct Options {
+    // Connections open at once, over all hosts.
+    int max_concurrent_requests = 8;
+    // Idle connections kept open for reuse.
+    int max_cached_connections = 16;
+  };
+
+  using Callback =
+      absl::AnyInvocable<void(absl::StatusOr<api::WebResponse>) &&>;
+
+  CurlMultiClient() : CurlMultiClient(Options()) {}
+  explicit CurlMultiClient(const Options& options);
+  CurlMultiClient(const CurlMultiClient&) = delete;
+  CurlMultiClient& operator=(const CurlMultiClient&) = delete;
+
+  // Fails requests still in flight with a cancelled error.
+  ~CurlMultiClient();
+
+  // The client shared by the platform's SendRequest().
+  static CurlMultiClient& GetInstance();
+
+  // Starts `request`. `callback` is called on the event loop thread once the
+  // request completes, fails, times out or is cancelled; it must not block.
+  void StartRequest(api::WebRequest request, Callback callback)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Sends `request` and waits for the response.
+  absl::StatusOr<api::WebResponse> SendRequest(api::WebRequest request);
+
+ private:
+  struct Transfer;
+
+  void Run();
+  void AddTransfer(std::unique_ptr<Transfer> transfer);
+  void CompleteTransfers();
+  void CancelTransfers();
+  void FinishTransfer(CURL* handle, absl::StatusOr<api::WebResponse> response);
+
+  CURLM* const multi_;
+  CURLSH* const share_;
+
+  absl::Mutex mutex_;
+  std::deque<std::unique_ptr<Transfer>> pending_ ABSL_GUARDED_BY(mutex_);
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // Only used by the event loop thread.
+  absl::flat_hash_map<CURL*, std::unique_ptr<Transfer>> running_;
+
+  std::thread thread_;
+};
+
+}  // namespace linux
+}  // namespace nearby
+
+#endif  // PLATFORM_IMPL_LINUX_CURL_MULTI_CLIENT_H_
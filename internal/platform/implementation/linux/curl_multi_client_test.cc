@@ -0,0 +1,306 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/curl_multi_client.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "internal/platform/implementation/http_loader.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+using ::testing::Contains;
+using ::testing::Pair;
+
+constexpr int kConcurrentRequests = 4;
+
+// A keep-alive HTTP/1.1 server on the loopback interface. It serves:
+//   /echo     200, echoing the request body and method.
+//   /missing  404.
+//   /slow     200, once the server is stopped.
+//   /gather   200, once kConcurrentRequests of them have arrived.
+class LoopbackServer {
+ public:
+  LoopbackServer() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+    listen(listen_fd_, 16);
+    accept_thread_ = std::thread([this]() { AcceptLoop(); });
+  }
+
+  ~LoopbackServer() {
+    stopped_.Notify();
+    shutdown(listen_fd_, SHUT_RDWR);
+    accept_thread_.join();
+    {
+      absl::MutexLock lock(&mutex_);
+      for (int fd : connection_fds_) shutdown(fd, SHUT_RDWR);
+    }
+    for (auto& thread : connection_threads_) thread.join();
+    close(listen_fd_);
+  }
+
+  std::string Url(absl::string_view path) const {
+    return absl::StrCat("http://127.0.0.1:", port_, path);
+  }
+
+  int accepted_connections() const { return accepted_connections_.load(); }
+
+ private:
+  void AcceptLoop() {
+    while (true) {
+      int fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0) return;
+      accepted_connections_++;
+      absl::MutexLock lock(&mutex_);
+      connection_fds_.push_back(fd);
+      connection_threads_.emplace_back([this, fd]() { Serve(fd); });
+    }
+  }
+
+  void Serve(int fd) {
+    std::string buffer;
+    char chunk[4096];
+    while (true) {
+      size_t header_end;
+      while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count <= 0) {
+          close(fd);
+          return;
+        }
+        buffer.append(chunk, count);
+      }
+      absl::string_view head(buffer.data(), header_end);
+      size_t content_length = 0;
+      size_t pos = head.find("Content-Length: ");
+      if (pos != absl::string_view::npos) {
+        absl::string_view value = head.substr(pos + 16);
+        (void)absl::SimpleAtoi(value.substr(0, value.find("\r\n")),
+                               &content_length);
+      }
+      size_t request_size = header_end + 4 + content_length;
+      while (buffer.size() < request_size) {
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count <= 0) {
+          close(fd);
+          return;
+        }
+        buffer.append(chunk, count);
+      }
+      std::string method(head.substr(0, head.find(' ')));
+      absl::string_view target = head.substr(method.size() + 1);
+      std::string path(target.substr(0, target.find(' ')));
+      std::string body = buffer.substr(header_end + 4, content_length);
+      buffer.erase(0, request_size);
+
+      std::string response = Respond(method, path, body);
+      if (write(fd, response.data(), response.size()) < 0) {
+        close(fd);
+        return;
+      }
+    }
+  }
+
+  std::string Respond(absl::string_view method, absl::string_view path,
+                      absl::string_view body) {
+    if (path == "/missing") {
+      return "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    }
+    if (path == "/slow") {
+      stopped_.WaitForNotification();
+    } else if (path == "/gather") {
+      absl::MutexLock lock(&mutex_);
+      gathered_++;
+      // Never arrives if the client sends the requests one at a time.
+      mutex_.Await(absl::Condition(
+          +[](int* gathered) { return *gathered == kConcurrentRequests; },
+          &gathered_));
+    }
+    return absl::StrCat("HTTP/1.1 200 OK\r\nX-Method: ", method,
+                        "\r\nContent-Length: ", body.size(), "\r\n\r\n",
+                        body);
+  }
+
+  int listen_fd_;
+  int port_;
+  std::atomic<int> accepted_connections_{0};
+  absl::Notification stopped_;
+  std::thread accept_thread_;
+  absl::Mutex mutex_;
+  int gathered_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::vector<int> connection_fds_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::thread> connection_threads_;
+};
+
+api::WebRequest CreateRequest(std::string url, std::string method = "GET",
+                              std::string body = "") {
+  api::WebRequest request;
+  request.url = std::move(url);
+  request.method = std::move(method);
+  request.body = std::move(body);
+  return request;
+}
+
+TEST(CurlMultiClientTest, GetReturnsResponse) {
+  LoopbackServer server;
+  CurlMultiClient client;
+
+  absl::StatusOr<api::WebResponse> response =
+      client.SendRequest(CreateRequest(server.Url("/echo")));
+
+  ASSERT_TRUE(response.ok()) << response.status();
+  EXPECT_EQ(response->status_code, 200);
+  EXPECT_EQ(response->status_text, "OK");
+  EXPECT_THAT(response->headers, Contains(Pair("X-Method", "GET")));
+  EXPECT_EQ(response->body, "");
+}
+
+TEST(CurlMultiClientTest, PostSendsBody) {
+  LoopbackServer server;
+  CurlMultiClient client;
+
+  absl::StatusOr<api::WebResponse> response =
+      client.SendRequest(CreateRequest(server.Url("/echo"), "POST", "hello"));
+
+  ASSERT_TRUE(response.ok()) << response.status();
+  EXPECT_THAT(response->headers, Contains(Pair("X-Method", "POST")));
+  EXPECT_EQ(response->body, "hello");
+}
+
+TEST(CurlMultiClientTest, CustomMethodSendsBody) {
+  LoopbackServer server;
+  CurlMultiClient client;
+
+  absl::StatusOr<api::WebResponse> response =
+      client.SendRequest(CreateRequest(server.Url("/echo"), "PUT", "hello"));
+
+  ASSERT_TRUE(response.ok()) << response.status();
+  EXPECT_THAT(response->headers, Contains(Pair("X-Method", "PUT")));
+  EXPECT_EQ(response->body, "hello");
+}
+
+TEST(CurlMultiClientTest, ErrorStatusCodeFails) {
+  LoopbackServer server;
+  CurlMultiClient client;
+
+  absl::StatusOr<api::WebResponse> response =
+      client.SendRequest(CreateRequest(server.Url("/missing")));
+
+  EXPECT_EQ(response.status().code(), absl::StatusCode::kNotFound);
+}
+
+TEST(CurlMultiClientTest, ReusesConnection) {
+  LoopbackServer server;
+  CurlMultiClient client;
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(client.SendRequest(CreateRequest(server.Url("/echo"))).ok());
+  }
+
+  EXPECT_EQ(server.accepted_connections(), 1);
+}
+
+TEST(CurlMultiClientTest, RunsRequestsConcurrently) {
+  LoopbackServer server;
+  CurlMultiClient client({.max_concurrent_requests = kConcurrentRequests});
+  absl::BlockingCounter done(kConcurrentRequests);
+  std::atomic<int> succeeded{0};
+
+  for (int i = 0; i < kConcurrentRequests; ++i) {
+    client.StartRequest(CreateRequest(server.Url("/gather")),
+                        [&](absl::StatusOr<api::WebResponse> response) {
+                          if (response.ok()) succeeded++;
+                          done.DecrementCount();
+                        });
+  }
+  done.Wait();
+
+  EXPECT_EQ(succeeded.load(), kConcurrentRequests);
+}
+
+TEST(CurlMultiClientTest, TimeoutFailsRequest) {
+  LoopbackServer server;
+  CurlMultiClient client;
+  api::WebRequest request = CreateRequest(server.Url("/slow"));
+  request.timeout = absl::Milliseconds(100);
+
+  absl::StatusOr<api::WebResponse> response =
+      client.SendRequest(std::move(request));
+
+  EXPECT_EQ(response.status().code(), absl::StatusCode::kDeadlineExceeded);
+}
+
+TEST(CurlMultiClientTest, CancelledRequestFails) {
+  LoopbackServer server;
+  CurlMultiClient client;
+  std::atomic<bool> cancelled{false};
+  api::WebRequest request = CreateRequest(server.Url("/slow"));
+  request.is_cancelled = [&cancelled]() { return cancelled.load(); };
+  absl::Notification done;
+  absl::Status status;
+
+  client.StartRequest(std::move(request),
+                      [&](absl::StatusOr<api::WebResponse> response) {
+                        status = response.status();
+                        done.Notify();
+                      });
+  cancelled = true;
+
+  EXPECT_TRUE(done.WaitForNotificationWithTimeout(absl::Seconds(5)));
+  EXPECT_EQ(status.code(), absl::StatusCode::kCancelled);
+}
+
+TEST(CurlMultiClientTest, LargeBodyFails) {
+  CurlMultiClient client;
+
+  absl::StatusOr<api::WebResponse> response = client.SendRequest(
+      CreateRequest("http://127.0.0.1/", "POST",
+                    std::string(8 * 1024 * 1024, 'a')));
+
+  EXPECT_EQ(response.status().code(), absl::StatusCode::kResourceExhausted);
+}
+
+}  // namespace
+}  // namespace linux
+}  // namespace nearby
@@ -0,0 +1,212 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/epoll_reactor.h"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace linux {
+
+namespace {
+// The wake eventfd is registered under the invalid watch id, which is never
+// handed out to callers.
+constexpr api::IoReactor::WatchId kWakeWatchId =
+    api::IoReactor::kInvalidWatchId;
+constexpr int kMaxEventsPerWait = 64;
+constexpr std::uint32_t kWatchEvents = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+}  // namespace
+
+EpollReactor::EpollReactor() {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0) {
+    NEARBY_LOGS(ERROR) << __func__
+                       << ": epoll_create1 failed: " << std::strerror(errno);
+    return;
+  }
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd_ < 0) {
+    NEARBY_LOGS(ERROR) << __func__
+                       << ": eventfd failed: " << std::strerror(errno);
+    return;
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = kWakeWatchId;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to register wake fd: "
+                       << std::strerror(errno);
+    close(wake_fd_);
+    wake_fd_ = -1;
+    return;
+  }
+  loop_thread_ = std::thread([this]() { RunLoop(); });
+}
+
+EpollReactor::~EpollReactor() {
+  Shutdown();
+  if (wake_fd_ >= 0) close(wake_fd_);
+  if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+api::IoReactor::WatchId EpollReactor::Watch(
+    int fd, absl::AnyInvocable<void()> on_readable) {
+  if (!IsValid() || fd < 0) return kInvalidWatchId;
+
+  int watched_fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (watched_fd < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to dup fd " << fd << ": "
+                       << std::strerror(errno);
+    return kInvalidWatchId;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  if (shut_down_) {
+    close(watched_fd);
+    return kInvalidWatchId;
+  }
+  WatchId watch_id = next_watch_id_++;
+  watches_.emplace(
+      watch_id,
+      WatchEntry{watched_fd, std::make_shared<absl::AnyInvocable<void()>>(
+                                 std::move(on_readable))});
+
+  epoll_event event{};
+  event.events = kWatchEvents;
+  event.data.u64 = watch_id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, watched_fd, &event) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to watch fd " << fd << ": "
+                       << std::strerror(errno);
+    watches_.erase(watch_id);
+    close(watched_fd);
+    return kInvalidWatchId;
+  }
+  return watch_id;
+}
+
+bool EpollReactor::Rearm(WatchId watch_id) {
+  absl::MutexLock lock(&mutex_);
+  auto it = watches_.find(watch_id);
+  if (it == watches_.end()) return false;
+
+  epoll_event event{};
+  event.events = kWatchEvents;
+  event.data.u64 = watch_id;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, it->second.fd, &event) < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to re-arm watch " << watch_id
+                       << ": " << std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+void EpollReactor::Unwatch(WatchId watch_id) {
+  absl::MutexLock lock(&mutex_);
+  auto it = watches_.find(watch_id);
+  if (it == watches_.end()) return;
+
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+  close(it->second.fd);
+  watches_.erase(it);
+
+  // Make sure the callback is not left running against state the caller is
+  // about to destroy. A callback unwatching itself must not wait for itself.
+  if (IsLoopThread()) return;
+  while (dispatching_ == watch_id) {
+    dispatch_done_.Wait(&mutex_);
+  }
+}
+
+void EpollReactor::Shutdown() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (shut_down_) return;
+    shut_down_ = true;
+  }
+  if (wake_fd_ >= 0) {
+    std::uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0) {
+      NEARBY_LOGS(WARNING) << __func__ << ": failed to wake reactor: "
+                           << std::strerror(errno);
+    }
+  }
+  if (loop_thread_.joinable()) {
+    if (IsLoopThread()) {
+      loop_thread_.detach();
+    } else {
+      loop_thread_.join();
+    }
+  }
+
+  absl::MutexLock lock(&mutex_);
+  for (auto& [watch_id, entry] : watches_) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, entry.fd, nullptr);
+    close(entry.fd);
+  }
+  watches_.clear();
+}
+
+bool EpollReactor::IsLoopThread() const {
+  return loop_thread_.get_id() == std::this_thread::get_id();
+}
+
+void EpollReactor::RunLoop() {
+  std::array<epoll_event, kMaxEventsPerWait> events;
+  while (true) {
+    int ready = epoll_wait(epoll_fd_, events.data(), events.size(), -1);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      NEARBY_LOGS(ERROR) << __func__
+                         << ": epoll_wait failed: " << std::strerror(errno);
+      return;
+    }
+
+    for (int i = 0; i < ready; ++i) {
+      WatchId watch_id = events[i].data.u64;
+      std::shared_ptr<absl::AnyInvocable<void()>> on_readable;
+      {
+        absl::MutexLock lock(&mutex_);
+        if (shut_down_) return;
+        if (watch_id == kWakeWatchId) continue;
+        auto it = watches_.find(watch_id);
+        // The watch may have been removed after epoll_wait() returned.
+        if (it == watches_.end()) continue;
+        on_readable = it->second.on_readable;
+        dispatching_ = watch_id;
+      }
+
+      (*on_readable)();
+
+      absl::MutexLock lock(&mutex_);
+      dispatching_ = kInvalidWatchId;
+      dispatch_done_.SignalAll();
+    }
+  }
+}
+
+}  // namespace linux
+}  // namespace nearby
@@ -0,0 +1,84 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_IMPL_LINUX_EPOLL_REACTOR_H_
+#define PLATFORM_IMPL_LINUX_EPOLL_REACTOR_H_
+
+#include <memory>
+#include <thread>  // NOLINT
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/implementation/io_reactor.h"
+
+#ifdef linux
+#undef linux
+#endif
+
+namespace nearby {
+namespace linux {
+
+// An IoReactor backed by a single epoll instance and one loop thread.
+//
+// Every watch is registered with EPOLLONESHOT, so a descriptor is reported at
+// most once per Rearm(). Each watch owns a dup() of the caller's descriptor;
+// this keeps the registration alive when the stream closes its own copy, and
+// a shutdown() of the socket still wakes the watch with end of stream.
+class EpollReactor : public api::IoReactor {
+ public:
+  EpollReactor();
+  ~EpollReactor() override;
+
+  // Returns false if the epoll instance could not be created; all watches
+  // then fail.
+  bool IsValid() const { return epoll_fd_ >= 0 && wake_fd_ >= 0; }
+
+  WatchId Watch(int fd, absl::AnyInvocable<void()> on_readable) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  bool Rearm(WatchId watch_id) override ABSL_LOCKS_EXCLUDED(mutex_);
+  void Unwatch(WatchId watch_id) override ABSL_LOCKS_EXCLUDED(mutex_);
+  void Shutdown() override ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct WatchEntry {
+    int fd;
+    // Shared so the loop can run the callback outside of |mutex_| while a
+    // concurrent Unwatch() erases the entry.
+    std::shared_ptr<absl::AnyInvocable<void()>> on_readable;
+  };
+
+  void RunLoop();
+  bool IsLoopThread() const;
+
+  int epoll_fd_ = -1;
+  // eventfd used to wake the loop for shutdown.
+  int wake_fd_ = -1;
+
+  mutable absl::Mutex mutex_;
+  absl::CondVar dispatch_done_;
+  absl::flat_hash_map<WatchId, WatchEntry> watches_ ABSL_GUARDED_BY(mutex_);
+  WatchId next_watch_id_ ABSL_GUARDED_BY(mutex_) = kInvalidWatchId + 1;
+  // The watch whose callback the loop is currently running, if any.
+  WatchId dispatching_ ABSL_GUARDED_BY(mutex_) = kInvalidWatchId;
+  bool shut_down_ ABSL_GUARDED_BY(mutex_) = false;
+
+  std::thread loop_thread_;
+};
+
+}  // namespace linux
+}  // namespace nearby
+
+#endif  // PLATFORM_IMPL_LINUX_EPOLL_REACTOR_H_
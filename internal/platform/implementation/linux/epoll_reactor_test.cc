@@ -0,0 +1,128 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/epoll_reactor.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+constexpr absl::Duration kWaitTimeout = absl::Seconds(1);
+constexpr absl::Duration kQuietPeriod = absl::Milliseconds(100);
+
+class EpollReactorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds_), 0);
+  }
+
+  void TearDown() override {
+    if (fds_[0] >= 0) close(fds_[0]);
+    if (fds_[1] >= 0) close(fds_[1]);
+  }
+
+  void SendByte() { ASSERT_EQ(write(fds_[1], "x", 1), 1); }
+
+  void ReceiveByte() {
+    char byte;
+    ASSERT_EQ(read(fds_[0], &byte, 1), 1);
+  }
+
+  int fds_[2] = {-1, -1};
+};
+
+TEST_F(EpollReactorTest, CallbackRunsWhenReadable) {
+  EpollReactor reactor;
+  ASSERT_TRUE(reactor.IsValid());
+  absl::Notification readable;
+
+  EXPECT_NE(reactor.Watch(fds_[0], [&readable]() { readable.Notify(); }),
+            api::IoReactor::kInvalidWatchId);
+  EXPECT_FALSE(readable.WaitForNotificationWithTimeout(kQuietPeriod));
+
+  SendByte();
+  EXPECT_TRUE(readable.WaitForNotificationWithTimeout(kWaitTimeout));
+}
+
+TEST_F(EpollReactorTest, WatchIsOneShotUntilRearmed) {
+  EpollReactor reactor;
+  std::atomic<int> calls = 0;
+  api::IoReactor::WatchId watch_id =
+      reactor.Watch(fds_[0], [&calls]() { ++calls; });
+  ASSERT_NE(watch_id, api::IoReactor::kInvalidWatchId);
+
+  SendByte();
+  absl::SleepFor(kQuietPeriod);
+  EXPECT_EQ(calls, 1);
+
+  // Still readable, but not reported again until re-armed.
+  SendByte();
+  absl::SleepFor(kQuietPeriod);
+  EXPECT_EQ(calls, 1);
+
+  EXPECT_TRUE(reactor.Rearm(watch_id));
+  absl::SleepFor(kQuietPeriod);
+  EXPECT_EQ(calls, 2);
+}
+
+TEST_F(EpollReactorTest, ShutdownOfClosedStreamStillWakesWatch) {
+  EpollReactor reactor;
+  absl::Notification readable;
+  ASSERT_NE(reactor.Watch(fds_[0], [&readable]() { readable.Notify(); }),
+            api::IoReactor::kInvalidWatchId);
+
+  // Mirrors a stream Close(): the socket is shut down and the stream's own
+  // descriptor closed, while the reactor still holds its duplicate.
+  shutdown(fds_[0], SHUT_RD);
+  close(fds_[0]);
+  fds_[0] = -1;
+
+  EXPECT_TRUE(readable.WaitForNotificationWithTimeout(kWaitTimeout));
+}
+
+TEST_F(EpollReactorTest, NoCallbackAfterUnwatch) {
+  EpollReactor reactor;
+  std::atomic<int> calls = 0;
+  api::IoReactor::WatchId watch_id =
+      reactor.Watch(fds_[0], [&calls]() { ++calls; });
+
+  reactor.Unwatch(watch_id);
+  SendByte();
+  absl::SleepFor(kQuietPeriod);
+
+  EXPECT_EQ(calls, 0);
+  EXPECT_FALSE(reactor.Rearm(watch_id));
+  ReceiveByte();
+}
+
+TEST_F(EpollReactorTest, WatchFailsAfterShutdown) {
+  EpollReactor reactor;
+  reactor.Shutdown();
+
+  EXPECT_EQ(reactor.Watch(fds_[0], []() {}), api::IoReactor::kInvalidWatchId);
+}
+
+}  // namespace
+}  // namespace linux
+}  // namespace nearby
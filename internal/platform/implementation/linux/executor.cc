@@ -15,18 +15,61 @@
 #include "internal/platform/implementation/linux/executor.h"
 
 #include <cassert>
+#include <memory>
+#include <utility>
 
+#include "absl/synchronization/mutex.h"
 #include "internal/platform/implementation/linux/thread_pool.h"
+#include "internal/platform/implementation/linux/work_stealing_thread_pool.h"
 #include "internal/platform/logging.h"
 
 namespace nearby {
 namespace linux {
+
+namespace {
+// The shared-pool executor whose task is running on the calling thread.
+thread_local const Executor *current_executor = nullptr;
+}  // namespace
+
+// Owned by a task posted to the shared pool. If the pool refuses the task, or
+// shuts down and destroys it before it runs, the slot is released here;
+// otherwise Shutdown() would wait for it forever.
+class Executor::TaskSlot {
+ public:
+  explicit TaskSlot(Executor *executor) : executor_(executor) {}
+  TaskSlot(TaskSlot &&other) : executor_(other.Take()) {}
+  TaskSlot &operator=(TaskSlot &&) = delete;
+  ~TaskSlot() {
+    if (executor_ != nullptr) executor_->ReleaseDroppedSlot();
+  }
+
+  // Called when the task runs; it then owns the slot.
+  Executor *Take() { return std::exchange(executor_, nullptr); }
+
+ private:
+  Executor *executor_;
+};
+
 Executor::Executor(size_t max_concurrency)
-    : thread_pool_(std::make_unique<ThreadPool>(max_concurrency)) {
+    : thread_pool_(std::make_unique<ThreadPool>(max_concurrency)),
+      max_concurrency_(max_concurrency) {
   assert(max_concurrency >= 1);
   assert(thread_pool_ != nullptr);
 }
 
+Executor::Executor(std::shared_ptr<WorkStealingThreadPool> shared_pool,
+                   size_t max_concurrency)
+    : shared_pool_(std::move(shared_pool)), max_concurrency_(max_concurrency) {
+  assert(max_concurrency >= 1);
+  assert(shared_pool_ != nullptr);
+}
+
+Executor::~Executor() {
+  if (shared_pool_ != nullptr && !shut_down_) {
+    Shutdown();
+  }
+}
+
 void Executor::Execute(Runnable &&runnable) {
   if (shut_down_) {
     NEARBY_LOGS(VERBOSE) << "Warning: " << __func__
@@ -39,13 +82,104 @@ void Executor::Execute(Runnable &&runnable) {
     return;
   }
 
-  thread_pool_->Run(std::move(runnable));
+  if (shared_pool_ == nullptr) {
+    thread_pool_->Run(std::move(runnable));
+    return;
+  }
+
+  {
+    absl::MutexLock lock(&mutex_);
+    pending_tasks_.push(std::move(runnable));
+    if (running_tasks_ >= max_concurrency_) {
+      // A running task picks this one up when it finishes.
+      return;
+    }
+    ++running_tasks_;
+  }
+  // If the pool is full, the task stays pending and runs after the next one
+  // posted.
+  PostNextPendingTask();
 }
 
 void Executor::Shutdown() {
   shut_down_ = true;
-  thread_pool_->ShutDown();
-  thread_pool_ = nullptr;
+  if (shared_pool_ == nullptr) {
+    thread_pool_->ShutDown();
+    thread_pool_ = nullptr;
+    return;
+  }
+
+  // The shared pool outlives this executor, so wait for our own tasks to
+  // finish instead of joining threads. A task shutting down its own executor
+  // does not wait for itself.
+  size_t self = current_executor == this ? 1 : 0;
+  absl::MutexLock lock(&mutex_);
+  pending_tasks_ = {};
+  auto idle = [this, self]() {
+    mutex_.AssertReaderHeld();
+    return running_tasks_ <= self;
+  };
+  mutex_.Await(absl::Condition(&idle));
+}
+
+void Executor::RunNextPendingTask() {
+  while (true) {
+    Runnable task;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (pending_tasks_.empty() || shut_down_) {
+        --running_tasks_;
+        return;
+      }
+      task = std::move(pending_tasks_.front());
+      pending_tasks_.pop();
+    }
+
+    const Executor *previous_executor = current_executor;
+    current_executor = this;
+    task();
+    current_executor = previous_executor;
+
+    {
+      absl::MutexLock lock(&mutex_);
+      if (pending_tasks_.empty() || shut_down_) {
+        --running_tasks_;
+        return;
+      }
+    }
+    // Repost rather than loop, so a busy executor yields the worker to other
+    // executors between tasks.
+    if (PostNextPendingTask()) {
+      return;
+    }
+
+    // The pool is full and gave the slot back. Take it again and keep going
+    // on this worker, unless the pool is gone or another task already holds
+    // the slot and will run what is pending.
+    absl::MutexLock lock(&mutex_);
+    if (shared_pool_->IsShutDown() || running_tasks_ >= max_concurrency_) {
+      return;
+    }
+    ++running_tasks_;
+  }
+}
+
+bool Executor::PostNextPendingTask() {
+  bool posted = shared_pool_->Run([slot = TaskSlot(this)]() mutable {
+    slot.Take()->RunNextPendingTask();
+  });
+  if (!posted) {
+    NEARBY_LOGS(ERROR) << __func__ << ": Shared thread pool refused task.";
+  }
+  return posted;
+}
+
+void Executor::ReleaseDroppedSlot() {
+  absl::MutexLock lock(&mutex_);
+  --running_tasks_;
+  if (shared_pool_->IsShutDown()) {
+    pending_tasks_ = {};
+  }
 }
 
 }  // namespace linux
@@ -16,10 +16,15 @@
 #define PLATFORM_IMPL_LINUX_EXECUTOR_H_
 
 #include <atomic>
+#include <cstddef>
 #include <memory>
+#include <queue>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "internal/platform/implementation/executor.h"
 #include "internal/platform/implementation/linux/thread_pool.h"
+#include "internal/platform/implementation/linux/work_stealing_thread_pool.h"
 
 namespace nearby {
 namespace linux {
@@ -28,18 +33,52 @@ namespace linux {
 // Executor.
 class Executor : public api::Executor {
  public:
+  // Creates an executor that owns |max_concurrency| threads.
   Executor(size_t max_concurrency = 1);
 
+  // Creates an executor that owns no threads and runs its tasks on
+  // |shared_pool| instead. Tasks are started in submission order, and at most
+  // |max_concurrency| of them run at once, so with the default of 1 the
+  // executor stays sequential even though the pool is not.
+  //
+  // Only use this for executors whose tasks do not block indefinitely; see
+  // WorkStealingThreadPool.
+  Executor(std::shared_ptr<WorkStealingThreadPool> shared_pool,
+           size_t max_concurrency = 1);
+
   // Before returning from destructor, executor must wait for all pending
   // jobs to finish.
-  ~Executor() override = default;
+  ~Executor() override;
 
   void Execute(Runnable&& runnable) override;
   void Shutdown() override;
 
  private:
+  class TaskSlot;
+
+  // Posts RunNextPendingTask() to the shared pool, holding one of the
+  // |running_tasks_| slots. Returns false, and gives the slot back, if the
+  // pool refused the post.
+  bool PostNextPendingTask();
+  // Runs the next pending task on the shared pool, then reposts itself while
+  // more tasks are pending. If the pool is full, it keeps running them on the
+  // current worker instead.
+  void RunNextPendingTask() ABSL_LOCKS_EXCLUDED(mutex_);
+  // Gives back the slot of a post the shared pool dropped without running it.
+  // If the pool has shut down, nothing is left to run the pending tasks
+  // either, so they are dropped too. Otherwise the pool was only full and
+  // they stay queued.
+  void ReleaseDroppedSlot() ABSL_LOCKS_EXCLUDED(mutex_);
+
   std::unique_ptr<linux::ThreadPool> thread_pool_ = nullptr;
   std::atomic<bool> shut_down_ = false;
+
+  // Used only when running on a shared pool.
+  std::shared_ptr<WorkStealingThreadPool> shared_pool_ = nullptr;
+  const size_t max_concurrency_;
+  absl::Mutex mutex_;
+  std::queue<Runnable> pending_tasks_ ABSL_GUARDED_BY(mutex_);
+  size_t running_tasks_ ABSL_GUARDED_BY(mutex_) = 0;
 };
 
 }  // namespace linux
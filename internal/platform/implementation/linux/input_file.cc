@@ -0,0 +1,145 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/input_file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace linux {
+
+namespace {
+// How far ahead of the read position the kernel is asked to read. A few
+// default-sized payload chunks, so the next ones are in the page cache by the
+// time the sender gets to them.
+constexpr std::int64_t kReadAheadBytes = 4 * 1024 * 1024;
+}  // namespace
+
+std::unique_ptr<InputFile> InputFile::Create(absl::string_view file_path) {
+  return absl::WrapUnique(new InputFile(file_path));
+}
+
+InputFile::InputFile(absl::string_view file_path) : path_(file_path) {
+  absl::MutexLock lock(&mutex_);
+  fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to open " << path_ << ": "
+                       << std::strerror(errno);
+    return;
+  }
+
+  struct stat file_stat;
+  if (fstat(fd_, &file_stat) != 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to stat " << path_ << ": "
+                       << std::strerror(errno);
+    close(fd_);
+    fd_ = -1;
+    return;
+  }
+  total_size_ = file_stat.st_size;
+
+  // Payloads are sent front to back; this doubles the kernel's default
+  // read-ahead window for the file.
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+InputFile::~InputFile() { Close(); }
+
+ExceptionOr<ByteArray> InputFile::Read(std::int64_t size) {
+  absl::MutexLock lock(&mutex_);
+  if (fd_ < 0) {
+    return ExceptionOr<ByteArray>{Exception::kIo};
+  }
+
+  std::int64_t remaining = std::max<std::int64_t>(total_size_ - position_, 0);
+  size = std::min(size, remaining);
+  if (size <= 0) {
+    return ExceptionOr<ByteArray>{ByteArray{}};
+  }
+  ReadAhead();
+
+  // Read straight into the buffer that backs the returned ByteArray, so the
+  // chunk is not copied again on its way to the caller.
+  std::string read_bytes(size, '\0');
+  std::int64_t num_bytes_read = 0;
+  while (num_bytes_read < size) {
+    ssize_t result = pread(fd_, read_bytes.data() + num_bytes_read,
+                           size - num_bytes_read, position_ + num_bytes_read);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      NEARBY_LOGS(ERROR) << __func__ << ": failed to read " << path_ << ": "
+                         << std::strerror(errno);
+      return ExceptionOr<ByteArray>{Exception::kIo};
+    }
+    // The file got shorter since it was opened.
+    if (result == 0) break;
+    num_bytes_read += result;
+  }
+  read_bytes.resize(num_bytes_read);
+  position_ += num_bytes_read;
+
+  return ExceptionOr<ByteArray>(ByteArray(std::move(read_bytes)));
+}
+
+ExceptionOr<size_t> InputFile::Skip(size_t offset) {
+  absl::MutexLock lock(&mutex_);
+  if (fd_ < 0) {
+    return ExceptionOr<size_t>{Exception::kIo};
+  }
+
+  std::int64_t remaining = std::max<std::int64_t>(total_size_ - position_, 0);
+  std::int64_t skipped =
+      std::min(static_cast<std::int64_t>(offset), remaining);
+  position_ += skipped;
+  return ExceptionOr<size_t>(skipped);
+}
+
+Exception InputFile::Close() {
+  absl::MutexLock lock(&mutex_);
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  return {Exception::kSuccess};
+}
+
+void InputFile::ReadAhead() {
+  if (position_ + kReadAheadBytes / 2 < read_ahead_until_) return;
+
+  // After a Skip() the position may be past everything requested so far.
+  std::int64_t start = std::max(position_, read_ahead_until_);
+  posix_fadvise(fd_, start, kReadAheadBytes, POSIX_FADV_WILLNEED);
+  read_ahead_until_ = start + kReadAheadBytes;
+}
+
+}  // namespace linux
+}  // namespace nearby
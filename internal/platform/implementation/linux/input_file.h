@@ -15,31 +15,68 @@
 #ifndef PLATFORM_IMPL_LINUX_INPUT_FILE_H_
 #define PLATFORM_IMPL_LINUX_INPUT_FILE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/input_file.h"
 
+#ifdef linux
+#undef linux
+#endif
+
 namespace nearby {
 namespace linux {
 
 // An InputFile represents a readable file on the system.
-class InputFile : public api::InputFile {
+//
+// Reads go straight from the page cache into the returned ByteArray with
+// pread(), so a chunk is copied once rather than through an iostream buffer
+// first. The kernel is told the file is read front to back and asked to read
+// ahead of the position, and Skip() only moves the position, so resuming a
+// transfer deep into a large file costs nothing.
+class InputFile final : public api::InputFile {
  public:
-  // TODO(b/184975123): replace with real implementation.
-  ~InputFile() override = default;
-  // TODO(b/184975123): replace with real implementation.
-  std::string GetFilePath() const override { return "Un-implemented"; }
-  // TODO(b/184975123): replace with real implementation.
-  std::int64_t GetTotalSize() const override { return 0; }
+  // Opens |file_path| for reading. If the file cannot be opened, the returned
+  // object reports a total size of -1 and fails every Read().
+  static std::unique_ptr<InputFile> Create(absl::string_view file_path);
+
+  ~InputFile() override;
+
+  std::string GetFilePath() const override { return path_; }
+  std::int64_t GetTotalSize() const override { return total_size_; }
 
   // throws Exception::kIo
-  // TODO(b/184975123): replace with real implementation.
-  ExceptionOr<ByteArray> Read(std::int64_t size) override {
-    return ExceptionOr<ByteArray>(Exception::kFailed);
-  }
+  ExceptionOr<ByteArray> Read(std::int64_t size) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Moves the read position without reading.
+  ExceptionOr<size_t> Skip(size_t offset) override ABSL_LOCKS_EXCLUDED(mutex_);
   // throws Exception::kIo
-  // TODO(b/184975123): replace with real implementation.
-  Exception Close() override { return Exception{}; }
+  Exception Close() override ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  explicit InputFile(absl::string_view file_path);
+
+  // Asks the kernel to start reading the next stretch of the file if the
+  // position is getting close to the end of what was requested before.
+  void ReadAhead() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const std::string path_;
+  std::int64_t total_size_ = -1;
+
+  // Close() may be called from another thread while a Read() is in progress;
+  // the lock keeps the descriptor from being closed and reused under it.
+  mutable absl::Mutex mutex_;
+  int fd_ ABSL_GUARDED_BY(mutex_) = -1;
+  std::int64_t position_ ABSL_GUARDED_BY(mutex_) = 0;
+  // End of the range the kernel has been asked to read ahead.
+  std::int64_t read_ahead_until_ ABSL_GUARDED_BY(mutex_) = 0;
 };
 
 }  // namespace linux
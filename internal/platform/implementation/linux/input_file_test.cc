@@ -14,122 +14,127 @@
 
 #include "internal/platform/implementation/linux/input_file.h"
 
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <memory>
+#include <string>
 
 #include "gtest/gtest.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/linux/test_utils.h"
-#include "internal/platform/logging.h"
-#include "internal/platform/payload_id.h"
 
 class InputFileTests : public testing::Test {
  protected:
-  // You can define per-test set-up logic as usual.
   void SetUp() override {
-    nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-    auto path = test_utils::GetPayloadPath(payloadId);
-
-    file_.open(path, std::ios::out);
-
-    if (!file_) {
-      NEARBY_LOG(
-          ERROR, "Failed to create OutputFile with payloadId: %s and error: %d",
-          test_utils::GetPayloadPath(payloadId).c_str(), std::strerror(errno));
-    }
-
-    const char* buffer = TEST_STRING;
-
-    file_.write(buffer, std::strlen(buffer));
-
-    file_.close();
+    path_ = (std::filesystem::path(testing::TempDir()) /
+             std::to_string(TEST_PAYLOAD_ID))
+                .string();
+    std::ofstream file(path_, std::ios::binary | std::ios::out);
+    file.write(TEST_STRING, std::strlen(TEST_STRING));
   }
 
-  // You can define per-test tear-down logic as usual.
-  void TearDown() override {
-    nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-    if (std::filesystem::exists(test_utils::GetPayloadPath(payloadId))) {
-      std::filesystem::remove(test_utils::GetPayloadPath(payloadId));
-    }
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::unique_ptr<nearby::linux::InputFile> CreateInputFile() {
+    return nearby::linux::InputFile::Create(path_);
   }
 
- private:
-  std::fstream file_;
+  std::string path_;
 };
 
 TEST_F(InputFileTests, SuccessfulCreation) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::InputFile> inputFile = nullptr;
-
-  inputFile = nearby::api::ImplementationPlatform::CreateInputFile(
-      payloadId, strlen(TEST_STRING));
+  auto inputFile = CreateInputFile();
 
   EXPECT_NE(inputFile, nullptr);
   EXPECT_EQ(inputFile->Close(), nearby::Exception{nearby::Exception::kSuccess});
 }
 
 TEST_F(InputFileTests, SuccessfulGetFilePath) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::InputFile> inputFile = nullptr;
-  std::string fileName;
-
-  inputFile = nearby::api::ImplementationPlatform::CreateInputFile(
-      payloadId, strlen(TEST_STRING));
-
-  fileName = inputFile->GetFilePath();
+  auto inputFile = CreateInputFile();
 
+  EXPECT_EQ(inputFile->GetFilePath(), path_);
   EXPECT_EQ(inputFile->Close(), nearby::Exception{nearby::Exception::kSuccess});
-
-  EXPECT_EQ(fileName, test_utils::GetPayloadPath(payloadId).c_str());
 }
 
 TEST_F(InputFileTests, SuccessfulGetTotalSize) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::InputFile> inputFile = nullptr;
-  int64_t size = -1;
-
-  inputFile = nearby::api::ImplementationPlatform::CreateInputFile(
-      payloadId, strlen(TEST_STRING));
-
-  size = inputFile->GetTotalSize();
+  auto inputFile = CreateInputFile();
 
+  EXPECT_EQ(inputFile->GetTotalSize(), std::strlen(TEST_STRING));
   EXPECT_EQ(inputFile->Close(), nearby::Exception{nearby::Exception::kSuccess});
-
-  EXPECT_EQ(size, strlen(TEST_STRING));
 }
 
 TEST_F(InputFileTests, SuccessfulRead) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::InputFile> inputFile = nullptr;
+  auto inputFile = CreateInputFile();
 
-  inputFile = nearby::api::ImplementationPlatform::CreateInputFile(
-      payloadId, strlen(TEST_STRING));
-
-  auto fileSize = inputFile->GetTotalSize();
-  auto dataRead = inputFile->Read(fileSize);
+  auto dataRead = inputFile->Read(inputFile->GetTotalSize());
 
   EXPECT_TRUE(dataRead.ok());
   EXPECT_EQ(inputFile->Close(), nearby::Exception{nearby::Exception::kSuccess});
+  EXPECT_EQ(std::string(dataRead.result()), TEST_STRING);
+}
 
-  EXPECT_STREQ(std::string(dataRead.result()).c_str(), TEST_STRING);
+TEST_F(InputFileTests, ReadAtEndOfFileReturnsEmpty) {
+  auto inputFile = CreateInputFile();
+
+  auto dataRead = inputFile->Read(inputFile->GetTotalSize());
+  EXPECT_TRUE(dataRead.ok());
+
+  dataRead = inputFile->Read(inputFile->GetTotalSize());
+  EXPECT_TRUE(dataRead.ok());
+  EXPECT_TRUE(dataRead.result().Empty());
 }
 
-TEST_F(InputFileTests, FailedRead) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::InputFile> inputFile = nullptr;
+TEST_F(InputFileTests, ReadsInChunks) {
+  auto inputFile = CreateInputFile();
+  std::string data;
+
+  while (true) {
+    auto dataRead = inputFile->Read(TEST_BUFFER_SIZE);
+    ASSERT_TRUE(dataRead.ok());
+    if (dataRead.result().Empty()) break;
+    EXPECT_LE(dataRead.result().size(), TEST_BUFFER_SIZE);
+    data += std::string(dataRead.result());
+  }
+
+  EXPECT_EQ(data, TEST_STRING);
+}
 
-  inputFile = nearby::api::ImplementationPlatform::CreateInputFile(
-      payloadId, strlen(TEST_STRING));
+TEST_F(InputFileTests, SkipMovesReadPosition) {
+  auto inputFile = CreateInputFile();
 
-  auto fileSize = inputFile->GetTotalSize();
-  EXPECT_NE(fileSize, -1);
+  auto skipped = inputFile->Skip(6);
+  ASSERT_TRUE(skipped.ok());
+  EXPECT_EQ(skipped.result(), 6);
 
-  auto dataRead = inputFile->Read(fileSize);
-  EXPECT_TRUE(dataRead.ok());
+  auto dataRead = inputFile->Read(5);
+  ASSERT_TRUE(dataRead.ok());
+  EXPECT_EQ(std::string(dataRead.result()), std::string(TEST_STRING, 6, 5));
+}
+
+TEST_F(InputFileTests, SkipStopsAtEndOfFile) {
+  auto inputFile = CreateInputFile();
 
-  dataRead = inputFile->Read(fileSize);
-  std::string data = std::string(dataRead.result());
+  auto skipped = inputFile->Skip(10 * std::strlen(TEST_STRING));
+  ASSERT_TRUE(skipped.ok());
+  EXPECT_EQ(skipped.result(), std::strlen(TEST_STRING));
+
+  auto dataRead = inputFile->Read(TEST_BUFFER_SIZE);
+  ASSERT_TRUE(dataRead.ok());
+  EXPECT_TRUE(dataRead.result().Empty());
+}
 
+TEST_F(InputFileTests, FailedRead) {
+  auto inputFile = CreateInputFile();
   inputFile->Close();
 
-  EXPECT_STREQ(data.c_str(), "");
+  EXPECT_FALSE(inputFile->Read(TEST_BUFFER_SIZE).ok());
+  EXPECT_FALSE(inputFile->Skip(1).ok());
+}
+
+TEST_F(InputFileTests, MissingFileFailsReads) {
+  auto inputFile = nearby::linux::InputFile::Create(path_ + ".missing");
+
+  EXPECT_EQ(inputFile->GetTotalSize(), -1);
+  EXPECT_FALSE(inputFile->Read(TEST_BUFFER_SIZE).ok());
 }
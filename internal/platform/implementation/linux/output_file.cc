@@ -0,0 +1,226 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/output_file.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "internal/flags/nearby_flags.h"
+#include "internal/platform/byte_array.h"
+#include "internal/platform/exception.h"
+#include "internal/platform/flags/nearby_platform_feature_flags.h"
+#include "internal/platform/logging.h"
+
+namespace nearby {
+namespace linux {
+
+// C++14 requires to declare this.
+constexpr std::size_t OutputFile::kBatchSize;
+constexpr std::size_t OutputFile::kMaxQueuedBatches;
+
+std::unique_ptr<OutputFile> OutputFile::Create(absl::string_view file_path) {
+  return absl::WrapUnique(new OutputFile(
+      file_path,
+      NearbyFlags::GetInstance().GetBoolFlag(
+          platform::config_package_nearby::nearby_platform_feature::
+              kEnableFileWriteBehindSync)));
+}
+
+OutputFile::OutputFile(absl::string_view file_path, bool sync_written_ranges)
+    : path_(file_path), sync_written_ranges_(sync_written_ranges) {
+  fd_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    NEARBY_LOGS(ERROR) << __func__ << ": failed to open " << path_ << ": "
+                       << std::strerror(errno);
+    absl::MutexLock lock(&mutex_);
+    failed_ = true;
+    return;
+  }
+  writer_thread_ = std::thread(&OutputFile::RunWriter, this);
+}
+
+OutputFile::~OutputFile() { Close(); }
+
+Exception OutputFile::Write(const ByteArray& data) {
+  absl::MutexLock lock(&mutex_);
+  if (closed_ || failed_) {
+    return {Exception::kIo};
+  }
+
+  std::size_t written = 0;
+  while (written < data.size()) {
+    if (batch_.capacity() < kBatchSize) batch_.reserve(kBatchSize);
+    std::size_t size =
+        std::min(kBatchSize - batch_.size(), data.size() - written);
+    batch_.append(data.data() + written, size);
+    written += size;
+    if (batch_.size() < kBatchSize) break;
+
+    while (queue_.size() >= kMaxQueuedBatches && !failed_) {
+      cond_.Wait(&mutex_);
+    }
+    if (failed_) {
+      return {Exception::kIo};
+    }
+    QueueBatchLocked();
+  }
+  return {Exception::kSuccess};
+}
+
+Exception OutputFile::Flush() {
+  absl::MutexLock lock(&mutex_);
+  if (closed_ || failed_) {
+    return {failed_ ? Exception::kIo : Exception::kSuccess};
+  }
+  QueueBatchLocked();
+  WaitForWriterLocked();
+  return {failed_ ? Exception::kIo : Exception::kSuccess};
+}
+
+Exception OutputFile::Close() {
+  bool failed;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (closed_) {
+      return {Exception::kSuccess};
+    }
+    if (!failed_) {
+      QueueBatchLocked();
+      WaitForWriterLocked();
+    }
+    closed_ = true;
+    failed = failed_;
+    cond_.SignalAll();
+  }
+
+  if (writer_thread_.joinable()) {
+    writer_thread_.join();
+  }
+  if (fd_ >= 0) {
+    if (close(fd_) != 0) {
+      NEARBY_LOGS(ERROR) << __func__ << ": failed to close " << path_ << ": "
+                         << std::strerror(errno);
+      failed = true;
+    }
+    fd_ = -1;
+  }
+  return {failed ? Exception::kIo : Exception::kSuccess};
+}
+
+Exception OutputFile::Preallocate(std::int64_t size) {
+  absl::MutexLock lock(&mutex_);
+  if (closed_ || fd_ < 0) {
+    return {Exception::kIo};
+  }
+  if (size <= 0) {
+    return {Exception::kSuccess};
+  }
+
+  if (fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, size) != 0) {
+    NEARBY_LOGS(WARNING) << __func__ << ": failed to reserve " << size
+                         << " bytes for " << path_ << ": "
+                         << std::strerror(errno);
+    return {Exception::kIo};
+  }
+  return {Exception::kSuccess};
+}
+
+void OutputFile::QueueBatchLocked() {
+  if (batch_.empty()) return;
+  queue_.push_back(std::move(batch_));
+  batch_ = std::string();
+  cond_.SignalAll();
+}
+
+void OutputFile::WaitForWriterLocked() {
+  while ((!queue_.empty() || writing_) && !failed_) {
+    cond_.Wait(&mutex_);
+  }
+}
+
+void OutputFile::RunWriter() {
+  while (true) {
+    std::string batch;
+    {
+      absl::MutexLock lock(&mutex_);
+      while (queue_.empty() && !closed_) {
+        cond_.Wait(&mutex_);
+      }
+      if (queue_.empty()) return;
+      batch = std::move(queue_.front());
+      queue_.pop_front();
+      writing_ = true;
+      // Write() may be waiting for room in the queue.
+      cond_.SignalAll();
+    }
+
+    bool written = WriteBatch(batch);
+
+    absl::MutexLock lock(&mutex_);
+    writing_ = false;
+    if (!written) {
+      failed_ = true;
+      queue_.clear();
+    }
+    cond_.SignalAll();
+  }
+}
+
+bool OutputFile::WriteBatch(const std::string& batch) {
+  std::size_t written = 0;
+  while (written < batch.size()) {
+    ssize_t result = pwrite(fd_, batch.data() + written, batch.size() - written,
+                            write_offset_ + written);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      NEARBY_LOGS(ERROR) << __func__ << ": failed to write " << path_ << ": "
+                         << std::strerror(errno);
+      return false;
+    }
+    written += result;
+  }
+
+  if (sync_written_ranges_) {
+    // Start writeback of this batch now, then wait for the previous one,
+    // which has had a whole batch worth of time to reach the disk, and drop
+    // it from the page cache.
+    sync_file_range(fd_, write_offset_, batch.size(), SYNC_FILE_RANGE_WRITE);
+    if (last_batch_size_ > 0) {
+      std::int64_t last_offset = write_offset_ - last_batch_size_;
+      sync_file_range(fd_, last_offset, last_batch_size_,
+                      SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                          SYNC_FILE_RANGE_WAIT_AFTER);
+      posix_fadvise(fd_, last_offset, last_batch_size_, POSIX_FADV_DONTNEED);
+    }
+  }
+  write_offset_ += batch.size();
+  last_batch_size_ = batch.size();
+  return true;
+}
+
+}  // namespace linux
+}  // namespace nearby
@@ -15,28 +15,97 @@
 #ifndef PLATFORM_IMPL_LINUX_OUTPUT_FILE_H_
 #define PLATFORM_IMPL_LINUX_OUTPUT_FILE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/output_file.h"
 
+#ifdef linux
+#undef linux
+#endif
+
 namespace nearby {
 namespace linux {
 
 // An OutputFile represents a writable file on the system.
-class OutputFile : public api::OutputFile {
+//
+// Write() only copies the data into a batch buffer. Full batches are written
+// in order by a dedicated writer thread, one large write per batch at offsets
+// that are multiples of the batch size, so a stream of small payload chunks
+// reaches the disk as a few big sequential writes. Flush() and Close() wait for
+// everything written so far to reach the file. A failed write is reported by
+// the next Write(), Flush() or Close().
+//
+// With the kEnableFileWriteBehindSync platform flag, writeback of each batch
+// is started as soon as it is written and the pages of earlier batches are
+// dropped from the page cache once they are on disk.
+class OutputFile final : public api::OutputFile {
  public:
-  // TODO(b/184975123): replace with real implementation.
-  ~OutputFile() override = default;
+  // Size of the batches handed to the writer thread.
+  static constexpr std::size_t kBatchSize = 1024 * 1024;
+  // Number of full batches that may wait for the writer thread before Write()
+  // blocks.
+  static constexpr std::size_t kMaxQueuedBatches = 4;
 
+  // Creates or truncates |file_path|. If the file cannot be opened, every
+  // operation on the returned object fails.
+  static std::unique_ptr<OutputFile> Create(absl::string_view file_path);
+
+  ~OutputFile() override;
+
+  // throws Exception::kIo
+  Exception Write(const ByteArray& data) override ABSL_LOCKS_EXCLUDED(mutex_);
   // throws Exception::kIo
-  // TODO(b/184975123): replace with real implementation.
-  Exception Write(const ByteArray& data) override { return Exception{}; }
+  Exception Flush() override ABSL_LOCKS_EXCLUDED(mutex_);
   // throws Exception::kIo
-  // TODO(b/184975123): replace with real implementation.
-  Exception Flush() override { return Exception{}; }
+  Exception Close() override ABSL_LOCKS_EXCLUDED(mutex_);
+  // Reserves |size| bytes of disk space without changing the file size, so a
+  // transfer that is cut short does not leave a padded file behind.
+  //
   // throws Exception::kIo
-  // TODO(b/184975123): replace with real implementation.
-  Exception Close() override { return Exception{}; }
+  Exception Preallocate(std::int64_t size) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  OutputFile(absl::string_view file_path, bool sync_written_ranges);
+
+  // Moves the partially filled batch to the writer queue.
+  void QueueBatchLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Waits until the writer thread has written every queued batch.
+  void WaitForWriterLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void RunWriter() ABSL_LOCKS_EXCLUDED(mutex_);
+  // Writes |batch| at |write_offset_|. Runs on the writer thread.
+  bool WriteBatch(const std::string& batch);
+
+  const std::string path_;
+  const bool sync_written_ranges_;
+  // Closed by Close() only after the writer thread has exited.
+  int fd_ = -1;
+
+  absl::Mutex mutex_;
+  absl::CondVar cond_;
+  std::string batch_ ABSL_GUARDED_BY(mutex_);
+  std::deque<std::string> queue_ ABSL_GUARDED_BY(mutex_);
+  // True while the writer thread is writing a batch it took off the queue.
+  bool writing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool failed_ ABSL_GUARDED_BY(mutex_) = false;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // Only used on the writer thread.
+  std::int64_t write_offset_ = 0;
+  std::int64_t last_batch_size_ = 0;
+
+  std::thread writer_thread_;
 };
 
 }  // namespace linux
@@ -13,68 +13,159 @@
 // limitations under the License.
 
 #include "internal/platform/implementation/linux/output_file.h"
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
 #include "gtest/gtest.h"
+#include "internal/flags/nearby_flags.h"
+#include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
-#include "internal/platform/implementation/platform.h"
-#include "internal/platform/implementation/windows/test_utils.h"
-#include "internal/platform/payload_id.h"
+#include "internal/platform/flags/nearby_platform_feature_flags.h"
+#include "internal/platform/implementation/linux/test_utils.h"
 
 class OutputFileTests : public testing::Test {
  protected:
-  // You can define per-test set-up logic as usual.
   void SetUp() override {
-    nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-    if (std::filesystem::exists(test_utils::GetPayloadPath(payloadId))) {
-      std::filesystem::remove(test_utils::GetPayloadPath(payloadId));
-    }
+    path_ = (std::filesystem::path(testing::TempDir()) /
+             std::to_string(TEST_PAYLOAD_ID))
+                .string();
+    std::filesystem::remove(path_);
   }
 
-  // You can define per-test tear-down logic as usual.
   void TearDown() override {
-    nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-    if (std::filesystem::exists(
-            test_utils::GetPayloadPath(payloadId).c_str())) {
-      std::filesystem::remove(test_utils::GetPayloadPath(payloadId).c_str());
-    }
+    std::filesystem::remove(path_);
+    nearby::NearbyFlags::GetInstance().ResetOverridedValues();
+  }
+
+  std::unique_ptr<nearby::linux::OutputFile> CreateOutputFile() {
+    return nearby::linux::OutputFile::Create(path_);
   }
+
+  std::string ReadFile() {
+    std::ifstream file(path_, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), {});
+  }
+
+  std::string path_;
 };
 
 TEST_F(OutputFileTests, SuccessfulCreation) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::OutputFile> outputFile = nullptr;
-
-  EXPECT_NO_THROW(
-      outputFile =
-          nearby::api::ImplementationPlatform::CreateOutputFile(payloadId));
+  auto outputFile = CreateOutputFile();
 
   EXPECT_NE(outputFile, nullptr);
-  EXPECT_NO_THROW(outputFile->Close());
+  EXPECT_TRUE(std::filesystem::exists(path_));
+  EXPECT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
 }
 
 TEST_F(OutputFileTests, SuccessfulClose) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
-  std::unique_ptr<nearby::api::OutputFile> outputFile = nullptr;
+  auto outputFile = CreateOutputFile();
 
-  EXPECT_NO_THROW(
-      outputFile =
-          nearby::api::ImplementationPlatform::CreateOutputFile(payloadId));
+  EXPECT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
+  // Closing again is harmless.
+  EXPECT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
+}
+
+TEST_F(OutputFileTests, SuccessfulWrite) {
+  nearby::ByteArray data(std::string(TEST_STRING));
+  auto outputFile = CreateOutputFile();
 
-  EXPECT_NO_THROW(outputFile->Close());
+  EXPECT_EQ(outputFile->Write(data),
+            nearby::Exception{nearby::Exception::kSuccess});
+  EXPECT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
 
-  std::filesystem::remove(test_utils::GetPayloadPath(payloadId).c_str());
+  EXPECT_EQ(ReadFile(), TEST_STRING);
 }
 
-TEST_F(OutputFileTests, SuccessfulWrite) {
-  nearby::PayloadId payloadId(TEST_PAYLOAD_ID);
+TEST_F(OutputFileTests, FlushWritesPartialBatch) {
+  nearby::ByteArray data(std::string(TEST_STRING));
+  auto outputFile = CreateOutputFile();
+
+  ASSERT_EQ(outputFile->Write(data),
+            nearby::Exception{nearby::Exception::kSuccess});
+  EXPECT_EQ(outputFile->Flush(),
+            nearby::Exception{nearby::Exception::kSuccess});
+
+  EXPECT_EQ(ReadFile(), TEST_STRING);
+}
+
+TEST_F(OutputFileTests, WritesManyChunksAcrossBatchesInOrder) {
+  auto outputFile = CreateOutputFile();
+  std::string expected;
+
+  // Chunks that do not divide the batch size evenly, spanning more batches
+  // than the writer queue holds.
+  constexpr int kChunkSize = 64 * 1024 + 7;
+  int chunks =
+      (nearby::linux::OutputFile::kMaxQueuedBatches + 3) *
+          nearby::linux::OutputFile::kBatchSize / kChunkSize + 1;
+  for (int i = 0; i < chunks; ++i) {
+    std::string chunk(kChunkSize, static_cast<char>('a' + i % 26));
+    expected += chunk;
+    ASSERT_EQ(outputFile->Write(nearby::ByteArray(std::move(chunk))),
+              nearby::Exception{nearby::Exception::kSuccess});
+  }
+  EXPECT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
+
+  EXPECT_EQ(ReadFile(), expected);
+}
+
+TEST_F(OutputFileTests, WriteBehindSyncKeepsContent) {
+  nearby::NearbyFlags::GetInstance().OverrideBoolFlagValue(
+      nearby::platform::config_package_nearby::nearby_platform_feature::
+          kEnableFileWriteBehindSync,
+      true);
+  auto outputFile = CreateOutputFile();
+  std::string expected(3 * nearby::linux::OutputFile::kBatchSize + 11, 'x');
+
+  ASSERT_EQ(outputFile->Write(nearby::ByteArray(expected)),
+            nearby::Exception{nearby::Exception::kSuccess});
+  EXPECT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
+
+  EXPECT_EQ(ReadFile(), expected);
+}
+
+TEST_F(OutputFileTests, PreallocateKeepsFileSize) {
+  nearby::ByteArray data(std::string(TEST_STRING));
+  auto outputFile = CreateOutputFile();
+
+  // Not every file system can reserve space; only the file size matters here.
+  outputFile->Preallocate(16 * 1024 * 1024);
+  ASSERT_EQ(outputFile->Write(data),
+            nearby::Exception{nearby::Exception::kSuccess});
+  ASSERT_EQ(outputFile->Close(),
+            nearby::Exception{nearby::Exception::kSuccess});
+
+  EXPECT_EQ(std::filesystem::file_size(path_), data.size());
+}
+
+TEST_F(OutputFileTests, FailedWrite) {
   nearby::ByteArray data(std::string(TEST_STRING));
-  std::unique_ptr<nearby::api::OutputFile> outputFile = nullptr;
+  auto outputFile = CreateOutputFile();
+  outputFile->Close();
 
-  EXPECT_NO_THROW(
-      outputFile =
-          nearby::api::ImplementationPlatform::CreateOutputFile(payloadId));
+  EXPECT_EQ(outputFile->Write(data), nearby::Exception{nearby::Exception::kIo});
+  EXPECT_EQ(outputFile->Preallocate(data.size()),
+            nearby::Exception{nearby::Exception::kIo});
+}
 
-  EXPECT_NO_THROW(outputFile->Write(data));
-  EXPECT_NO_THROW(outputFile->Close());
+TEST_F(OutputFileTests, UnopenableFileFails) {
+  auto outputFile =
+      nearby::linux::OutputFile::Create(path_ + "/missing/directory/file");
 
-  std::filesystem::remove(test_utils::GetPayloadPath(payloadId).c_str());
+  EXPECT_EQ(outputFile->Write(nearby::ByteArray(std::string(TEST_STRING))),
+            nearby::Exception{nearby::Exception::kIo});
+  EXPECT_EQ(outputFile->Flush(), nearby::Exception{nearby::Exception::kIo});
 }
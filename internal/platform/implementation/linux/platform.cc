@@ -16,7 +16,6 @@
 #include <memory>
 #include <string>
 
-#include <curl/curl.h>
 #include <sdbus-c++/Error.h>
 #include <sdbus-c++/Types.h>
 
@@ -35,9 +34,13 @@
 #include "internal/platform/implementation/linux/bluetooth_classic_medium.h"
 #include "internal/platform/implementation/linux/bluez.h"
 #include "internal/platform/implementation/linux/condition_variable.h"
+#include "internal/platform/implementation/linux/curl_multi_client.h"
 #include "internal/platform/implementation/linux/dbus.h"
+#include "internal/platform/implementation/linux/epoll_reactor.h"
+#include "internal/platform/implementation/linux/input_file.h"
 #include "internal/platform/implementation/linux/generated/dbus/bluez/adapter_client.h"
 #include "internal/platform/implementation/linux/mutex.h"
+#include "internal/platform/implementation/linux/output_file.h"
 #include "internal/platform/implementation/linux/preferences_manager.h"
 #include "internal/platform/implementation/linux/submittable_executor.h"
 #include "internal/platform/implementation/linux/timer.h"
@@ -47,7 +50,6 @@
 #include "internal/platform/implementation/linux/wifi_medium.h"
 #include "internal/platform/implementation/platform.h"
 #include "internal/platform/implementation/shared/count_down_latch.h"
-#include "internal/platform/implementation/shared/file.h"
 #include "internal/platform/implementation/submittable_executor.h"
 #include "internal/platform/implementation/wifi_hotspot.h"
 #include "internal/platform/implementation/wifi_lan.h"
@@ -116,17 +118,17 @@ ImplementationPlatform::CreateConditionVariable(api::Mutex *mutex) {
 std::unique_ptr<api::InputFile> ImplementationPlatform::CreateInputFile(
     PayloadId id, std::int64_t total_size) {
   auto path = GetDownloadPath(std::to_string(id));
-  return nearby::shared::IOFile::CreateInputFile(path, total_size);
+  return linux::InputFile::Create(path);
 }
 
 std::unique_ptr<InputFile> ImplementationPlatform::CreateInputFile(
     const std::string &file_path, size_t size) {
-  return nearby::shared::IOFile::CreateInputFile(file_path, size);
+  return linux::InputFile::Create(file_path);
 }
 
 std::unique_ptr<OutputFile> ImplementationPlatform::CreateOutputFile(
     PayloadId payload_id) {
-  return nearby::shared::IOFile::CreateOutputFile(
+  return linux::OutputFile::Create(
       GetDownloadPath("", std::to_string(payload_id)));
 }
 
@@ -140,7 +142,7 @@ std::unique_ptr<OutputFile> ImplementationPlatform::CreateOutputFile(
                        << path.parent_path() << ": " << err.what();
   }
 
-  return nearby::shared::IOFile::CreateOutputFile(path.string());
+  return linux::OutputFile::Create(path.string());
 }
 
 std::unique_ptr<api::LogMessage> ImplementationPlatform::CreateLogMessage(
@@ -164,6 +166,12 @@ ImplementationPlatform::CreateScheduledExecutor() {
   return std::make_unique<linux::ScheduledExecutor>();
 }
 
+std::unique_ptr<api::IoReactor> ImplementationPlatform::CreateIoReactor() {
+  auto reactor = std::make_unique<linux::EpollReactor>();
+  if (!reactor->IsValid()) return nullptr;
+  return reactor;
+}
+
 std::unique_ptr<api::BluetoothAdapter>
 ImplementationPlatform::CreateBluetoothAdapter() {
   auto manager =
@@ -299,71 +307,7 @@ std::unique_ptr<api::DeviceInfo> ImplementationPlatform::CreateDeviceInfo() {
 
 absl::StatusOr<api::WebResponse> ImplementationPlatform::SendRequest(
     const WebRequest &request) {
-  if (request.body.size() >= (8 * 1024 * 1024)) {
-    return absl::Status(absl::StatusCode::kResourceExhausted,
-                        "request body too large");
-  }
-
-  CURL *handle = curl_easy_init();
-  char errbuf[CURL_ERROR_SIZE];
-  errbuf[0] = '\0';
-
-  curl_easy_setopt(handle, CURLOPT_URL, request.url.c_str());
-  curl_easy_setopt(handle, CURLOPT_ERRORBUFFER, errbuf);
-
-  if (request.method == "GET")
-    curl_easy_setopt(handle, CURLOPT_HTTPGET, 1L);
-  else if (request.method == "POST")
-    curl_easy_setopt(handle, CURLOPT_POST, 1L);
-  else
-    curl_easy_setopt(handle, CURLOPT_CUSTOMREQUEST, request.method.c_str());
-
-  curl_easy_setopt(handle, CURLOPT_UPLOAD, request.body.c_str());
-
-  struct curl_slist *headers_slist = nullptr;
-
-  for (auto &[key, value] : request.headers) {
-    auto hdr = absl::StrCat(key, ": ", value);
-    auto temp = curl_slist_append(headers_slist, hdr.c_str());
-    if (temp == nullptr) {
-      if (headers_slist != nullptr) {
-        curl_slist_free_all(headers_slist);
-      }
-      return absl::Status(absl::StatusCode::kResourceExhausted,
-                          "failed to append header to slist");
-    }
-  }
-
-  curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headers_slist);
-
-  api::WebResponse response;
-
-  if (curl_easy_perform(handle) != CURLE_OK) {
-    NEARBY_LOGS(ERROR) << __func__
-                       << ": Error performing HTTP request: " << errbuf;
-    return absl::Status(absl::StatusCode::kUnknown, errbuf);
-  }
-
-  struct curl_header *prev = nullptr;
-  struct curl_header *h;
-
-  h = curl_easy_nextheader(handle, CURLH_HEADER, 0, prev);
-  while (h != nullptr) {
-    response.headers.emplace(h->name, h->value);
-  }
-
-  auto writefn = [](char *ptr, size_t size, size_t nmemb, void *userdata) {
-    std::string *body = static_cast<std::string *>(userdata);
-    body->append(ptr, size * nmemb);
-  };
-
-  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writefn);
-  curl_easy_setopt(handle, CURLOPT_WRITEDATA,
-                   static_cast<void *>(&response.body));
-  long status;
-  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &status);
-  response.status_code = status;
-  return response;
+  return linux::CurlMultiClient::GetInstance().SendRequest(request);
 }
 
 #ifndef NEARBY_CHROMIUM
@@ -17,11 +17,17 @@
 #include <optional>
 #include <ostream>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "internal/platform/implementation/linux/preferences_manager.h"
 #include "internal/platform/implementation/linux/preferences_repository.h"
+#include "internal/platform/implementation/platform.h"
 #include "internal/platform/logging.h"
 #include "nlohmann/json.hpp"
 #include "nlohmann/json_fwd.hpp"
@@ -32,8 +38,12 @@ namespace {
 using json = ::nlohmann::json;
 }  // namespace
 
-PreferencesManager::PreferencesManager(absl::string_view file_path)
-    : api::PreferencesManager(file_path) {
+// C++14 requires to declare this.
+constexpr int PreferencesManager::kMaxJournalEntries;
+
+PreferencesManager::PreferencesManager(absl::string_view file_path,
+                                       Options options)
+    : api::PreferencesManager(file_path), options_(options) {
   std::optional<std::filesystem::path> path =
       nearby::api::ImplementationPlatform::CreateDeviceInfo()
           ->GetLocalAppDataPath();
@@ -47,66 +57,56 @@ PreferencesManager::PreferencesManager(absl::string_view file_path)
   value_ = preferences_repository_->LoadPreferences();
 }
 
+PreferencesManager::~PreferencesManager() {
+  // Waits for a running flush and drops the scheduled one.
+  flush_executor_.Shutdown();
+  Flush();
+}
+
 bool PreferencesManager::Set(absl::string_view key, const json& value) {
-  absl::MutexLock lock(&mutex_);
   return SetValue(key, value);
 }
 
 bool PreferencesManager::SetBoolean(absl::string_view key, bool value) {
-  absl::MutexLock lock(&mutex_);
   return SetValue(key, value);
 }
 
 bool PreferencesManager::SetInteger(absl::string_view key, int value) {
-  absl::MutexLock lock(&mutex_);
   return SetValue(key, value);
 }
 
 bool PreferencesManager::SetInt64(absl::string_view key, int64_t value) {
-  absl::MutexLock lock(&mutex_);
   return SetValue(key, value);
 }
 
 bool PreferencesManager::SetString(absl::string_view key,
                                    absl::string_view value) {
-  absl::MutexLock lock(&mutex_);
   return SetValue(key, absl::StrCat(value));
 }
 
 bool PreferencesManager::SetBooleanArray(absl::string_view key,
                                          absl::Span<const bool> value) {
-  absl::MutexLock lock(&mutex_);
   return SetArrayValue(key, value);
 }
 
 bool PreferencesManager::SetIntegerArray(absl::string_view key,
                                          absl::Span<const int> value) {
-  absl::MutexLock lock(&mutex_);
   return SetArrayValue(key, value);
 }
 
 bool PreferencesManager::SetInt64Array(absl::string_view key,
                                        absl::Span<const int64_t> value) {
-  absl::MutexLock lock(&mutex_);
   return SetArrayValue(key, value);
 }
 
 bool PreferencesManager::SetStringArray(absl::string_view key,
                                         absl::Span<const std::string> value) {
-  absl::MutexLock lock(&mutex_);
   return SetArrayValue(key, value);
 }
 
 bool PreferencesManager::SetTime(absl::string_view key, absl::Time value) {
   // Save time as nanos
-  absl::MutexLock lock(&mutex_);
-  int64_t tt = absl::ToUnixNanos(value);
-  if (value_[absl::StrCat(key)] == tt) {
-    return false;
-  }
-
-  value_[absl::StrCat(key)] = tt;
-  return Commit();
+  return SetValue(key, absl::ToUnixNanos(value));
 }
 
 // Get JSON value.
@@ -177,34 +177,107 @@ absl::Time PreferencesManager::GetTime(absl::string_view key,
 
 // Removes preferences
 void PreferencesManager::Remove(absl::string_view key) {
-  absl::MutexLock lock(&mutex_);
-  value_.erase(absl::StrCat(key));
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!value_.is_object() || value_.erase(absl::StrCat(key)) == 0) {
+      return;
+    }
+  }
+  Commit(key);
 }
 
-// Private methods
+bool PreferencesManager::Flush() {
+  absl::MutexLock write_lock(&write_mutex_);
+  bool use_journal =
+      options_.use_journal &&
+      preferences_repository_->GetJournalSize() < kMaxJournalEntries;
+  absl::flat_hash_set<std::string> dirty_keys;
+  json preferences;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (dirty_keys_.empty()) {
+      return true;
+    }
+    dirty_keys.swap(dirty_keys_);
+    if (use_journal) {
+      preferences = json::array();
+      for (const std::string& key : dirty_keys) {
+        json change = {{"key", key}};
+        auto it = value_.find(key);
+        if (it != value_.end()) {
+          change["value"] = *it;
+        }
+        preferences.push_back(std::move(change));
+      }
+    } else {
+      preferences = value_;
+    }
+  }
 
-// Writes data to storage.
-bool PreferencesManager::Commit() {
-  if (!preferences_repository_->SavePreferences(value_)) {
+  // A failed append may leave a torn change behind, so fall back to rewriting
+  // the whole file, which also clears the journal.
+  bool saved = use_journal &&
+               preferences_repository_->AppendToJournal(preferences);
+  if (!saved) {
+    if (use_journal) {
+      absl::MutexLock lock(&mutex_);
+      preferences = value_;
+    }
+    saved = preferences_repository_->SavePreferences(std::move(preferences));
+  }
+  if (!saved) {
     NEARBY_LOGS(ERROR) << "Failed to save preference." << std::endl;
+    absl::MutexLock lock(&mutex_);
+    dirty_keys_.insert(dirty_keys.begin(), dirty_keys.end());
     return false;
   }
   return true;
 }
 
-bool PreferencesManager::SetValue(absl::string_view key, const json& value) {
-  if (!value_.is_object()) {
-    NEARBY_LOGS(ERROR) << "Preferences is no longer an object! value_="
-                       << value_.dump(4);
-    value_ = json::object();
+// Private methods
+
+bool PreferencesManager::Commit(absl::string_view key) {
+  if (options_.flush_delay <= absl::ZeroDuration()) {
+    {
+      absl::MutexLock lock(&mutex_);
+      dirty_keys_.insert(std::string(key));
+    }
+    return Flush();
   }
 
-  if (value_[absl::StrCat(key)] == value) {
-    return false;
+  absl::MutexLock lock(&mutex_);
+  dirty_keys_.insert(std::string(key));
+  if (!flush_scheduled_) {
+    flush_scheduled_ = true;
+    flush_executor_.Schedule(
+        [this]() {
+          {
+            absl::MutexLock lock(&mutex_);
+            flush_scheduled_ = false;
+          }
+          Flush();
+        },
+        options_.flush_delay);
   }
+  return true;
+}
 
-  value_[absl::StrCat(key)] = value;
-  return Commit();
+bool PreferencesManager::SetValue(absl::string_view key, const json& value) {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!value_.is_object()) {
+      NEARBY_LOGS(ERROR) << "Preferences is no longer an object! value_="
+                         << value_.dump(4);
+      value_ = json::object();
+    }
+
+    if (value_[absl::StrCat(key)] == value) {
+      return false;
+    }
+
+    value_[absl::StrCat(key)] = value;
+  }
+  return Commit(key);
 }
 
 template <typename T>
@@ -226,23 +299,12 @@ T PreferencesManager::GetValue(absl::string_view key,
 template <typename T>
 bool PreferencesManager::SetArrayValue(absl::string_view key,
                                        absl::Span<const T> value) {
-  if (!value_.is_object()) {
-    NEARBY_LOGS(ERROR) << "Preferences is no longer an object! value_="
-                       << value_.dump(4);
-    value_ = json::object();
-  }
-
   json array_value = json::array();
   for (const T& item_value : value) {
     array_value.push_back(item_value);
   }
 
-  if (value_[absl::StrCat(key)] == array_value) {
-    return false;
-  }
-
-  value_[absl::StrCat(key)] = array_value;
-  return Commit();
+  return SetValue(key, array_value);
 }
 
 template <typename T>
@@ -22,11 +22,13 @@
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "internal/platform/implementation/linux/preferences_repository.h"
+#include "internal/platform/implementation/linux/scheduled_executor.h"
 #include "internal/platform/implementation/preferences_manager.h"
 #include "nlohmann/json.hpp"
 #include "nlohmann/json_fwd.hpp"
@@ -38,11 +40,29 @@ namespace linux {
 // Preferences are persistent storage for application settings, it is key/value
 // based settings. Application components can observe the interested preference
 // change by the observer.
+//
+// Changes are written behind: a setter updates the preferences in memory and
+// schedules a write, so a burst of changes is written to storage once. Call
+// Flush() when a change must be on storage before going on. Pending changes
+// are also written when the manager is destroyed.
 class PreferencesManager : public api::PreferencesManager {
  public:
-  explicit PreferencesManager(absl::string_view path);
-
-  // Sets values
+  struct Options {
+    // How long to wait after a change before writing it. Zero writes every
+    // change before the setter returns.
+    absl::Duration flush_delay = absl::Milliseconds(500);
+    // Appends changed keys to a journal instead of rewriting the whole file.
+    // The file is rewritten once the journal grows long.
+    bool use_journal = false;
+  };
+
+  explicit PreferencesManager(absl::string_view path)
+      : PreferencesManager(path, Options()) {}
+  PreferencesManager(absl::string_view path, Options options);
+  ~PreferencesManager() override;
+
+  // Sets values. They return true if the value changed; with a flush delay
+  // the change may not be on storage yet.
 
   bool Set(absl::string_view key, const nlohmann::json& value) override
       ABSL_LOCKS_EXCLUDED(mutex_);
@@ -108,12 +128,20 @@ class PreferencesManager : public api::PreferencesManager {
   // Removes preferences
   void Remove(absl::string_view key) override ABSL_LOCKS_EXCLUDED(mutex_);
 
+  // Writes pending changes to storage and returns once they are written.
+  // Returns false if they couldn't be written; they stay pending then.
+  bool Flush() override ABSL_LOCKS_EXCLUDED(mutex_, write_mutex_);
+
  private:
-  // Writes data to storage.
-  bool Commit() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Threshold of journaled changes after which the whole file is rewritten.
+  static constexpr int kMaxJournalEntries = 256;
+
+  // Writes the change to `key` now or schedules it, depending on the flush
+  // delay.
+  bool Commit(absl::string_view key) ABSL_LOCKS_EXCLUDED(mutex_, write_mutex_);
 
   bool SetValue(absl::string_view key, const nlohmann::json& value)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+      ABSL_LOCKS_EXCLUDED(mutex_, write_mutex_);
 
   template <typename T>
   T GetValue(absl::string_view key, const T& default_value) const
@@ -121,18 +149,28 @@ class PreferencesManager : public api::PreferencesManager {
 
   template <typename T>
   bool SetArrayValue(absl::string_view key, absl::Span<const T> value)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+      ABSL_LOCKS_EXCLUDED(mutex_, write_mutex_);
 
   template <typename T>
   std::vector<T> GetArrayValue(absl::string_view key,
                                absl::Span<const T> default_value) const
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  const Options options_;
+
   nlohmann::json value_ ABSL_GUARDED_BY(mutex_);
+  // Keys changed or removed since the last write.
+  absl::flat_hash_set<std::string> dirty_keys_ ABSL_GUARDED_BY(mutex_);
+  bool flush_scheduled_ ABSL_GUARDED_BY(mutex_) = false;
+  mutable absl::Mutex mutex_;
+
+  // Keeps writes in order. Acquired before `mutex_`; storage is written
+  // without holding `mutex_`, so readers and setters don't wait for it.
+  absl::Mutex write_mutex_ ABSL_ACQUIRED_BEFORE(mutex_);
   std::unique_ptr<PreferencesRepository> preferences_repository_
-      ABSL_GUARDED_BY(mutex_);
+      ABSL_GUARDED_BY(write_mutex_);
 
-  mutable absl::Mutex mutex_;
+  ScheduledExecutor flush_executor_;
 };
 
 }  // namespace linux
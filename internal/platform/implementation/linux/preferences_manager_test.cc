@@ -38,6 +38,15 @@ namespace {
 using json = ::nlohmann::json;
 constexpr absl::Duration kTimeOut = absl::Milliseconds(200);
 constexpr char kPreferencesFilePath[] = "Google/Nearby/Sharing";
+
+// Returns an empty directory for the preferences of one test.
+std::filesystem::path CreateEmptyDirectory(absl::string_view name) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / std::string(name);
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path);
+  return path;
+}
 }  // namespace
 
 TEST(PreferencesManager, CorruptedConfigFile) {
@@ -181,5 +190,57 @@ TEST(PreferencesManager, RemoveKey) {
   EXPECT_EQ(result, "default key");
 }
 
+TEST(PreferencesManager, WriteBehindWritesOnFlush) {
+  std::filesystem::path path = CreateEmptyDirectory("write_behind_flush");
+  PreferencesManager pm(path.string(), {.flush_delay = absl::Hours(1)});
+
+  EXPECT_TRUE(pm.SetInteger("data", 8));
+  EXPECT_TRUE(pm.SetString("name", "Valid"));
+  EXPECT_FALSE(std::filesystem::exists(path / "preferences.json"));
+
+  EXPECT_TRUE(pm.Flush());
+  PreferencesManager reloaded(path.string());
+  EXPECT_EQ(reloaded.GetInteger("data", 100), 8);
+  EXPECT_EQ(reloaded.GetString("name", ""), "Valid");
+}
+
+TEST(PreferencesManager, WriteBehindWritesAfterDelay) {
+  std::filesystem::path path = CreateEmptyDirectory("write_behind_delay");
+  PreferencesManager pm(path.string(),
+                        {.flush_delay = absl::Milliseconds(10)});
+
+  pm.SetInteger("data", 8);
+  absl::SleepFor(kTimeOut);
+
+  EXPECT_EQ(PreferencesManager(path.string()).GetInteger("data", 100), 8);
+}
+
+TEST(PreferencesManager, WriteBehindWritesOnDestruction) {
+  std::filesystem::path path = CreateEmptyDirectory("write_behind_destroy");
+  {
+    PreferencesManager pm(path.string(), {.flush_delay = absl::Hours(1)});
+    pm.SetInteger("data", 8);
+  }
+
+  EXPECT_EQ(PreferencesManager(path.string()).GetInteger("data", 100), 8);
+}
+
+TEST(PreferencesManager, JournalKeepsChangesAndRemovals) {
+  std::filesystem::path path = CreateEmptyDirectory("journal");
+  PreferencesManager::Options options = {.flush_delay = absl::ZeroDuration(),
+                                         .use_journal = true};
+  {
+    PreferencesManager pm(path.string(), options);
+    pm.SetInteger("data", 8);
+    pm.SetString("name", "Valid");
+    pm.Remove("data");
+  }
+
+  EXPECT_FALSE(std::filesystem::exists(path / "preferences.json"));
+  PreferencesManager reloaded(path.string(), options);
+  EXPECT_EQ(reloaded.GetInteger("data", 100), 100);
+  EXPECT_EQ(reloaded.GetString("name", ""), "Valid");
+}
+
 }  // namespace linux
 }  // namespace nearby
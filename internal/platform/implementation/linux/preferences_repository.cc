@@ -11,11 +11,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
 #include <exception>
 #include <filesystem>  // NOLINT(build/c++17)
 #include <fstream>
 #include <optional>
+#include <string>
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "internal/platform/implementation/linux/preferences_repository.h"
 #include "internal/platform/logging.h"
 #include "nlohmann/json.hpp"
@@ -28,11 +36,62 @@ using json = ::nlohmann::json;
 
 constexpr char kPreferencesFileName[] = "preferences.json";
 constexpr char kPreferencesBackupFileName[] = "preferences_bak.json";
+constexpr char kPreferencesTempFileName[] = "preferences_tmp.json";
+constexpr char kPreferencesJournalFileName[] = "preferences_journal.json";
+
+// Writes `contents` to the file and waits until it is on storage.
+bool WriteFile(const std::filesystem::path& file_name,
+               absl::string_view contents, bool append) {
+  FILE* file = std::fopen(file_name.c_str(), append ? "ab" : "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool written =
+      std::fwrite(contents.data(), 1, contents.size(), file) ==
+          contents.size() &&
+      std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+  bool closed = std::fclose(file) == 0;
+  return written && closed;
+}
+
+// Finishes a save that was interrupted after the journal was removed, or drops
+// the temporary file of a save that was interrupted before.
+void RecoverInterruptedSave(const std::filesystem::path& path) {
+  std::filesystem::path full_name = path / kPreferencesFileName;
+  std::filesystem::path full_name_temp = path / kPreferencesTempFileName;
+  std::filesystem::path full_name_journal = path / kPreferencesJournalFileName;
+  if (!std::filesystem::exists(full_name_temp)) {
+    return;
+  }
+
+  if (!std::filesystem::exists(full_name_journal)) {
+    std::ifstream temp_file(full_name_temp.c_str());
+    if (!json::parse(temp_file, nullptr, false).is_discarded()) {
+      temp_file.close();
+      NEARBY_LOGS(INFO) << "Completing interrupted save of preferences.";
+      std::filesystem::rename(full_name_temp, full_name);
+      return;
+    }
+  }
+  std::filesystem::remove(full_name_temp);
+}
 
 }  // namespace
 
 json PreferencesRepository::LoadPreferences() {
   absl::MutexLock lock(&mutex_);
+  try {
+    RecoverInterruptedSave(path_);
+  } catch (const std::exception& e) {
+    NEARBY_LOGS(ERROR) << "Failed to recover interrupted save: " << e.what();
+  }
+
+  json preferences = LoadPreferencesFile();
+  ReplayJournal(preferences);
+  return preferences;
+}
+
+json PreferencesRepository::LoadPreferencesFile() {
   std::optional<json> preferences = AttemptLoad();
   if (preferences.has_value()) {
     // The top level root should be an object, if it's not then something went
@@ -74,35 +133,72 @@ bool PreferencesRepository::SavePreferences(json preferences) {
 
     std::filesystem::path full_name = path / kPreferencesFileName;
     std::filesystem::path full_name_backup = path / kPreferencesBackupFileName;
+    std::filesystem::path full_name_temp = path / kPreferencesTempFileName;
+    std::filesystem::path full_name_journal =
+        path / kPreferencesJournalFileName;
+
+    // Write the new file aside, so the current one stays intact until the new
+    // one is complete.
+    if (!WriteFile(full_name_temp, preferences.dump(), /*append=*/false)) {
+      NEARBY_LOGS(ERROR) << "Failed to write preferences file.";
+      std::filesystem::remove(full_name_temp);
+      return false;
+    }
+
+    // The new file holds every journaled change. Once the journal is gone, a
+    // complete temporary file is taken as the latest preferences on load.
+    std::filesystem::remove(full_name_journal);
+    journal_size_ = 0;
 
     // Create a backup without moving the bytes on disk
     if (std::filesystem::exists(full_name)) {
       NEARBY_LOGS(INFO) << "Making backup of preferences file.";
       std::filesystem::rename(full_name, full_name_backup);
     }
+    std::filesystem::rename(full_name_temp, full_name);
+  } catch (const std::exception& e) {
+    NEARBY_LOGS(ERROR) << "Failed to save preferences file: " << e.what();
+    return false;
+  }
 
-    std::ofstream preferences_file(full_name.c_str());
-    preferences_file << preferences;
-    preferences_file.close();
+  return true;
+}
 
-    // Make sure the file wasn't saved in a corrupted state
-    if (!AttemptLoad().has_value()) {
-      NEARBY_LOGS(ERROR) << "Preferences saved to disk in corrupted state. "
-                            "Restoring from backup.";
+bool PreferencesRepository::AppendToJournal(const json& changes) {
+  absl::MutexLock lock(&mutex_);
+  try {
+    std::filesystem::path path = path_;
+    if (!std::filesystem::exists(path) &&
+        !std::filesystem::create_directories(path)) {
+      NEARBY_LOGS(ERROR) << "Failed to create preferences path.";
+      return false;
+    }
 
-      if (!RestoreFromBackup().has_value()) {
-        NEARBY_LOGS(ERROR) << "Failed to restore preferences file.";
-        return false;
-      }
+    // One change per line, so a torn write only loses the last change.
+    std::string lines;
+    for (const json& change : changes) {
+      absl::StrAppend(&lines, change.dump(), "\n");
     }
+    if (!WriteFile(path / kPreferencesJournalFileName, lines,
+                   /*append=*/true)) {
+      NEARBY_LOGS(ERROR) << "Failed to append to preferences journal.";
+      return false;
+    }
+    journal_size_ += static_cast<int>(changes.size());
   } catch (const std::exception& e) {
-    NEARBY_LOGS(ERROR) << "Failed to save preferences file: " << e.what();
+    NEARBY_LOGS(ERROR) << "Failed to append to preferences journal: "
+                       << e.what();
     return false;
   }
 
   return true;
 }
 
+int PreferencesRepository::GetJournalSize() {
+  absl::MutexLock lock(&mutex_);
+  return journal_size_;
+}
+
 std::optional<json> PreferencesRepository::AttemptLoad() {
   std::filesystem::path path = path_;
   std::filesystem::path full_name = path / kPreferencesFileName;
@@ -131,6 +227,49 @@ std::optional<json> PreferencesRepository::AttemptLoad() {
   }
 }
 
+void PreferencesRepository::ReplayJournal(json& preferences) {
+  journal_size_ = 0;
+  std::filesystem::path full_name_journal =
+      std::filesystem::path(path_) / kPreferencesJournalFileName;
+  try {
+    if (!std::filesystem::exists(full_name_journal)) {
+      return;
+    }
+
+    std::ifstream journal_file(full_name_journal.c_str());
+    std::string line;
+    std::uintmax_t valid_size = 0;
+    while (std::getline(journal_file, line)) {
+      json change = json::parse(line, nullptr, false);
+      if (change.is_discarded() || !change.is_object() ||
+          !change.contains("key") || !change["key"].is_string()) {
+        break;
+      }
+      const auto& key = change["key"].get_ref<const std::string&>();
+      auto value = change.find("value");
+      if (value == change.end()) {
+        preferences.erase(key);
+      } else {
+        preferences[key] = *value;
+      }
+      ++journal_size_;
+      valid_size += line.size() + 1;
+    }
+    journal_file.close();
+
+    // Drop a torn last change, so that later changes are appended after the
+    // valid ones.
+    if (std::filesystem::file_size(full_name_journal) > valid_size) {
+      NEARBY_LOGS(ERROR) << "Preferences journal corrupted after "
+                         << journal_size_ << " changes.";
+      std::filesystem::resize_file(full_name_journal, valid_size);
+    }
+  } catch (const std::exception& e) {
+    NEARBY_LOGS(ERROR) << "Exception while replaying preferences journal: "
+                       << e.what();
+  }
+}
+
 std::optional<json> PreferencesRepository::RestoreFromBackup() {
   std::filesystem::path path = path_;
   std::filesystem::path full_name = path / kPreferencesFileName;
@@ -35,15 +35,32 @@ class PreferencesRepository {
  public:
   explicit PreferencesRepository(absl::string_view path) : path_(path) {}
 
+  // Loads the preferences file and replays the journal on top of it.
   nlohmann::json LoadPreferences() ABSL_LOCKS_EXCLUDED(&mutex_);
+  // Replaces the preferences file with `preferences` and clears the journal.
+  // The new file is written aside and renamed into place, so a failed write
+  // never leaves a partial file behind.
   bool SavePreferences(nlohmann::json preferences) ABSL_LOCKS_EXCLUDED(&mutex_);
+  // Appends `changes` to the journal. Each change is an object holding the key
+  // under "key" and, unless the key was removed, its value under "value".
+  bool AppendToJournal(const nlohmann::json& changes)
+      ABSL_LOCKS_EXCLUDED(&mutex_);
+  // Returns the number of changes in the journal.
+  int GetJournalSize() ABSL_LOCKS_EXCLUDED(&mutex_);
 
   std::optional<nlohmann::json> AttemptLoad();
   std::optional<nlohmann::json> RestoreFromBackup();
 
  private:
+  // Loads the preferences file, or its backup if it is corrupted.
+  nlohmann::json LoadPreferencesFile() ABSL_EXCLUSIVE_LOCKS_REQUIRED(&mutex_);
+  // Applies the changes in the journal to `preferences`.
+  void ReplayJournal(nlohmann::json& preferences)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(&mutex_);
+
   absl::Mutex mutex_;
   const std::string path_;
+  int journal_size_ ABSL_GUARDED_BY(&mutex_) = 0;
 };
 
 }  // namespace linux
@@ -31,6 +31,7 @@ using json = ::nlohmann::json;
 
 constexpr char kPreferencesFileName[] = "preferences.json";
 constexpr char kPreferencesBackupFileName[] = "preferences_bak.json";
+constexpr char kPreferencesJournalFileName[] = "preferences_journal.json";
 constexpr char kPreferencesPath[] = "Google/Nearby/Sharing";
 
 TEST(PreferencesRepository, LoadWithBadPath) {
@@ -155,6 +156,72 @@ TEST(PreferencesRepository, RecoverFromCorruption) {
   EXPECT_FALSE(std::filesystem::exists(full_name_backup));
 }
 
+TEST(PreferencesRepository, LoadReplaysJournal) {
+  std::filesystem::path full_path =
+      std::filesystem::temp_directory_path() / "preferences_journal_test";
+  std::filesystem::remove_all(full_path);
+
+  PreferencesRepository preferences_repository{full_path.string()};
+  json data;
+  data["key1"] = "value1";
+  data["key2"] = "value2";
+  EXPECT_TRUE(preferences_repository.SavePreferences(data));
+  EXPECT_TRUE(preferences_repository.AppendToJournal(
+      {{{"key", "key1"}, {"value", "changed"}}, {{"key", "key2"}}}));
+  EXPECT_EQ(preferences_repository.GetJournalSize(), 2);
+
+  json result = PreferencesRepository{full_path.string()}.LoadPreferences();
+  EXPECT_EQ(result.size(), 1);
+  EXPECT_EQ(result["key1"], "changed");
+  std::filesystem::remove_all(full_path);
+}
+
+TEST(PreferencesRepository, LoadIgnoresTornJournalEntry) {
+  std::filesystem::path full_path =
+      std::filesystem::temp_directory_path() / "preferences_torn_journal_test";
+  std::filesystem::remove_all(full_path);
+  std::filesystem::create_directories(full_path);
+  std::ofstream journal_file((full_path / kPreferencesJournalFileName).c_str());
+  journal_file << R"({"key":"key1","value":"value1"})" << "\n"
+               << R"({"key":"ke)";
+  journal_file.close();
+
+  PreferencesRepository preferences_repository{full_path.string()};
+  json result = preferences_repository.LoadPreferences();
+  EXPECT_EQ(result.size(), 1);
+  EXPECT_EQ(result["key1"], "value1");
+  EXPECT_EQ(preferences_repository.GetJournalSize(), 1);
+
+  // Later changes are appended after the valid ones.
+  EXPECT_TRUE(preferences_repository.AppendToJournal(
+      {{{"key", "key2"}, {"value", "value2"}}}));
+  result = PreferencesRepository{full_path.string()}.LoadPreferences();
+  EXPECT_EQ(result["key2"], "value2");
+  std::filesystem::remove_all(full_path);
+}
+
+TEST(PreferencesRepository, SaveClearsJournal) {
+  std::filesystem::path full_path =
+      std::filesystem::temp_directory_path() / "preferences_save_test";
+  std::filesystem::remove_all(full_path);
+
+  PreferencesRepository preferences_repository{full_path.string()};
+  EXPECT_TRUE(preferences_repository.AppendToJournal(
+      {{{"key", "key1"}, {"value", "value1"}}}));
+  json data;
+  data["key2"] = "value2";
+  EXPECT_TRUE(preferences_repository.SavePreferences(data));
+
+  EXPECT_EQ(preferences_repository.GetJournalSize(), 0);
+  EXPECT_FALSE(
+      std::filesystem::exists(full_path / kPreferencesJournalFileName));
+  EXPECT_FALSE(std::filesystem::exists(full_path / "preferences_tmp.json"));
+  json result = PreferencesRepository{full_path.string()}.LoadPreferences();
+  EXPECT_EQ(result.size(), 1);
+  EXPECT_EQ(result["key2"], "value2");
+  std::filesystem::remove_all(full_path);
+}
+
 }  // namespace
 }  // namespace linux
 }  // namespace nearby
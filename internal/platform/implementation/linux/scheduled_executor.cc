@@ -14,19 +14,46 @@
 
 #include "internal/platform/implementation/linux/scheduled_executor.h"
 
-#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "internal/platform/logging.h"
 
 namespace nearby {
 namespace linux {
 
-ScheduledExecutor::ScheduledExecutor()
-    : executor_(std::make_unique<nearby::linux::Executor>()),
-      shut_down_(false) {}
+bool ScheduledExecutor::ScheduledTask::Cancel() {
+  Status expected = kNotRun;
+  if (!status_.compare_exchange_strong(expected, kCanceled)) {
+    return false;
+  }
+
+  // Drop the task from the queue right away rather than when its deadline
+  // comes up, so cancelled long timeouts do not accumulate.
+  std::shared_ptr<TimerQueue> timers = timers_.lock();
+  if (timers != nullptr) {
+    absl::MutexLock lock(&timers->mutex);
+    timers->tasks.erase(key_);
+  }
+  return true;
+}
+
+ScheduledExecutor::ScheduledExecutor(size_t max_concurrency)
+    : executor_(std::make_unique<nearby::linux::Executor>(max_concurrency)),
+      timers_(std::make_shared<TimerQueue>()),
+      shut_down_(false) {
+  timer_thread_ = std::thread([this]() { RunTimerLoop(); });
+}
+
+ScheduledExecutor::~ScheduledExecutor() {
+  if (!shut_down_) {
+    Shutdown();
+  }
+}
 
 // Cancelable is kept both in the executor context, and in the caller context.
 // We want Cancelable to live until both caller and executor are done with it.
@@ -41,18 +68,17 @@ std::shared_ptr<api::Cancelable> ScheduledExecutor::Schedule(
     return nullptr;
   }
 
-  // Cleans completed tasks
-  scheduled_tasks_.erase(
-      std::remove_if(
-          scheduled_tasks_.begin(), scheduled_tasks_.end(),
-          [](std::shared_ptr<ScheduledTask> &task) { return task->IsDone(); }),
-      scheduled_tasks_.end());
-
   std::shared_ptr<ScheduledTask> task =
-      std::make_shared<ScheduledTask>(std::move(runnable), duration);
+      std::make_shared<ScheduledTask>(std::move(runnable), timers_);
 
-  scheduled_tasks_.push_back(task);
-  executor_->Execute([task]() { task->Start(); });
+  absl::MutexLock lock(&timers_->mutex);
+  TimerKey key{absl::Now() + duration, timers_->next_sequence++};
+  task->SetKey(key);
+  auto [it, inserted] = timers_->tasks.emplace(key, task);
+  // Only a new earliest deadline changes how long the timer thread sleeps.
+  if (it == timers_->tasks.begin()) {
+    timers_->cond.Signal();
+  }
   return task;
 }
 
@@ -69,16 +95,69 @@ void ScheduledExecutor::Execute(Runnable &&runnable) {
 void ScheduledExecutor::Shutdown() {
   if (!shut_down_) {
     shut_down_ = true;
-    for (auto &task : scheduled_tasks_) {
+    {
+      absl::MutexLock lock(&timers_->mutex);
+      timers_->shut_down = true;
+      timers_->cond.Signal();
+    }
+    timer_thread_.join();
+
+    // Whatever is still queued will never run.
+    std::vector<std::shared_ptr<ScheduledTask>> pending;
+    {
+      absl::MutexLock lock(&timers_->mutex);
+      for (auto &entry : timers_->tasks) {
+        pending.push_back(std::move(entry.second));
+      }
+      timers_->tasks.clear();
+    }
+    for (auto &task : pending) {
       task->Cancel();
     }
 
-    scheduled_tasks_.clear();
     executor_->Shutdown();
     return;
   }
   NEARBY_LOGS(ERROR) << __func__
                      << ": Attempt to Shutdown on a shut down executor.";
 }
+
+void ScheduledExecutor::RunTimerLoop() {
+  std::vector<std::shared_ptr<ScheduledTask>> expired;
+  while (true) {
+    {
+      absl::MutexLock lock(&timers_->mutex);
+      while (!timers_->shut_down) {
+        if (timers_->tasks.empty()) {
+          timers_->cond.Wait(&timers_->mutex);
+          continue;
+        }
+        absl::Time now = absl::Now();
+        auto it = timers_->tasks.begin();
+        if (it->first.first > now) {
+          timers_->cond.WaitWithDeadline(&timers_->mutex, it->first.first);
+          continue;
+        }
+        // Pop everything that is due in one pass.
+        while (it != timers_->tasks.end() && it->first.first <= now) {
+          expired.push_back(std::move(it->second));
+          it = timers_->tasks.erase(it);
+        }
+        break;
+      }
+      if (timers_->shut_down) return;
+    }
+
+    // Dispatch outside the lock so Schedule() and Cancel() are never blocked
+    // on the worker queue.
+    for (auto &task : expired) {
+      if (task->MarkExecuted()) {
+        executor_->Execute([task]() { task->Run(); });
+      }
+    }
+    expired.clear();
+  }
+}
+
 }  // namespace linux
 }  // namespace nearby
@@ -15,15 +15,20 @@
 #ifndef PLATFORM_IMPL_LINUX_SCHEDULED_EXECUTOR_H_
 #define PLATFORM_IMPL_LINUX_SCHEDULED_EXECUTOR_H_
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <thread>  // NOLINT
 #include <utility>
-#include <vector>
 
-#include "absl/synchronization/notification.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/btree_map.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "internal/platform/implementation/cancelable.h"
 #include "internal/platform/implementation/linux/executor.h"
 #include "internal/platform/implementation/scheduled_executor.h"
+#include "internal/platform/runnable.h"
 
 namespace nearby {
 namespace linux {
@@ -33,12 +38,19 @@ namespace linux {
 // An Executor that can schedule commands to run after a given delay, or to
 // execute periodically.
 //
+// Pending tasks are kept in a single deadline-ordered queue that is driven by
+// one timer thread; no thread is parked per pending task. When a deadline
+// expires the task is handed to the worker executor, so a long delay never
+// holds up a shorter one scheduled after it.
+//
 // https://docs.oracle.com/javase/8/docs/api/java/util/concurrent/ScheduledExecutorService.html
 class ScheduledExecutor : public api::ScheduledExecutor {
  public:
-  ScheduledExecutor();
+  // |max_concurrency| is the number of worker threads running expired and
+  // immediate tasks. The default of 1 keeps tasks serialized.
+  explicit ScheduledExecutor(size_t max_concurrency = 1);
 
-  ~ScheduledExecutor() override = default;
+  ~ScheduledExecutor() override;
 
   // Cancelable is kept both in the executor context, and in the caller context.
   // We want Cancelable to live until both caller and executor are done with it.
@@ -54,43 +66,62 @@ class ScheduledExecutor : public api::ScheduledExecutor {
   void Shutdown() override;
 
  private:
+  class ScheduledTask;
+
+  // Tasks are ordered by deadline; the sequence number breaks ties so tasks
+  // with equal deadlines fire in the order they were scheduled, and makes
+  // each key unique so a task can be erased in O(log n) on cancel.
+  using TimerKey = std::pair<absl::Time, std::uint64_t>;
+
+  // State shared between the executor and the Cancelables it hands out, which
+  // may outlive it.
+  struct TimerQueue {
+    absl::Mutex mutex;
+    absl::CondVar cond;
+    absl::btree_map<TimerKey, std::shared_ptr<ScheduledTask>> tasks
+        ABSL_GUARDED_BY(mutex);
+    std::uint64_t next_sequence ABSL_GUARDED_BY(mutex) = 0;
+    bool shut_down ABSL_GUARDED_BY(mutex) = false;
+  };
+
   class ScheduledTask : public api::Cancelable {
    public:
-    explicit ScheduledTask(Runnable&& task, absl::Duration duration)
-        : task_(std::move(task)), duration_(duration) {}
+    ScheduledTask(Runnable&& task, std::weak_ptr<TimerQueue> timers)
+        : task_(std::move(task)), timers_(std::move(timers)) {}
 
-    bool Cancel() override {
-      if (is_executed_ || is_cancelled_) {
-        return false;
-      }
-
-      is_cancelled_ = true;
-      notification_.Notify();
-      return true;
-    };
+    bool Cancel() override;
 
-    void Start() {
-      if (is_executed_ ||
-          notification_.WaitForNotificationWithTimeout(duration_)) {
-        return;
-      }
+    // Claims the task for execution. Returns false if it has been cancelled.
+    bool MarkExecuted() {
+      Status expected = kNotRun;
+      return status_.compare_exchange_strong(expected, kExecuted);
+    }
 
-      is_executed_ = true;
-      task_();
+    void Run() {
+      Runnable task = std::move(task_);
+      task();
     }
 
-    bool IsDone() const { return is_cancelled_ || is_executed_; }
+    void SetKey(const TimerKey& key) { key_ = key; }
 
    private:
+    enum Status {
+      kNotRun,
+      kExecuted,
+      kCanceled,
+    };
+
     Runnable task_;
-    absl::Duration duration_;
-    absl::Notification notification_;
-    bool is_cancelled_ = false;
-    bool is_executed_ = false;
+    std::weak_ptr<TimerQueue> timers_;
+    TimerKey key_;
+    std::atomic<Status> status_ = kNotRun;
   };
 
+  void RunTimerLoop();
+
   std::unique_ptr<nearby::linux::Executor> executor_ = nullptr;
-  std::vector<std::shared_ptr<ScheduledTask>> scheduled_tasks_;
+  std::shared_ptr<TimerQueue> timers_;
+  std::thread timer_thread_;
   std::atomic_bool shut_down_ = false;
 };
 
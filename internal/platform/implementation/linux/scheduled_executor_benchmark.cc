@@ -0,0 +1,95 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "internal/platform/implementation/linux/scheduled_executor.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+// Schedules state.range(0) timers with deadlines spread evenly over
+// kScheduleWindow and reports how late they fired relative to their deadline.
+constexpr absl::Duration kScheduleWindow = absl::Milliseconds(500);
+
+void BM_ScheduleFiringLatency(benchmark::State& state) {
+  const int timer_count = state.range(0);
+  std::vector<absl::Duration> latencies(timer_count);
+
+  for (auto _ : state) {
+    ScheduledExecutor executor;
+    absl::BlockingCounter fired(timer_count);
+    absl::Time start = absl::Now();
+    for (int i = 0; i < timer_count; ++i) {
+      absl::Duration delay = kScheduleWindow * i / timer_count;
+      absl::Time deadline = start + delay;
+      executor.Schedule(
+          [&latencies, &fired, deadline, i]() {
+            latencies[i] = absl::Now() - deadline;
+            fired.DecrementCount();
+          },
+          deadline - absl::Now());
+    }
+    fired.Wait();
+    executor.Shutdown();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile_us = [&](double p) {
+    return absl::ToDoubleMicroseconds(
+        latencies[static_cast<size_t>(p * (timer_count - 1))]);
+  };
+  state.counters["p50_us"] = percentile_us(0.5);
+  state.counters["p99_us"] = percentile_us(0.99);
+  state.counters["max_us"] = percentile_us(1.0);
+  state.SetItemsProcessed(state.iterations() * timer_count);
+}
+
+BENCHMARK(BM_ScheduleFiringLatency)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Measures the cost of scheduling and then cancelling a timer while many
+// others are pending.
+void BM_ScheduleAndCancel(benchmark::State& state) {
+  ScheduledExecutor executor;
+  std::vector<std::shared_ptr<api::Cancelable>> pending;
+  for (int i = 0; i < state.range(0); ++i) {
+    pending.push_back(executor.Schedule([]() {}, absl::Hours(1)));
+  }
+
+  for (auto _ : state) {
+    auto cancelable = executor.Schedule([]() {}, absl::Minutes(30));
+    benchmark::DoNotOptimize(cancelable->Cancel());
+  }
+  executor.Shutdown();
+}
+
+BENCHMARK(BM_ScheduleAndCancel)->Arg(1000)->Arg(100000);
+
+}  // namespace
+}  // namespace linux
+}  // namespace nearby
+
+BENCHMARK_MAIN();
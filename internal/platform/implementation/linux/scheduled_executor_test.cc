@@ -173,6 +173,47 @@ TEST(ScheduledExecutorTests, CancelAfterStartedFails) {
   ASSERT_EQ(output, expected);
 }
 
+TEST(ScheduledExecutorTests, ShortDelayIsNotBlockedByLongDelay) {
+  absl::Notification short_notification;
+  absl::Notification long_notification;
+  auto scheduled_executor = std::make_unique<ScheduledExecutor>();
+
+  // Act
+  scheduled_executor->Schedule([&]() { long_notification.Notify(); },
+                               absl::Seconds(30));
+  scheduled_executor->Schedule([&]() { short_notification.Notify(); },
+                               absl::Milliseconds(50));
+
+  // Assert
+  EXPECT_TRUE(short_notification.WaitForNotificationWithTimeout(
+      absl::Milliseconds(500)));
+  EXPECT_FALSE(long_notification.HasBeenNotified());
+  scheduled_executor->Shutdown();
+  EXPECT_FALSE(long_notification.HasBeenNotified());
+}
+
+TEST(ScheduledExecutorTests, TasksRunInDeadlineOrder) {
+  absl::Notification notification;
+  auto scheduled_executor = std::make_unique<ScheduledExecutor>();
+  std::string output;
+
+  // Act
+  scheduled_executor->Schedule([&]() { output.append("c"); },
+                               absl::Milliseconds(150));
+  scheduled_executor->Schedule([&]() { output.append("a"); },
+                               absl::Milliseconds(50));
+  scheduled_executor->Schedule([&]() { output.append("b"); },
+                               absl::Milliseconds(100));
+  scheduled_executor->Schedule([&]() { notification.Notify(); },
+                               absl::Milliseconds(200));
+
+  // Assert
+  ASSERT_TRUE(
+      notification.WaitForNotificationWithTimeout(absl::Milliseconds(2000)));
+  scheduled_executor->Shutdown();
+  EXPECT_EQ(output, "abc");
+}
+
 }  // namespace
 }  // namespace linux
 }  // namespace nearby
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <array>
 #include <cerrno>
 #include <cstdint>
+#include <cstring>
 
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/implementation/linux/stream.h"
@@ -45,8 +48,24 @@ ExceptionOr<ByteArray> InputStream::Read(std::int64_t size) {
   return ExceptionOr(ByteArray(std::move(buffer)));
 }
 
+ExceptionOr<size_t> InputStream::ReadInto(absl::Span<char> buffer) {
+  if (!fd_.isValid()) return {Exception::kIo};
+
+  while (true) {
+    ssize_t ret = recv(fd_.get(), buffer.data(), buffer.size(), 0);
+    if (ret >= 0) return ExceptionOr<size_t>(static_cast<size_t>(ret));
+    if (errno == EINTR) continue;
+    NEARBY_LOGS(ERROR) << __func__
+                       << ": error reading from fd: " << std::strerror(errno);
+    return {Exception::kIo};
+  }
+}
+
 Exception InputStream::Close() {
   if (!fd_.isValid()) return Exception{Exception::kIo};
+  // Closing our descriptor alone neither unblocks a recv() in progress nor
+  // wakes a poller holding a duplicate; shutting down the read side does both.
+  shutdown(fd_.get(), SHUT_RD);
   fd_.reset();
   return {};
 }
@@ -56,8 +75,10 @@ Exception OutputStream::Write(const ByteArray &data) {
 
   size_t written = 0;
   while (written < data.size()) {
-    ssize_t ret = write(fd_.get(), data.data(), data.size());
+    ssize_t ret =
+        write(fd_.get(), data.data() + written, data.size() - written);
     if (ret < 0) {
+      if (errno == EINTR) continue;
       NEARBY_LOGS(ERROR) << __func__
                          << ": error writing to fd: " << std::strerror(errno);
       return Exception{Exception::kIo};
@@ -67,11 +88,58 @@ Exception OutputStream::Write(const ByteArray &data) {
   return Exception{Exception::kSuccess};
 }
 
+Exception OutputStream::GatherWrite(
+    absl::Span<const ByteArray *const> buffers) {
+  // Frames are at most a header, a body and a trailer; anything longer is
+  // unusual enough to take the one-write-per-buffer path.
+  constexpr size_t kMaxGatherBuffers = 8;
+  if (buffers.size() > kMaxGatherBuffers) {
+    return nearby::OutputStream::GatherWrite(buffers);
+  }
+  if (!fd_.isValid()) return Exception{Exception::kIo};
+
+  std::array<iovec, kMaxGatherBuffers> iov;
+  size_t iov_count = 0;
+  for (const ByteArray *buffer : buffers) {
+    if (buffer->Empty()) continue;
+    iov[iov_count].iov_base = const_cast<char *>(buffer->data());
+    iov[iov_count].iov_len = buffer->size();
+    ++iov_count;
+  }
+
+  iovec *pending = iov.data();
+  while (iov_count > 0) {
+    ssize_t ret = writev(fd_.get(), pending, iov_count);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      NEARBY_LOGS(ERROR) << __func__
+                         << ": error writing to fd: " << std::strerror(errno);
+      return Exception{Exception::kIo};
+    }
+    // Skip the buffers the kernel fully consumed and trim the one it stopped
+    // in the middle of, then retry with whatever is left.
+    size_t wrote = ret;
+    while (iov_count > 0 && wrote >= pending->iov_len) {
+      wrote -= pending->iov_len;
+      ++pending;
+      --iov_count;
+    }
+    if (iov_count > 0) {
+      pending->iov_base = static_cast<char *>(pending->iov_base) + wrote;
+      pending->iov_len -= wrote;
+    }
+  }
+  return Exception{Exception::kSuccess};
+}
+
 Exception OutputStream::Flush() { return Exception{Exception::kSuccess}; }
 
 Exception OutputStream::Close() {
   if (!fd_.isValid()) return Exception{Exception::kIo};
 
+  // A poller may still hold a duplicate of the socket; shutting down the
+  // write side lets the peer see the close regardless.
+  shutdown(fd_.get(), SHUT_WR);
   auto ret = close(fd_.get()) < 0 ? Exception{Exception::kIo}
                                   : Exception{Exception::kSuccess};
   fd_.reset();
@@ -19,6 +19,7 @@
 
 #include <sdbus-c++/Types.h>
 
+#include "absl/types/span.h"
 #include "internal/platform/input_stream.h"
 #include "internal/platform/output_stream.h"
 
@@ -33,9 +34,16 @@ class InputStream : public nearby::InputStream {
   explicit InputStream(sdbus::UnixFd fd) : fd_(std::move(fd)){};
 
   ExceptionOr<ByteArray> Read(std::int64_t size) override;
+  // Receives straight into `buffer`, returning as soon as any data arrives.
+  ExceptionOr<size_t> ReadInto(absl::Span<char> buffer) override;
+  bool SupportsPartialReads() const override { return true; }
 
   Exception Close() override;
 
+  int GetReadinessFd() const override {
+    return fd_.isValid() ? fd_.get() : -1;
+  }
+
  private:
   sdbus::UnixFd fd_;
 };
@@ -45,6 +53,9 @@ class OutputStream : public nearby::OutputStream {
   explicit OutputStream(sdbus::UnixFd fd) : fd_(std::move(fd)){};
 
   Exception Write(const ByteArray &data) override;
+  // Sends all buffers with a single writev() per attempt, so a frame's length
+  // prefix and body leave in the same syscall.
+  Exception GatherWrite(absl::Span<const ByteArray *const> buffers) override;
   Exception Flush() override;
   Exception Close() override;
 
@@ -14,6 +14,9 @@
 
 #include "internal/platform/implementation/linux/submittable_executor.h"
 
+#include <memory>
+#include <utility>
+
 #include "internal/platform/implementation/linux/executor.h"
 #include "internal/platform/logging.h"
 
@@ -24,6 +27,12 @@ SubmittableExecutor::SubmittableExecutor(size_t max_concurrancy)
     : executor_(std::make_unique<nearby::linux::Executor>(max_concurrancy)),
       shut_down_(false) {}
 
+SubmittableExecutor::SubmittableExecutor(
+    std::shared_ptr<WorkStealingThreadPool> shared_pool, size_t max_concurrancy)
+    : executor_(std::make_unique<nearby::linux::Executor>(
+          std::move(shared_pool), max_concurrancy)),
+      shut_down_(false) {}
+
 bool SubmittableExecutor::DoSubmit(Runnable&& wrapped_callable) {
   if (!shut_down_) {
     executor_->Execute(std::move(wrapped_callable));
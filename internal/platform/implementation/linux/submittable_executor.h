@@ -15,7 +15,10 @@
 #ifndef PLATFORM_IMPL_LINUX_SUBMITTABLE_EXECUTOR_H_
 #define PLATFORM_IMPL_LINUX_SUBMITTABLE_EXECUTOR_H_
 
+#include <memory>
+
 #include "internal/platform/implementation/linux/executor.h"
+#include "internal/platform/implementation/linux/work_stealing_thread_pool.h"
 #include "internal/platform/implementation/submittable_executor.h"
 
 namespace nearby {
@@ -28,6 +31,10 @@ namespace linux {
 class SubmittableExecutor : public api::SubmittableExecutor {
  public:
   SubmittableExecutor(size_t maxConcurrancy = 1);
+  // Runs tasks on |shared_pool| instead of owning threads; see
+  // Executor::Executor(std::shared_ptr<WorkStealingThreadPool>, size_t).
+  SubmittableExecutor(std::shared_ptr<WorkStealingThreadPool> shared_pool,
+                      size_t maxConcurrancy = 1);
   ~SubmittableExecutor() override = default;
 
   // Submit a callable (with no delay).
@@ -14,7 +14,9 @@
 
 #include <atomic>
 #include <queue>
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "absl/synchronization/mutex.h"
 #include "internal/platform/implementation/linux/thread_pool.h"
@@ -49,6 +51,9 @@ bool ThreadPool::Start() {
       auto task = NextTask();
 
       if (task == nullptr) {
+        if (shut_down_) {
+          return;
+        }
         NEARBY_LOGS(WARNING) << __func__ << ": Tried to run a null task.";
         continue;
       }
@@ -88,15 +93,19 @@ void ThreadPool::ShutDown() {
   NEARBY_LOGS(INFO)
       << __func__ << ": asked to shut down, waiting for active threads to stop";
 
+  // Join without holding the lock; idle workers need it to observe the
+  // shutdown in NextTask().
+  std::vector<std::thread> threads;
   {
-    absl::ReaderMutexLock l(&mutex_);
-    for (auto &thread : threads_) {
+    absl::MutexLock l(&mutex_);
+    threads.swap(threads_);
+  }
+  for (auto &thread : threads) {
+    if (thread.joinable()) {
       thread.join();
     }
   }
 
-  absl::MutexLock l(&mutex_);
-  threads_.clear();
   NEARBY_LOGS(INFO) << __func__ << ": shut down thread pool";
 }
 
@@ -104,11 +113,14 @@ Runnable ThreadPool::NextTask() {
   Runnable task;
   auto task_available = [&]() {
     mutex_.AssertReaderHeld();
-    return !tasks_.empty();
+    return !tasks_.empty() || shut_down_;
   };
 
   {
     absl::MutexLock l(&mutex_, absl::Condition(&task_available));
+    if (tasks_.empty()) {
+      return task;
+    }
 
     task = std::move(tasks_.front());
     tasks_.pop();
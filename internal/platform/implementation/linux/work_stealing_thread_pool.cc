@@ -0,0 +1,315 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/work_stealing_thread_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/runnable.h"
+
+namespace nearby {
+namespace linux {
+
+namespace {
+
+// The pool and worker index of the calling thread, if it is a pool worker.
+thread_local const WorkStealingThreadPool *current_pool = nullptr;
+thread_local size_t current_worker_index = 0;
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) result <<= 1;
+  return result;
+}
+
+}  // namespace
+
+// A bounded Chase-Lev work-stealing deque, following "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (Le et al., PPoPP 2013). Only the
+// owning worker calls Push() and Take(); any thread may call Steal().
+class WorkStealingThreadPool::TaskDeque {
+ public:
+  explicit TaskDeque(size_t capacity)
+      : mask_(capacity - 1), buffer_(capacity) {}
+
+  // Returns false if the deque is full.
+  bool Push(Runnable *task) {
+    std::int64_t bottom = bottom_.load(std::memory_order_relaxed);
+    std::int64_t top = top_.load(std::memory_order_acquire);
+    if (bottom - top > static_cast<std::int64_t>(mask_)) {
+      return false;
+    }
+    buffer_[bottom & mask_].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  Runnable *Take() {
+    std::int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = top_.load(std::memory_order_relaxed);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    Runnable *task = buffer_[bottom & mask_].load(std::memory_order_relaxed);
+    if (top == bottom) {
+      // Last element: race against thieves for it.
+      if (!top_.compare_exchange_strong(top, top + 1,
+                                        std::memory_order_seq_cst,
+                                        std::memory_order_relaxed)) {
+        task = nullptr;
+      }
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  Runnable *Steal() {
+    std::int64_t top = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    Runnable *task = buffer_[top & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      // Lost the race to the owner or another thief.
+      return nullptr;
+    }
+    return task;
+  }
+
+ private:
+  const size_t mask_;
+  std::vector<std::atomic<Runnable *>> buffer_;
+  alignas(64) std::atomic<std::int64_t> top_ = 0;
+  alignas(64) std::atomic<std::int64_t> bottom_ = 0;
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(const Options &options)
+    : max_injected_tasks_(options.max_injected_tasks) {
+  size_t hardware_threads =
+      std::max<size_t>(1, std::thread::hardware_concurrency());
+  size_t thread_count =
+      options.thread_count > 0 ? options.thread_count : hardware_threads;
+  size_t capacity =
+      RoundUpToPowerOfTwo(std::max<size_t>(2, options.local_queue_capacity));
+
+  workers_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; ++i) {
+    auto worker = std::make_unique<Worker>();
+    worker->deque = std::make_unique<TaskDeque>(capacity);
+    workers_.push_back(std::move(worker));
+  }
+
+  NEARBY_LOGS(INFO) << __func__ << ": Starting work-stealing thread pool with "
+                    << thread_count << " threads";
+
+  // Start threads only once every deque exists, since workers steal from
+  // each other right away.
+  for (size_t i = 0; i < thread_count; ++i) {
+    workers_[i]->thread = std::thread([this, i]() { WorkerLoop(i); });
+    if (options.pin_threads_to_cpus) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(i % hardware_threads, &cpu_set);
+      int result = pthread_setaffinity_np(workers_[i]->thread.native_handle(),
+                                          sizeof(cpu_set), &cpu_set);
+      if (result != 0) {
+        NEARBY_LOGS(WARNING) << __func__ << ": Failed to pin worker " << i
+                             << " to a CPU: " << std::strerror(result);
+      }
+    }
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  // A worker cannot join itself, so it must not destroy the pool.
+  assert(!IsWorkerThread());
+  ShutDown();
+  // Join the worker that called ShutDown() from a task, if any; it may still
+  // be using its Worker until it exits.
+  for (auto &worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+bool WorkStealingThreadPool::Run(Runnable &&task) {
+  if (shut_down_) {
+    NEARBY_LOGS(ERROR) << __func__ << ": thread pool has shut down";
+    return false;
+  }
+  if (task == nullptr) {
+    NEARBY_LOGS(WARNING) << __func__ << ": Tried to run a null task.";
+    return false;
+  }
+
+  auto *heap_task = new Runnable(std::move(task));
+  bool queued = false;
+  if (current_pool == this) {
+    queued = workers_[current_worker_index]->deque->Push(heap_task);
+  }
+  if (!queued) {
+    absl::MutexLock lock(&mutex_);
+    if (max_injected_tasks_ > 0 &&
+        injected_tasks_.size() >= max_injected_tasks_) {
+      rejected_tasks_.fetch_add(1, std::memory_order_relaxed);
+      delete heap_task;
+      return false;
+    }
+    injected_tasks_.push_back(heap_task);
+  }
+
+  queued_tasks_.fetch_add(1);
+  if (sleeping_workers_.load() > 0) {
+    WakeUpWorker();
+  }
+  return true;
+}
+
+void WorkStealingThreadPool::ShutDown() {
+  if (shut_down_.exchange(true)) {
+    return;
+  }
+
+  NEARBY_LOGS(INFO)
+      << __func__ << ": asked to shut down, waiting for active threads to stop";
+
+  {
+    absl::MutexLock lock(&mutex_);
+    work_available_.SignalAll();
+  }
+  for (auto &worker : workers_) {
+    // Shutting down from inside a task: this worker exits on its own once
+    // the task returns, and the destructor joins it.
+    if (!worker->thread.joinable() ||
+        worker->thread.get_id() == std::this_thread::get_id()) {
+      continue;
+    }
+    worker->thread.join();
+  }
+
+  // Drop whatever never got to run.
+  for (auto &worker : workers_) {
+    while (Runnable *task = worker->deque->Steal()) {
+      delete task;
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  for (Runnable *task : injected_tasks_) {
+    delete task;
+  }
+  injected_tasks_.clear();
+  NEARBY_LOGS(INFO) << __func__ << ": shut down thread pool";
+}
+
+bool WorkStealingThreadPool::IsShutDown() const { return shut_down_; }
+
+bool WorkStealingThreadPool::IsWorkerThread() const {
+  return current_pool == this;
+}
+
+WorkStealingThreadPool::Stats WorkStealingThreadPool::GetStats() const {
+  Stats stats;
+  stats.queued_tasks = std::max<std::int64_t>(0, queued_tasks_.load());
+  stats.rejected_tasks = rejected_tasks_.load(std::memory_order_relaxed);
+  for (const auto &worker : workers_) {
+    stats.executed_tasks +=
+        worker->executed_tasks.load(std::memory_order_relaxed);
+    stats.stolen_tasks += worker->stolen_tasks.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void WorkStealingThreadPool::WorkerLoop(size_t index) {
+  current_pool = this;
+  current_worker_index = index;
+  Worker &worker = *workers_[index];
+
+  while (!shut_down_) {
+    Runnable *task = FindTask(index);
+    if (task != nullptr) {
+      queued_tasks_.fetch_sub(1);
+      (*task)();
+      delete task;
+      worker.executed_tasks.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    // Nothing to do. Announce that we are going to sleep before checking the
+    // task count one last time; producers check for sleepers after counting
+    // their task, so one of the two always sees the other.
+    absl::MutexLock lock(&mutex_);
+    sleeping_workers_.fetch_add(1);
+    while (queued_tasks_.load() <= 0 && !shut_down_) {
+      work_available_.Wait(&mutex_);
+    }
+    sleeping_workers_.fetch_sub(1);
+  }
+}
+
+Runnable *WorkStealingThreadPool::FindTask(size_t index) {
+  if (Runnable *task = workers_[index]->deque->Take()) {
+    return task;
+  }
+  if (Runnable *task = PopInjected()) {
+    return task;
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    size_t victim = (index + i) % workers_.size();
+    if (Runnable *task = workers_[victim]->deque->Steal()) {
+      workers_[index]->stolen_tasks.fetch_add(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+Runnable *WorkStealingThreadPool::PopInjected() {
+  absl::MutexLock lock(&mutex_);
+  if (injected_tasks_.empty()) {
+    return nullptr;
+  }
+  Runnable *task = injected_tasks_.front();
+  injected_tasks_.pop_front();
+  return task;
+}
+
+void WorkStealingThreadPool::WakeUpWorker() {
+  absl::MutexLock lock(&mutex_);
+  work_available_.Signal();
+}
+
+}  // namespace linux
+}  // namespace nearby
@@ -0,0 +1,127 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_IMPL_LINUX_WORK_STEALING_THREAD_POOL_H_
+#define PLATFORM_IMPL_LINUX_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "internal/platform/runnable.h"
+
+#ifdef linux
+#undef linux
+#endif
+
+namespace nearby {
+namespace linux {
+
+// A fixed-size pool of worker threads meant to be shared by many executors.
+//
+// Every worker owns a bounded Chase-Lev deque. Tasks posted from a worker go
+// to its own deque and are popped LIFO by that worker; idle workers steal
+// FIFO from the other end. Tasks posted from any other thread go through a
+// single injection queue. This keeps the common case (a task posting its
+// continuation) off any shared lock.
+//
+// Tasks must not block indefinitely: a task that never returns permanently
+// takes a worker away from every executor sharing the pool.
+class WorkStealingThreadPool {
+ public:
+  struct Options {
+    // Number of worker threads. 0 means one per hardware thread.
+    size_t thread_count = 0;
+    // Capacity of each worker's deque; rounded up to a power of two. Tasks
+    // that do not fit spill over to the injection queue.
+    size_t local_queue_capacity = 256;
+    // Maximum number of tasks in the injection queue. 0 means unbounded.
+    size_t max_injected_tasks = 0;
+    // If true, worker i is pinned to CPU (i % hardware threads).
+    bool pin_threads_to_cpus = false;
+  };
+
+  struct Stats {
+    // Tasks queued but not yet started.
+    std::int64_t queued_tasks = 0;
+    std::uint64_t executed_tasks = 0;
+    // Tasks a worker took from another worker's deque.
+    std::uint64_t stolen_tasks = 0;
+    // Tasks refused because the injection queue was full.
+    std::uint64_t rejected_tasks = 0;
+  };
+
+  WorkStealingThreadPool(const WorkStealingThreadPool &) = delete;
+  WorkStealingThreadPool &operator=(const WorkStealingThreadPool &) = delete;
+  explicit WorkStealingThreadPool(const Options &options);
+  ~WorkStealingThreadPool();
+
+  // Runs a task on the pool. Returns false if the pool is shut down or the
+  // injection queue is full.
+  bool Run(Runnable &&task);
+
+  // Stops all workers. Tasks that have not started yet are dropped.
+  //
+  // May be called from one of the pool's own tasks, but the pool must then be
+  // destroyed from another thread.
+  void ShutDown();
+
+  // Returns true once ShutDown() has been called.
+  bool IsShutDown() const;
+
+  // Returns true if the calling thread is one of this pool's workers.
+  bool IsWorkerThread() const;
+
+  size_t GetThreadCount() const { return workers_.size(); }
+  Stats GetStats() const;
+
+ private:
+  class TaskDeque;
+
+  struct Worker {
+    std::unique_ptr<TaskDeque> deque;
+    std::thread thread;
+    std::atomic<std::uint64_t> executed_tasks = 0;
+    std::atomic<std::uint64_t> stolen_tasks = 0;
+  };
+
+  void WorkerLoop(size_t index);
+  Runnable *FindTask(size_t index);
+  Runnable *PopInjected() ABSL_LOCKS_EXCLUDED(mutex_);
+  void WakeUpWorker() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const size_t max_injected_tasks_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic_bool shut_down_ = false;
+  // Number of tasks queued anywhere in the pool. It may briefly go negative
+  // while a task is taken before its producer has counted it.
+  std::atomic<std::int64_t> queued_tasks_ = 0;
+  std::atomic<size_t> sleeping_workers_ = 0;
+  std::atomic<std::uint64_t> rejected_tasks_ = 0;
+
+  mutable absl::Mutex mutex_;
+  absl::CondVar work_available_;
+  std::deque<Runnable *> injected_tasks_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace linux
+}  // namespace nearby
+
+#endif  // PLATFORM_IMPL_LINUX_WORK_STEALING_THREAD_POOL_H_
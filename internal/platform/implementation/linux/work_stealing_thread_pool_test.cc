@@ -0,0 +1,236 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "internal/platform/implementation/linux/work_stealing_thread_pool.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+#include "internal/platform/implementation/linux/executor.h"
+
+namespace nearby {
+namespace linux {
+namespace {
+
+constexpr int kTaskCount = 1000;
+
+TEST(WorkStealingThreadPool, RunsAllTasks) {
+  WorkStealingThreadPool pool({.thread_count = 4});
+  absl::BlockingCounter blocking_counter(kTaskCount);
+  std::atomic<int> sum = 0;
+
+  for (int i = 0; i < kTaskCount; ++i) {
+    EXPECT_TRUE(pool.Run([&, i]() {
+      sum += i;
+      blocking_counter.DecrementCount();
+    }));
+  }
+
+  blocking_counter.Wait();
+  EXPECT_EQ(sum, kTaskCount * (kTaskCount - 1) / 2);
+  EXPECT_EQ(pool.GetStats().executed_tasks, kTaskCount);
+  pool.ShutDown();
+}
+
+TEST(WorkStealingThreadPool, TasksPostedFromWorkerAreStolen) {
+  WorkStealingThreadPool pool({.thread_count = 4});
+  absl::BlockingCounter blocking_counter(kTaskCount);
+
+  // One task fans out onto its worker's local deque; the other workers can
+  // only get at that work by stealing it.
+  pool.Run([&]() {
+    EXPECT_TRUE(pool.IsWorkerThread());
+    for (int i = 0; i < kTaskCount; ++i) {
+      pool.Run([&]() {
+        absl::SleepFor(absl::Microseconds(100));
+        blocking_counter.DecrementCount();
+      });
+    }
+  });
+
+  blocking_counter.Wait();
+  EXPECT_FALSE(pool.IsWorkerThread());
+  EXPECT_GT(pool.GetStats().stolen_tasks, 0);
+  pool.ShutDown();
+}
+
+TEST(WorkStealingThreadPool, RejectsTasksWhenInjectionQueueIsFull) {
+  WorkStealingThreadPool pool({.thread_count = 1, .max_injected_tasks = 1});
+  absl::Notification release;
+  absl::Notification started;
+
+  ASSERT_TRUE(pool.Run([&]() {
+    started.Notify();
+    release.WaitForNotification();
+  }));
+  started.WaitForNotification();
+
+  EXPECT_TRUE(pool.Run([]() {}));
+  EXPECT_FALSE(pool.Run([]() {}));
+  EXPECT_EQ(pool.GetStats().rejected_tasks, 1);
+
+  release.Notify();
+  pool.ShutDown();
+}
+
+TEST(WorkStealingThreadPool, RunAfterShutDownFails) {
+  WorkStealingThreadPool pool({.thread_count = 2});
+  pool.ShutDown();
+
+  EXPECT_FALSE(pool.Run([]() {}));
+}
+
+TEST(WorkStealingThreadPool, ShutDownFromTaskThenDestroy) {
+  auto pool = std::make_unique<WorkStealingThreadPool>(
+      WorkStealingThreadPool::Options{.thread_count = 2});
+  absl::Notification shut_down;
+
+  ASSERT_TRUE(pool->Run([&]() {
+    pool->ShutDown();
+    shut_down.Notify();
+    // Keep the worker busy past the destructor's start.
+    absl::SleepFor(absl::Milliseconds(100));
+  }));
+  shut_down.WaitForNotification();
+  // Waits for the worker that shut the pool down.
+  pool.reset();
+}
+
+TEST(WorkStealingThreadPool, SharedSingleThreadExecutorsStaySequential) {
+  auto pool = std::make_shared<WorkStealingThreadPool>(
+      WorkStealingThreadPool::Options{.thread_count = 4});
+  constexpr int kExecutorCount = 8;
+  constexpr int kTasksPerExecutor = 100;
+  absl::BlockingCounter blocking_counter(kExecutorCount * kTasksPerExecutor);
+  std::vector<std::vector<int>> completed_tasks(kExecutorCount);
+  std::vector<std::unique_ptr<Executor>> executors;
+
+  for (int e = 0; e < kExecutorCount; ++e) {
+    executors.push_back(std::make_unique<Executor>(pool));
+  }
+  for (int i = 0; i < kTasksPerExecutor; ++i) {
+    for (int e = 0; e < kExecutorCount; ++e) {
+      executors[e]->Execute([&, e, i]() {
+        completed_tasks[e].push_back(i);
+        blocking_counter.DecrementCount();
+      });
+    }
+  }
+
+  blocking_counter.Wait();
+  for (auto& executor : executors) {
+    executor->Shutdown();
+  }
+  for (const auto& tasks : completed_tasks) {
+    ASSERT_EQ(tasks.size(), kTasksPerExecutor);
+    for (int i = 0; i < kTasksPerExecutor; ++i) {
+      EXPECT_EQ(tasks[i], i);
+    }
+  }
+  pool->ShutDown();
+}
+
+TEST(WorkStealingThreadPool, SharedExecutorShutsDownAfterPoolDropsItsTasks) {
+  auto pool = std::make_shared<WorkStealingThreadPool>(
+      WorkStealingThreadPool::Options{.thread_count = 1});
+  Executor executor(pool);
+  absl::Notification started;
+  absl::Notification release;
+  std::atomic_bool ran = false;
+
+  // Keep the only worker busy so the executor's task stays queued.
+  ASSERT_TRUE(pool->Run([&]() {
+    started.Notify();
+    release.WaitForNotification();
+  }));
+  started.WaitForNotification();
+  executor.Execute([&]() { ran = true; });
+  std::thread shut_down_pool([&]() { pool->ShutDown(); });
+  absl::SleepFor(absl::Milliseconds(100));
+  release.Notify();
+  shut_down_pool.join();
+
+  // Returns even though the pool dropped the queued task.
+  executor.Shutdown();
+  EXPECT_FALSE(ran);
+}
+
+TEST(WorkStealingThreadPool, SharedExecutorShutsDownAfterPoolRefusesRepost) {
+  auto pool = std::make_shared<WorkStealingThreadPool>(
+      WorkStealingThreadPool::Options{.thread_count = 1});
+  Executor executor(pool);
+  absl::Notification started;
+  absl::Notification release;
+  std::atomic_bool second_ran = false;
+
+  executor.Execute([&]() {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  executor.Execute([&]() { second_ran = true; });
+  started.WaitForNotification();
+  // The first task finishes after the pool shut down, so its repost for the
+  // second one is refused.
+  std::thread shut_down_pool([&]() { pool->ShutDown(); });
+  absl::SleepFor(absl::Milliseconds(100));
+  release.Notify();
+  shut_down_pool.join();
+
+  executor.Shutdown();
+  EXPECT_FALSE(second_ran);
+}
+
+TEST(WorkStealingThreadPool, SharedExecutorKeepsTasksWhenPoolIsFull) {
+  auto pool = std::make_shared<WorkStealingThreadPool>(
+      WorkStealingThreadPool::Options{.thread_count = 1,
+                                      .max_injected_tasks = 1});
+  Executor executor(pool);
+  absl::Notification started;
+  absl::Notification release;
+  std::vector<int> order;
+  absl::Notification done;
+
+  // Keep the only worker busy and fill the injection queue.
+  ASSERT_TRUE(pool->Run([&]() {
+    started.Notify();
+    release.WaitForNotification();
+  }));
+  started.WaitForNotification();
+  ASSERT_TRUE(pool->Run([]() {}));
+
+  // Refused by the pool, but stays queued on the executor.
+  executor.Execute([&]() { order.push_back(1); });
+  release.Notify();
+  absl::SleepFor(absl::Milliseconds(100));
+  executor.Execute([&]() {
+    order.push_back(2);
+    done.Notify();
+  });
+
+  done.WaitForNotification();
+  executor.Shutdown();
+  EXPECT_EQ(order, (std::vector<int>{1, 2}));
+  pool->ShutDown();
+}
+
+}  // namespace
+}  // namespace linux
+}  // namespace nearby
@@ -15,6 +15,8 @@
 #ifndef PLATFORM_API_OUTPUT_FILE_H_
 #define PLATFORM_API_OUTPUT_FILE_H_
 
+#include <cstdint>
+
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/output_stream.h"
@@ -26,6 +28,15 @@ namespace api {
 class OutputFile : public OutputStream {
  public:
   ~OutputFile() override = default;
+
+  // Tells the file that |size| bytes are going to be written to it, so that
+  // the space can be reserved up front and the file laid out contiguously.
+  // This is a hint; the default does nothing.
+  //
+  // throws Exception::kIo
+  virtual Exception Preallocate(std::int64_t size) {
+    return {Exception::kSuccess};
+  }
 };
 
 }  // namespace api
@@ -34,6 +34,7 @@
 #include "internal/platform/implementation/device_info.h"
 #include "internal/platform/implementation/http_loader.h"
 #include "internal/platform/implementation/input_file.h"
+#include "internal/platform/implementation/io_reactor.h"
 #include "internal/platform/implementation/log_message.h"
 #include "internal/platform/implementation/mutex.h"
 #include "internal/platform/implementation/output_file.h"
@@ -124,6 +125,9 @@ class ImplementationPlatform {
   static std::unique_ptr<SubmittableExecutor> CreateMultiThreadExecutor(
       std::int32_t max_concurrency);
   static std::unique_ptr<ScheduledExecutor> CreateScheduledExecutor();
+  // Returns nullptr on platforms without readiness-based I/O multiplexing;
+  // callers then fall back to one blocking reader thread per stream.
+  static std::unique_ptr<IoReactor> CreateIoReactor();
 
   // Protocol implementations, domain-specific support
   static std::unique_ptr<BluetoothAdapter> CreateBluetoothAdapter();
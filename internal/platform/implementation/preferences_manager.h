@@ -85,6 +85,10 @@ class PreferencesManager {
 
   // Removes preferences
   virtual void Remove(absl::string_view key) = 0;
+
+  // Writes changes that aren't on storage yet. Implementations that write
+  // every change right away have nothing to do. Returns false on failure.
+  virtual bool Flush() { return true; }
 };
 
 }  // namespace api
@@ -19,6 +19,7 @@
 #include <ios>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
@@ -63,15 +64,17 @@ ExceptionOr<ByteArray> IOFile::Read(std::int64_t size) {
     return ExceptionOr<ByteArray>{Exception::kIo};
   }
 
-  ByteArray bytes(size);
-  std::unique_ptr<char[]> read_bytes{new char[size]};
-  file_.read(read_bytes.get(), static_cast<ptrdiff_t>(size));
+  // Read straight into the buffer that backs the returned ByteArray, so the
+  // chunk is not copied again on its way to the caller.
+  std::string read_bytes(size, '\0');
+  file_.read(read_bytes.data(), static_cast<ptrdiff_t>(size));
   auto num_bytes_read = file_.gcount();
   if (num_bytes_read == 0) {
     return ExceptionOr<ByteArray>{Exception::kIo};
   }
+  read_bytes.resize(num_bytes_read);
 
-  return ExceptionOr<ByteArray>(ByteArray(read_bytes.get(), num_bytes_read));
+  return ExceptionOr<ByteArray>(ByteArray(std::move(read_bytes)));
 }
 
 Exception IOFile::Close() {
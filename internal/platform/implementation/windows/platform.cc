@@ -254,6 +254,10 @@ ImplementationPlatform::CreateScheduledExecutor() {
   return absl::make_unique<windows::ScheduledExecutor>();
 }
 
+std::unique_ptr<IoReactor> ImplementationPlatform::CreateIoReactor() {
+  return nullptr;
+}
+
 std::unique_ptr<BluetoothAdapter>
 ImplementationPlatform::CreateBluetoothAdapter() {
   return absl::make_unique<windows::BluetoothAdapter>();
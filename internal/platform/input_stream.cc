@@ -17,8 +17,10 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <utility>
 
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 
@@ -45,33 +47,57 @@ ExceptionOr<size_t> InputStream::Skip(size_t offset) {
 }
 
 ExceptionOr<ByteArray> InputStream::ReadExactly(std::size_t size) {
-  ByteArray buffer;
-  std::size_t current_pos = 0;
+  if (size == 0) {
+    return ExceptionOr<ByteArray>(ByteArray());
+  }
+  ExceptionOr<ByteArray> read_bytes = Read(size);
+  if (!read_bytes.ok()) {
+    return read_bytes;
+  }
+  const ByteArray& result = read_bytes.result();
+  if (result.Empty() || result.size() > size) {
+    return ExceptionOr<ByteArray>(Exception::kIo);
+  }
+  if (result.size() == size) {
+    // We have read the requested `size` bytes in one chunk. We can return it
+    // directly.
+    return read_bytes;
+  }
 
-  while (current_pos < size) {
-    ExceptionOr<ByteArray> read_bytes = Read(size - current_pos);
-    if (!read_bytes.ok()) {
-      return read_bytes;
-    }
-    const ByteArray& result = read_bytes.result();
+  ByteArray buffer(size);
+  std::memcpy(buffer.data(), result.data(), result.size());
+  Exception exception = ReadExactlyInto(
+      absl::MakeSpan(buffer.data() + result.size(), size - result.size()));
+  if (exception.Raised()) {
+    return ExceptionOr<ByteArray>(exception);
+  }
+  return ExceptionOr<ByteArray>(std::move(buffer));
+}
 
-    if (result.Empty()) {
-      return ExceptionOr<ByteArray>(Exception::kIo);
+ExceptionOr<size_t> InputStream::ReadInto(absl::Span<char> buffer) {
+  ExceptionOr<ByteArray> result = Read(buffer.size());
+  if (!result.ok()) {
+    return result.GetException();
+  }
+  const ByteArray& bytes = result.result();
+  if (bytes.size() > buffer.size()) {
+    return ExceptionOr<size_t>(Exception::kIo);
+  }
+  std::memcpy(buffer.data(), bytes.data(), bytes.size());
+  return ExceptionOr<size_t>(bytes.size());
+}
+
+Exception InputStream::ReadExactlyInto(absl::Span<char> buffer) {
+  while (!buffer.empty()) {
+    ExceptionOr<size_t> bytes_read = ReadInto(buffer);
+    if (!bytes_read.ok()) {
+      return bytes_read.GetException();
     }
-    if (current_pos == 0) {
-      if (result.size() == size) {
-        // We have read the requested `size` bytes in one chunk. We can return
-        // it directly.
-        return read_bytes;
-      } else {
-        // Reserve space for in the buffer.
-        buffer.SetData(size);
-      }
+    if (bytes_read.result() == 0) {
+      return {Exception::kIo};
     }
-    buffer.CopyAt(current_pos, result);
-    current_pos += result.size();
+    buffer.remove_prefix(bytes_read.result());
   }
-
-  return ExceptionOr<ByteArray>(std::move(buffer));
+  return {Exception::kSuccess};
 }
 }  // namespace nearby
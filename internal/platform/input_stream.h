@@ -15,8 +15,10 @@
 #ifndef PLATFORM_BASE_INPUT_STREAM_H_
 #define PLATFORM_BASE_INPUT_STREAM_H_
 
+#include <cstddef>
 #include <cstdint>
 
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 
@@ -43,8 +45,31 @@ class InputStream {
   // `size` bytes.
   ExceptionOr<ByteArray> ReadExactly(std::size_t size);
 
+  // Reads at most `buffer.size()` bytes into `buffer`.
+  // Returns the number of bytes read, 0 on end of file, or Exception::kIo on
+  // error. The default reads through Read() and copies, and fails if Read()
+  // returns more than it asked for; streams that can fill the caller's buffer
+  // directly override this.
+  virtual ExceptionOr<size_t> ReadInto(absl::Span<char> buffer);
+
+  // Returns true if ReadInto() returns as soon as any data is available.
+  // Streams that may block until the whole buffer is filled must return
+  // false, so callers don't ask them for more than they need.
+  virtual bool SupportsPartialReads() const { return false; }
+
+  // Fills `buffer` from the input stream.
+  // Return Exception::kIo on error, or if end of file is reached before
+  // `buffer` is full.
+  Exception ReadExactlyInto(absl::Span<char> buffer);
+
   // throws Exception::kIo
   virtual Exception Close() = 0;
+
+  // Returns a descriptor that polls readable when Read() can make progress,
+  // or -1 if the stream cannot be polled. Streams that buffer data in user
+  // space must return -1, since readiness of the descriptor would not reflect
+  // what Read() returns. Close() must wake anyone polling the descriptor.
+  virtual int GetReadinessFd() const { return -1; }
 };
 
 }  // namespace nearby
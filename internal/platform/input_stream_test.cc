@@ -19,6 +19,7 @@
 #include "gmock/gmock.h"
 #include "protobuf-matchers/protocol-buffer-matchers.h"
 #include "gtest/gtest.h"
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 
@@ -115,5 +116,60 @@ TEST(InputStreamTest, ReadExactlyFailsOnError) {
   EXPECT_EQ(result.exception(), Exception::kIo);
 }
 
+TEST(InputStreamTest, ReadExactlyFailsIfReadReturnsTooMuch) {
+  NiceMock<TestInputStream> stream;
+  EXPECT_CALL(stream, Read(10)).WillOnce(Return(Range(0, 20)));
+
+  ExceptionOr<ByteArray> result = stream.ReadExactly(10);
+
+  EXPECT_EQ(result.exception(), Exception::kIo);
+}
+
+TEST(InputStreamTest, ReadIntoCopiesRead) {
+  NiceMock<TestInputStream> stream;
+  EXPECT_CALL(stream, Read(30)).WillOnce(Return(Range(0, 10)));
+  char buffer[30];
+
+  ExceptionOr<std::size_t> result = stream.ReadInto(absl::MakeSpan(buffer));
+
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(ByteArray(buffer, result.result()), Range(0, 10).result());
+}
+
+TEST(InputStreamTest, ReadIntoFailsIfReadReturnsTooMuch) {
+  NiceMock<TestInputStream> stream;
+  EXPECT_CALL(stream, Read(10)).WillOnce(Return(Range(0, 20)));
+  char buffer[10];
+
+  ExceptionOr<std::size_t> result = stream.ReadInto(absl::MakeSpan(buffer));
+
+  EXPECT_EQ(result.exception(), Exception::kIo);
+}
+
+TEST(InputStreamTest, ReadExactlyIntoMultipleChunks) {
+  NiceMock<TestInputStream> stream;
+  InSequence seq;
+  EXPECT_CALL(stream, Read(30)).WillOnce(Return(Range(0, 10)));
+  EXPECT_CALL(stream, Read(20)).WillOnce(Return(Range(10, 30)));
+  char buffer[30];
+
+  Exception result = stream.ReadExactlyInto(absl::MakeSpan(buffer));
+
+  EXPECT_TRUE(result.Ok());
+  EXPECT_EQ(ByteArray(buffer, sizeof(buffer)), Range(0, 30).result());
+}
+
+TEST(InputStreamTest, ReadExactlyIntoFailsOnEof) {
+  NiceMock<TestInputStream> stream;
+  InSequence seq;
+  EXPECT_CALL(stream, Read(30)).WillOnce(Return(Range(0, 10)));
+  EXPECT_CALL(stream, Read(20)).WillOnce(Return(Range(0, 0)));
+  char buffer[30];
+
+  Exception result = stream.ReadExactlyInto(absl::MakeSpan(buffer));
+
+  EXPECT_TRUE(result.Raised(Exception::kIo));
+}
+
 }  // namespace
 }  // namespace nearby
@@ -0,0 +1,69 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PLATFORM_PUBLIC_IO_REACTOR_H_
+#define PLATFORM_PUBLIC_IO_REACTOR_H_
+
+#include <memory>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "internal/platform/implementation/io_reactor.h"
+#include "internal/platform/implementation/platform.h"
+
+namespace nearby {
+
+// Waits for many pollable streams on one thread. See api::IoReactor for the
+// watch semantics.
+//
+// Not every platform provides a reactor; check IsValid() and fall back to a
+// blocking reader thread per stream when it returns false.
+class IoReactor final {
+ public:
+  using Platform = api::ImplementationPlatform;
+  using WatchId = api::IoReactor::WatchId;
+  static constexpr WatchId kInvalidWatchId = api::IoReactor::kInvalidWatchId;
+
+  IoReactor() : impl_(Platform::CreateIoReactor()) {}
+  // Wraps a given implementation; for tests.
+  explicit IoReactor(std::unique_ptr<api::IoReactor> impl)
+      : impl_(std::move(impl)) {}
+  IoReactor(IoReactor&&) = default;
+  IoReactor& operator=(IoReactor&&) = default;
+  ~IoReactor() { Shutdown(); }
+
+  bool IsValid() const { return impl_ != nullptr; }
+
+  WatchId Watch(int fd, absl::AnyInvocable<void()> on_readable) {
+    if (!impl_) return kInvalidWatchId;
+    return impl_->Watch(fd, std::move(on_readable));
+  }
+
+  bool Rearm(WatchId watch_id) { return impl_ && impl_->Rearm(watch_id); }
+
+  void Unwatch(WatchId watch_id) {
+    if (impl_) impl_->Unwatch(watch_id);
+  }
+
+  void Shutdown() {
+    if (impl_) impl_->Shutdown();
+  }
+
+ private:
+  std::unique_ptr<api::IoReactor> impl_;
+};
+
+}  // namespace nearby
+
+#endif  // PLATFORM_PUBLIC_IO_REACTOR_H_
@@ -86,6 +86,8 @@ void MediumEnvironment::Reset() {
       MutexLock lock(&mutex_);
       wifi_direct_mediums_.clear();
       wifi_hotspot_mediums_.clear();
+      link_models_.clear();
+      link_seed_ = 0;
     }
     use_valid_peer_connection_ = true;
     peer_connection_latency_ = absl::ZeroDuration();
@@ -822,6 +824,31 @@ absl::Duration MediumEnvironment::GetPeerConnectionLatency() {
   return peer_connection_latency_;
 }
 
+void MediumEnvironment::SetLinkModel(
+    location::nearby::proto::connections::Medium medium,
+    const LinkModel& model) {
+  MutexLock lock(&mutex_);
+  link_models_[medium] = model;
+}
+
+std::optional<LinkModel> MediumEnvironment::GetLinkModel(
+    location::nearby::proto::connections::Medium medium) {
+  MutexLock lock(&mutex_);
+  auto it = link_models_.find(medium);
+  if (it == link_models_.end()) return std::nullopt;
+  return it->second;
+}
+
+void MediumEnvironment::SetLinkSeed(std::uint64_t seed) {
+  MutexLock lock(&mutex_);
+  link_seed_ = seed;
+}
+
+std::uint64_t MediumEnvironment::NextLinkSeed() {
+  MutexLock lock(&mutex_);
+  return link_seed_++;
+}
+
 std::string MediumEnvironment::GetFakeIPAddress() const {
   std::string ip_address;
   ip_address.resize(4);
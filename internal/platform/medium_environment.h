@@ -16,6 +16,8 @@
 #define PLATFORM_BASE_MEDIUM_ENVIRONMENT_H_
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -25,6 +27,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "internal/base/observer_list.h"
 #include "internal/platform/borrowable.h"
@@ -46,6 +49,7 @@
 #include "internal/platform/nsd_service_info.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/platform/wifi_credential.h"
+#include "proto/connections_enums.pb.h"
 
 namespace nearby {
 
@@ -63,6 +67,27 @@ struct EnvironmentConfig {
   bool use_simulated_clock = false;
 };
 
+// Shapes the data sent in one direction of a simulated socket connection.
+// A default-constructed model behaves like an ideal link.
+struct LinkModel {
+  // Sustained throughput, refilled into a token bucket. 0 means unlimited.
+  std::int64_t bandwidth_bytes_per_second = 0;
+  // Bytes that can be sent back to back before the bandwidth limit applies.
+  std::int64_t burst_bytes = 0;
+  // One-way delay added to every packet.
+  absl::Duration latency = absl::ZeroDuration();
+  // Extra delay, uniformly distributed in [0, jitter), added to every packet.
+  // Packets are still delivered in order.
+  absl::Duration jitter = absl::ZeroDuration();
+  // Writes are split into packets of at most `mtu` bytes. 0 sends each write
+  // as one packet.
+  std::size_t mtu = 0;
+  // Probability, in [0, 1], that a packet is lost. Sockets are reliable, so a
+  // lost packet stalls the link for `loss_stall` while it is retransmitted.
+  double loss_probability = 0;
+  absl::Duration loss_stall = absl::Milliseconds(200);
+};
+
 // MediumEnvironment is a simulated environment which allows multiple instances
 // of simulated HW devices to "work" together as if they are physical.
 // For each medium type it provides necessary methods to implement
@@ -189,6 +214,23 @@ class MediumEnvironment {
 
   absl::Duration GetPeerConnectionLatency();
 
+  // Shapes sockets of `medium` connected from now on. Applies to both
+  // directions of a connection, unless the socket sets its own model.
+  void SetLinkModel(location::nearby::proto::connections::Medium medium,
+                    const LinkModel& model);
+
+  // Returns the model set for `medium`, or nullopt if its sockets are ideal.
+  std::optional<LinkModel> GetLinkModel(
+      location::nearby::proto::connections::Medium medium);
+
+  // Seeds the jitter and loss of links shaped from now on. Each link takes the
+  // next seed in turn, so a test that connects in the same order sees the same
+  // packet timings on every run.
+  void SetLinkSeed(std::uint64_t seed);
+
+  // Returns the seed for the next shaped link.
+  std::uint64_t NextLinkSeed();
+
   // Adds medium-related info to allow for scanning/advertising to work.
   // This provides access to this medium from other mediums, when protocol
   // expects they should communicate.
@@ -515,6 +557,10 @@ class MediumEnvironment {
   absl::flat_hash_map<api::WifiHotspotMedium*, WifiHotspotMediumContext>
       wifi_hotspot_mediums_ ABSL_GUARDED_BY(mutex_);
 
+  absl::flat_hash_map<location::nearby::proto::connections::Medium, LinkModel>
+      link_models_ ABSL_GUARDED_BY(mutex_);
+  std::uint64_t link_seed_ ABSL_GUARDED_BY(mutex_) = 0;
+
   bool use_valid_peer_connection_ = true;
   absl::Duration peer_connection_latency_ = absl::ZeroDuration();
   std::unique_ptr<FakeClock> simulated_clock_ ABSL_GUARDED_BY(mutex_);
@@ -15,6 +15,7 @@
 #ifndef PLATFORM_BASE_OUTPUT_STREAM_H_
 #define PLATFORM_BASE_OUTPUT_STREAM_H_
 
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 
@@ -30,6 +31,21 @@ class OutputStream {
   virtual Exception Write(const ByteArray& data) = 0;  // throws Exception::kIo
   virtual Exception Flush() = 0;                       // throws Exception::kIo
   virtual Exception Close() = 0;                       // throws Exception::kIo
+
+  // Writes |buffers| back to back, as if they were a single concatenated
+  // ByteArray. Streams backed by a file descriptor override this to hand all
+  // buffers to the kernel in one gather-write call; the default writes them
+  // one at a time.
+  //
+  // throws Exception::kIo
+  virtual Exception GatherWrite(absl::Span<const ByteArray* const> buffers) {
+    for (const ByteArray* buffer : buffers) {
+      if (buffer->Empty()) continue;
+      Exception exception = Write(*buffer);
+      if (exception.Raised()) return exception;
+    }
+    return {Exception::kSuccess};
+  }
 };
 
 }  // namespace nearby
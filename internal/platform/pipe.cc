@@ -14,13 +14,17 @@
 
 #include "internal/platform/pipe.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
-#include <deque>
+#include <cstring>
 #include <memory>
 #include <utility>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/types/span.h"
 #include "internal/platform/base_mutex_lock.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
@@ -35,9 +39,30 @@ namespace nearby {
 namespace {
 using Platform = api::ImplementationPlatform;
 
+// Size of the ring buffer an unbounded pipe starts with.
+constexpr std::size_t kInitialBufferSize = 4 * 1024;
+// An unbounded pipe looks at shrinking its buffer once per this many reads
+// that empty it, and only if the buffer is this many times larger than what
+// was buffered at most since the last look.
+constexpr int kDrainsPerShrinkCheck = 16;
+constexpr std::size_t kShrinkRatio = 4;
+
+// A pipe backed by a ring buffer. `read_pos_` and `write_pos_` count the bytes
+// read and written so far; the bytes between them wait in the buffer, at the
+// positions taken modulo the buffer size.
+//
+// An unbounded pipe grows its buffer to fit each write. Once a burst has
+// passed, it shrinks the buffer down to what was recently buffered, rather
+// than on every read that empties it, so a steady stream of large writes does
+// not keep reallocating. A bounded pipe makes
+// Write() wait for room, copying the data in as the reader frees space.
 class Pipe {
  public:
-  Pipe() {
+  explicit Pipe(const PipeOptions& options)
+      : capacity_(options.capacity),
+        lock_free_(options.capacity > 0 && options.lock_free),
+        buffer_size_(capacity_ > 0 ? capacity_ : kInitialBufferSize),
+        buffer_(new char[buffer_size_]) {
 #pragma push_macro("CreateMutex")
 #undef CreateMutex
     mutex_ = Platform::CreateMutex(api::Mutex::Mode::kRegular);
@@ -51,8 +76,22 @@ class Pipe {
     ~PipeInputStream() override { DoClose(); }
 
     ExceptionOr<ByteArray> Read(std::int64_t size) override {
-      return pipe_->Read(size);
+      ByteArray data;
+      ExceptionOr<size_t> bytes_read =
+          pipe_->Read(size, [&data](size_t bytes_to_read) {
+            data.SetData(bytes_to_read);
+            return data.data();
+          });
+      if (!bytes_read.ok()) {
+        return ExceptionOr<ByteArray>{bytes_read.exception()};
+      }
+      return ExceptionOr<ByteArray>{std::move(data)};
+    }
+    ExceptionOr<size_t> ReadInto(absl::Span<char> buffer) override {
+      return pipe_->Read(buffer.size(),
+                         [buffer](size_t) { return buffer.data(); });
     }
+    bool SupportsPartialReads() const override { return true; }
     Exception Close() override { return DoClose(); }
 
    private:
@@ -83,111 +122,279 @@ class Pipe {
   };
 
  private:
-  ExceptionOr<ByteArray> Read(size_t size) ABSL_LOCKS_EXCLUDED(mutex_);
+  // Waits for data, and copies up to `size` bytes of it to the buffer that
+  // `destination` returns for the number of bytes about to be copied.
+  // Returns that number, 0 at the end of the stream.
+  ExceptionOr<size_t> Read(size_t size,
+                           absl::FunctionRef<char*(size_t)> destination)
+      ABSL_LOCKS_EXCLUDED(mutex_);
   Exception Write(const ByteArray& data) ABSL_LOCKS_EXCLUDED(mutex_);
 
   void MarkInputStreamClosed() ABSL_LOCKS_EXCLUDED(mutex_);
   void MarkOutputStreamClosed() ABSL_LOCKS_EXCLUDED(mutex_);
 
-  Exception WriteLocked(const ByteArray& data)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  ExceptionOr<size_t> LockFreeRead(size_t size,
+                                   absl::FunctionRef<char*(size_t)> destination)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  Exception LockFreeWrite(const char* data, size_t size)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Wait until there is data to read, or the pipe is closed. Return the number
+  // of bytes that can be read, 0 at the end of the stream.
+  ExceptionOr<size_t> WaitToRead() ABSL_LOCKS_EXCLUDED(mutex_);
+  ExceptionOr<size_t> WaitToReadLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Wait until there is room to write, or the pipe is closed. Return the number
+  // of bytes that can be written, 0 once the pipe is closed.
+  ExceptionOr<size_t> WaitToWrite() ABSL_LOCKS_EXCLUDED(mutex_);
+  ExceptionOr<size_t> WaitToWriteLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Wakes the other side if it is blocked in WaitToRead() or WaitToWrite().
+  void NotifyIfWaiting(const std::atomic_bool& waiting)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  size_t Readable() const { return write_pos_ - read_pos_; }
+  bool Closed() const { return input_stream_closed_ || output_stream_closed_; }
+  // Copies `size` bytes between `data` and the buffer, starting at stream
+  // position `position`.
+  void CopyIn(std::uint64_t position, const char* data, size_t size);
+  void CopyOut(std::uint64_t position, char* data, size_t size) const;
+  // Makes room for `size` more bytes in an unbounded pipe.
+  void GrowLocked(size_t size) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Gives back the memory an unbounded pipe grew into, once it is empty and
+  // has not needed that much for a while.
+  void ShrinkIfDrainedLocked() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const size_t capacity_;
+  const bool lock_free_;
+  size_t buffer_size_;
+  std::unique_ptr<char[]> buffer_;
+  std::atomic<std::uint64_t> read_pos_ = 0;
+  std::atomic<std::uint64_t> write_pos_ = 0;
+  // Only used by unbounded pipes: the most bytes buffered, and the number of
+  // reads that emptied the buffer, since the last shrink check.
+  size_t high_water_mark_ ABSL_GUARDED_BY(mutex_) = 0;
+  int drains_ ABSL_GUARDED_BY(mutex_) = 0;
+
+  std::atomic_bool input_stream_closed_ = false;
+  std::atomic_bool output_stream_closed_ = false;
+  // Only used by lock-free pipes.
+  std::atomic_bool reader_waiting_ = false;
+  std::atomic_bool writer_waiting_ = false;
 
-  bool input_stream_closed_ ABSL_GUARDED_BY(mutex_) = false;
-  bool output_stream_closed_ ABSL_GUARDED_BY(mutex_) = false;
-  bool read_all_chunks_ ABSL_GUARDED_BY(mutex_) = false;
-
-  std::deque<ByteArray> ABSL_GUARDED_BY(mutex_) buffer_;
   // Order of declaration matters:
   // - mutex must be defined before condvar;
   std::unique_ptr<api::Mutex> mutex_;
   std::unique_ptr<api::ConditionVariable> cond_;
 };
 
-ExceptionOr<ByteArray> Pipe::Read(size_t size) {
-  BaseMutexLock lock(mutex_.get());
+ExceptionOr<size_t> Pipe::Read(size_t size,
+                               absl::FunctionRef<char*(size_t)> destination) {
+  if (lock_free_) return LockFreeRead(size, destination);
 
-  // We're done reading all the chunks that were written before the OutputStream
-  // was closed, so there's nothing to do here other than return an empty chunk
-  // to serve as an EOF indication to callers.
-  if (read_all_chunks_) {
-    return ExceptionOr<ByteArray>{ByteArray{}};
+  BaseMutexLock lock(mutex_.get());
+  ExceptionOr<size_t> available = WaitToReadLocked();
+  if (!available.ok()) return available;
+
+  // Reading nothing serves as an EOF indication to callers.
+  size_t bytes_to_read = std::min(size, available.result());
+  CopyOut(read_pos_, destination(bytes_to_read), bytes_to_read);
+  read_pos_ += bytes_to_read;
+  if (capacity_ > 0) {
+    // Unblock a writer waiting for room.
+    cond_->Notify();
+  } else {
+    ShrinkIfDrainedLocked();
   }
+  return ExceptionOr<size_t>{bytes_to_read};
+}
 
-  while (buffer_.empty() && !input_stream_closed_) {
-    Exception wait_exception = cond_->Wait();
+Exception Pipe::Write(const ByteArray& data) {
+  if (lock_free_) return LockFreeWrite(data.data(), data.size());
 
-    if (wait_exception.Raised()) {
-      return ExceptionOr<ByteArray>{wait_exception};
-    }
+  BaseMutexLock lock(mutex_.get());
+  if (Closed()) return {Exception::kIo};
+
+  const char* bytes = data.data();
+  size_t remaining = data.size();
+  if (capacity_ == 0) {
+    GrowLocked(remaining);
+    high_water_mark_ = std::max(high_water_mark_, Readable() + remaining);
   }
+  while (remaining > 0) {
+    ExceptionOr<size_t> room = WaitToWriteLocked();
+    if (!room.ok()) return {room.exception()};
+    if (room.result() == 0) return {Exception::kIo};
+
+    size_t size = std::min(remaining, room.result());
+    CopyIn(write_pos_, bytes, size);
+    write_pos_ += size;
+    bytes += size;
+    remaining -= size;
+    // Trigger cond_ to unblock a potentially-blocked call to read(), now that
+    // there's more data for it to consume.
+    cond_->Notify();
+  }
+  return {Exception::kSuccess};
+}
 
-  // If we received our sentinel chunk, mark the fact that there cannot
-  // possibly be any more chunks to read here on in, and return an empty chunk
-  // to serve as an EOF indication to callers.
-  if (buffer_.empty() || buffer_.front().Empty()) {
-    read_all_chunks_ = true;
-    return ExceptionOr<ByteArray>{ByteArray{}};
+ExceptionOr<size_t> Pipe::LockFreeRead(
+    size_t size, absl::FunctionRef<char*(size_t)> destination) {
+  size_t available = Readable();
+  if (available == 0) {
+    ExceptionOr<size_t> result = WaitToRead();
+    if (!result.ok()) return result;
+    available = result.result();
   }
+  if (input_stream_closed_) available = 0;
+
+  size_t bytes_to_read = std::min(size, available);
+  std::uint64_t position = read_pos_.load(std::memory_order_relaxed);
+  CopyOut(position, destination(bytes_to_read), bytes_to_read);
+  read_pos_.store(position + bytes_to_read);
+  NotifyIfWaiting(writer_waiting_);
+  return ExceptionOr<size_t>{bytes_to_read};
+}
 
-  ByteArray first_chunk{buffer_.front()};
-  buffer_.pop_front();
+Exception Pipe::LockFreeWrite(const char* data, size_t size) {
+  if (Closed()) return {Exception::kIo};
 
-  // If first_chunk is small enough to not overshoot the requested 'size', just
-  // return that.
-  if (first_chunk.size() <= size) {
-    return ExceptionOr<ByteArray>{first_chunk};
-  } else {
-    // Break first_chunk into 2 parts -- the first one of which (next_chunk)
-    // will be 'size' bytes long, and will be returned, and the second one of
-    // which (overflow_chunk) will be re-inserted into buffer_, at the head of
-    // the queue, to be served up in the next call to read().
-    ByteArray next_chunk(first_chunk.data(), size);
-    buffer_.push_front(
-        ByteArray(first_chunk.data() + size, first_chunk.size() - size));
-    return ExceptionOr<ByteArray>{next_chunk};
+  while (size > 0) {
+    size_t room = capacity_ - Readable();
+    if (room == 0) {
+      ExceptionOr<size_t> result = WaitToWrite();
+      if (!result.ok()) return {result.exception()};
+      room = result.result();
+    }
+    if (room == 0 || Closed()) return {Exception::kIo};
+
+    size_t chunk_size = std::min(size, room);
+    std::uint64_t position = write_pos_.load(std::memory_order_relaxed);
+    CopyIn(position, data, chunk_size);
+    write_pos_.store(position + chunk_size);
+    data += chunk_size;
+    size -= chunk_size;
+    NotifyIfWaiting(reader_waiting_);
   }
+  return {Exception::kSuccess};
 }
 
-Exception Pipe::Write(const ByteArray& data) {
+ExceptionOr<size_t> Pipe::WaitToRead() {
+  BaseMutexLock lock(mutex_.get());
+  // Publishing `reader_waiting_` before checking for data means a writer
+  // either sees it and wakes us, or wrote before we check.
+  reader_waiting_ = true;
+  ExceptionOr<size_t> result = WaitToReadLocked();
+  reader_waiting_ = false;
+  return result;
+}
+
+ExceptionOr<size_t> Pipe::WaitToReadLocked() {
+  while (Readable() == 0 && !Closed()) {
+    Exception wait_exception = cond_->Wait();
+    if (wait_exception.Raised()) {
+      return ExceptionOr<size_t>{wait_exception};
+    }
+  }
+  // Data written before the OutputStream was closed can still be read.
+  if (input_stream_closed_) return ExceptionOr<size_t>{0};
+  return ExceptionOr<size_t>{Readable()};
+}
+
+ExceptionOr<size_t> Pipe::WaitToWrite() {
   BaseMutexLock lock(mutex_.get());
+  writer_waiting_ = true;
+  ExceptionOr<size_t> result = WaitToWriteLocked();
+  writer_waiting_ = false;
+  return result;
+}
 
-  return WriteLocked(data);
+ExceptionOr<size_t> Pipe::WaitToWriteLocked() {
+  if (capacity_ == 0) return ExceptionOr<size_t>{buffer_size_ - Readable()};
+  while (Readable() == capacity_ && !Closed()) {
+    Exception wait_exception = cond_->Wait();
+    if (wait_exception.Raised()) {
+      return ExceptionOr<size_t>{wait_exception};
+    }
+  }
+  if (Closed()) return ExceptionOr<size_t>{0};
+  return ExceptionOr<size_t>{capacity_ - Readable()};
+}
+
+void Pipe::NotifyIfWaiting(const std::atomic_bool& waiting) {
+  if (waiting) {
+    BaseMutexLock lock(mutex_.get());
+    cond_->Notify();
+  }
 }
 
 void Pipe::MarkInputStreamClosed() {
   BaseMutexLock lock(mutex_.get());
   if (input_stream_closed_) return;
   input_stream_closed_ = true;
-  // Trigger cond_ to unblock a potentially-blocked call to read(), and to let
-  // it know to return Exception::IO.
+  // Trigger cond_ to unblock a potentially-blocked call to read() or write(),
+  // and to let it know the pipe is closed.
   cond_->Notify();
 }
 
 void Pipe::MarkOutputStreamClosed() {
   BaseMutexLock lock(mutex_.get());
   if (output_stream_closed_) return;
-  // Write a sentinel null chunk before marking output_stream_closed as true.
-  WriteLocked(ByteArray{});
   output_stream_closed_ = true;
+  cond_->Notify();
 }
 
-Exception Pipe::WriteLocked(const ByteArray& data) {
-  if (input_stream_closed_ || output_stream_closed_) {
-    return {Exception::kIo};
-  }
+void Pipe::CopyIn(std::uint64_t position, const char* data, size_t size) {
+  size_t offset = position % buffer_size_;
+  size_t first = std::min(size, buffer_size_ - offset);
+  std::memcpy(buffer_.get() + offset, data, first);
+  std::memcpy(buffer_.get(), data + first, size - first);
+}
 
-  buffer_.push_back(data);
-  // Trigger cond_ to unblock a potentially-blocked call to read(), now that
-  // there's more data for it to consume.
-  cond_->Notify();
-  return {Exception::kSuccess};
+void Pipe::CopyOut(std::uint64_t position, char* data, size_t size) const {
+  size_t offset = position % buffer_size_;
+  size_t first = std::min(size, buffer_size_ - offset);
+  std::memcpy(data, buffer_.get() + offset, first);
+  std::memcpy(data + first, buffer_.get(), size - first);
+}
+
+void Pipe::GrowLocked(size_t size) {
+  size_t readable = Readable();
+  if (readable + size <= buffer_size_) return;
+
+  size_t buffer_size = std::max(buffer_size_ * 2, readable + size);
+  // Like the constructor, leave the new buffer uninitialized.
+  std::unique_ptr<char[]> buffer(new char[buffer_size]);
+  CopyOut(read_pos_, buffer.get(), readable);
+  buffer_ = std::move(buffer);
+  buffer_size_ = buffer_size;
+  read_pos_ = 0;
+  write_pos_ = readable;
+}
+
+void Pipe::ShrinkIfDrainedLocked() {
+  if (Readable() > 0 || ++drains_ < kDrainsPerShrinkCheck) return;
+
+  size_t buffer_size = std::max(high_water_mark_, kInitialBufferSize);
+  drains_ = 0;
+  high_water_mark_ = 0;
+  if (buffer_size_ < kShrinkRatio * buffer_size) return;
+
+  buffer_.reset(new char[buffer_size]);
+  buffer_size_ = buffer_size;
+  read_pos_ = 0;
+  write_pos_ = 0;
 }
 
 }  // namespace
 
 std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
 CreatePipe() {
-  auto pipe = std::make_shared<Pipe>();
+  return CreatePipe(PipeOptions());
+}
+
+std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
+CreatePipe(const PipeOptions& options) {
+  auto pipe = std::make_shared<Pipe>(options);
   return std::make_pair(std::make_unique<Pipe::PipeInputStream>(pipe),
                         std::make_unique<Pipe::PipeOutputStream>(pipe));
 }
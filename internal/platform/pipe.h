@@ -15,6 +15,7 @@
 #ifndef PLATFORM_PUBLIC_PIPE_H_
 #define PLATFORM_PUBLIC_PIPE_H_
 
+#include <cstddef>
 #include <memory>
 #include <utility>
 
@@ -30,9 +31,25 @@ namespace nearby {
 //  WriterThread(std::move(output));
 //  ```
 //  Pipe stays valid as long as either `input` or `output` exist.
+//
+// The pipe buffers all the data that was written but not yet read.
 std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
 CreatePipe();
 
+struct PipeOptions {
+  // Bytes the pipe buffers before Write() blocks until the reader catches up.
+  // 0 means unbounded.
+  std::size_t capacity = 0;
+  // Lets Read() and Write() skip the lock while there is data to read or room
+  // to write. Requires a capacity, and that a single thread reads and a single
+  // thread writes.
+  bool lock_free = false;
+};
+
+// Creates a pipe as above, bounded by `options`.
+std::pair<std::unique_ptr<InputStream>, std::unique_ptr<OutputStream>>
+CreatePipe(const PipeOptions& options);
+
 }  // namespace nearby
 
 #endif  // PLATFORM_PUBLIC_PIPE_H_
@@ -16,6 +16,7 @@
 
 #include <pthread.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <cstring>
@@ -26,6 +27,9 @@
 
 #include "gtest/gtest.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "internal/platform/byte_array.h"
 #include "internal/platform/exception.h"
 #include "internal/platform/input_stream.h"
@@ -54,6 +58,18 @@ TEST(PipeTest, SimpleWriteRead) {
   EXPECT_EQ(data, std::string(read_data.result()));
 }
 
+TEST(PipeTest, GatherWriteConcatenatesBuffers) {
+  auto [input_stream, output_stream] = CreatePipe();
+  ByteArray header("AB");
+  ByteArray empty;
+  ByteArray body("CDEF");
+  EXPECT_TRUE(output_stream->GatherWrite({&header, &empty, &body}).Ok());
+
+  ExceptionOr<ByteArray> read_data = input_stream->ReadExactly(6);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_EQ(std::string(read_data.result()), "ABCDEF");
+}
+
 TEST(PipeTest, WriteEndClosedBeforeRead) {
   auto [input_stream, output_stream] = CreatePipe();
 
@@ -337,4 +353,135 @@ TEST(PipeTest, ConcurrentWriteAndRead) {
   reader_thread.Join();
 }
 
+TEST(PipeTest, SmallReadsOfLargeWrite) {
+  auto [input_stream, output_stream] = CreatePipe();
+  std::string data(3 * kChunkSize, 'a');
+  for (size_t i = 0; i < data.size(); ++i) data[i] = 'A' + i % 26;
+  EXPECT_TRUE(output_stream->Write(ByteArray(data)).Ok());
+  EXPECT_TRUE(output_stream->Close().Ok());
+
+  std::string read_data;
+  while (true) {
+    ExceptionOr<ByteArray> chunk = input_stream->Read(1000);
+    ASSERT_TRUE(chunk.ok());
+    if (chunk.result().Empty()) break;
+    EXPECT_LE(chunk.result().size(), 1000);
+    read_data += std::string(chunk.result());
+  }
+  EXPECT_EQ(data, read_data);
+}
+
+TEST(PipeTest, WritesAfterDrainingLargeWrite) {
+  auto [input_stream, output_stream] = CreatePipe();
+  std::string large(3 * kChunkSize, 'a');
+  EXPECT_TRUE(output_stream->Write(ByteArray(large)).Ok());
+  ExceptionOr<ByteArray> read_large = input_stream->Read(large.size());
+  ASSERT_TRUE(read_large.ok());
+  EXPECT_EQ(std::string(read_large.result()), large);
+
+  // The drained pipe shrinks after a while; writes that wrap around it must
+  // still arrive intact.
+  for (int i = 0; i < 40; ++i) {
+    std::string small(1000, 'A' + i);
+    EXPECT_TRUE(output_stream->Write(ByteArray(small)).Ok());
+    EXPECT_TRUE(output_stream->Write(ByteArray(small)).Ok());
+    ExceptionOr<ByteArray> read_small = input_stream->Read(2 * small.size());
+    ASSERT_TRUE(read_small.ok());
+    EXPECT_EQ(std::string(read_small.result()), small + small);
+  }
+}
+
+TEST(PipeTest, BoundedReadSeesWritesUpToCapacity) {
+  auto [input_stream, output_stream] = CreatePipe({.capacity = 4});
+  EXPECT_TRUE(output_stream->Write(ByteArray("ABCD")).Ok());
+
+  ExceptionOr<ByteArray> read_data = input_stream->Read(kChunkSize);
+  EXPECT_TRUE(read_data.ok());
+  EXPECT_EQ(std::string(read_data.result()), "ABCD");
+}
+
+TEST(PipeTest, BoundedWriteBlockedUntilRead) {
+  auto [input_stream, output_stream] = CreatePipe({.capacity = 4});
+  std::atomic_bool write_done = false;
+
+  Thread writer_thread;
+  writer_thread.Start([&output_stream = output_stream, &write_done]() {
+    EXPECT_TRUE(output_stream->Write(ByteArray("ABCDEFGH")).Ok());
+    write_done = true;
+  });
+
+  absl::SleepFor(absl::Milliseconds(100));
+  EXPECT_FALSE(write_done);
+  EXPECT_EQ(std::string(input_stream->ReadExactly(8).result()), "ABCDEFGH");
+  writer_thread.Join();
+  EXPECT_TRUE(write_done);
+}
+
+TEST(PipeTest, BoundedWriteFailsWhenReadEndClosed) {
+  auto [input_stream, output_stream] = CreatePipe({.capacity = 4});
+
+  Thread writer_thread;
+  writer_thread.Start([&output_stream = output_stream]() {
+    EXPECT_TRUE(
+        output_stream->Write(ByteArray("ABCDEFGH")).Raised(Exception::kIo));
+  });
+
+  absl::SleepFor(absl::Milliseconds(100));
+  EXPECT_TRUE(input_stream->Close().Ok());
+  writer_thread.Join();
+}
+
+TEST(PipeTest, LockFreeTransfersInOrder) {
+  auto [input_stream, output_stream] =
+      CreatePipe({.capacity = 1000, .lock_free = true});
+  std::string data(10 * kChunkSize, 'a');
+  for (size_t i = 0; i < data.size(); ++i) data[i] = 'A' + i % 26;
+
+  Thread writer_thread;
+  writer_thread.Start([&output_stream = output_stream, &data]() {
+    for (size_t offset = 0; offset < data.size(); offset += 777) {
+      size_t size = std::min<size_t>(777, data.size() - offset);
+      EXPECT_TRUE(output_stream->Write(ByteArray(data.data() + offset, size))
+                      .Ok());
+    }
+    EXPECT_TRUE(output_stream->Close().Ok());
+  });
+
+  std::string read_data;
+  while (true) {
+    ExceptionOr<ByteArray> chunk = input_stream->Read(555);
+    ASSERT_TRUE(chunk.ok());
+    if (chunk.result().Empty()) break;
+    read_data += std::string(chunk.result());
+  }
+  writer_thread.Join();
+  EXPECT_EQ(data, read_data);
+}
+
+TEST(PipeTest, ReadIntoFillsBuffer) {
+  auto [input_stream, output_stream] = CreatePipe();
+  EXPECT_TRUE(output_stream->Write(ByteArray("ABCDEF")).Ok());
+  char buffer[4];
+
+  ExceptionOr<size_t> read_size =
+      input_stream->ReadInto(absl::MakeSpan(buffer));
+  EXPECT_TRUE(read_size.ok());
+  EXPECT_EQ(std::string(buffer, read_size.result()), "ABCD");
+
+  read_size = input_stream->ReadInto(absl::MakeSpan(buffer));
+  EXPECT_TRUE(read_size.ok());
+  EXPECT_EQ(std::string(buffer, read_size.result()), "EF");
+}
+
+TEST(PipeTest, ReadIntoReturnsZeroAtEnd) {
+  auto [input_stream, output_stream] = CreatePipe();
+  EXPECT_TRUE(output_stream->Close().Ok());
+  char buffer[4];
+
+  ExceptionOr<size_t> read_size =
+      input_stream->ReadInto(absl::MakeSpan(buffer));
+  EXPECT_TRUE(read_size.ok());
+  EXPECT_EQ(read_size.result(), 0);
+}
+
 }  // namespace nearby
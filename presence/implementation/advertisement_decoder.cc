@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -187,7 +188,7 @@ bool ContainsAny(const std::vector<DataElement>& data_elements,
 }  // namespace
 
 void AdvertisementDecoder::DecodeBaseAction(
-    absl::string_view serialized_action) {
+    absl::string_view serialized_action, Advertisement& decoded) const {
   if (serialized_action.empty() || serialized_action.size() > 3) {
     NEARBY_LOGS(WARNING) << "Base NP action \'"
                          << absl::BytesToHexString(serialized_action)
@@ -202,46 +203,37 @@ void AdvertisementDecoder::DecodeBaseAction(
     action.action |= serialized_action[i] << offset;
   }
 
-  ActionFactory::DecodeAction(action, decoded_advertisement_.data_elements);
+  ActionFactory::DecodeAction(action, decoded.data_elements);
 }
 
 absl::StatusOr<std::string> AdvertisementDecoder::DecryptLdt(
-    const std::vector<internal::SharedCredential>& credentials,
-    absl::string_view salt, absl::string_view data_elements) {
-  if (credentials.empty()) {
-    return absl::UnavailableError("No credentials");
+    CredentialMatcher& matcher, absl::string_view salt,
+    absl::string_view data_elements, Advertisement& decoded) const {
+  absl::StatusOr<CredentialMatcher::Match> match =
+      matcher.DecryptAndVerify(salt, data_elements);
+  if (!match.ok()) {
+    return match.status();
   }
-  for (const auto& credential : credentials) {
-    absl::StatusOr<LdtEncryptor> encryptor = LdtEncryptor::Create(
-        credential.key_seed(),
-        credential.metadata_encryption_key_tag_v0());
-    if (encryptor.ok()) {
-      absl::StatusOr<std::string> result =
-          encryptor->DecryptAndVerify(data_elements, salt);
-      if (result.ok() && result->size() > kBaseMetadataSize) {
-        decoded_advertisement_.public_credential = credential;
-        decoded_advertisement_.metadata_key =
-            result->substr(0, kBaseMetadataSize);
-        return result->substr(kBaseMetadataSize);
-      }
-    }
+  if (match->decrypted.size() <= kBaseMetadataSize) {
+    return absl::UnavailableError(
+        "Couldn't decrypt the message with any credentials");
   }
-  return absl::UnavailableError(
-      "Couldn't decrypt the message with any credentials");
+  decoded.public_credential = *match->credential;
+  decoded.metadata_key = match->decrypted.substr(0, kBaseMetadataSize);
+  return match->decrypted.substr(kBaseMetadataSize);
 }
 
 absl::Status AdvertisementDecoder::DecryptDataElements(
-    const DataElement& elem) {
+    const DataElement& elem, Advertisement& decoded) const {
   if (elem.GetValue().size() <= kEncryptedIdentityAdditionalLength) {
     return absl::OutOfRangeError(absl::StrFormat(
         "Encrypted identity data element is too short - %d bytes",
         elem.GetValue().size()));
   }
   absl::string_view salt = elem.GetValue().substr(0, kSaltSize);
-  decoded_advertisement_.data_elements.emplace_back(DataElement::kSaltFieldType,
-                                                    salt);
+  decoded.data_elements.emplace_back(DataElement::kSaltFieldType, salt);
   absl::string_view encrypted = elem.GetValue().substr(kSaltSize);
-  absl::StatusOr<std::string> decrypted = Decrypt(salt, encrypted);
+  absl::StatusOr<std::string> decrypted = Decrypt(salt, encrypted, decoded);
   if (!decrypted.ok()) {
     NEARBY_LOGS(WARNING) << "Failed to decrypt advertisement, status: "
                          << decrypted.status();
@@ -257,38 +249,59 @@ absl::Status AdvertisementDecoder::DecryptDataElements(
       return internal_elem.status();
     }
     if (internal_elem->GetType() == DataElement::kActionFieldType) {
-      DecodeBaseAction(internal_elem->GetValue());
+      DecodeBaseAction(internal_elem->GetValue(), decoded);
     } else {
-      decoded_advertisement_.data_elements.push_back(*std::move(internal_elem));
+      decoded.data_elements.push_back(*std::move(internal_elem));
     }
   }
   return absl::OkStatus();
 }
 
 absl::StatusOr<std::string> AdvertisementDecoder::Decrypt(
-    absl::string_view salt, absl::string_view encrypted) {
-  for (const auto& scan_filter : scan_request_.scan_filters) {
-    if (!absl::holds_alternative<LegacyPresenceScanFilter>(scan_filter)) {
-      continue;
-    }
-    const std::vector<nearby::internal::SharedCredential>& credentials =
-        absl::get<LegacyPresenceScanFilter>(scan_filter)
-            .remote_public_credentials;
-    if (credentials.empty()) {
+    absl::string_view salt, absl::string_view encrypted,
+    Advertisement& decoded) const {
+  for (const auto& matcher : scan_filter_matchers_) {
+    if (matcher->IsEmpty()) {
       continue;
     }
     absl::StatusOr<std::string> decrypted =
-        DecryptLdt(credentials, salt, encrypted);
+        DecryptLdt(*matcher, salt, encrypted, decoded);
     if (decrypted.ok()) {
       return decrypted;
     }
   }
-  if (credentials_ == nullptr) {
+  if (!credential_matchers_.has_value()) {
     return absl::FailedPreconditionError("Missing credentials");
   }
 
-  return DecryptLdt((*credentials_)[decoded_advertisement_.identity_type], salt,
-                    encrypted);
+  auto it = credential_matchers_->find(decoded.identity_type);
+  if (it == credential_matchers_->end()) {
+    return absl::UnavailableError("No credentials");
+  }
+  return DecryptLdt(*it->second, salt, encrypted, decoded);
+}
+
+void AdvertisementDecoder::CreateCredentialMatchers(
+    const absl::flat_hash_map<IdentityType,
+                              std::vector<internal::SharedCredential>>*
+        credentials) {
+  for (const auto& scan_filter : scan_request_.scan_filters) {
+    if (!absl::holds_alternative<LegacyPresenceScanFilter>(scan_filter)) {
+      continue;
+    }
+    scan_filter_matchers_.push_back(std::make_unique<CredentialMatcher>(
+        absl::get<LegacyPresenceScanFilter>(scan_filter)
+            .remote_public_credentials));
+  }
+  if (credentials == nullptr) {
+    return;
+  }
+  credential_matchers_.emplace();
+  for (const auto& [identity_type, identity_credentials] : *credentials) {
+    credential_matchers_->emplace(
+        identity_type,
+        std::make_unique<CredentialMatcher>(identity_credentials));
+  }
 }
 
 void AdvertisementDecoder::AddBannedDataTypes() {
@@ -321,11 +334,8 @@ void AdvertisementDecoder::AddBannedDataTypes() {
 }
 
 absl::StatusOr<Advertisement> AdvertisementDecoder::DecodeAdvertisement(
-    absl::string_view advertisement) {
-  // Let's keep the result advertisement in a member variable to avoid passing
-  // it around all the time.
-  decoded_advertisement_ = Advertisement{};
-  std::vector<DataElement> result;
+    absl::string_view advertisement) const {
+  Advertisement decoded;
   NEARBY_LOGS(INFO) << "Advertisement: "
                     << absl::BytesToHexString(advertisement);
   if (advertisement.empty()) {
@@ -337,7 +347,7 @@ absl::StatusOr<Advertisement> AdvertisementDecoder::DecodeAdvertisement(
     return absl::UnimplementedError(absl::StrFormat(
         "Advertisement version (%d) is not supported", version));
   }
-  decoded_advertisement_.version = version;
+  decoded.version = version;
   size_t index = 1;
   absl::StatusOr<std::string> decrypted;
   while (index < advertisement.size()) {
@@ -356,26 +366,26 @@ absl::StatusOr<Advertisement> AdvertisementDecoder::DecodeAdvertisement(
                           elem->GetType()));
     }
     if (IsIdentity(elem->GetType())) {
-      decoded_advertisement_.identity_type = GetIdentityType(elem->GetType());
+      decoded.identity_type = GetIdentityType(elem->GetType());
     }
     if (IsEncryptedIdentity(elem->GetType())) {
-      absl::Status status = DecryptDataElements(*elem);
+      absl::Status status = DecryptDataElements(*elem, decoded);
       if (!status.ok()) {
         return status;
       }
     } else {
       if (elem->GetType() == DataElement::kActionFieldType) {
-        DecodeBaseAction(elem->GetValue());
+        DecodeBaseAction(elem->GetValue(), decoded);
       } else {
-        decoded_advertisement_.data_elements.push_back(*std::move(elem));
+        decoded.data_elements.push_back(*std::move(elem));
       }
     }
   }
-  return std::move(decoded_advertisement_);
+  return decoded;
 }
 
 bool AdvertisementDecoder::MatchesScanFilter(
-    const std::vector<DataElement>& data_elements) {
+    const std::vector<DataElement>& data_elements) const {
   // The advertisement matches the scan request when it matches at least
   // one of the filters in the request.
   if (scan_request_.scan_filters.empty()) {
@@ -399,14 +409,14 @@ bool AdvertisementDecoder::MatchesScanFilter(
 
 bool AdvertisementDecoder::MatchesScanFilter(
     const std::vector<DataElement>& data_elements,
-    const PresenceScanFilter& filter) {
+    const PresenceScanFilter& filter) const {
   // The advertisement must contain all Data Elements in scan request.
   return ContainsAll(data_elements, filter.extended_properties);
 }
 
 bool AdvertisementDecoder::MatchesScanFilter(
     const std::vector<DataElement>& data_elements,
-    const LegacyPresenceScanFilter& filter) {
+    const LegacyPresenceScanFilter& filter) const {
   // The advertisement must:
   // * contain any Action from scan request,
   // * contain all Data Elements in scan request.
@@ -15,6 +15,8 @@
 #ifndef THIRD_PARTY_NEARBY_PRESENCE_ADVERTISEMENT_DECODER_H_
 #define THIRD_PARTY_NEARBY_PRESENCE_ADVERTISEMENT_DECODER_H_
 
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -25,6 +27,7 @@
 #include "internal/platform/implementation/credential_callbacks.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/data_element.h"
+#include "presence/implementation/credential_matcher.h"
 #include "presence/scan_request.h"
 
 namespace nearby {
@@ -40,6 +43,10 @@ struct Advertisement {
 };
 
 // Decodes BLE NP advertisements
+//
+// The credentials are prepared for decryption when the decoder is created;
+// create a new decoder when they change. Decoding and matching are
+// thread-safe, so one decoder can serve several decoding threads.
 class AdvertisementDecoder {
  public:
   using IdentityType = ::nearby::internal::IdentityType;
@@ -48,13 +55,15 @@ class AdvertisementDecoder {
       ScanRequest scan_request,
       absl::flat_hash_map<IdentityType,
                           std::vector<internal::SharedCredential>>* credentials)
-      : scan_request_(scan_request), credentials_(credentials) {
+      : scan_request_(scan_request) {
     AddBannedDataTypes();
+    CreateCredentialMatchers(credentials);
   }
 
   explicit AdvertisementDecoder(ScanRequest scan_request)
       : scan_request_(scan_request) {
     AddBannedDataTypes();
+    CreateCredentialMatchers(nullptr);
   }
 
   static std::vector<CredentialSelector> GetCredentialSelectors(
@@ -64,33 +73,45 @@ class AdvertisementDecoder {
   // Returns an error if the advertisement is misformatted or if it couldn't be
   // decrypted.
   absl::StatusOr<Advertisement> DecodeAdvertisement(
-      absl::string_view advertisement);
+      absl::string_view advertisement) const;
 
   // Returns true if the decoded advertisement in `data_elements` matches the
   // filters in `scan_request`.
-  bool MatchesScanFilter(const std::vector<DataElement>& data_elements);
+  bool MatchesScanFilter(const std::vector<DataElement>& data_elements) const;
 
  private:
   // Decrypts data elements stored inside encrypted `elem` and appends them to
-  // `decoded_advertisement_`.
-  absl::Status DecryptDataElements(const DataElement& elem);
+  // `decoded`.
+  absl::Status DecryptDataElements(const DataElement& elem,
+                                   Advertisement& decoded) const;
   absl::StatusOr<std::string> Decrypt(absl::string_view salt,
-                                      absl::string_view encrypted);
-  void DecodeBaseAction(absl::string_view serialized_action);
-  absl::StatusOr<std::string> DecryptLdt(
-      const std::vector<internal::SharedCredential>& credentials,
-      absl::string_view salt, absl::string_view data_elements);
+                                      absl::string_view encrypted,
+                                      Advertisement& decoded) const;
+  void DecodeBaseAction(absl::string_view serialized_action,
+                        Advertisement& decoded) const;
+  absl::StatusOr<std::string> DecryptLdt(CredentialMatcher& matcher,
+                                         absl::string_view salt,
+                                         absl::string_view data_elements,
+                                         Advertisement& decoded) const;
   void AddBannedDataTypes();
+  void CreateCredentialMatchers(
+      const absl::flat_hash_map<IdentityType,
+                                std::vector<internal::SharedCredential>>*
+          credentials);
   bool MatchesScanFilter(const std::vector<DataElement>& data_elements,
-                         const PresenceScanFilter& filter);
+                         const PresenceScanFilter& filter) const;
   bool MatchesScanFilter(const std::vector<DataElement>& data_elements,
-                         const LegacyPresenceScanFilter& filter);
+                         const LegacyPresenceScanFilter& filter) const;
 
   ScanRequest scan_request_;
-  absl::flat_hash_map<IdentityType, std::vector<internal::SharedCredential>>*
-      credentials_ = nullptr;
+  // Remote public credentials of the legacy scan filters, in the order of the
+  // filters.
+  std::vector<std::unique_ptr<CredentialMatcher>> scan_filter_matchers_;
+  // Unset if the decoder was created without credentials.
+  std::optional<
+      absl::flat_hash_map<IdentityType, std::unique_ptr<CredentialMatcher>>>
+      credential_matchers_;
   absl::flat_hash_set<int> banned_data_types_;
-  Advertisement decoded_advertisement_;
 };
 
 }  // namespace presence
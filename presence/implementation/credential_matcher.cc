@@ -0,0 +1,107 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "presence/implementation/credential_matcher.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
+#include "internal/proto/credential.pb.h"
+#include "presence/implementation/ldt.h"
+
+namespace nearby {
+namespace presence {
+
+// C++14 requires to declare this.
+constexpr size_t CredentialMatcher::kMaxRememberedSalts;
+
+CredentialMatcher::CredentialMatcher(
+    const std::vector<internal::SharedCredential>& credentials) {
+  absl::flat_hash_set<std::pair<std::string, std::string>> keys;
+  entries_.reserve(credentials.size());
+  for (const auto& credential : credentials) {
+    if (!keys.emplace(credential.key_seed(),
+                      credential.metadata_encryption_key_tag_v0())
+             .second) {
+      continue;
+    }
+    absl::StatusOr<LdtEncryptor> encryptor = LdtEncryptor::Create(
+        credential.key_seed(), credential.metadata_encryption_key_tag_v0());
+    if (!encryptor.ok()) {
+      NEARBY_LOGS(WARNING) << "Failed to create LDT decrypter, status: "
+                           << encryptor.status();
+      continue;
+    }
+    entries_.push_back(
+        std::make_unique<Entry>(credential, *std::move(encryptor)));
+  }
+}
+
+absl::StatusOr<CredentialMatcher::Match> CredentialMatcher::DecryptAndVerify(
+    absl::string_view salt, absl::string_view data) {
+  if (entries_.empty()) {
+    return absl::UnavailableError("No credentials");
+  }
+
+  // Salts are short and collide between devices, so a remembered credential
+  // is only a first guess.
+  size_t first = entries_.size();
+  {
+    MutexLock lock(&mutex_);
+    auto it = entry_by_salt_.find(salt);
+    if (it != entry_by_salt_.end()) {
+      first = it->second;
+    }
+  }
+  if (first < entries_.size()) {
+    absl::StatusOr<std::string> result =
+        DecryptWith(*entries_[first], salt, data);
+    if (result.ok()) {
+      return Match{&entries_[first]->credential, *std::move(result)};
+    }
+  }
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (i == first) continue;
+    absl::StatusOr<std::string> result = DecryptWith(*entries_[i], salt, data);
+    if (!result.ok()) continue;
+
+    MutexLock lock(&mutex_);
+    if (entry_by_salt_.size() >= kMaxRememberedSalts) {
+      entry_by_salt_.clear();
+    }
+    entry_by_salt_[salt] = i;
+    return Match{&entries_[i]->credential, *std::move(result)};
+  }
+  return absl::UnavailableError(
+      "Couldn't decrypt the message with any credentials");
+}
+
+absl::StatusOr<std::string> CredentialMatcher::DecryptWith(
+    Entry& entry, absl::string_view salt, absl::string_view data) {
+  MutexLock lock(&entry.mutex);
+  return entry.encryptor.DecryptAndVerify(data, salt);
+}
+
+}  // namespace presence
+}  // namespace nearby
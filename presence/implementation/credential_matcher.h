@@ -0,0 +1,98 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_CREDENTIAL_MATCHER_H_
+#define THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_CREDENTIAL_MATCHER_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "internal/platform/mutex.h"
+#include "internal/proto/credential.pb.h"
+#include "presence/implementation/ldt.h"
+
+namespace nearby {
+namespace presence {
+
+// Finds the credential an LDT encrypted advertisement was encrypted with.
+//
+// The LDT decrypter of every credential is derived once, when the matcher is
+// created, instead of for every advertisement. Credentials with the same key
+// seed and tag share a decrypter. The credential that decrypted an
+// advertisement is remembered by its salt, so the copies of an advertisement
+// that keep arriving while a device is in range are decrypted at the first
+// attempt.
+//
+// The matcher is thread-safe. Decryption with different credentials may run
+// in parallel.
+class CredentialMatcher {
+ public:
+  // Maximum number of salts remembered.
+  static constexpr size_t kMaxRememberedSalts = 256;
+
+  struct Match {
+    // Points into the matcher; valid until the matcher is destroyed.
+    const internal::SharedCredential* credential;
+    std::string decrypted;
+  };
+
+  CredentialMatcher() = default;
+  explicit CredentialMatcher(
+      const std::vector<internal::SharedCredential>& credentials);
+  CredentialMatcher(const CredentialMatcher&) = delete;
+  CredentialMatcher& operator=(const CredentialMatcher&) = delete;
+
+  // Returns true if there are no usable credentials.
+  bool IsEmpty() const { return entries_.empty(); }
+
+  // Decrypts `data` with the first credential that verifies it.
+  absl::StatusOr<Match> DecryptAndVerify(absl::string_view salt,
+                                         absl::string_view data)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    Entry(internal::SharedCredential credential, LdtEncryptor encryptor)
+        : credential(std::move(credential)), encryptor(std::move(encryptor)) {}
+
+    const internal::SharedCredential credential;
+    // The LDT library makes no promises about concurrent use of a handle.
+    Mutex mutex;
+    LdtEncryptor encryptor ABSL_GUARDED_BY(mutex);
+  };
+
+  // Decrypts `data` with the credential of `entry`.
+  static absl::StatusOr<std::string> DecryptWith(Entry& entry,
+                                                 absl::string_view salt,
+                                                 absl::string_view data);
+
+  std::vector<std::unique_ptr<Entry>> entries_;
+  Mutex mutex_;
+  // Index into `entries_` of the credential that last decrypted an
+  // advertisement with a given salt.
+  absl::flat_hash_map<std::string, size_t> entry_by_salt_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace presence
+}  // namespace nearby
+
+#endif  // THIRD_PARTY_NEARBY_PRESENCE_IMPLEMENTATION_CREDENTIAL_MATCHER_H_
@@ -0,0 +1,113 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "presence/implementation/credential_matcher.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "protobuf-matchers/protocol-buffer-matchers.h"
+#include "gtest/gtest.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "internal/proto/credential.pb.h"
+
+namespace nearby {
+namespace presence {
+
+namespace {
+using ::nearby::internal::SharedCredential;
+using ::protobuf_matchers::EqualsProto;
+using ::testing::status::StatusIs;
+
+// Test data from Android tests.
+constexpr absl::string_view kKeySeedBase16 =
+    "BAF3C12E1BBBB3E4367BBD40986D0D7CD158DF6D662AAE6312FE67634B5D4547";
+constexpr absl::string_view kKnownMacBase16 =
+    "CDDA7C6CF56882D74364F8BE9874A78D7C961BFF9800A40D83F6652E6CF5D1A7";
+constexpr absl::string_view kPlainTextBase16 =
+    "205BF1D88FF539EC740CCC2EC2DE19353EF30F01054C3E24";
+constexpr absl::string_view kCipherTextBase16 =
+    "FDABC09D6F8028D4E5E585C62E9A0DB5003F19FEBDF92524";
+constexpr absl::string_view kSaltBase16 = "874C";
+
+SharedCredential GetCredential(absl::string_view key_seed_base16,
+                               absl::string_view known_mac_base16) {
+  SharedCredential credential;
+  credential.set_key_seed(absl::HexStringToBytes(key_seed_base16));
+  credential.set_metadata_encryption_key_tag_v0(
+      absl::HexStringToBytes(known_mac_base16));
+  return credential;
+}
+
+TEST(CredentialMatcher, NoCredentials) {
+  CredentialMatcher matcher(std::vector<SharedCredential>{});
+
+  EXPECT_TRUE(matcher.IsEmpty());
+  EXPECT_THAT(matcher.DecryptAndVerify(absl::HexStringToBytes(kSaltBase16),
+                                       absl::HexStringToBytes(
+                                           kCipherTextBase16)),
+              StatusIs(absl::StatusCode::kUnavailable));
+}
+
+#ifdef USE_RUST_LDT
+
+TEST(CredentialMatcher, FindsMatchingCredential) {
+  SharedCredential other = GetCredential(
+      "0000000000000000000000000000000000000000000000000000000000000000",
+      kKnownMacBase16);
+  SharedCredential expected = GetCredential(kKeySeedBase16, kKnownMacBase16);
+  CredentialMatcher matcher(
+      std::vector<SharedCredential>{other, other, expected});
+
+  // The second attempt is served by the remembered salt.
+  for (int i = 0; i < 2; ++i) {
+    absl::StatusOr<CredentialMatcher::Match> match = matcher.DecryptAndVerify(
+        absl::HexStringToBytes(kSaltBase16),
+        absl::HexStringToBytes(kCipherTextBase16));
+
+    ASSERT_OK(match);
+    EXPECT_THAT(*match->credential, EqualsProto(expected));
+    EXPECT_EQ(match->decrypted, absl::HexStringToBytes(kPlainTextBase16));
+  }
+}
+
+TEST(CredentialMatcher, RememberedSaltIsOnlyAGuess) {
+  SharedCredential expected = GetCredential(kKeySeedBase16, kKnownMacBase16);
+  CredentialMatcher matcher(std::vector<SharedCredential>{expected});
+
+  ASSERT_OK(matcher.DecryptAndVerify(
+      absl::HexStringToBytes(kSaltBase16),
+      absl::HexStringToBytes(kCipherTextBase16)));
+
+  // Same salt, but data that no credential verifies.
+  EXPECT_THAT(matcher.DecryptAndVerify(absl::HexStringToBytes(kSaltBase16),
+                                       absl::HexStringToBytes(
+                                           kPlainTextBase16)),
+              StatusIs(absl::StatusCode::kUnavailable));
+}
+
+#else
+TEST(CredentialMatcher, LdtUnavailable) {
+  CredentialMatcher matcher(std::vector<SharedCredential>{
+      GetCredential(kKeySeedBase16, kKnownMacBase16)});
+
+  EXPECT_TRUE(matcher.IsEmpty());
+}
+#endif
+
+}  // namespace
+}  // namespace presence
+}  // namespace nearby
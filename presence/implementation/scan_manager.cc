@@ -17,16 +17,24 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "absl/types/variant.h"
 #include "internal/platform/implementation/crypto.h"
 #include "internal/platform/future.h"
 #include "internal/platform/implementation/ble_v2.h"
 #include "internal/platform/implementation/credential_callbacks.h"
+#include "internal/platform/implementation/system_clock.h"
+#include "internal/platform/logging.h"
+#include "internal/platform/mutex_lock.h"
 #include "internal/platform/uuid.h"
 #include "presence/data_types.h"
 #include "presence/implementation/advertisement_decoder.h"
@@ -44,6 +52,13 @@ using ScanningSession = ::nearby::api::ble_v2::BleMedium::ScanningSession;
 using ScanningCallback = ::nearby::api::ble_v2::BleMedium::ScanningCallback;
 }  // namespace
 
+// C++14 requires to declare these.
+constexpr int ScanManager::kDecodeThreads;
+constexpr int ScanManager::kMaxPendingDecodes;
+constexpr absl::Duration ScanManager::kDuplicateWindow;
+constexpr int ScanManager::kMaxRecentAdvertisements;
+constexpr int ScanManager::kMaxCachedAdvertisements;
+
 ScanSessionId ScanManager::StartScan(ScanRequest scan_request,
                                      ScanCallback cb) {
   ScanSessionId id = nearby::RandData<ScanSessionId>();
@@ -61,20 +76,17 @@ ScanSessionId ScanManager::StartScan(ScanRequest scan_request,
                 .advertisement_found_cb =
                     [this, id](BlePeripheral& peripheral,
                                BleAdvertisementData data) {
-                      RunOnServiceControllerThread(
-                          "notify-found-ble",
-                          [this, id, data = std::move(data),
-                           address = peripheral.GetAddress()]()
-                              ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_) {
-                                NotifyFoundBle(id, data, address);
-                              });
+                      EnqueueFoundBle(id, std::move(data),
+                                      peripheral.GetAddress());
                     }};
             FetchCredentials(id, scan_request);
+            // Advertisements may be found before StartScanning() returns.
+            SetDecoder(id,
+                       std::make_shared<AdvertisementDecoder>(scan_request));
             scan_sessions_.insert(
                 {id, ScanSessionState{
                          .request = scan_request,
                          .callback = std::move(scan_callback),
-                         .decoder = AdvertisementDecoder(scan_request),
                          .scanning_session = mediums_->GetBle().StartScanning(
                              scan_request, std::move(callback))}});
           });
@@ -95,39 +107,128 @@ void ScanManager::StopScan(ScanSessionId id) {
           }
         }
         scan_sessions_.erase(it);
+        SetDecoder(id, nullptr);
       });
 }
 
-void ScanManager::NotifyFoundBle(ScanSessionId id, BleAdvertisementData data,
+void ScanManager::EnqueueFoundBle(ScanSessionId id, BleAdvertisementData data,
+                                  absl::string_view remote_address) {
+  std::string advertisement_data(
+      data.service_data[kPresenceServiceUuid].AsStringView());
+  std::shared_ptr<const AdvertisementDecoder> decoder;
+  uint64_t credential_epoch;
+  {
+    MutexLock lock(&decode_mutex_);
+    auto it = decode_sessions_.find(id);
+    if (it == decode_sessions_.end()) {
+      return;
+    }
+    if (pending_decodes_ >= kMaxPendingDecodes) {
+      // The device keeps advertising; a later copy will get through.
+      NEARBY_LOGS(VERBOSE) << __func__ << ": decode queue is full, dropping "
+                           << "advertisement from " << remote_address;
+      return;
+    }
+    DecodeSession& session = it->second;
+    absl::Time now = SystemClock::ElapsedRealtime();
+    if (now - session.recent_since >= kDuplicateWindow ||
+        session.recent.size() >= kMaxRecentAdvertisements) {
+      session.recent.clear();
+      session.recent_since = now;
+    }
+    if (!session.recent.insert(absl::StrCat(remote_address, "|",
+                                            advertisement_data))
+             .second) {
+      return;
+    }
+    ++pending_decodes_;
+    decoder = session.decoder;
+    credential_epoch = session.credential_epoch;
+  }
+  decode_executor_.Execute(
+      "decode-ble",
+      [this, id, decoder = std::move(decoder), credential_epoch,
+       advertisement_data = std::move(advertisement_data),
+       address = std::string(remote_address)]() {
+        DecodeFoundBle(id, *decoder, credential_epoch, advertisement_data,
+                       address);
+      });
+}
+
+void ScanManager::DecodeFoundBle(ScanSessionId id,
+                                 const AdvertisementDecoder& decoder,
+                                 uint64_t credential_epoch,
+                                 absl::string_view advertisement_data,
                                  absl::string_view remote_address) {
-  auto advertisement_data =
-      data.service_data[kPresenceServiceUuid].AsStringView();
+  std::string cache_key =
+      absl::StrCat(id, "|", credential_epoch, "|", advertisement_data);
+  std::optional<std::shared_ptr<const absl::StatusOr<Advertisement>>> cached =
+      decoded_advertisements_.Get(cache_key);
+  std::shared_ptr<const absl::StatusOr<Advertisement>> advert;
+  if (cached.has_value()) {
+    advert = *std::move(cached);
+  } else {
+    advert = std::make_shared<const absl::StatusOr<Advertisement>>(
+        decoder.DecodeAdvertisement(advertisement_data));
+    decoded_advertisements_.Put(cache_key, advert);
+  }
+  {
+    MutexLock lock(&decode_mutex_);
+    --pending_decodes_;
+  }
+  if (!advert->ok()) {
+    // This advertisement is not relevant to the current element, skip.
+    return;
+  }
+  if (!decoder.MatchesScanFilter((*advert)->data_elements)) {
+    return;
+  }
+  RunOnServiceControllerThread(
+      "notify-found-ble",
+      [this, id, advert = **advert,
+       address = std::string(remote_address)]()
+          ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_) mutable {
+            NotifyFoundBle(id, std::move(advert), address);
+          });
+}
+
+void ScanManager::NotifyFoundBle(ScanSessionId id, Advertisement advert,
+                                 absl::string_view remote_address) {
+  // The scan may have been stopped while the advertisement was decoded.
   auto it = scan_sessions_.find(id);
   if (it == scan_sessions_.end()) {
     return;
   }
-  auto advert = it->second.decoder.DecodeAdvertisement(advertisement_data);
-  if (!advert.ok()) {
-    // This advertisement is not relevant to the current element, skip.
-    return;
+  internal::Metadata metadata;
+  metadata.set_bluetooth_mac_address(std::string(remote_address));
+  PresenceDevice device(DeviceMotion(), metadata, advert.identity_type);
+  // Ok if the advertisement is for trusted/private identity.
+  if (advert.public_credential.ok()) {
+    device.SetDecryptSharedCredential(*(advert.public_credential));
   }
-  if (it->second.decoder.MatchesScanFilter(advert->data_elements)) {
-    internal::Metadata metadata;
-    metadata.set_bluetooth_mac_address(std::string(remote_address));
-    PresenceDevice device(DeviceMotion(), metadata, advert->identity_type);
-    // Ok if the advertisement is for trusted/private identity.
-    if (advert->public_credential.ok()) {
-      device.SetDecryptSharedCredential(*(advert->public_credential));
+  device.AddExtendedProperties(advert.data_elements);
+  for (const auto& data_element : advert.data_elements) {
+    if (data_element.GetType() == DataElement::kActionFieldType) {
+      device.AddAction(PresenceAction(static_cast<int>(
+          static_cast<uint8_t>(data_element.GetValue()[0]))));
     }
-    device.AddExtendedProperties(advert->data_elements);
-    for (const auto& data_element : advert->data_elements) {
-      if (data_element.GetType() == DataElement::kActionFieldType) {
-        device.AddAction(PresenceAction(static_cast<int>(
-            static_cast<uint8_t>(data_element.GetValue()[0]))));
-      }
-    }
-    it->second.callback.on_discovered_cb(std::move(device));
   }
+  it->second.callback.on_discovered_cb(std::move(device));
+}
+
+void ScanManager::SetDecoder(
+    ScanSessionId id, std::shared_ptr<const AdvertisementDecoder> decoder) {
+  MutexLock lock(&decode_mutex_);
+  if (decoder == nullptr) {
+    decode_sessions_.erase(id);
+    return;
+  }
+  DecodeSession& session = decode_sessions_[id];
+  session.decoder = std::move(decoder);
+  ++session.credential_epoch;
+  // Advertisements that did not decode with the old credentials may decode
+  // with the new ones.
+  session.recent.clear();
 }
 
 void ScanManager::FetchCredentials(ScanSessionId id,
@@ -176,7 +277,8 @@ void ScanManager::UpdateCredentials(ScanSessionId id,
   }
   ScanSessionState& session = it->second;
   session.credentials[identity_type] = std::move(credentials);
-  session.decoder = AdvertisementDecoder(session.request, &session.credentials);
+  SetDecoder(id, std::make_shared<AdvertisementDecoder>(session.request,
+                                                        &session.credentials));
 }
 
 int ScanManager::ScanningCallbacksLengthForTest() {
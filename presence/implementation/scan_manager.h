@@ -21,7 +21,16 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "internal/base/lru_cache.h"
+#include "internal/platform/multi_thread_executor.h"
+#include "internal/platform/mutex.h"
+#include "internal/platform/mutex_lock.h"
 #include "internal/platform/single_thread_executor.h"
 #include "internal/proto/credential.pb.h"
 #include "presence/data_types.h"
@@ -35,8 +44,31 @@ namespace presence {
 
 // The instance of ScanManager is owned by `ServiceControllerImpl`.
 // Helping service controller to manage scan requests and callbacks.
+//
+// Found advertisements are decoded off the service controller thread, on a
+// pool of `kDecodeThreads` threads. Copies of an advertisement that a device
+// repeats within `kDuplicateWindow` are decoded only once, and advertisements
+// are dropped while `kMaxPendingDecodes` are waiting to be decoded. Devices are
+// still reported to the scan callbacks on the service controller thread, one
+// at a time.
+//
+// Decoding results, including failures, are cached by the advertisement bytes
+// and the scan session's credentials, so an advertisement seen again later is
+// not decrypted again until the credentials change.
 class ScanManager {
  public:
+  // Number of threads decoding advertisements.
+  static constexpr int kDecodeThreads = 4;
+  // Maximum number of advertisements waiting to be decoded.
+  static constexpr int kMaxPendingDecodes = 256;
+  // Time during which repeated copies of an advertisement are ignored.
+  static constexpr absl::Duration kDuplicateWindow = absl::Seconds(1);
+  // Maximum number of distinct advertisements remembered per scan session
+  // within `kDuplicateWindow`.
+  static constexpr int kMaxRecentAdvertisements = 1024;
+  // Maximum number of decoding results cached across all scan sessions.
+  static constexpr int kMaxCachedAdvertisements = 512;
+
   using SingleThreadExecutor = ::nearby::SingleThreadExecutor;
   using Mutex = ::nearby::Mutex;
   using MutexLock = ::nearby::MutexLock;
@@ -59,18 +91,48 @@ class ScanManager {
   // Reference: go/totw/135#augmenting-the-public-api-for-tests
   int ScanningCallbacksLengthForTest();
 
+  // Returns the lookup counts of the decoded advertisement cache.
+  LruCacheStats GetDecodeCacheStats() const {
+    return decoded_advertisements_.GetStats();
+  }
+
  private:
   struct ScanSessionState {
     ScanRequest request;
     ScanCallback callback;
     absl::flat_hash_map<IdentityType, std::vector<SharedCredential>>
         credentials;
-    AdvertisementDecoder decoder;
     std::unique_ptr<ScanningSession> scanning_session;
   };
-  void NotifyFoundBle(ScanSessionId id, BleAdvertisementData data,
+  // What the decoding threads need to know about a scan session.
+  struct DecodeSession {
+    // Replaced when the credentials change; decodes in flight keep using the
+    // decoder they started with.
+    std::shared_ptr<const AdvertisementDecoder> decoder;
+    // Incremented whenever `decoder` is replaced; part of the decoding cache
+    // key, so results from older credentials are not used.
+    uint64_t credential_epoch = 0;
+    // Advertisements seen since `recent_since`, keyed by the remote address
+    // and the advertisement bytes.
+    absl::flat_hash_set<std::string> recent;
+    absl::Time recent_since;
+  };
+  // Called on the BLE thread for every advertisement found.
+  void EnqueueFoundBle(ScanSessionId id, BleAdvertisementData data,
+                       absl::string_view remote_address)
+      ABSL_LOCKS_EXCLUDED(decode_mutex_);
+  // Runs on a decoding thread.
+  void DecodeFoundBle(ScanSessionId id, const AdvertisementDecoder& decoder,
+                      uint64_t credential_epoch,
+                      absl::string_view advertisement_data,
+                      absl::string_view remote_address)
+      ABSL_LOCKS_EXCLUDED(decode_mutex_);
+  void NotifyFoundBle(ScanSessionId id, Advertisement advert,
                       absl::string_view remote_address)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
+  void SetDecoder(ScanSessionId id,
+                  std::shared_ptr<const AdvertisementDecoder> decoder)
+      ABSL_LOCKS_EXCLUDED(decode_mutex_);
   void FetchCredentials(ScanSessionId id, const ScanRequest& scan_request)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(*executor_);
   void UpdateCredentials(ScanSessionId id, IdentityType identity_type,
@@ -84,6 +146,15 @@ class ScanManager {
   absl::flat_hash_map<ScanSessionId, ScanSessionState> scan_sessions_
       ABSL_GUARDED_BY(*executor_);
   SingleThreadExecutor* executor_;
+  Mutex decode_mutex_;
+  absl::flat_hash_map<ScanSessionId, DecodeSession> decode_sessions_
+      ABSL_GUARDED_BY(decode_mutex_);
+  int pending_decodes_ ABSL_GUARDED_BY(decode_mutex_) = 0;
+  LruCache<std::shared_ptr<const absl::StatusOr<Advertisement>>>
+      decoded_advertisements_{kMaxCachedAdvertisements};
+  // Declared last, so that the decoding threads are joined before the state
+  // they use is destroyed.
+  MultiThreadExecutor decode_executor_{kDecodeThreads};
 };
 
 }  // namespace presence
@@ -294,6 +294,33 @@ TEST_F(ScanManagerTest, StopOneSessionFromAnotherDeadlock) {
   EXPECT_EQ(manager.ScanningCallbacksLengthForTest(), 0);
 }
 
+// Copies of an advertisement are only ignored within the session that has
+// already seen it.
+TEST_F(ScanManagerTest, SameAdvertisementFoundByEverySession) {
+  Mediums mediums;
+  ScanManager manager(mediums, credential_manager_, executor_);
+  CountDownLatch found_latch2{1};
+  ScanSessionId scan_session =
+      manager.StartScan(MakeDefaultScanRequest(), MakeDefaultScanCallback());
+  ScanSessionId scan_session2 = manager.StartScan(
+      MakeDefaultScanRequest(),
+      ScanCallback{.start_scan_cb = [](absl::Status status) {},
+                   .on_discovered_cb =
+                       [&](PresenceDevice pd) { found_latch2.CountDown(); }});
+  ASSERT_EQ(manager.ScanningCallbacksLengthForTest(), 2);
+
+  nearby::BluetoothAdapter server_adapter;
+  Ble ble2(server_adapter);
+  std::unique_ptr<AdvertisingSession> advertising_session =
+      StartAdvertisingOn(ble2);
+
+  EXPECT_TRUE(found_latch_.Await().Ok());
+  EXPECT_TRUE(found_latch2.Await().Ok());
+  manager.StopScan(scan_session);
+  manager.StopScan(scan_session2);
+  EXPECT_EQ(manager.ScanningCallbacksLengthForTest(), 0);
+}
+
 // Receive a BLE advertisement after StopScan. `on_discovered_cb`
 // must not be called.
 TEST_F(ScanManagerTest, NoDeviceFoundAfterStopScan) {